@@ -8,10 +8,36 @@
 
 namespace ccc::ast {
 
-static bool compare_nodes_and_merge(
-	CompareResult& dest, const Node& node_lhs, const Node& node_rhs, const SymbolDatabase* database);
+// The state of a comparison between a pair of nodes, for comparing trees
+// without recursion.
+struct CompareFrame {
+	const Node* lhs = nullptr;
+	const Node* rhs = nullptr;
+	bool check_intrusive_fields = true;
+	CompareResult result = CompareResultType::MATCHES_NO_SWAP;
+	u32 step = 0;
+	// The pair of children currently being compared.
+	const Node* child_lhs = nullptr;
+	const Node* child_rhs = nullptr;
+	
+	CompareFrame() {}
+	CompareFrame(const Node& l, const Node& r, bool check_intrusive)
+		: lhs(&l), rhs(&r), check_intrusive_fields(check_intrusive) {}
+	
+	std::optional<CompareResult> compare_children(const Node& l, const Node& r)
+	{
+		child_lhs = &l;
+		child_rhs = &r;
+		return std::nullopt;
+	}
+};
+
+static std::optional<CompareResult> compare_next_children(CompareFrame& frame);
+static bool merge_compare_results(
+	CompareResult& dest, CompareResult result, const Node& node_lhs, const Node& node_rhs, const SymbolDatabase* database);
 static bool try_to_match_wobbly_typedefs(
 	const Node& node_lhs, const Node& node_rhs, const SymbolDatabase& database);
+static std::unique_ptr<Node> clone_node_without_children(const Node& node);
 
 void Node::set_access_specifier(AccessSpecifier specifier, u32 importer_flags)
 {
@@ -134,45 +160,89 @@ DataTypeHandle TypeName::data_type_handle_unless_forward_declared() const
 CompareResult compare_nodes(
 	const Node& node_lhs, const Node& node_rhs, const SymbolDatabase* database, bool check_intrusive_fields)
 {
-	CompareResult result = CompareResultType::MATCHES_NO_SWAP;
+	SmallStack<CompareFrame> stack;
+	stack.push_back(CompareFrame(node_lhs, node_rhs, check_intrusive_fields));
 	
-	if(node_lhs.descriptor != node_rhs.descriptor) {
-		return CompareFailReason::DESCRIPTOR;
-	}
+	// The result for the pair of children that was just compared, if any.
+	bool has_child_result = false;
+	CompareResult child_result = CompareResultType::MATCHES_NO_SWAP;
 	
-	if(check_intrusive_fields) {
-		if(node_lhs.storage_class != node_rhs.storage_class) {
-			// In some cases we can determine that a type was typedef'd for C
-			// translation units, but not for C++ translation units, so we need
-			// to add a special case for that here.
-			if(node_lhs.storage_class == STORAGE_CLASS_TYPEDEF && node_rhs.storage_class == STORAGE_CLASS_NONE) {
-				result = CompareResultType::MATCHES_FAVOUR_LHS;
-			} else if(node_lhs.storage_class == STORAGE_CLASS_NONE && node_rhs.storage_class == STORAGE_CLASS_TYPEDEF) {
-				result = CompareResultType::MATCHES_FAVOUR_RHS;
-			} else {
-				return CompareFailReason::STORAGE_CLASS;
-			}
-		}
+	while(true) {
+		CompareFrame& frame = stack.back();
 		
-		// Vtable pointers and constructors can sometimes contain type numbers
-		// that are different between translation units, so we don't want to
-		// compare them.
-		bool is_vtable_pointer = node_lhs.is_vtable_pointer && node_rhs.is_vtable_pointer;
-		bool is_numbered_constructor = node_lhs.name.starts_with("$_") && node_rhs.name.starts_with("$_");
-		if(node_lhs.name != node_rhs.name && !is_vtable_pointer && !is_numbered_constructor) {
-			return CompareFailReason::NAME;
+		std::optional<CompareResult> frame_result;
+		if(has_child_result && merge_compare_results(frame.result, child_result, *frame.child_lhs, *frame.child_rhs, database)) {
+			// If any of the inner types differ, the outer type does too.
+			frame_result = frame.result;
+		} else {
+			frame_result = compare_next_children(frame);
 		}
 		
-		if(node_lhs.offset_bytes != node_rhs.offset_bytes) {
-			return CompareFailReason::RELATIVE_OFFSET_BYTES;
-		}
+		has_child_result = false;
 		
-		if(node_lhs.size_bits != node_rhs.size_bits) {
-			return CompareFailReason::SIZE_BITS;
+		if(frame_result.has_value()) {
+			stack.pop_back();
+			if(stack.empty()) {
+				return *frame_result;
+			}
+			child_result = *frame_result;
+			has_child_result = true;
+		} else {
+			stack.push_back(CompareFrame(*frame.child_lhs, *frame.child_rhs, true));
+		}
+	}
+}
+
+static std::optional<CompareResult> compare_next_children(CompareFrame& frame)
+{
+	const Node& node_lhs = *frame.lhs;
+	const Node& node_rhs = *frame.rhs;
+	
+	// This function is called once before the children are compared, and once
+	// after each pair of children has been compared. The fields that aren't
+	// children are checked in between in the same order as the children, so
+	// that the first difference is the one that gets reported.
+	u32 step = frame.step++;
+	
+	if(step == 0) {
+		if(node_lhs.descriptor != node_rhs.descriptor) {
+			return CompareFailReason::DESCRIPTOR;
 		}
 		
-		if(node_lhs.is_const != node_rhs.is_const) {
-			return CompareFailReason::CONSTNESS;
+		if(frame.check_intrusive_fields) {
+			if(node_lhs.storage_class != node_rhs.storage_class) {
+				// In some cases we can determine that a type was typedef'd for C
+				// translation units, but not for C++ translation units, so we need
+				// to add a special case for that here.
+				if(node_lhs.storage_class == STORAGE_CLASS_TYPEDEF && node_rhs.storage_class == STORAGE_CLASS_NONE) {
+					frame.result = CompareResultType::MATCHES_FAVOUR_LHS;
+				} else if(node_lhs.storage_class == STORAGE_CLASS_NONE && node_rhs.storage_class == STORAGE_CLASS_TYPEDEF) {
+					frame.result = CompareResultType::MATCHES_FAVOUR_RHS;
+				} else {
+					return CompareFailReason::STORAGE_CLASS;
+				}
+			}
+			
+			// Vtable pointers and constructors can sometimes contain type numbers
+			// that are different between translation units, so we don't want to
+			// compare them.
+			bool is_vtable_pointer = node_lhs.is_vtable_pointer && node_rhs.is_vtable_pointer;
+			bool is_numbered_constructor = node_lhs.name.view().starts_with("$_") && node_rhs.name.view().starts_with("$_");
+			if(node_lhs.name != node_rhs.name && !is_vtable_pointer && !is_numbered_constructor) {
+				return CompareFailReason::NAME;
+			}
+			
+			if(node_lhs.offset_bytes != node_rhs.offset_bytes) {
+				return CompareFailReason::RELATIVE_OFFSET_BYTES;
+			}
+			
+			if(node_lhs.size_bits != node_rhs.size_bits) {
+				return CompareFailReason::SIZE_BITS;
+			}
+			
+			if(node_lhs.is_const != node_rhs.is_const) {
+				return CompareFailReason::CONSTNESS;
+			}
 		}
 	}
 	
@@ -180,8 +250,8 @@ CompareResult compare_nodes(
 		case ARRAY: {
 			const auto [lhs, rhs] = Node::as<Array>(node_lhs, node_rhs);
 			
-			if(compare_nodes_and_merge(result, *lhs.element_type.get(), *rhs.element_type.get(), database)) {
-				return result;
+			if(step == 0) {
+				return frame.compare_children(*lhs.element_type.get(), *rhs.element_type.get());
 			}
 			
 			if(lhs.element_count != rhs.element_count) {
@@ -193,12 +263,12 @@ CompareResult compare_nodes(
 		case BITFIELD: {
 			const auto [lhs, rhs] = Node::as<BitField>(node_lhs, node_rhs);
 			
-			if(lhs.bitfield_offset_bits != rhs.bitfield_offset_bits) {
-				return CompareFailReason::BITFIELD_OFFSET_BITS;
-			}
-			
-			if(compare_nodes_and_merge(result, *lhs.underlying_type.get(), *rhs.underlying_type.get(), database)) {
-				return result;
+			if(step == 0) {
+				if(lhs.bitfield_offset_bits != rhs.bitfield_offset_bits) {
+					return CompareFailReason::BITFIELD_OFFSET_BITS;
+				}
+				
+				return frame.compare_children(*lhs.underlying_type.get(), *rhs.underlying_type.get());
 			}
 			
 			break;
@@ -227,24 +297,27 @@ CompareResult compare_nodes(
 		case FUNCTION: {
 			const auto [lhs, rhs] = Node::as<Function>(node_lhs, node_rhs);
 			
-			if(lhs.return_type.has_value() != rhs.return_type.has_value()) {
-				return CompareFailReason::FUNCTION_RETURN_TYPE_HAS_VALUE;
-			}
-			
-			if(lhs.return_type.has_value()) {
-				if(compare_nodes_and_merge(result, *lhs.return_type->get(), *rhs.return_type->get(), database)) {
-					return result;
+			if(step == 0) {
+				if(lhs.return_type.has_value() != rhs.return_type.has_value()) {
+					return CompareFailReason::FUNCTION_RETURN_TYPE_HAS_VALUE;
 				}
+				
+				if(lhs.return_type.has_value()) {
+					return frame.compare_children(*lhs.return_type->get(), *rhs.return_type->get());
+				}
+				
+				// Skip over the step for the return type.
+				step = frame.step++;
 			}
 			
+			u32 parameter_index = step - 1;
+			
 			if(lhs.parameters.has_value() && rhs.parameters.has_value()) {
-				if(lhs.parameters->size() != rhs.parameters->size()) {
+				if(parameter_index == 0 && lhs.parameters->size() != rhs.parameters->size()) {
 					return CompareFailReason::FUNCTION_PARAMAETER_COUNT;
 				}
-				for(size_t i = 0; i < lhs.parameters->size(); i++) {
-					if(compare_nodes_and_merge(result, *(*lhs.parameters)[i].get(), *(*rhs.parameters)[i].get(), database)) {
-						return result;
-					}
+				if(parameter_index < lhs.parameters->size()) {
+					return frame.compare_children(*(*lhs.parameters)[parameter_index].get(), *(*rhs.parameters)[parameter_index].get());
 				}
 			} else if(lhs.parameters.has_value() != rhs.parameters.has_value()) {
 				return CompareFailReason::FUNCTION_PARAMETERS_HAS_VALUE;
@@ -259,12 +332,12 @@ CompareResult compare_nodes(
 		case POINTER_OR_REFERENCE: {
 			const auto [lhs, rhs] = Node::as<PointerOrReference>(node_lhs, node_rhs);
 			
-			if(lhs.is_pointer != rhs.is_pointer) {
-				return CompareFailReason::DESCRIPTOR;
-			}
-			
-			if(compare_nodes_and_merge(result, *lhs.value_type.get(), *rhs.value_type.get(), database)) {
-				return result;
+			if(step == 0) {
+				if(lhs.is_pointer != rhs.is_pointer) {
+					return CompareFailReason::DESCRIPTOR;
+				}
+				
+				return frame.compare_children(*lhs.value_type.get(), *rhs.value_type.get());
 			}
 			
 			break;
@@ -272,12 +345,12 @@ CompareResult compare_nodes(
 		case POINTER_TO_DATA_MEMBER: {
 			const auto [lhs, rhs] = Node::as<PointerToDataMember>(node_lhs, node_rhs);
 			
-			if(compare_nodes_and_merge(result, *lhs.class_type.get(), *rhs.class_type.get(), database)) {
-				return result;
+			if(step == 0) {
+				return frame.compare_children(*lhs.class_type.get(), *rhs.class_type.get());
 			}
 			
-			if(compare_nodes_and_merge(result, *lhs.member_type.get(), *rhs.member_type.get(), database)) {
-				return result;
+			if(step == 1) {
+				return frame.compare_children(*lhs.member_type.get(), *rhs.member_type.get());
 			}
 			
 			break;
@@ -285,38 +358,37 @@ CompareResult compare_nodes(
 		case STRUCT_OR_UNION: {
 			const auto [lhs, rhs] = Node::as<StructOrUnion>(node_lhs, node_rhs);
 			
-			if(lhs.is_struct != rhs.is_struct) {
-				return CompareFailReason::DESCRIPTOR;
-			}
-			
-			if(lhs.base_classes.size() != rhs.base_classes.size()) {
-				return CompareFailReason::BASE_CLASS_COUNT;
+			if(step == 0) {
+				if(lhs.is_struct != rhs.is_struct) {
+					return CompareFailReason::DESCRIPTOR;
+				}
+				
+				if(lhs.base_classes.size() != rhs.base_classes.size()) {
+					return CompareFailReason::BASE_CLASS_COUNT;
+				}
 			}
 			
-			for(size_t i = 0; i < lhs.base_classes.size(); i++) {
-				if(compare_nodes_and_merge(result, *lhs.base_classes[i].get(), *rhs.base_classes[i].get(), database)) {
-					return result;
-				}
+			size_t index = step;
+			if(index < lhs.base_classes.size()) {
+				return frame.compare_children(*lhs.base_classes[index].get(), *rhs.base_classes[index].get());
 			}
 			
-			if(lhs.fields.size() != rhs.fields.size()) {
+			index -= lhs.base_classes.size();
+			if(index == 0 && lhs.fields.size() != rhs.fields.size()) {
 				return CompareFailReason::FIELDS_SIZE;
 			}
 			
-			for(size_t i = 0; i < lhs.fields.size(); i++) {
-				if(compare_nodes_and_merge(result, *lhs.fields[i].get(), *rhs.fields[i].get(), database)) {
-					return result;
-				}
+			if(index < lhs.fields.size()) {
+				return frame.compare_children(*lhs.fields[index].get(), *rhs.fields[index].get());
 			}
 			
-			if(lhs.member_functions.size() != rhs.member_functions.size()) {
+			index -= lhs.fields.size();
+			if(index == 0 && lhs.member_functions.size() != rhs.member_functions.size()) {
 				return CompareFailReason::MEMBER_FUNCTION_COUNT;
 			}
 			
-			for(size_t i = 0; i < lhs.member_functions.size(); i++) {
-				if(compare_nodes_and_merge(result, *lhs.member_functions[i].get(), *rhs.member_functions[i].get(), database)) {
-					return result;
-				}
+			if(index < lhs.member_functions.size()) {
+				return frame.compare_children(*lhs.member_functions[index].get(), *rhs.member_functions[index].get());
 			}
 			
 			break;
@@ -343,13 +415,13 @@ CompareResult compare_nodes(
 			break;
 		}
 	}
-	return result;
+	
+	return frame.result;
 }
 
-static bool compare_nodes_and_merge(
-	CompareResult& dest, const Node& node_lhs, const Node& node_rhs, const SymbolDatabase* database)
+static bool merge_compare_results(
+	CompareResult& dest, CompareResult result, const Node& node_lhs, const Node& node_rhs, const SymbolDatabase* database)
 {
-	CompareResult result = compare_nodes(node_lhs, node_rhs, database, true);
 	if(database) {
 		if(result.type == CompareResultType::DIFFERS && try_to_match_wobbly_typedefs(node_lhs, node_rhs, *database)) {
 			result.type = CompareResultType::MATCHES_FAVOUR_LHS;
@@ -559,4 +631,264 @@ s32 builtin_class_size(BuiltInClass bclass)
 	return 0;
 }
 
+std::unique_ptr<Node> clone_node(const Node& node)
+{
+	struct Frame {
+		const Node* source = nullptr;
+		std::unique_ptr<Node>* destination = nullptr;
+	};
+	
+	std::unique_ptr<Node> result;
+	
+	SmallStack<Frame> stack;
+	stack.push_back({&node, &result});
+	
+	while(!stack.empty()) {
+		Frame frame = stack.back();
+		stack.pop_back();
+		
+		*frame.destination = clone_node_without_children(*frame.source);
+		
+		// Allocate the child slots and push them in reverse order, so they
+		// get filled in the same order as the nodes were originally created.
+		switch(frame.source->descriptor) {
+			case ARRAY: {
+				stack.push_back({frame.source->as<Array>().element_type.get(), &(*frame.destination)->as<Array>().element_type});
+				break;
+			}
+			case BITFIELD: {
+				stack.push_back({frame.source->as<BitField>().underlying_type.get(), &(*frame.destination)->as<BitField>().underlying_type});
+				break;
+			}
+			case BUILTIN:
+			case ENUM:
+			case ERROR_NODE:
+			case TYPE_NAME: {
+				break;
+			}
+			case FUNCTION: {
+				const Function& source = frame.source->as<Function>();
+				Function& destination = (*frame.destination)->as<Function>();
+				if(source.parameters.has_value()) {
+					destination.parameters.emplace(source.parameters->size());
+					for(size_t i = source.parameters->size(); i > 0; i--) {
+						stack.push_back({(*source.parameters)[i - 1].get(), &(*destination.parameters)[i - 1]});
+					}
+				}
+				if(source.return_type.has_value()) {
+					destination.return_type.emplace();
+					stack.push_back({source.return_type->get(), &*destination.return_type});
+				}
+				break;
+			}
+			case POINTER_OR_REFERENCE: {
+				stack.push_back({frame.source->as<PointerOrReference>().value_type.get(), &(*frame.destination)->as<PointerOrReference>().value_type});
+				break;
+			}
+			case POINTER_TO_DATA_MEMBER: {
+				const PointerToDataMember& source = frame.source->as<PointerToDataMember>();
+				PointerToDataMember& destination = (*frame.destination)->as<PointerToDataMember>();
+				stack.push_back({source.member_type.get(), &destination.member_type});
+				stack.push_back({source.class_type.get(), &destination.class_type});
+				break;
+			}
+			case STRUCT_OR_UNION: {
+				const StructOrUnion& source = frame.source->as<StructOrUnion>();
+				StructOrUnion& destination = (*frame.destination)->as<StructOrUnion>();
+				destination.base_classes.resize(source.base_classes.size());
+				destination.fields.resize(source.fields.size());
+				destination.member_functions.resize(source.member_functions.size());
+				for(size_t i = source.member_functions.size(); i > 0; i--) {
+					stack.push_back({source.member_functions[i - 1].get(), &destination.member_functions[i - 1]});
+				}
+				for(size_t i = source.fields.size(); i > 0; i--) {
+					stack.push_back({source.fields[i - 1].get(), &destination.fields[i - 1]});
+				}
+				for(size_t i = source.base_classes.size(); i > 0; i--) {
+					stack.push_back({source.base_classes[i - 1].get(), &destination.base_classes[i - 1]});
+				}
+				break;
+			}
+		}
+	}
+	
+	return result;
+}
+
+static std::unique_ptr<Node> clone_node_without_children(const Node& node)
+{
+	std::unique_ptr<Node> result;
+	switch(node.descriptor) {
+		case ARRAY: {
+			auto new_array = std::make_unique<Array>();
+			new_array->element_count = node.as<Array>().element_count;
+			result = std::move(new_array);
+			break;
+		}
+		case BITFIELD: {
+			auto new_bitfield = std::make_unique<BitField>();
+			new_bitfield->bitfield_offset_bits = node.as<BitField>().bitfield_offset_bits;
+			result = std::move(new_bitfield);
+			break;
+		}
+		case BUILTIN: {
+			auto new_builtin = std::make_unique<BuiltIn>();
+			new_builtin->bclass = node.as<BuiltIn>().bclass;
+			result = std::move(new_builtin);
+			break;
+		}
+		case ENUM: {
+			auto new_enum = std::make_unique<Enum>();
+			new_enum->constants = node.as<Enum>().constants;
+			result = std::move(new_enum);
+			break;
+		}
+		case ERROR_NODE: {
+			auto new_error = std::make_unique<Error>();
+			new_error->message = node.as<Error>().message;
+			result = std::move(new_error);
+			break;
+		}
+		case FUNCTION: {
+			const Function& function = node.as<Function>();
+			auto new_function = std::make_unique<Function>();
+			new_function->modifier = function.modifier;
+			new_function->vtable_index = function.vtable_index;
+			new_function->definition_handle = function.definition_handle;
+			result = std::move(new_function);
+			break;
+		}
+		case POINTER_OR_REFERENCE: {
+			auto new_pointer_or_reference = std::make_unique<PointerOrReference>();
+			new_pointer_or_reference->is_pointer = node.as<PointerOrReference>().is_pointer;
+			result = std::move(new_pointer_or_reference);
+			break;
+		}
+		case POINTER_TO_DATA_MEMBER: {
+			result = std::make_unique<PointerToDataMember>();
+			break;
+		}
+		case STRUCT_OR_UNION: {
+			auto new_struct_or_union = std::make_unique<StructOrUnion>();
+			new_struct_or_union->is_struct = node.as<StructOrUnion>().is_struct;
+			result = std::move(new_struct_or_union);
+			break;
+		}
+		case TYPE_NAME: {
+			const TypeName& type_name = node.as<TypeName>();
+			auto new_type_name = std::make_unique<TypeName>();
+			new_type_name->data_type_handle = type_name.data_type_handle;
+			new_type_name->source = type_name.source;
+			new_type_name->is_forward_declared = type_name.is_forward_declared;
+			if(type_name.unresolved_stabs) {
+				new_type_name->unresolved_stabs = std::make_unique<TypeName::UnresolvedStabs>(*type_name.unresolved_stabs);
+			}
+			result = std::move(new_type_name);
+			break;
+		}
+	}
+	
+	// The descriptor is const, so the fields from the base class have to be
+	// copied over one by one.
+	result->is_const = node.is_const;
+	result->is_volatile = node.is_volatile;
+	result->is_virtual_base_class = node.is_virtual_base_class;
+	result->is_vtable_pointer = node.is_vtable_pointer;
+	result->is_constructor_or_destructor = node.is_constructor_or_destructor;
+	result->is_special_member_function = node.is_special_member_function;
+	result->is_operator_member_function = node.is_operator_member_function;
+	result->cannot_compute_size = node.cannot_compute_size;
+	result->storage_class = node.storage_class;
+	result->access_specifier = node.access_specifier;
+	result->size_bytes = node.size_bytes;
+	result->name = node.name;
+	result->offset_bytes = node.offset_bytes;
+	result->size_bits = node.size_bits;
+	
+	return result;
+}
+
+s32 relocate_nodes(std::unique_ptr<Node>& node)
+{
+	// Allocate the new parent node before any of its children.
+	switch(node->descriptor) {
+		case ARRAY: node = std::make_unique<Array>(std::move(node->as<Array>())); break;
+		case BITFIELD: node = std::make_unique<BitField>(std::move(node->as<BitField>())); break;
+		case BUILTIN: node = std::make_unique<BuiltIn>(std::move(node->as<BuiltIn>())); break;
+		case ENUM: node = std::make_unique<Enum>(std::move(node->as<Enum>())); break;
+		case ERROR_NODE: node = std::make_unique<Error>(std::move(node->as<Error>())); break;
+		case FUNCTION: node = std::make_unique<Function>(std::move(node->as<Function>())); break;
+		case POINTER_OR_REFERENCE: node = std::make_unique<PointerOrReference>(std::move(node->as<PointerOrReference>())); break;
+		case POINTER_TO_DATA_MEMBER: node = std::make_unique<PointerToDataMember>(std::move(node->as<PointerToDataMember>())); break;
+		case STRUCT_OR_UNION: node = std::make_unique<StructOrUnion>(std::move(node->as<StructOrUnion>())); break;
+		case TYPE_NAME: node = std::make_unique<TypeName>(std::move(node->as<TypeName>())); break;
+	}
+	
+	s32 count = 1;
+	switch(node->descriptor) {
+		case ARRAY: {
+			count += relocate_nodes(node->as<Array>().element_type);
+			break;
+		}
+		case BITFIELD: {
+			count += relocate_nodes(node->as<BitField>().underlying_type);
+			break;
+		}
+		case BUILTIN: {
+			break;
+		}
+		case ENUM: {
+			node->as<Enum>().constants.shrink_to_fit();
+			break;
+		}
+		case ERROR_NODE: {
+			break;
+		}
+		case FUNCTION: {
+			Function& function = node->as<Function>();
+			if(function.return_type.has_value()) {
+				count += relocate_nodes(*function.return_type);
+			}
+			if(function.parameters.has_value()) {
+				function.parameters->shrink_to_fit();
+				for(std::unique_ptr<Node>& parameter : *function.parameters) {
+					count += relocate_nodes(parameter);
+				}
+			}
+			break;
+		}
+		case POINTER_OR_REFERENCE: {
+			count += relocate_nodes(node->as<PointerOrReference>().value_type);
+			break;
+		}
+		case POINTER_TO_DATA_MEMBER: {
+			PointerToDataMember& pointer = node->as<PointerToDataMember>();
+			count += relocate_nodes(pointer.class_type);
+			count += relocate_nodes(pointer.member_type);
+			break;
+		}
+		case STRUCT_OR_UNION: {
+			StructOrUnion& struct_or_union = node->as<StructOrUnion>();
+			struct_or_union.base_classes.shrink_to_fit();
+			for(std::unique_ptr<Node>& base_class : struct_or_union.base_classes) {
+				count += relocate_nodes(base_class);
+			}
+			struct_or_union.fields.shrink_to_fit();
+			for(std::unique_ptr<Node>& field : struct_or_union.fields) {
+				count += relocate_nodes(field);
+			}
+			struct_or_union.member_functions.shrink_to_fit();
+			for(std::unique_ptr<Node>& member_function : struct_or_union.member_functions) {
+				count += relocate_nodes(member_function);
+			}
+			break;
+		}
+		case TYPE_NAME: {
+			break;
+		}
+	}
+	
+	return count;
+}
+
 }
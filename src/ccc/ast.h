@@ -29,13 +29,15 @@ enum AccessSpecifier {
 // To add a new type of node:
 //  1. Add it to the NodeDescriptor enum.
 //  2. Create a struct for it.
-//  3. Add support for it in for_each_node.
-//  4. Add support for it in compute_size_bytes_recursive.
+//  3. Add support for it in for_each_child_reversed.
+//  4. Add support for it in compute_size_bytes.
 //  5. Add support for it in compare_nodes.
 //  6. Add support for it in node_type_to_string.
 //  7. Add support for it in CppPrinter::ast_node.
 //  8. Add support for it in write_json.
-//  9. Add support for it in refine_node.
+//  9. Add support for it in DataRefiner::compile_node.
+// 10. Add support for it in relocate_nodes.
+// 11. Add support for it in clone_node.
 struct Node {
 	const NodeDescriptor descriptor;
 	u8 is_const : 1 = false;
@@ -54,7 +56,7 @@ struct Node {
 	// If the name isn't populated for a given node, the name from the last
 	// ancestor to have one should be used i.e. when processing the tree you
 	// should pass the name down.
-	std::string name;
+	InternedString name;
 	
 	s32 offset_bytes = -1; // Offset relative to start of last inline struct/union.
 	s32 size_bits = -1; // Size stored in the .mdebug symbol table, may not be set.
@@ -293,6 +295,13 @@ const char* builtin_class_to_string(BuiltInClass bclass);
 
 s32 builtin_class_size(BuiltInClass bclass);
 
+// Make a deep copy of a tree.
+std::unique_ptr<Node> clone_node(const Node& node);
+
+// Reallocate all the nodes in a tree in preorder, and shrink the vectors of
+// child nodes to fit. Returns the number of nodes relocated.
+s32 relocate_nodes(std::unique_ptr<Node>& node);
+
 enum TraversalOrder {
 	PREORDER_TRAVERSAL,
 	POSTORDER_TRAVERSAL
@@ -303,21 +312,21 @@ enum ExplorationMode {
 	DONT_EXPLORE_CHILDREN
 };
 
+// Call the callback for each of the direct children of a node in reverse
+// order, so that if they are pushed onto a stack they will be popped off again
+// in the right order.
 template <typename ThisNode, typename Callback>
-void for_each_node(ThisNode& node, TraversalOrder order, Callback callback)
+void for_each_child_reversed(ThisNode& node, Callback callback)
 {
-	if(order == PREORDER_TRAVERSAL && callback(node) == DONT_EXPLORE_CHILDREN) {
-		return;
-	}
 	switch(node.descriptor) {
 		case ARRAY: {
 			auto& array = node.template as<Array>();
-			for_each_node(*array.element_type.get(), order, callback);
+			callback(*array.element_type.get());
 			break;
 		}
 		case BITFIELD: {
 			auto& bitfield = node.template as<BitField>();
-			for_each_node(*bitfield.underlying_type.get(), order, callback);
+			callback(*bitfield.underlying_type.get());
 			break;
 		}
 		case BUILTIN: {
@@ -331,37 +340,37 @@ void for_each_node(ThisNode& node, TraversalOrder order, Callback callback)
 		}
 		case FUNCTION: {
 			auto& func = node.template as<Function>();
-			if(func.return_type.has_value()) {
-				for_each_node(*func.return_type->get(), order, callback);
-			}
 			if(func.parameters.has_value()) {
-				for(auto& child : *func.parameters) {
-					for_each_node(*child.get(), order, callback);
+				for(auto child = func.parameters->rbegin(); child != func.parameters->rend(); child++) {
+					callback(*child->get());
 				}
 			}
+			if(func.return_type.has_value()) {
+				callback(*func.return_type->get());
+			}
 			break;
 		}
 		case POINTER_OR_REFERENCE: {
 			auto& pointer_or_reference = node.template as<PointerOrReference>();
-			for_each_node(*pointer_or_reference.value_type.get(), order, callback);
+			callback(*pointer_or_reference.value_type.get());
 			break;
 		}
 		case POINTER_TO_DATA_MEMBER: {
 			auto& pointer = node.template as<PointerToDataMember>();
-			for_each_node(*pointer.class_type.get(), order, callback);
-			for_each_node(*pointer.member_type.get(), order, callback);
+			callback(*pointer.member_type.get());
+			callback(*pointer.class_type.get());
 			break;
 		}
 		case STRUCT_OR_UNION: {
 			auto& struct_or_union = node.template as<StructOrUnion>();
-			for(auto& child : struct_or_union.base_classes) {
-				for_each_node(*child.get(), order, callback);
+			for(auto child = struct_or_union.member_functions.rbegin(); child != struct_or_union.member_functions.rend(); child++) {
+				callback(*child->get());
 			}
-			for(auto& child : struct_or_union.fields) {
-				for_each_node(*child.get(), order, callback);
+			for(auto child = struct_or_union.fields.rbegin(); child != struct_or_union.fields.rend(); child++) {
+				callback(*child->get());
 			}
-			for(auto& child : struct_or_union.member_functions) {
-				for_each_node(*child.get(), order, callback);
+			for(auto child = struct_or_union.base_classes.rbegin(); child != struct_or_union.base_classes.rend(); child++) {
+				callback(*child->get());
 			}
 			break;
 		}
@@ -369,8 +378,53 @@ void for_each_node(ThisNode& node, TraversalOrder order, Callback callback)
 			break;
 		}
 	}
-	if(order == POSTORDER_TRAVERSAL) {
-		callback(node);
+}
+
+// Visit every node in a tree. This uses an explicit stack instead of
+// recursion, so there's no limit on how deeply nested the tree can be.
+template <typename ThisNode, typename Callback>
+void for_each_node(ThisNode& node, TraversalOrder order, Callback callback)
+{
+	using AnyNode = std::conditional_t<std::is_const_v<ThisNode>, const Node, Node>;
+	
+	if(order == PREORDER_TRAVERSAL) {
+		SmallStack<AnyNode*> stack;
+		stack.push_back(&node);
+		
+		while(!stack.empty()) {
+			AnyNode& current = *stack.back();
+			stack.pop_back();
+			
+			if(callback(current) == EXPLORE_CHILDREN) {
+				for_each_child_reversed(current, [&](AnyNode& child) {
+					stack.push_back(&child);
+				});
+			}
+		}
+	} else {
+		struct Frame {
+			AnyNode* node;
+			bool children_visited;
+		};
+		
+		SmallStack<Frame> stack;
+		stack.push_back({&node, false});
+		
+		while(!stack.empty()) {
+			Frame& frame = stack.back();
+			AnyNode& current = *frame.node;
+			
+			if(frame.children_visited) {
+				stack.pop_back();
+				callback(current);
+				continue;
+			}
+			
+			frame.children_visited = true;
+			for_each_child_reversed(current, [&](AnyNode& child) {
+				stack.push_back({&child, false});
+			});
+		}
 	}
 }
 
@@ -9,18 +9,29 @@
 #include "dependency.h"
 #include "elf.h"
 #include "elf_symtab.h"
+#include "field_layout.h"
+#include "function_matching.h"
 #include "importer_flags.h"
+#include "live_variables.h"
 #include "mdebug_analysis.h"
 #include "mdebug_importer.h"
 #include "mdebug_section.h"
 #include "mdebug_symbols.h"
+#include "memory_map.h"
 #include "print_cpp.h"
+#include "profiler.h"
 #include "registers.h"
 #include "sndll.h"
 #include "stabs.h"
 #include "stabs_to_ast.h"
+#include "stack_unwinder.h"
+#include "string_pool.h"
 #include "symbol_database.h"
 #include "symbol_file.h"
 #include "symbol_json.h"
+#include "symbol_query.h"
+#include "symbol_snapshot.h"
+#include "symbol_stats.h"
 #include "symbol_table.h"
 #include "util.h"
+#include "watch_expression.h"
@@ -3,22 +3,22 @@
 
 #include "data_refinement.h"
 
-#include <cinttypes>
-
-#include "ast.h"
+#include <charconv>
 
 namespace ccc {
 
-static Result<RefinedData> refine_node(
-	u32 virtual_address, const ast::Node& type, const SymbolDatabase& database, const ElfFile& elf, s32 depth);
-static Result<RefinedData> refine_builtin(
-	u32 virtual_address, ast::BuiltInClass bclass, const SymbolDatabase& database, const ElfFile& elf);
-static Result<RefinedData> refine_pointer_or_reference(
-	u32 virtual_address, const ast::Node& type, const SymbolDatabase& database, const ElfFile& elf);
-static const char* generate_format_string(s32 size, bool is_signed);
-static std::string single_precision_float_to_string(float value);
-static std::string string_format(const char* format, va_list args);
-static std::string stringf(const char* format, ...);
+// Flush the output buffer to the file once it gets bigger than this.
+static const size_t OUTPUT_FLUSH_THRESHOLD = 64 * 1024;
+
+static DataLayoutInstruction named_instruction(DataLayoutOpcode opcode, const DataLayoutInstruction& name);
+static void apply_name(DataLayoutInstruction& instruction, const DataLayoutInstruction& name);
+static void inline_layout(const DataLayout& inlined, s32 offset, const DataLayoutInstruction& name, DataLayout& layout);
+static void write_builtin(const u8* data, ast::BuiltInClass bclass, std::string& output);
+static void write_unsigned(u64 value, std::string& output);
+static void write_signed(s64 value, std::string& output);
+static void write_single_precision_float(float value, std::string& output);
+static void write_double_precision_float(double value, std::string& output);
+static void write_indentation(s32 level, std::string& output);
 
 bool can_refine_variable(const VariableToRefine& variable)
 {
@@ -30,287 +30,761 @@ bool can_refine_variable(const VariableToRefine& variable)
 	return true;
 }
 
-Result<RefinedData> refine_variable(
-	const VariableToRefine& variable, const SymbolDatabase& database, const ElfFile& elf)
+bool PreparedVariable::is_list() const
+{
+	if(!layout || layout->instructions.empty()) {
+		return false;
+	}
+	
+	DataLayoutOpcode opcode = layout->instructions[0].opcode;
+	return opcode == DataLayoutOpcode::BEGIN_LIST
+		|| opcode == DataLayoutOpcode::BEGIN_ARRAY
+		|| opcode == DataLayoutOpcode::BUILTIN_ARRAY;
+}
+
+DataRefiner::DataRefiner(const SymbolDatabase& database, const ElfFile& elf)
+	: m_database(database)
+	, m_elf(elf) {}
+
+Result<PreparedVariable> DataRefiner::prepare_variable(const VariableToRefine& variable)
 {
 	CCC_ASSERT(variable.type);
-	return refine_node(variable.address.value, *variable.type, database, elf, 0);
+	
+	std::shared_ptr<DataLayout> layout = std::make_shared<DataLayout>();
+	Result<void> compile_result = compile_node(*variable.type, *layout);
+	CCC_RETURN_IF_ERROR(compile_result);
+	
+	PreparedVariable prepared;
+	
+	// Read all the data up front so that we can report errors before anything
+	// has been printed out.
+	if(layout->extent > 0) {
+		Result<std::span<const u8>> data = m_elf.get_virtual(variable.address.value, (u32) layout->extent);
+		CCC_RETURN_IF_ERROR(data);
+		prepared.data = *data;
+	}
+	
+	prepared.layout = std::move(layout);
+	
+	return prepared;
 }
 
-static Result<RefinedData> refine_node(
-	u32 virtual_address, const ast::Node& type, const SymbolDatabase& database, const ElfFile& elf, s32 depth)
+void DataRefiner::write_variable(const PreparedVariable& variable, s32 indentation_level, FILE* out)
 {
-	if(depth > 200) {
-		const char* error_message = "Call depth greater than 200 in refine_node, probably infinite recursion.";
-		
-		CCC_WARN(error_message);
+	std::string output;
+	execute(variable, indentation_level, output, out);
+	fwrite(output.data(), output.size(), 1, out);
+}
+
+void DataRefiner::write_variable(const PreparedVariable& variable, s32 indentation_level, std::string& output)
+{
+	execute(variable, indentation_level, output, nullptr);
+}
+
+Result<void> DataRefiner::compile_node(const ast::Node& node, DataLayout& layout)
+{
+	// The tree is walked using an explicit stack. Instructions that have to be
+	// emitted after all the children of a node have been compiled are pushed
+	// onto the stack underneath them.
+	std::vector<CompileFrame> stack;
+	
+	// The data types currently being compiled, used to detect types that
+	// contain themselves, which can happen if the symbol table is corrupted.
+	std::vector<const DataType*> data_types;
+	
+	CompileFrame& root = stack.emplace_back();
+	root.node = &node;
+	root.layout = &layout;
+	
+	while(!stack.empty()) {
+		CompileFrame frame = std::move(stack.back());
+		stack.pop_back();
 		
-		RefinedData data;
-		data.value = error_message;
-		return data;
+		switch(frame.step) {
+			case CompileStep::COMPILE_NODE: {
+				Result<void> result = compile_node_step(frame, stack, data_types);
+				CCC_RETURN_IF_ERROR(result);
+				break;
+			}
+			case CompileStep::END_LIST: {
+				frame.layout->instructions.emplace_back(named_instruction(DataLayoutOpcode::END_LIST, frame.name));
+				break;
+			}
+			case CompileStep::END_ARRAY: {
+				finish_array(frame);
+				break;
+			}
+			case CompileStep::END_DATA_TYPE: {
+				CCC_ASSERT(!data_types.empty() && data_types.back() == frame.data_type);
+				data_types.pop_back();
+				
+				std::shared_ptr<DataLayout>& compiled = frame.data_type_layout;
+				compiled->dependencies.emplace_back(frame.data_type->handle(), frame.data_type->generation());
+				std::sort(compiled->dependencies.begin(), compiled->dependencies.end());
+				compiled->dependencies.erase(
+					std::unique(compiled->dependencies.begin(), compiled->dependencies.end()), compiled->dependencies.end());
+				
+				m_data_type_layouts[frame.data_type->handle()] = compiled;
+				
+				inline_layout(*compiled, frame.offset, frame.name, *frame.layout);
+				break;
+			}
+		}
 	}
 	
-	switch(type.descriptor) {
+	return Result<void>();
+}
+
+Result<void> DataRefiner::compile_node_step(
+	CompileFrame& frame, std::vector<CompileFrame>& stack, std::vector<const DataType*>& data_types)
+{
+	const ast::Node& node = *frame.node;
+	s32 offset = frame.offset;
+	const DataLayoutInstruction& name = frame.name;
+	DataLayout& layout = *frame.layout;
+	
+	switch(node.descriptor) {
 		case ast::ARRAY: {
-			const ast::Array& array = type.as<ast::Array>();
+			const ast::Array& array = node.as<ast::Array>();
 			CCC_CHECK(array.element_type->size_bytes > -1, "Cannot compute element size for '%s' array.", array.name.c_str());
-			RefinedData list;
-			std::vector<RefinedData>& elements = list.value.emplace<std::vector<RefinedData>>();
-			for(s32 i = 0; i < array.element_count; i++) {
-				s32 offset = i * array.element_type->size_bytes;
-				Result<RefinedData> element = refine_node(virtual_address + offset, *array.element_type.get(), database, elf, depth + 1);
-				CCC_RETURN_IF_ERROR(element);
-				element->field_name = "[" + std::to_string(i) + "]";
-				elements.emplace_back(std::move(*element));
-			}
-			return list;
+			
+			// Compile the element type into a separate layout, and then emit
+			// the instructions for the array once it's done.
+			CompileFrame& end = stack.emplace_back();
+			end.step = CompileStep::END_ARRAY;
+			end.node = &node;
+			end.offset = offset;
+			end.name = name;
+			end.layout = &layout;
+			end.element = std::make_unique<DataLayout>();
+			
+			DataLayout* element = end.element.get();
+			
+			CompileFrame& element_frame = stack.emplace_back();
+			element_frame.node = array.element_type.get();
+			element_frame.name.name = DataLayoutName::ARRAY_ELEMENT;
+			element_frame.layout = element;
+			
+			break;
 		}
 		case ast::BITFIELD: {
-			RefinedData data;
-			data.value = "BITFIELD";
-			return data;
+			DataLayoutInstruction& text = layout.instructions.emplace_back(named_instruction(DataLayoutOpcode::TEXT, name));
+			text.text = "BITFIELD";
+			break;
 		}
 		case ast::BUILTIN: {
-			const ast::BuiltIn& builtin = type.as<ast::BuiltIn>();
-			return refine_builtin(virtual_address, builtin.bclass, database, elf);
-		}
-		case ast::ENUM: {
-			const ast::Enum& enumeration = type.as<ast::Enum>();
+			const ast::BuiltIn& builtin = node.as<ast::BuiltIn>();
 			
-			s32 value = 0;
-			Result<void> read_result = elf.copy_virtual((u8*) &value, virtual_address, 4);
-			CCC_RETURN_IF_ERROR(read_result);
-			
-			RefinedData data;
-			for(const auto& [number, name] : enumeration.constants) {
-				if(number == value) {
-					data.value = name;
-					return data;
-				}
-			}
-			data.value = std::to_string(value);
+			DataLayoutInstruction& instruction = layout.instructions.emplace_back(
+				named_instruction(DataLayoutOpcode::BUILTIN, name));
+			instruction.offset = offset;
+			instruction.bclass = builtin.bclass;
 			
-			return data;
+			layout.extent = std::max(layout.extent, offset + builtin_class_size(builtin.bclass));
+			break;
 		}
-		case ast::ERROR_NODE: {
+		case ast::ENUM: {
+			DataLayoutInstruction& instruction = layout.instructions.emplace_back(
+				named_instruction(DataLayoutOpcode::ENUM, name));
+			instruction.offset = offset;
+			instruction.enumeration = &node.as<ast::Enum>();
+			
+			layout.extent = std::max(layout.extent, offset + 4);
 			break;
 		}
+		case ast::ERROR_NODE:
 		case ast::FUNCTION: {
-			break;
+			return CCC_FAILURE("Failed to refine global variable (%s).", ast::node_type_to_string(node));
 		}
 		case ast::POINTER_OR_REFERENCE: {
-			return refine_pointer_or_reference(virtual_address, type, database, elf);
+			DataLayoutInstruction& instruction = layout.instructions.emplace_back(
+				named_instruction(DataLayoutOpcode::POINTER, name));
+			instruction.offset = offset;
+			instruction.is_pointer = node.as<ast::PointerOrReference>().is_pointer;
+			
+			layout.extent = std::max(layout.extent, offset + 4);
+			break;
 		}
 		case ast::POINTER_TO_DATA_MEMBER: {
-			return refine_builtin(virtual_address, ast::BuiltInClass::UNSIGNED_32, database, elf);
+			DataLayoutInstruction& instruction = layout.instructions.emplace_back(
+				named_instruction(DataLayoutOpcode::BUILTIN, name));
+			instruction.offset = offset;
+			instruction.bclass = ast::BuiltInClass::UNSIGNED_32;
+			
+			layout.extent = std::max(layout.extent, offset + 4);
+			break;
 		}
 		case ast::STRUCT_OR_UNION: {
-			const ast::StructOrUnion& struct_or_union = type.as<ast::StructOrUnion>();
-			RefinedData list;
-			std::vector<RefinedData>& children = list.value.emplace<std::vector<RefinedData>>();
+			const ast::StructOrUnion& struct_or_union = node.as<ast::StructOrUnion>();
 			
-			for(s32 i = 0; i < (s32) struct_or_union.base_classes.size(); i++) {
-				const std::unique_ptr<ast::Node>& base_class = struct_or_union.base_classes[i];
-				Result<RefinedData> child = refine_node(virtual_address + base_class->offset_bytes, *base_class.get(), database, elf, depth + 1);
-				CCC_RETURN_IF_ERROR(child);
-				child->field_name = "base class " + std::to_string(i);
-				children.emplace_back(std::move(*child));
+			s32 child_count = (s32) struct_or_union.base_classes.size();
+			for(const std::unique_ptr<ast::Node>& field : struct_or_union.fields) {
+				if(field->storage_class != STORAGE_CLASS_STATIC) {
+					child_count++;
+				}
 			}
 			
-			for(const std::unique_ptr<ast::Node>& field : struct_or_union.fields) {
+			layout.instructions.emplace_back(named_instruction(DataLayoutOpcode::BEGIN_LIST, name));
+			
+			CompileFrame& end = stack.emplace_back();
+			end.step = CompileStep::END_LIST;
+			end.name = name;
+			end.layout = &layout;
+			
+			// Push the children in reverse order so that they're compiled in
+			// the right order.
+			s32 child_index = child_count;
+			for(size_t i = struct_or_union.fields.size(); i > 0; i--) {
+				const std::unique_ptr<ast::Node>& field = struct_or_union.fields[i - 1];
 				if(field->storage_class == STORAGE_CLASS_STATIC) {
 					continue;
 				}
-				Result<RefinedData> child = refine_node(virtual_address + field->offset_bytes, *field.get(), database, elf, depth + 1);
-				CCC_RETURN_IF_ERROR(child);
-				child->field_name = "." + field->name;
-				children.emplace_back(std::move(*child));
+				
+				CompileFrame& child = stack.emplace_back();
+				child.node = field.get();
+				child.offset = offset + field->offset_bytes;
+				child.name.name = DataLayoutName::FIELD;
+				child.name.field_name = &field->name.str();
+				child.name.is_last = child_index-- == child_count;
+				child.layout = &layout;
+			}
+			
+			for(size_t i = struct_or_union.base_classes.size(); i > 0; i--) {
+				const std::unique_ptr<ast::Node>& base_class = struct_or_union.base_classes[i - 1];
+				
+				CompileFrame& child = stack.emplace_back();
+				child.node = base_class.get();
+				child.offset = offset + base_class->offset_bytes;
+				child.name.name = DataLayoutName::BASE_CLASS;
+				child.name.base_class_index = (s32) i - 1;
+				child.name.is_last = child_index-- == child_count;
+				child.layout = &layout;
 			}
 			
-			return list;
+			break;
 		}
 		case ast::TYPE_NAME: {
-			const ast::TypeName& type_name = type.as<ast::TypeName>();
-			const DataType* resolved_type = database.data_types.symbol_from_handle(type_name.data_type_handle);
-			return refine_node(virtual_address, *resolved_type->type(), database, elf, depth + 1);
+			const ast::TypeName& type_name = node.as<ast::TypeName>();
+			const DataType* resolved_type = m_database.data_types.symbol_from_handle(type_name.data_type_handle);
+			CCC_CHECK(resolved_type && resolved_type->type(),
+				"Failed to resolve type name '%s' while refining global variable.", type_name.name.c_str());
+			
+			if(std::shared_ptr<const DataLayout> cached_layout = lookup_data_type_layout(*resolved_type)) {
+				inline_layout(*cached_layout, offset, name, layout);
+				break;
+			}
+			
+			if(std::find(CCC_BEGIN_END(data_types), resolved_type) != data_types.end()) {
+				const char* error_message = "Data type contains itself, probably a corrupted symbol table.";
+				
+				CCC_WARN(error_message);
+				
+				DataLayoutInstruction& text = layout.instructions.emplace_back(named_instruction(DataLayoutOpcode::TEXT, name));
+				text.text = error_message;
+				break;
+			}
+			
+			data_types.emplace_back(resolved_type);
+			
+			// Compile the data type into its own layout so that it can be
+			// cached, and then inline it once it's done.
+			CompileFrame& end = stack.emplace_back();
+			end.step = CompileStep::END_DATA_TYPE;
+			end.offset = offset;
+			end.name = name;
+			end.layout = &layout;
+			end.data_type = resolved_type;
+			end.data_type_layout = std::make_shared<DataLayout>();
+			
+			DataLayout* compiled = end.data_type_layout.get();
+			
+			CompileFrame& child = stack.emplace_back();
+			child.node = resolved_type->type();
+			child.layout = compiled;
+			
+			break;
+		}
+	}
+	
+	return Result<void>();
+}
+
+void DataRefiner::finish_array(CompileFrame& frame)
+{
+	const ast::Array& array = frame.node->as<ast::Array>();
+	const DataLayout& element = *frame.element;
+	const DataLayoutInstruction& name = frame.name;
+	DataLayout& layout = *frame.layout;
+	s32 offset = frame.offset;
+	
+	s32 element_count = std::max(array.element_count, 0);
+	s32 stride = array.element_type->size_bytes;
+	
+	bool is_builtin_array = element.instructions.size() == 1
+		&& element.instructions[0].opcode == DataLayoutOpcode::BUILTIN
+		&& element.instructions[0].offset == 0;
+	if(is_builtin_array) {
+		// Arrays of built-ins are printed in a single step.
+		DataLayoutInstruction& instruction = layout.instructions.emplace_back(
+			named_instruction(DataLayoutOpcode::BUILTIN_ARRAY, name));
+		instruction.offset = offset;
+		instruction.element_count = element_count;
+		instruction.stride = stride;
+		instruction.bclass = element.instructions[0].bclass;
+	} else {
+		DataLayoutInstruction& begin = layout.instructions.emplace_back(
+			named_instruction(DataLayoutOpcode::BEGIN_ARRAY, name));
+		begin.offset = offset;
+		begin.element_count = element_count;
+		begin.stride = stride;
+		begin.jump = (s32) element.instructions.size() + 1;
+		
+		layout.instructions.insert(layout.instructions.end(),
+			element.instructions.begin(), element.instructions.end());
+		
+		layout.instructions.emplace_back(named_instruction(DataLayoutOpcode::END_ARRAY, name));
+	}
+	
+	if(element_count > 0 && element.extent > 0) {
+		layout.extent = std::max(layout.extent, offset + (element_count - 1) * stride + element.extent);
+	}
+	
+	layout.dependencies.insert(layout.dependencies.end(),
+		element.dependencies.begin(), element.dependencies.end());
+}
+
+std::shared_ptr<const DataLayout> DataRefiner::lookup_data_type_layout(const DataType& data_type) const
+{
+	auto iterator = m_data_type_layouts.find(data_type.handle());
+	if(iterator == m_data_type_layouts.end()) {
+		return nullptr;
+	}
+	
+	// Make sure none of the types that were inlined have changed.
+	for(const auto& [handle, generation] : iterator->second->dependencies) {
+		const DataType* dependency = m_database.data_types.symbol_from_handle(handle);
+		if(!dependency || dependency->generation() != generation) {
+			return nullptr;
+		}
+	}
+	
+	return iterator->second;
+}
+
+void DataRefiner::execute(const PreparedVariable& variable, s32 indentation_level, std::string& output, FILE* out)
+{
+	CCC_ASSERT(variable.layout);
+	const std::vector<DataLayoutInstruction>& instructions = variable.layout->instructions;
+	
+	struct Frame {
+		s32 begin = 0;
+		s32 index = 0;
+		s32 count = 1;
+		s32 stride = 0;
+		s32 base = 0;
+	};
+	
+	std::vector<Frame> frames(1);
+	s32 level = indentation_level;
+	
+	auto write_prefix = [&](const DataLayoutInstruction& instruction, const Frame& frame) {
+		if(instruction.name == DataLayoutName::NOT_IN_LIST) {
+			return;
+		}
+		write_indentation(level, output);
+		switch(instruction.name) {
+			case DataLayoutName::NOT_IN_LIST: {
+				break;
+			}
+			case DataLayoutName::FIELD: {
+				output += "/* .";
+				output += *instruction.field_name;
+				output += " = */ ";
+				break;
+			}
+			case DataLayoutName::BASE_CLASS: {
+				output += "/* base class ";
+				write_signed(instruction.base_class_index, output);
+				output += " = */ ";
+				break;
+			}
+			case DataLayoutName::ARRAY_ELEMENT: {
+				output += "/* [";
+				write_signed(frame.index, output);
+				output += "] = */ ";
+				break;
+			}
+		}
+	};
+	
+	auto write_suffix = [&](const DataLayoutInstruction& instruction, const Frame& frame) {
+		if(instruction.name == DataLayoutName::NOT_IN_LIST) {
+			return;
+		}
+		bool is_last = instruction.name == DataLayoutName::ARRAY_ELEMENT
+			? frame.index == frame.count - 1
+			: instruction.is_last;
+		if(!is_last) {
+			output += ',';
+		}
+		output += '\n';
+		
+		if(out && output.size() > OUTPUT_FLUSH_THRESHOLD) {
+			fwrite(output.data(), output.size(), 1, out);
+			output.clear();
+		}
+	};
+	
+	for(s32 i = 0; i < (s32) instructions.size(); i++) {
+		const DataLayoutInstruction& instruction = instructions[i];
+		Frame& frame = frames.back();
+		s32 offset = frame.base + instruction.offset;
+		
+		switch(instruction.opcode) {
+			case DataLayoutOpcode::BEGIN_LIST: {
+				write_prefix(instruction, frame);
+				output += "{\n";
+				level++;
+				break;
+			}
+			case DataLayoutOpcode::END_LIST: {
+				level--;
+				write_indentation(level, output);
+				output += '}';
+				write_suffix(instruction, frame);
+				break;
+			}
+			case DataLayoutOpcode::BEGIN_ARRAY: {
+				write_prefix(instruction, frame);
+				output += "{\n";
+				if(instruction.element_count > 0) {
+					Frame& element = frames.emplace_back();
+					element.begin = i;
+					element.count = instruction.element_count;
+					element.stride = instruction.stride;
+					element.base = offset;
+					level++;
+				} else {
+					write_indentation(level, output);
+					output += '}';
+					write_suffix(instruction, frame);
+					i += instruction.jump;
+				}
+				break;
+			}
+			case DataLayoutOpcode::END_ARRAY: {
+				frame.index++;
+				if(frame.index < frame.count) {
+					frame.base += frame.stride;
+					i = frame.begin;
+				} else {
+					frames.pop_back();
+					level--;
+					write_indentation(level, output);
+					output += '}';
+					write_suffix(instruction, frames.back());
+				}
+				break;
+			}
+			case DataLayoutOpcode::BUILTIN_ARRAY: {
+				write_prefix(instruction, frame);
+				output += "{\n";
+				for(s32 j = 0; j < instruction.element_count; j++) {
+					write_indentation(level + 1, output);
+					output += "/* [";
+					write_signed(j, output);
+					output += "] = */ ";
+					write_builtin(&variable.data[offset + j * instruction.stride], instruction.bclass, output);
+					if(j != instruction.element_count - 1) {
+						output += ',';
+					}
+					output += '\n';
+					
+					if(out && output.size() > OUTPUT_FLUSH_THRESHOLD) {
+						fwrite(output.data(), output.size(), 1, out);
+						output.clear();
+					}
+				}
+				write_indentation(level, output);
+				output += '}';
+				write_suffix(instruction, frame);
+				break;
+			}
+			case DataLayoutOpcode::BUILTIN: {
+				write_prefix(instruction, frame);
+				write_builtin(&variable.data[offset], instruction.bclass, output);
+				write_suffix(instruction, frame);
+				break;
+			}
+			case DataLayoutOpcode::ENUM: {
+				write_prefix(instruction, frame);
+				
+				s32 value = 0;
+				memcpy(&value, &variable.data[offset], 4);
+				
+				bool found = false;
+				for(const auto& [number, name] : instruction.enumeration->constants) {
+					if(number == value) {
+						output += name;
+						found = true;
+						break;
+					}
+				}
+				if(!found) {
+					write_signed(value, output);
+				}
+				
+				write_suffix(instruction, frame);
+				break;
+			}
+			case DataLayoutOpcode::POINTER: {
+				write_prefix(instruction, frame);
+				
+				u32 pointer = 0;
+				memcpy(&pointer, &variable.data[offset], 4);
+				write_pointer(pointer, instruction.is_pointer, output);
+				
+				write_suffix(instruction, frame);
+				break;
+			}
+			case DataLayoutOpcode::TEXT: {
+				write_prefix(instruction, frame);
+				output += instruction.text;
+				write_suffix(instruction, frame);
+				break;
+			}
+		}
+	}
+}
+
+void DataRefiner::write_pointer(u32 pointer, bool is_pointer, std::string& output)
+{
+	if(pointer == 0) {
+		output += "NULL";
+		return;
+	}
+	
+	FunctionHandle function_handle = m_database.functions.first_handle_from_starting_address(pointer);
+	const Function* function_symbol = m_database.functions.symbol_from_handle(function_handle);
+	if(function_symbol) {
+		if(is_pointer) {
+			output += '&';
+		}
+		output += function_symbol->name();
+		return;
+	}
+	
+	GlobalVariableHandle global_variable_handle = m_database.global_variables.first_handle_from_starting_address(pointer);
+	const GlobalVariable* global_variable_symbol = m_database.global_variables.symbol_from_handle(global_variable_handle);
+	if(global_variable_symbol) {
+		bool pointing_at_array = global_variable_symbol->type()
+			&& global_variable_symbol->type()->descriptor == ast::ARRAY;
+		if(is_pointer && !pointing_at_array) {
+			output += '&';
 		}
+		output += global_variable_symbol->name();
+		return;
 	}
 	
-	return CCC_FAILURE("Failed to refine global variable (%s).", ast::node_type_to_string(type));
+	char buffer[16];
+	std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), pointer, 16);
+	output += "0x";
+	output.append(buffer, result.ptr);
 }
 
-static Result<RefinedData> refine_builtin(
-	u32 virtual_address, ast::BuiltInClass bclass, const SymbolDatabase& database, const ElfFile& elf)
+static DataLayoutInstruction named_instruction(DataLayoutOpcode opcode, const DataLayoutInstruction& name)
 {
-	RefinedData data;
+	DataLayoutInstruction instruction;
+	instruction.opcode = opcode;
+	apply_name(instruction, name);
+	return instruction;
+}
+
+static void apply_name(DataLayoutInstruction& instruction, const DataLayoutInstruction& name)
+{
+	instruction.name = name.name;
+	instruction.is_last = name.is_last;
+	instruction.base_class_index = name.base_class_index;
+	instruction.field_name = name.field_name;
+}
+
+static void inline_layout(const DataLayout& inlined, s32 offset, const DataLayoutInstruction& name, DataLayout& layout)
+{
+	if(inlined.instructions.empty()) {
+		return;
+	}
+	
+	// Copy the instructions from the cached layout, adjusting the offsets of
+	// those that aren't inside of an array.
+	size_t first = layout.instructions.size();
+	s32 array_depth = 0;
+	for(const DataLayoutInstruction& instruction : inlined.instructions) {
+		DataLayoutInstruction& copy = layout.instructions.emplace_back(instruction);
+		if(copy.opcode == DataLayoutOpcode::END_ARRAY) {
+			array_depth--;
+		}
+		if(array_depth == 0) {
+			copy.offset += offset;
+		}
+		if(copy.opcode == DataLayoutOpcode::BEGIN_ARRAY) {
+			array_depth++;
+		}
+	}
+	
+	apply_name(layout.instructions[first], name);
+	DataLayoutOpcode first_opcode = layout.instructions[first].opcode;
+	if(first_opcode == DataLayoutOpcode::BEGIN_LIST || first_opcode == DataLayoutOpcode::BEGIN_ARRAY) {
+		apply_name(layout.instructions.back(), name);
+	}
+	
+	if(inlined.extent > 0) {
+		layout.extent = std::max(layout.extent, offset + inlined.extent);
+	}
 	
+	layout.dependencies.insert(layout.dependencies.end(),
+		inlined.dependencies.begin(), inlined.dependencies.end());
+}
+
+static void write_builtin(const u8* data, ast::BuiltInClass bclass, std::string& output)
+{
 	switch(bclass) {
 		case ast::BuiltInClass::VOID_TYPE: {
 			break;
 		}
 		case ast::BuiltInClass::UNSIGNED_8:
-		case ast::BuiltInClass::UNQUALIFIED_8:
-		case ast::BuiltInClass::UNSIGNED_16:
-		case ast::BuiltInClass::UNSIGNED_32:
-		case ast::BuiltInClass::UNSIGNED_64: {
-			s32 size = builtin_class_size(bclass);
-			
-			u64 value = 0;
-			Result<void> read_result = elf.copy_virtual((u8*) &value, virtual_address, size);
-			CCC_RETURN_IF_ERROR(read_result);
-			
-			const char* format = generate_format_string(size, false);
-			data.value = stringf(format, value);
-			
+		case ast::BuiltInClass::UNQUALIFIED_8: {
+			write_unsigned(*(const u8*) data, output);
 			break;
 		}
-		case ast::BuiltInClass::SIGNED_8:
-		case ast::BuiltInClass::SIGNED_16:
-		case ast::BuiltInClass::SIGNED_32:
-		case ast::BuiltInClass::SIGNED_64: {
-			s32 size = builtin_class_size(bclass);
-			
-			s64 value = 0;
-			Result<void> read_result = elf.copy_virtual((u8*) &value, virtual_address, size);
-			CCC_RETURN_IF_ERROR(read_result);
-			
-			const char* format = generate_format_string(size, true);
-			data.value = stringf(format, value);
-			
+		case ast::BuiltInClass::SIGNED_8: {
+			write_signed(*(const s8*) data, output);
 			break;
 		}
 		case ast::BuiltInClass::BOOL_8: {
-			Result<u8> value = elf.get_object_virtual<u8>(virtual_address);
-			CCC_RETURN_IF_ERROR(value);
-			
-			data.value = *value ? "true" : "false";
-			
+			output += *data ? "true" : "false";
+			break;
+		}
+		case ast::BuiltInClass::UNSIGNED_16: {
+			u16 value;
+			memcpy(&value, data, 2);
+			write_unsigned(value, output);
+			break;
+		}
+		case ast::BuiltInClass::SIGNED_16: {
+			s16 value;
+			memcpy(&value, data, 2);
+			write_signed(value, output);
+			break;
+		}
+		case ast::BuiltInClass::UNSIGNED_32: {
+			u32 value;
+			memcpy(&value, data, 4);
+			write_unsigned(value, output);
+			break;
+		}
+		case ast::BuiltInClass::SIGNED_32: {
+			s32 value;
+			memcpy(&value, data, 4);
+			write_signed(value, output);
 			break;
 		}
 		case ast::BuiltInClass::FLOAT_32: {
 			static_assert(sizeof(float) == 4);
-			
-			Result<float> value = elf.get_object_virtual<float>(virtual_address);
-			CCC_RETURN_IF_ERROR(value);
-			
-			data.value = single_precision_float_to_string(*value);
-			
+			float value;
+			memcpy(&value, data, 4);
+			write_single_precision_float(value, output);
+			break;
+		}
+		case ast::BuiltInClass::UNSIGNED_64: {
+			u64 value;
+			memcpy(&value, data, 8);
+			write_unsigned(value, output);
+			break;
+		}
+		case ast::BuiltInClass::SIGNED_64: {
+			s64 value;
+			memcpy(&value, data, 8);
+			write_signed(value, output);
 			break;
 		}
 		case ast::BuiltInClass::FLOAT_64: {
 			static_assert(sizeof(double) == 8);
-			
-			Result<double> value = elf.get_object_virtual<double>(virtual_address);
-			CCC_RETURN_IF_ERROR(value);
-			
-			std::string string = stringf("%g", *value);
-			if(strtof(string.c_str(), nullptr) != *value) {
-				string = stringf("%.17g", *value);
-			}
-			data.value = std::move(string);
-			
+			double value;
+			memcpy(&value, data, 8);
+			write_double_precision_float(value, output);
 			break;
 		}
 		case ast::BuiltInClass::UNSIGNED_128:
 		case ast::BuiltInClass::SIGNED_128:
 		case ast::BuiltInClass::UNQUALIFIED_128:
 		case ast::BuiltInClass::FLOAT_128: {
-			Result<std::span<const float>> value = elf.get_array_virtual<float>(virtual_address, 4);
-			CCC_RETURN_IF_ERROR(value);
-			
-			data.value = stringf("VECTOR(%s, %s, %s, %s)",
-				single_precision_float_to_string((*value)[0]).c_str(),
-				single_precision_float_to_string((*value)[1]).c_str(),
-				single_precision_float_to_string((*value)[2]).c_str(),
-				single_precision_float_to_string((*value)[3]).c_str());
-				
+			float value[4];
+			memcpy(value, data, 16);
+			output += "VECTOR(";
+			for(s32 i = 0; i < 4; i++) {
+				if(i != 0) {
+					output += ", ";
+				}
+				write_single_precision_float(value[i], output);
+			}
+			output += ')';
 			break;
 		}
 	}
-	
-	return data;
 }
 
-static Result<RefinedData> refine_pointer_or_reference(
-	u32 virtual_address, const ast::Node& type, const SymbolDatabase& database, const ElfFile& elf)
+static void write_unsigned(u64 value, std::string& output)
 {
-	RefinedData data;
-	u32 pointer = 0;
-	Result<void> read_result = elf.copy_virtual((u8*) &pointer, virtual_address, 4);
-	CCC_RETURN_IF_ERROR(read_result);
-	
-	std::string string;
-	if(pointer != 0) {
-		FunctionHandle function_handle = database.functions.first_handle_from_starting_address(pointer);
-		const Function* function_symbol = database.functions.symbol_from_handle(function_handle);
-		
-		GlobalVariableHandle global_variable_handle = database.global_variables.first_handle_from_starting_address(pointer);
-		const GlobalVariable* global_variable_symbol = database.global_variables.symbol_from_handle(global_variable_handle);
-		
-		if(function_symbol) {
-			bool is_pointer = type.descriptor == ast::POINTER_OR_REFERENCE
-				&& type.as<ast::PointerOrReference>().is_pointer;
-			if(is_pointer) {
-				string += "&";
-			}
-			string += function_symbol->name();
-		} else if(global_variable_symbol) {
-			bool is_pointer = type.descriptor == ast::POINTER_OR_REFERENCE
-				&& type.as<ast::PointerOrReference>().is_pointer;
-			bool pointing_at_array = global_variable_symbol->type()
-				&& global_variable_symbol->type()->descriptor == ast::ARRAY;
-			if(is_pointer && !pointing_at_array) {
-				string += "&";
-			}
-			string += global_variable_symbol->name();
-		} else {
-			string = stringf("0x%x", pointer);
-		}
-	} else {
-		string = "NULL";
-	}
-	data.value = std::move(string);
-	
-	return data;
+	char buffer[32];
+	std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	output.append(buffer, result.ptr);
 }
 
-static const char* generate_format_string(s32 size, bool is_signed)
+static void write_signed(s64 value, std::string& output)
 {
-	switch(size) {
-		case 1: return is_signed ? "%hhd" : "%hhu";
-		case 2: return is_signed ? "%hd" : "%hu";
-		case 4: return is_signed ? "%d" : "%hu";
-	}
-	return is_signed ? ("%" PRId64) : ("%" PRIu64);
+	char buffer[32];
+	std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	output.append(buffer, result.ptr);
 }
 
-static std::string single_precision_float_to_string(float value)
+static void write_single_precision_float(float value, std::string& output)
 {
-	std::string result = stringf("%g", value);
-	if(strtof(result.c_str(), nullptr) != value) {
-		result = stringf("%.9g", value);
+	// Try the equivalent of %g first, then fall back to the shortest string
+	// that round trips.
+	char buffer[64];
+	std::to_chars_result result = std::to_chars(
+		buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+	float parsed = 0.f;
+	std::from_chars(buffer, result.ptr, parsed);
+	if(parsed != value) {
+		result = std::to_chars(buffer, buffer + sizeof(buffer), value);
 	}
-	if(result.find(".") == std::string::npos) {
-		result += ".";
+	
+	std::string_view string(buffer, result.ptr);
+	output += string;
+	if(string.find('.') == std::string_view::npos) {
+		output += '.';
 	}
-	result += "f";
-	return result;
+	output += 'f';
 }
 
-static std::string string_format(const char* format, va_list args)
+static void write_double_precision_float(double value, std::string& output)
 {
-	static char buffer[16 * 1024];
-	vsnprintf(buffer, sizeof(buffer), format, args);
-	return std::string(buffer);
+	char buffer[64];
+	std::to_chars_result result = std::to_chars(
+		buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+	double parsed = 0.0;
+	std::from_chars(buffer, result.ptr, parsed);
+	if(parsed != value) {
+		result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	}
+	
+	output.append(buffer, result.ptr);
 }
 
-static std::string stringf(const char* format, ...)
+static void write_indentation(s32 level, std::string& output)
 {
-	va_list args;
-	va_start(args, format);
-	std::string string = string_format(format, args);
-	va_end(args);
-	return string;
+	output.append(std::max(level, 0), '\t');
 }
 
 }
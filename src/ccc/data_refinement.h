@@ -5,16 +5,12 @@
 
 #include <functional>
 
+#include "ast.h"
 #include "elf.h"
 #include "symbol_database.h"
 
 namespace ccc {
 
-struct RefinedData {
-	std::string field_name;
-	std::variant<std::string, std::vector<RefinedData>> value;
-};
-
 struct VariableToRefine {
 	Address address;
 	const GlobalStorage* storage = nullptr;
@@ -22,7 +18,109 @@ struct VariableToRefine {
 };
 
 bool can_refine_variable(const VariableToRefine& variable);
-Result<RefinedData> refine_variable(
-	const VariableToRefine& variable, const SymbolDatabase& database, const ElfFile& elf);
+
+enum class DataLayoutOpcode : u8 {
+	BEGIN_LIST, // Struct or union.
+	END_LIST,
+	BEGIN_ARRAY, // Array with elements that aren't built-ins.
+	END_ARRAY,
+	BUILTIN_ARRAY, // Array of built-ins, printed in a single step.
+	BUILTIN,
+	ENUM,
+	POINTER,
+	TEXT
+};
+
+// How the comment before a value in an initializer list should be printed.
+enum class DataLayoutName : u8 {
+	NOT_IN_LIST,
+	FIELD, // /* .name = */
+	BASE_CLASS, // /* base class 0 = */
+	ARRAY_ELEMENT // /* [0] = */
+};
+
+struct DataLayoutInstruction {
+	DataLayoutOpcode opcode;
+	DataLayoutName name = DataLayoutName::NOT_IN_LIST;
+	bool is_last = false; // Omit the comma after this value.
+	bool is_pointer = false;
+	ast::BuiltInClass bclass = ast::BuiltInClass::VOID_TYPE;
+	s32 offset = 0; // Relative to the innermost array element being printed.
+	s32 element_count = 0;
+	s32 stride = 0;
+	s32 jump = 0; // Distance from a BEGIN_ARRAY to its END_ARRAY.
+	s32 base_class_index = 0;
+	const std::string* field_name = nullptr;
+	const ast::Enum* enumeration = nullptr;
+	const char* text = nullptr;
+};
+
+// A type compiled into a flat list of instructions which can be executed
+// against the data of a variable to print out an initializer.
+struct DataLayout {
+	std::vector<DataLayoutInstruction> instructions;
+	s32 extent = 0; // Number of bytes read.
+	// Data types that were inlined, used to invalidate the cache.
+	std::vector<std::pair<DataTypeHandle, u32>> dependencies;
+};
+
+struct PreparedVariable {
+	std::shared_ptr<const DataLayout> layout;
+	std::span<const u8> data;
+	
+	// Whether the initializer will be an initializer list.
+	bool is_list() const;
+};
+
+// Converts global variable data into structured initializer lists and
+// literals. The layout of each data type is only compiled once, and the output
+// is written out directly instead of building a tree of strings first.
+class DataRefiner {
+public:
+	DataRefiner(const SymbolDatabase& database, const ElfFile& elf);
+	
+	const SymbolDatabase& database() const { return m_database; }
+	const ElfFile& elf() const { return m_elf; }
+	
+	// Compile the type of the variable and make sure its data can be read.
+	Result<PreparedVariable> prepare_variable(const VariableToRefine& variable);
+	
+	// Print the initializer for a variable that has already been prepared.
+	void write_variable(const PreparedVariable& variable, s32 indentation_level, FILE* out);
+	void write_variable(const PreparedVariable& variable, s32 indentation_level, std::string& output);
+	
+protected:
+	enum class CompileStep : u8 {
+		COMPILE_NODE,
+		END_LIST,
+		END_ARRAY,
+		END_DATA_TYPE
+	};
+	
+	struct CompileFrame {
+		CompileStep step = CompileStep::COMPILE_NODE;
+		const ast::Node* node = nullptr;
+		s32 offset = 0;
+		DataLayoutInstruction name;
+		DataLayout* layout = nullptr;
+		// The layout of the element type for END_ARRAY.
+		std::unique_ptr<DataLayout> element;
+		// The data type being compiled and its layout for END_DATA_TYPE.
+		const DataType* data_type = nullptr;
+		std::shared_ptr<DataLayout> data_type_layout;
+	};
+	
+	Result<void> compile_node(const ast::Node& node, DataLayout& layout);
+	Result<void> compile_node_step(
+		CompileFrame& frame, std::vector<CompileFrame>& stack, std::vector<const DataType*>& data_types);
+	void finish_array(CompileFrame& frame);
+	std::shared_ptr<const DataLayout> lookup_data_type_layout(const DataType& data_type) const;
+	void execute(const PreparedVariable& variable, s32 indentation_level, std::string& output, FILE* out);
+	void write_pointer(u32 pointer, bool is_pointer, std::string& output);
+	
+	const SymbolDatabase& m_database;
+	const ElfFile& m_elf;
+	std::map<DataTypeHandle, std::shared_ptr<const DataLayout>> m_data_type_layouts;
+};
 
 }
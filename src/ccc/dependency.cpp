@@ -4,6 +4,7 @@
 #include "dependency.h"
 
 #include "ast.h"
+#include "profiler.h"
 
 namespace ccc {
 
@@ -32,6 +33,8 @@ static void map_types_to_files_based_on_reference_count_single_pass(SymbolDataba
 
 void map_types_to_files_based_on_this_pointers(SymbolDatabase& database)
 {
+	ProfileScope profile(ProfilePhase::POST_PASSES);
+	
 	for(const Function& function : database.functions) {
 		if(!function.parameter_variables().has_value() || function.parameter_variables()->empty()) {
 			continue;
@@ -74,6 +77,8 @@ void map_types_to_files_based_on_this_pointers(SymbolDatabase& database)
 
 void map_types_to_files_based_on_reference_count(SymbolDatabase& database)
 {
+	ProfileScope profile(ProfilePhase::POST_PASSES);
+	
 	map_types_to_files_based_on_reference_count_single_pass(database, false);
 	map_types_to_files_based_on_reference_count_single_pass(database, true);
 }
@@ -59,6 +59,19 @@ Result<void> import_symbols(
 	u32 importer_flags,
 	DemanglerFunctions demangler)
 {
+	Result<std::vector<StagedSymbol>> symbols = stage_symbols(symtab, strtab, importer_flags, demangler);
+	CCC_RETURN_IF_ERROR(symbols);
+	
+	return insert_staged_symbols(database, group, *symbols, importer_flags);
+}
+
+Result<std::vector<StagedSymbol>> stage_symbols(
+	std::span<const u8> symtab,
+	std::span<const u8> strtab,
+	u32 importer_flags,
+	DemanglerFunctions demangler)
+{
+	std::vector<StagedSymbol> output;
 	for(u32 i = 0; i < symtab.size() / sizeof(Symbol); i++) {
 		const Symbol* symbol = get_packed<Symbol>(symtab, i * sizeof(Symbol));
 		CCC_ASSERT(symbol);
@@ -72,79 +85,65 @@ Result<void> import_symbols(
 			continue;
 		}
 		
-		if(!(importer_flags & DONT_DEDUPLICATE_SYMBOLS)) {
-			if(database.functions.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-			
-			if(database.global_variables.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-			
-			if(database.local_variables.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-		}
-		
 		const char* string = get_string(strtab, symbol->name);
 		CCC_CHECK(string, "Symbol string out of range.");
 		
+		StagedSymbol staged;
+		staged.name = string;
+		staged.address = address;
+		staged.size = symbol->size;
+		
 		switch(symbol->type()) {
 			case SymbolType::NOTYPE: {
-				Result<Label*> label = database.labels.create_symbol(
-					string, group.source, group.module_symbol, address, importer_flags, demangler);
-				CCC_RETURN_IF_ERROR(label);
+				staged.type = StagedSymbolType::LABEL;
 				
 				// These symbols get emitted at the same addresses as functions
 				// and aren't extremely useful, so we want to mark them to
 				// prevent them from possibly being used as function names.
-				(*label)->is_junk =
-					(*label)->name() == "__gnu_compiled_c" ||
-					(*label)->name() == "__gnu_compiled_cplusplus" ||
-					(*label)->name() == "gcc2_compiled.";
+				staged.is_junk =
+					staged.name == "__gnu_compiled_c" ||
+					staged.name == "__gnu_compiled_cplusplus" ||
+					staged.name == "gcc2_compiled.";
 				
 				break;
 			}
 			case SymbolType::OBJECT: {
+				if(importer_flags & NO_GLOBAL_VARIABLES) {
+					continue;
+				}
+				
 				if(symbol->size != 0) {
-					Result<GlobalVariable*> global_variable = database.global_variables.create_symbol(
-						string, group.source, group.module_symbol, address, importer_flags, demangler);
-					CCC_RETURN_IF_ERROR(global_variable);
-					
-					if(*global_variable) {
-						(*global_variable)->set_size(symbol->size);
-					}
+					staged.type = StagedSymbolType::GLOBAL_VARIABLE;
+					staged.demangled_name = demangle_symbol_name(staged.name, importer_flags, demangler);
 				} else {
-					Result<Label*> label = database.labels.create_symbol(
-						string, group.source, group.module_symbol, address, importer_flags, demangler);
-					CCC_RETURN_IF_ERROR(label);
+					staged.type = StagedSymbolType::LABEL;
 				}
 				
 				break;
 			}
 			case SymbolType::FUNC: {
-				Result<Function*> function = database.functions.create_symbol(
-					string, group.source, group.module_symbol, address, importer_flags, demangler);
-				CCC_RETURN_IF_ERROR(function);
-				
-				if(*function) {
-					(*function)->set_size(symbol->size);
+				if(importer_flags & NO_FUNCTIONS) {
+					continue;
 				}
 				
+				staged.type = StagedSymbolType::FUNCTION;
+				staged.demangled_name = demangle_symbol_name(staged.name, importer_flags, demangler);
+				
 				break;
 			}
 			case SymbolType::FILE: {
-				Result<SourceFile*> source_file = database.source_files.create_symbol(
-					string, group.source, group.module_symbol);
-				CCC_RETURN_IF_ERROR(source_file);
-				
+				staged.type = StagedSymbolType::SOURCE_FILE;
 				break;
 			}
-			default: {}
+			default: {
+				continue;
+			}
 		}
+		
+		output.emplace_back(std::move(staged));
 	}
 	
-	return Result<void>();
+	return output;
 }
 
 Result<void> print_symbol_table(FILE* out, std::span<const u8> symtab, std::span<const u8> strtab)
@@ -14,6 +14,14 @@ Result<void> import_symbols(
 	std::span<const u8> strtab,
 	u32 importer_flags,
 	DemanglerFunctions demangler);
+
+// Read the symbols and demangle their names. This doesn't access the symbol
+// database, so it's safe to run while another symbol table is being imported.
+Result<std::vector<StagedSymbol>> stage_symbols(
+	std::span<const u8> symtab,
+	std::span<const u8> strtab,
+	u32 importer_flags,
+	DemanglerFunctions demangler);
 	
 Result<void> print_symbol_table(FILE* out, std::span<const u8> symtab, std::span<const u8> strtab);
 
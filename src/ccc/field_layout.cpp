@@ -0,0 +1,247 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "field_layout.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+static void flatten_struct_or_union(
+	FieldLayout& layout,
+	const ast::StructOrUnion& struct_or_union,
+	s32 base_offset,
+	const std::string& prefix,
+	const SymbolDatabase& database,
+	s32 depth);
+static bool is_layout_valid(const FieldLayout& layout, const SymbolDatabase& database);
+
+const FieldLayoutEntry* FieldLayout::entry_at_offset(s32 offset) const
+{
+	auto iterator = std::upper_bound(entries.begin(), entries.end(), offset,
+		[](s32 offset, const FieldLayoutEntry& entry) { return offset < entry.offset; });
+	
+	// Walk backwards until none of the remaining entries could overlap the
+	// offset. For structs this will only ever check a single entry.
+	const FieldLayoutEntry* result = nullptr;
+	for(s32 i = (s32) (iterator - entries.begin()) - 1; i >= 0 && max_end_offsets[i] > offset; i--) {
+		if(offset < entries[i].offset + entries[i].size) {
+			result = &entries[i];
+		}
+	}
+	
+	return result;
+}
+
+std::shared_ptr<const FieldLayout> FieldLayoutCache::layout(const DataType& data_type, const SymbolDatabase& database)
+{
+	if(!data_type.type() || data_type.type()->descriptor != ast::STRUCT_OR_UNION) {
+		return nullptr;
+	}
+	
+	std::lock_guard<std::mutex> lock(m_mutex);
+	
+	auto iterator = m_layouts.find(data_type.handle());
+	if(iterator != m_layouts.end() && is_layout_valid(*iterator->second, database)) {
+		return iterator->second;
+	}
+	
+	std::shared_ptr<FieldLayout> layout = build_field_layout(data_type.type()->as<ast::StructOrUnion>(), database);
+	layout->dependencies.emplace_back(data_type.handle(), data_type.generation());
+	
+	m_layouts[data_type.handle()] = layout;
+	
+	return layout;
+}
+
+std::optional<FieldLookupResult> FieldLayoutCache::field_at_offset(
+	const ast::Node& type, s32 offset, const SymbolDatabase& database, s32 max_depth)
+{
+	return lookup(type, nullptr, offset, database, max_depth);
+}
+
+std::optional<FieldLookupResult> FieldLayoutCache::field_at_offset(
+	const DataType& data_type, s32 offset, const SymbolDatabase& database, s32 max_depth)
+{
+	if(!data_type.type()) {
+		return std::nullopt;
+	}
+	return lookup(*data_type.type(), &data_type, offset, database, max_depth);
+}
+
+void FieldLayoutCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_layouts.clear();
+}
+
+std::optional<FieldLookupResult> FieldLayoutCache::lookup(
+	const ast::Node& type, const DataType* symbol, s32 offset, const SymbolDatabase& database, s32 max_depth)
+{
+	if(offset < 0) {
+		return std::nullopt;
+	}
+	
+	FieldLookupResult result;
+	const ast::Node* node = &type;
+	for(s32 depth = 0; depth < max_depth; depth++) {
+		auto [physical_type, data_type] = node->physical_type(database);
+		if(depth == 0 && !data_type) {
+			data_type = symbol;
+		}
+		
+		const FieldLayoutEntry* entry = nullptr;
+		if(physical_type->descriptor == ast::STRUCT_OR_UNION) {
+			// Use the cached layout if the struct is a named type, otherwise we
+			// have to build a temporary one.
+			std::shared_ptr<const FieldLayout> layout;
+			if(data_type) {
+				layout = this->layout(*data_type, database);
+			} else {
+				layout = build_field_layout(physical_type->as<ast::StructOrUnion>(), database);
+			}
+			if(layout) {
+				entry = layout->entry_at_offset(offset);
+			}
+			if(!entry) {
+				break;
+			}
+			
+			if(!result.path.empty()) {
+				result.path += '.';
+			}
+			result.path += entry->path;
+			offset -= entry->offset;
+			node = entry->node;
+		} else if(physical_type->descriptor == ast::ARRAY) {
+			const ast::Array& array = physical_type->as<ast::Array>();
+			s32 element_size = array.element_type->size_bytes;
+			if(element_size <= 0) {
+				break;
+			}
+			
+			s32 index = offset / element_size;
+			if(index >= array.element_count) {
+				break;
+			}
+			
+			result.path += '[';
+			result.path += std::to_string(index);
+			result.path += ']';
+			offset -= index * element_size;
+			node = array.element_type.get();
+		} else {
+			break;
+		}
+	}
+	
+	if(node == &type) {
+		return std::nullopt;
+	}
+	
+	result.node = node;
+	result.offset_in_node = offset;
+	
+	return result;
+}
+
+std::unique_ptr<FieldLayout> build_field_layout(
+	const ast::StructOrUnion& struct_or_union, const SymbolDatabase& database)
+{
+	std::unique_ptr<FieldLayout> layout = std::make_unique<FieldLayout>();
+	flatten_struct_or_union(*layout, struct_or_union, 0, "", database, 0);
+	
+	std::stable_sort(layout->entries.begin(), layout->entries.end(),
+		[](const FieldLayoutEntry& lhs, const FieldLayoutEntry& rhs) { return lhs.offset < rhs.offset; });
+	
+	s32 max_end_offset = 0;
+	layout->max_end_offsets.reserve(layout->entries.size());
+	for(const FieldLayoutEntry& entry : layout->entries) {
+		max_end_offset = std::max(max_end_offset, entry.offset + entry.size);
+		layout->max_end_offsets.emplace_back(max_end_offset);
+	}
+	
+	std::sort(layout->dependencies.begin(), layout->dependencies.end());
+	layout->dependencies.erase(
+		std::unique(layout->dependencies.begin(), layout->dependencies.end()), layout->dependencies.end());
+	
+	return layout;
+}
+
+static void flatten_struct_or_union(
+	FieldLayout& layout,
+	const ast::StructOrUnion& struct_or_union,
+	s32 base_offset,
+	const std::string& prefix,
+	const SymbolDatabase& database,
+	s32 depth)
+{
+	if(depth > 100) {
+		return;
+	}
+	
+	for(const std::unique_ptr<ast::Node>& base_class : struct_or_union.base_classes) {
+		if(base_class->descriptor != ast::TYPE_NAME) {
+			continue;
+		}
+		
+		DataTypeHandle handle = base_class->as<ast::TypeName>().data_type_handle;
+		const DataType* base_class_symbol = database.data_types.symbol_from_handle(handle);
+		if(!base_class_symbol || !base_class_symbol->type() || base_class_symbol->type()->descriptor != ast::STRUCT_OR_UNION) {
+			continue;
+		}
+		
+		layout.dependencies.emplace_back(handle, base_class_symbol->generation());
+		
+		flatten_struct_or_union(
+			layout,
+			base_class_symbol->type()->as<ast::StructOrUnion>(),
+			base_offset + base_class->offset_bytes,
+			prefix,
+			database,
+			depth + 1);
+	}
+	
+	for(const std::unique_ptr<ast::Node>& field : struct_or_union.fields) {
+		if(field->storage_class == STORAGE_CLASS_STATIC) {
+			continue;
+		}
+		
+		// Pull the fields of inline structs and unions up into this layout.
+		if(field->descriptor == ast::STRUCT_OR_UNION) {
+			std::string new_prefix = field->name.empty() ? prefix : prefix + field->name + ".";
+			flatten_struct_or_union(
+				layout,
+				field->as<ast::StructOrUnion>(),
+				base_offset + field->offset_bytes,
+				new_prefix,
+				database,
+				depth + 1);
+			continue;
+		}
+		
+		s32 size = field->size_bytes;
+		if(size <= 0 && field->size_bits > 0) {
+			size = (field->size_bits + 7) / 8;
+		}
+		
+		FieldLayoutEntry& entry = layout.entries.emplace_back();
+		entry.offset = base_offset + field->offset_bytes;
+		entry.size = std::max(size, 1);
+		entry.node = field.get();
+		entry.path = prefix + field->name;
+	}
+}
+
+static bool is_layout_valid(const FieldLayout& layout, const SymbolDatabase& database)
+{
+	for(const auto& [handle, generation] : layout.dependencies) {
+		const DataType* data_type = database.data_types.symbol_from_handle(handle);
+		if(!data_type || data_type->generation() != generation) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,74 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <mutex>
+
+#include "ast.h"
+
+namespace ccc {
+
+struct FieldLayoutEntry {
+	s32 offset = 0;
+	s32 size = 0;
+	const ast::Node* node = nullptr;
+	// Path relative to the start of the struct e.g. "a.b" if a is an inline
+	// struct, or just "c" for a field inherited from a base class.
+	std::string path;
+};
+
+// All the fields of a struct or union, including those of base classes and
+// inline structs and unions, sorted by their offsets.
+struct FieldLayout {
+	std::vector<FieldLayoutEntry> entries;
+	// The highest end offset of all the entries up to and including each index,
+	// so that we can stop searching for overlapping union members early.
+	std::vector<s32> max_end_offsets;
+	// Data types that were flattened into this layout, used to invalidate the
+	// cache.
+	std::vector<std::pair<DataTypeHandle, u32>> dependencies;
+	
+	// Find the first field (in declaration order) that contains the given
+	// offset using a binary search.
+	const FieldLayoutEntry* entry_at_offset(s32 offset) const;
+};
+
+struct FieldLookupResult {
+	std::string path; // e.g. "a.b[3].c"
+	const ast::Node* node = nullptr; // The innermost field or array element.
+	s32 offset_in_node = 0;
+};
+
+// Lazily builds and caches the flattened field layouts of data types. Entries
+// are rebuilt if the generation of the data type (or of any of its base
+// classes) changes. This class is safe to use from multiple threads.
+class FieldLayoutCache {
+public:
+	// Retrieve the layout for a struct or union data type, building it if
+	// necessary. Returns nullptr for other types.
+	std::shared_ptr<const FieldLayout> layout(const DataType& data_type, const SymbolDatabase& database);
+	
+	// Determine which field is at a given offset into an object of the given
+	// type, descending into nested structs, unions and arrays. Returns nullopt
+	// if the offset isn't inside of any field.
+	std::optional<FieldLookupResult> field_at_offset(
+		const ast::Node& type, s32 offset, const SymbolDatabase& database, s32 max_depth = 100);
+	std::optional<FieldLookupResult> field_at_offset(
+		const DataType& data_type, s32 offset, const SymbolDatabase& database, s32 max_depth = 100);
+	
+	void clear();
+	
+protected:
+	std::optional<FieldLookupResult> lookup(
+		const ast::Node& type, const DataType* symbol, s32 offset, const SymbolDatabase& database, s32 max_depth);
+	
+	std::mutex m_mutex;
+	std::map<DataTypeHandle, std::shared_ptr<const FieldLayout>> m_layouts;
+};
+
+// Build the flattened layout of a struct or union without caching it.
+std::unique_ptr<FieldLayout> build_field_layout(
+	const ast::StructOrUnion& struct_or_union, const SymbolDatabase& database);
+
+}
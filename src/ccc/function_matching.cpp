@@ -0,0 +1,648 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "function_matching.h"
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+#include "ast.h"
+
+namespace ccc {
+
+// Don't bother comparing against LSH buckets that are this big, since they
+// will be full of tiny boilerplate functions that would match anyway.
+static const size_t MAX_BUCKET_SIZE = 64;
+
+struct TransferState {
+	SymbolDatabase& target_database;
+	const SymbolDatabase& source_database;
+	const SymbolGroup& group;
+	std::map<DataTypeHandle, DataTypeHandle> data_types;
+	// The keys of the map above in the order they were inserted, so that
+	// entries can be removed again when a speculative copy is undone.
+	std::vector<DataTypeHandle> data_type_order;
+};
+
+// The parts of a source function that have been copied into the target
+// database but not yet attached to the matched function.
+struct CopiedFunction {
+	const Function* source = nullptr;
+	FunctionHandle target;
+	std::unique_ptr<ast::Node> type;
+	std::optional<std::vector<ParameterVariableHandle>> parameter_variables;
+};
+
+static u32 normalise_instruction(u32 instruction);
+static u32 mix(u32 value);
+static void compute_signature(
+	FunctionSignature& signature, std::span<const u32> code, const FunctionMatchingConfig& config);
+static u64 band_key(const FunctionSignature& signature, s32 band);
+static s32 count_equal_min_hashes(const FunctionSignature& lhs, const FunctionSignature& rhs);
+static Result<std::unique_ptr<ast::Node>> copy_node(const ast::Node& node, TransferState& state);
+static Result<DataTypeHandle> copy_data_type(DataTypeHandle source_handle, TransferState& state);
+static Result<DataTypeHandle> find_equivalent_data_type(
+	DataTypeHandle source_handle, const DataType& source, TransferState& state);
+static Result<CopiedFunction> copy_function(const Function& source, FunctionHandle target, TransferState& state);
+static void attach_copied_function(CopiedFunction& copy, SymbolDatabase& database);
+
+std::vector<FunctionSignature> compute_function_signatures(
+	const SymbolDatabase& database, const ElfFile& elf, const FunctionMatchingConfig& config)
+{
+	std::vector<const Function*> functions;
+	for(const Function& function : database.functions) {
+		if(function.address().valid() && function.size() >= 4) {
+			functions.emplace_back(&function);
+		}
+	}
+	
+	std::vector<FunctionSignature> signatures(functions.size());
+	parallel_for((s32) functions.size(), config.thread_count, [&](s32 i, s32) {
+		FunctionSignature& signature = signatures[i];
+		signature.function = functions[i]->handle();
+		signature.address = functions[i]->address();
+		
+		Result<std::span<const u32>> code = elf.get_array_virtual<u32>(
+			functions[i]->address().value, functions[i]->size() / 4);
+		if(code.success()) {
+			compute_signature(signature, *code, config);
+		}
+	});
+	
+	// Drop functions where the code couldn't be read.
+	std::erase_if(signatures, [](const FunctionSignature& signature) {
+		return signature.instruction_count == 0;
+	});
+	
+	return signatures;
+}
+
+std::vector<FunctionMatch> match_functions(
+	std::span<const FunctionSignature> source,
+	std::span<const FunctionSignature> target,
+	const FunctionMatchingConfig& config)
+{
+	std::vector<FunctionMatch> matches;
+	std::vector<bool> source_matched(source.size(), false);
+	std::vector<bool> target_matched(target.size(), false);
+	
+	// First pass: Pair up functions that have an exact hash that is unique in
+	// both programs.
+	struct ExactEntry {
+		s32 source_index = -1;
+		s32 source_count = 0;
+		s32 target_index = -1;
+		s32 target_count = 0;
+	};
+	
+	std::unordered_map<u64, ExactEntry> exact;
+	for(s32 i = 0; i < (s32) source.size(); i++) {
+		ExactEntry& entry = exact[((u64) source[i].instruction_count << 32) | source[i].exact_hash];
+		entry.source_index = i;
+		entry.source_count++;
+	}
+	for(s32 i = 0; i < (s32) target.size(); i++) {
+		auto entry = exact.find(((u64) target[i].instruction_count << 32) | target[i].exact_hash);
+		if(entry != exact.end()) {
+			entry->second.target_index = i;
+			entry->second.target_count++;
+		}
+	}
+	
+	for(auto& [key, entry] : exact) {
+		if(entry.source_count == 1 && entry.target_count == 1) {
+			FunctionMatch& match = matches.emplace_back();
+			match.source = source[entry.source_index].function;
+			match.target = target[entry.target_index].function;
+			match.similarity = 1.f;
+			source_matched[entry.source_index] = true;
+			target_matched[entry.target_index] = true;
+		}
+	}
+	
+	// Second pass: Build a locality-sensitive hash table from the MinHash
+	// bands of the remaining target functions.
+	std::vector<std::unordered_map<u64, std::vector<s32>>> buckets(FUNCTION_MINHASH_BANDS);
+	for(s32 i = 0; i < (s32) target.size(); i++) {
+		if(target_matched[i] || target[i].instruction_count < config.min_fuzzy_instruction_count) {
+			continue;
+		}
+		for(s32 band = 0; band < FUNCTION_MINHASH_BANDS; band++) {
+			buckets[band][band_key(target[i], band)].emplace_back(i);
+		}
+	}
+	
+	// Find the best candidate for each remaining source function.
+	struct Proposal {
+		s32 source_index = -1;
+		s32 target_index = -1;
+		s32 equal_count = 0;
+	};
+	
+	s32 min_equal_count = (s32) ceilf(config.min_similarity * FUNCTION_MINHASH_SIZE);
+	
+	std::vector<Proposal> proposals(source.size());
+	parallel_for((s32) source.size(), config.thread_count, [&](s32 i, s32) {
+		if(source_matched[i] || source[i].instruction_count < config.min_fuzzy_instruction_count) {
+			return;
+		}
+		
+		std::vector<s32> candidates;
+		for(s32 band = 0; band < FUNCTION_MINHASH_BANDS; band++) {
+			auto bucket = buckets[band].find(band_key(source[i], band));
+			if(bucket != buckets[band].end() && bucket->second.size() <= MAX_BUCKET_SIZE) {
+				candidates.insert(candidates.end(), bucket->second.begin(), bucket->second.end());
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		
+		Proposal& proposal = proposals[i];
+		bool ambiguous = false;
+		for(s32 candidate : candidates) {
+			s32 equal_count = count_equal_min_hashes(source[i], target[candidate]);
+			if(equal_count > proposal.equal_count) {
+				proposal.source_index = i;
+				proposal.target_index = candidate;
+				proposal.equal_count = equal_count;
+				ambiguous = false;
+			} else if(equal_count == proposal.equal_count) {
+				ambiguous = true;
+			}
+		}
+		
+		if(ambiguous || proposal.equal_count < min_equal_count) {
+			proposal = Proposal();
+		}
+	});
+	
+	// Accept the best proposals first so that each target function is only
+	// matched once.
+	std::erase_if(proposals, [](const Proposal& proposal) {
+		return proposal.source_index == -1;
+	});
+	std::sort(proposals.begin(), proposals.end(), [](const Proposal& lhs, const Proposal& rhs) {
+		if(lhs.equal_count != rhs.equal_count) {
+			return lhs.equal_count > rhs.equal_count;
+		}
+		return lhs.source_index < rhs.source_index;
+	});
+	
+	for(const Proposal& proposal : proposals) {
+		if(target_matched[proposal.target_index]) {
+			continue;
+		}
+		
+		FunctionMatch& match = matches.emplace_back();
+		match.source = source[proposal.source_index].function;
+		match.target = target[proposal.target_index].function;
+		match.similarity = proposal.equal_count / (float) FUNCTION_MINHASH_SIZE;
+		target_matched[proposal.target_index] = true;
+	}
+	
+	std::sort(matches.begin(), matches.end(), [](const FunctionMatch& lhs, const FunctionMatch& rhs) {
+		return lhs.target < rhs.target;
+	});
+	
+	return matches;
+}
+
+Result<s32> transfer_function_symbols(
+	SymbolDatabase& target_database,
+	const SymbolDatabase& source_database,
+	std::span<const FunctionMatch> matches,
+	const SymbolGroup& group)
+{
+	TransferState state{target_database, source_database, group};
+	
+	// If anything goes wrong, undo all the changes made to the database. Since
+	// modifications to the fields of the matched functions aren't recorded in
+	// the undo journal, everything that can fail is done before any of them
+	// are touched.
+	target_database.begin_transaction();
+	
+	std::vector<CopiedFunction> copies;
+	for(const FunctionMatch& match : matches) {
+		const Function* source = source_database.functions.symbol_from_handle(match.source);
+		const Function* target = target_database.functions.symbol_from_handle(match.target);
+		if(!source || !target) {
+			continue;
+		}
+		
+		Result<CopiedFunction> copy = copy_function(*source, match.target, state);
+		if(!copy.success()) {
+			target_database.rollback_transaction();
+			return copy;
+		}
+		
+		copies.emplace_back(std::move(*copy));
+	}
+	
+	for(CopiedFunction& copy : copies) {
+		attach_copied_function(copy, target_database);
+	}
+	
+	// Free any parameters that were replaced.
+	target_database.destroy_marked_symbols();
+	
+	target_database.commit_transaction();
+	
+	return (s32) copies.size();
+}
+
+static u32 normalise_instruction(u32 instruction)
+{
+	// Only keep the fields that select the operation, since register numbers
+	// and immediates will change between builds and when relocations are
+	// applied.
+	u32 opcode = instruction >> 26;
+	switch(opcode) {
+		case 0x00: // SPECIAL
+		case 0x1c: // MMI
+			return (opcode << 8) | (instruction & 0x3f);
+		case 0x01: // REGIMM
+		case 0x10: // COP0
+		case 0x11: // COP1
+		case 0x12: // COP2
+			return (opcode << 8) | ((instruction >> 16) & 0x1f) | (((instruction >> 21) & 0x1f) << 5);
+	}
+	return opcode << 8;
+}
+
+static u32 mix(u32 value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352d;
+	value ^= value >> 15;
+	value *= 0x846ca68b;
+	value ^= value >> 16;
+	return value;
+}
+
+static void compute_signature(
+	FunctionSignature& signature, std::span<const u32> code, const FunctionMatchingConfig& config)
+{
+	signature.instruction_count = (u32) code.size();
+	
+	FunctionHash hash;
+	std::vector<u32> normalised(code.size());
+	for(size_t i = 0; i < code.size(); i++) {
+		hash.update(code[i]);
+		normalised[i] = normalise_instruction(code[i]);
+	}
+	signature.exact_hash = hash.get();
+	
+	signature.min_hashes.fill(UINT32_MAX);
+	
+	size_t ngram_size = std::min((size_t) std::max(config.ngram_size, 1), normalised.size());
+	for(size_t i = 0; i + ngram_size <= normalised.size(); i++) {
+		u32 ngram = 0;
+		for(size_t j = 0; j < ngram_size; j++) {
+			ngram = mix(ngram ^ normalised[i + j]);
+		}
+		for(s32 k = 0; k < FUNCTION_MINHASH_SIZE; k++) {
+			u32 value = mix(ngram ^ (0x9e3779b9 * (k + 1)));
+			signature.min_hashes[k] = std::min(signature.min_hashes[k], value);
+		}
+	}
+}
+
+static u64 band_key(const FunctionSignature& signature, s32 band)
+{
+	u64 key = band;
+	for(s32 row = 0; row < FUNCTION_MINHASH_ROWS; row++) {
+		key = key * 0x100000001b3 ^ signature.min_hashes[band * FUNCTION_MINHASH_ROWS + row];
+	}
+	return key;
+}
+
+static s32 count_equal_min_hashes(const FunctionSignature& lhs, const FunctionSignature& rhs)
+{
+	s32 count = 0;
+	for(s32 i = 0; i < FUNCTION_MINHASH_SIZE; i++) {
+		count += lhs.min_hashes[i] == rhs.min_hashes[i];
+	}
+	return count;
+}
+
+static Result<std::unique_ptr<ast::Node>> copy_node(const ast::Node& node, TransferState& state)
+{
+	std::unique_ptr<ast::Node> result;
+	switch(node.descriptor) {
+		case ast::ARRAY: {
+			const ast::Array& src = node.as<ast::Array>();
+			std::unique_ptr<ast::Array> dest = std::make_unique<ast::Array>();
+			Result<std::unique_ptr<ast::Node>> element_type = copy_node(*src.element_type, state);
+			CCC_RETURN_IF_ERROR(element_type);
+			dest->element_type = std::move(*element_type);
+			dest->element_count = src.element_count;
+			result = std::move(dest);
+			break;
+		}
+		case ast::BITFIELD: {
+			const ast::BitField& src = node.as<ast::BitField>();
+			std::unique_ptr<ast::BitField> dest = std::make_unique<ast::BitField>();
+			dest->bitfield_offset_bits = src.bitfield_offset_bits;
+			Result<std::unique_ptr<ast::Node>> underlying_type = copy_node(*src.underlying_type, state);
+			CCC_RETURN_IF_ERROR(underlying_type);
+			dest->underlying_type = std::move(*underlying_type);
+			result = std::move(dest);
+			break;
+		}
+		case ast::BUILTIN: {
+			std::unique_ptr<ast::BuiltIn> dest = std::make_unique<ast::BuiltIn>();
+			dest->bclass = node.as<ast::BuiltIn>().bclass;
+			result = std::move(dest);
+			break;
+		}
+		case ast::ENUM: {
+			std::unique_ptr<ast::Enum> dest = std::make_unique<ast::Enum>();
+			dest->constants = node.as<ast::Enum>().constants;
+			result = std::move(dest);
+			break;
+		}
+		case ast::ERROR_NODE: {
+			std::unique_ptr<ast::Error> dest = std::make_unique<ast::Error>();
+			dest->message = node.as<ast::Error>().message;
+			result = std::move(dest);
+			break;
+		}
+		case ast::FUNCTION: {
+			const ast::Function& src = node.as<ast::Function>();
+			std::unique_ptr<ast::Function> dest = std::make_unique<ast::Function>();
+			if(src.return_type.has_value()) {
+				Result<std::unique_ptr<ast::Node>> return_type = copy_node(**src.return_type, state);
+				CCC_RETURN_IF_ERROR(return_type);
+				dest->return_type = std::move(*return_type);
+			}
+			if(src.parameters.has_value()) {
+				dest->parameters.emplace();
+				for(const std::unique_ptr<ast::Node>& parameter : *src.parameters) {
+					Result<std::unique_ptr<ast::Node>> parameter_copy = copy_node(*parameter, state);
+					CCC_RETURN_IF_ERROR(parameter_copy);
+					dest->parameters->emplace_back(std::move(*parameter_copy));
+				}
+			}
+			dest->modifier = src.modifier;
+			dest->vtable_index = src.vtable_index;
+			result = std::move(dest);
+			break;
+		}
+		case ast::POINTER_OR_REFERENCE: {
+			const ast::PointerOrReference& src = node.as<ast::PointerOrReference>();
+			std::unique_ptr<ast::PointerOrReference> dest = std::make_unique<ast::PointerOrReference>();
+			dest->is_pointer = src.is_pointer;
+			Result<std::unique_ptr<ast::Node>> value_type = copy_node(*src.value_type, state);
+			CCC_RETURN_IF_ERROR(value_type);
+			dest->value_type = std::move(*value_type);
+			result = std::move(dest);
+			break;
+		}
+		case ast::POINTER_TO_DATA_MEMBER: {
+			const ast::PointerToDataMember& src = node.as<ast::PointerToDataMember>();
+			std::unique_ptr<ast::PointerToDataMember> dest = std::make_unique<ast::PointerToDataMember>();
+			Result<std::unique_ptr<ast::Node>> class_type = copy_node(*src.class_type, state);
+			CCC_RETURN_IF_ERROR(class_type);
+			dest->class_type = std::move(*class_type);
+			Result<std::unique_ptr<ast::Node>> member_type = copy_node(*src.member_type, state);
+			CCC_RETURN_IF_ERROR(member_type);
+			dest->member_type = std::move(*member_type);
+			result = std::move(dest);
+			break;
+		}
+		case ast::STRUCT_OR_UNION: {
+			const ast::StructOrUnion& src = node.as<ast::StructOrUnion>();
+			std::unique_ptr<ast::StructOrUnion> dest = std::make_unique<ast::StructOrUnion>();
+			dest->is_struct = src.is_struct;
+			for(const std::unique_ptr<ast::Node>& base_class : src.base_classes) {
+				Result<std::unique_ptr<ast::Node>> copy = copy_node(*base_class, state);
+				CCC_RETURN_IF_ERROR(copy);
+				dest->base_classes.emplace_back(std::move(*copy));
+			}
+			for(const std::unique_ptr<ast::Node>& field : src.fields) {
+				Result<std::unique_ptr<ast::Node>> copy = copy_node(*field, state);
+				CCC_RETURN_IF_ERROR(copy);
+				dest->fields.emplace_back(std::move(*copy));
+			}
+			for(const std::unique_ptr<ast::Node>& member_function : src.member_functions) {
+				Result<std::unique_ptr<ast::Node>> copy = copy_node(*member_function, state);
+				CCC_RETURN_IF_ERROR(copy);
+				dest->member_functions.emplace_back(std::move(*copy));
+			}
+			result = std::move(dest);
+			break;
+		}
+		case ast::TYPE_NAME: {
+			const ast::TypeName& src = node.as<ast::TypeName>();
+			std::unique_ptr<ast::TypeName> dest = std::make_unique<ast::TypeName>();
+			Result<DataTypeHandle> data_type_handle = copy_data_type(src.data_type_handle, state);
+			CCC_RETURN_IF_ERROR(data_type_handle);
+			dest->data_type_handle = *data_type_handle;
+			dest->source = src.source;
+			dest->is_forward_declared = src.is_forward_declared;
+			if(src.unresolved_stabs) {
+				dest->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>(*src.unresolved_stabs);
+				dest->unresolved_stabs->referenced_file_handle = SourceFileHandle();
+			}
+			result = std::move(dest);
+			break;
+		}
+	}
+	
+	CCC_ASSERT(result);
+	result->is_const = node.is_const;
+	result->is_volatile = node.is_volatile;
+	result->is_virtual_base_class = node.is_virtual_base_class;
+	result->is_vtable_pointer = node.is_vtable_pointer;
+	result->is_constructor_or_destructor = node.is_constructor_or_destructor;
+	result->is_special_member_function = node.is_special_member_function;
+	result->is_operator_member_function = node.is_operator_member_function;
+	result->cannot_compute_size = node.cannot_compute_size;
+	result->storage_class = node.storage_class;
+	result->access_specifier = node.access_specifier;
+	result->size_bytes = node.size_bytes;
+	result->name = node.name;
+	result->offset_bytes = node.offset_bytes;
+	result->size_bits = node.size_bits;
+	
+	return result;
+}
+
+static Result<DataTypeHandle> copy_data_type(DataTypeHandle source_handle, TransferState& state)
+{
+	auto iterator = state.data_types.find(source_handle);
+	if(iterator != state.data_types.end()) {
+		return iterator->second;
+	}
+	
+	const DataType* source = state.source_database.data_types.symbol_from_handle(source_handle);
+	if(!source) {
+		return DataTypeHandle();
+	}
+	
+	Result<DataTypeHandle> existing_handle = find_equivalent_data_type(source_handle, *source, state);
+	CCC_RETURN_IF_ERROR(existing_handle);
+	if(existing_handle->valid()) {
+		return *existing_handle;
+	}
+	
+	Result<DataType*> target = state.target_database.data_types.create_symbol(
+		source->name(), state.group.source, state.group.module_symbol);
+	CCC_RETURN_IF_ERROR(target);
+	
+	DataTypeHandle target_handle = (*target)->handle();
+	(*target)->not_defined_in_any_translation_unit = source->not_defined_in_any_translation_unit;
+	(*target)->only_defined_in_single_translation_unit = source->only_defined_in_single_translation_unit;
+	
+	// Add the type to the map before copying its AST so that recursive types
+	// can reference themselves.
+	state.data_types.emplace(source_handle, target_handle);
+	state.data_type_order.emplace_back(source_handle);
+	
+	if(source->type()) {
+		Result<std::unique_ptr<ast::Node>> type = copy_node(*source->type(), state);
+		CCC_RETURN_IF_ERROR(type);
+		
+		// Copying the AST may have created other data types, so we need to
+		// look up the symbol again.
+		DataType* data_type = state.target_database.data_types.symbol_from_handle(target_handle);
+		CCC_ASSERT(data_type);
+		data_type->set_type(std::move(*type));
+	}
+	
+	return target_handle;
+}
+
+static Result<DataTypeHandle> find_equivalent_data_type(
+	DataTypeHandle source_handle, const DataType& source, TransferState& state)
+{
+	if(!source.type()) {
+		return DataTypeHandle();
+	}
+	
+	// Only consider types from the same group, like create_data_type_if_unique
+	// does, so that all the types from one source can be destroyed together.
+	std::vector<DataTypeHandle> candidates;
+	for(DataTypeHandle handle : state.target_database.data_types.handles_from_name(source.name())) {
+		const DataType* candidate = state.target_database.data_types.symbol_from_handle(handle);
+		if(candidate
+			&& candidate->type()
+			&& candidate->type()->descriptor == source.type()->descriptor
+			&& state.group.is_in_group(*candidate)) {
+			candidates.emplace_back(handle);
+		}
+	}
+	
+	for(DataTypeHandle candidate_handle : candidates) {
+		// Copy the AST as if the source type had already been copied to the
+		// candidate, so that recursive types can compare equal, and undo
+		// everything that was created if it turns out not to match.
+		UndoSavepoint savepoint = state.target_database.savepoint();
+		size_t data_type_count = state.data_type_order.size();
+		state.data_types.emplace(source_handle, candidate_handle);
+		state.data_type_order.emplace_back(source_handle);
+		
+		Result<std::unique_ptr<ast::Node>> type = copy_node(*source.type(), state);
+		CCC_RETURN_IF_ERROR(type);
+		
+		const DataType* candidate = state.target_database.data_types.symbol_from_handle(candidate_handle);
+		CCC_ASSERT(candidate && candidate->type());
+		ast::CompareResult compare_result = compare_nodes(*candidate->type(), **type, &state.target_database, true);
+		if(compare_result.type != ast::CompareResultType::DIFFERS) {
+			return candidate_handle;
+		}
+		
+		state.target_database.rollback_to_savepoint(savepoint);
+		for(size_t i = data_type_count; i < state.data_type_order.size(); i++) {
+			state.data_types.erase(state.data_type_order[i]);
+		}
+		state.data_type_order.resize(data_type_count);
+	}
+	
+	return DataTypeHandle();
+}
+
+static Result<CopiedFunction> copy_function(const Function& source, FunctionHandle target, TransferState& state)
+{
+	CopiedFunction copy;
+	copy.source = &source;
+	copy.target = target;
+	
+	if(source.type()) {
+		Result<std::unique_ptr<ast::Node>> type = copy_node(*source.type(), state);
+		CCC_RETURN_IF_ERROR(type);
+		copy.type = std::move(*type);
+	}
+	
+	if(!source.parameter_variables().has_value()) {
+		return copy;
+	}
+	
+	SymbolDatabase& database = state.target_database;
+	
+	copy.parameter_variables.emplace();
+	for(ParameterVariableHandle source_handle : *source.parameter_variables()) {
+		const ParameterVariable* source_parameter = state.source_database.parameter_variables.symbol_from_handle(source_handle);
+		if(!source_parameter) {
+			continue;
+		}
+		
+		Result<ParameterVariable*> target_parameter = database.parameter_variables.create_symbol(
+			source_parameter->name(), state.group.source, state.group.module_symbol);
+		CCC_RETURN_IF_ERROR(target_parameter);
+		
+		ParameterVariableHandle target_handle = (*target_parameter)->handle();
+		(*target_parameter)->storage = source_parameter->storage;
+		copy.parameter_variables->emplace_back(target_handle);
+		
+		if(source_parameter->type()) {
+			Result<std::unique_ptr<ast::Node>> type = copy_node(*source_parameter->type(), state);
+			CCC_RETURN_IF_ERROR(type);
+			
+			database.parameter_variables.retype_symbol(target_handle, std::move(*type));
+		}
+	}
+	
+	return copy;
+}
+
+static void attach_copied_function(CopiedFunction& copy, SymbolDatabase& database)
+{
+	const Function& source = *copy.source;
+	
+	Function* target = database.functions.symbol_from_handle(copy.target);
+	CCC_ASSERT(target);
+	
+	database.functions.rename_symbol(copy.target, source.name());
+	if(source.mangled_name() != source.name()) {
+		target->set_mangled_name(source.mangled_name());
+	}
+	target->relative_path = source.relative_path;
+	target->storage_class = source.storage_class;
+	target->stack_frame_size = source.stack_frame_size;
+	target->saved_register_mask = source.saved_register_mask;
+	target->saved_register_offset = source.saved_register_offset;
+	target->return_pc_register = source.return_pc_register;
+	target->is_member_function_ish = source.is_member_function_ish;
+	target->is_no_return = source.is_no_return;
+	
+	if(copy.type) {
+		database.functions.retype_symbol(copy.target, std::move(copy.type));
+	}
+	
+	if(!copy.parameter_variables.has_value()) {
+		return;
+	}
+	
+	// Replace any existing parameters.
+	if(target->parameter_variables().has_value()) {
+		for(ParameterVariableHandle parameter_variable : *target->parameter_variables()) {
+			database.parameter_variables.mark_symbol_for_destruction(parameter_variable, &database);
+		}
+	}
+	
+	target->set_parameter_variables(std::move(*copy.parameter_variables), database);
+}
+
+}
@@ -0,0 +1,73 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "elf.h"
+#include "symbol_database.h"
+
+namespace ccc {
+
+// Number of MinHash values stored per function. These are split up into bands
+// for the locality-sensitive hash table.
+static constexpr const s32 FUNCTION_MINHASH_SIZE = 32;
+static constexpr const s32 FUNCTION_MINHASH_BANDS = 8;
+static constexpr const s32 FUNCTION_MINHASH_ROWS = FUNCTION_MINHASH_SIZE / FUNCTION_MINHASH_BANDS;
+
+// A fingerprint of the code of a function that doesn't depend on relocations
+// or the registers allocated, so that it can be compared between builds.
+struct FunctionSignature {
+	FunctionHandle function;
+	Address address;
+	u32 instruction_count = 0;
+	// Equivalent to FunctionHash, used to find exact matches.
+	u32 exact_hash = 0;
+	// MinHash sketch of the set of instruction n-grams, used to find similar
+	// functions where a few instructions have been added or removed.
+	std::array<u32, FUNCTION_MINHASH_SIZE> min_hashes;
+};
+
+struct FunctionMatchingConfig {
+	// Number of consecutive instructions that make up each n-gram.
+	s32 ngram_size = 4;
+	// Functions shorter than this will only be matched if their exact hashes
+	// are unique in both programs.
+	u32 min_fuzzy_instruction_count = 8;
+	// The fraction of MinHash values that must be equal for a fuzzy match.
+	float min_similarity = 0.75f;
+	// Set to zero to use all the available cores.
+	s32 thread_count = 0;
+};
+
+struct FunctionMatch {
+	FunctionHandle source; // Function from the database with symbols.
+	FunctionHandle target; // Function from the database without symbols.
+	float similarity = 0.f; // 1 for exact matches.
+};
+
+// Compute signatures for all the functions in a database that have both an
+// address and a size. The code is read from the given ELF file.
+std::vector<FunctionSignature> compute_function_signatures(
+	const SymbolDatabase& database, const ElfFile& elf, const FunctionMatchingConfig& config);
+
+// Find functions in the target program that correspond to functions in the
+// source program. Exact matches that are unique in both programs are accepted
+// first, then the remaining functions are paired up using a MinHash LSH index.
+// Each function will be matched at most once.
+std::vector<FunctionMatch> match_functions(
+	std::span<const FunctionSignature> source,
+	std::span<const FunctionSignature> target,
+	const FunctionMatchingConfig& config);
+
+// Copy the names, types, parameters and any data types they reference from the
+// source database onto the matched functions in the target database. Returns
+// the number of functions that were updated. Data types that are equivalent
+// to ones previously copied into the same symbol group are reused. If an error
+// occurs, the target database is left unchanged.
+Result<s32> transfer_function_symbols(
+	SymbolDatabase& target_database,
+	const SymbolDatabase& source_database,
+	std::span<const FunctionMatch> matches,
+	const SymbolGroup& group);
+
+}
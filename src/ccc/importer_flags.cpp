@@ -33,6 +33,16 @@ const std::vector<ImporterFlagInfo> IMPORTER_FLAGS = {
 	{NO_ACCESS_SPECIFIERS, "--no-access-specifiers", {
 		"Do not print access specifiers."
 	}},
+	{NO_FUNCTIONS, "--no-functions", {
+		"Do not import functions, or their parameters",
+		"and local variables."
+	}},
+	{NO_GLOBAL_VARIABLES, "--no-global-variables", {
+		"Do not import global variables."
+	}},
+	{NO_LOCAL_VARIABLES, "--no-local-variables", {
+		"Do not import parameters or local variables."
+	}},
 	{NO_MEMBER_FUNCTIONS, "--no-member-functions", {
 		"Do not print member functions."
 	}},
@@ -68,6 +78,19 @@ const std::vector<ImporterFlagInfo> IMPORTER_FLAGS = {
 	}}
 };
 
+const std::vector<ImporterProfileInfo> IMPORTER_PROFILES = {
+	{"full", NO_IMPORTER_FLAGS, {
+		"Import everything. This is the default."
+	}},
+	{"functions-and-globals", NO_LOCAL_VARIABLES, {
+		"Import functions, global variables and data",
+		"types, but not parameters or local variables."
+	}},
+	{"types", NO_FUNCTIONS | NO_GLOBAL_VARIABLES | NO_LOCAL_VARIABLES, {
+		"Only import data types."
+	}}
+};
+
 u32 parse_importer_flag(const char* argument)
 {
 	for(const ImporterFlagInfo& flag : IMPORTER_FLAGS) {
@@ -78,8 +101,29 @@ u32 parse_importer_flag(const char* argument)
 	return NO_IMPORTER_FLAGS;
 }
 
+std::optional<u32> parse_importer_profile(const char* name)
+{
+	for(const ImporterProfileInfo& profile : IMPORTER_PROFILES) {
+		if(strcmp(profile.name, name) == 0) {
+			return profile.flags;
+		}
+	}
+	return std::nullopt;
+}
+
 void print_importer_flags_help(FILE* out)
 {
+	fprintf(out, "\n");
+	fprintf(out, "  --profile <profile>           Only import the symbols needed for a given\n");
+	fprintf(out, "                                use case. Supported profiles are:\n");
+	for(const ImporterProfileInfo& profile : IMPORTER_PROFILES) {
+		fprintf(out, "\n");
+		fprintf(out, "                                  %s\n", profile.name);
+		for(const char* line : profile.help_text) {
+			fprintf(out, "                                    %s\n", line);
+		}
+	}
+	
 	for(const ImporterFlagInfo& flag : IMPORTER_FLAGS) {
 		fprintf(out, "\n");
 		fprintf(out, "  %-29s ", flag.argument);
@@ -22,7 +22,10 @@ enum ImporterFlags {
 	TYPEDEF_ALL_ENUMS = (1 << 10),
 	TYPEDEF_ALL_STRUCTS = (1 << 11),
 	TYPEDEF_ALL_UNIONS = (1 << 12),
-	UNIQUE_FUNCTIONS = (1 << 13)
+	UNIQUE_FUNCTIONS = (1 << 13),
+	NO_FUNCTIONS = (1 << 14),
+	NO_GLOBAL_VARIABLES = (1 << 15),
+	NO_LOCAL_VARIABLES = (1 << 16)
 };
 
 struct ImporterFlagInfo {
@@ -33,7 +36,17 @@ struct ImporterFlagInfo {
 
 extern const std::vector<ImporterFlagInfo> IMPORTER_FLAGS;
 
+// A named set of importer flags for commonly used subsets of the symbols.
+struct ImporterProfileInfo {
+	const char* name;
+	u32 flags;
+	std::vector<const char*> help_text;
+};
+
+extern const std::vector<ImporterProfileInfo> IMPORTER_PROFILES;
+
 u32 parse_importer_flag(const char* argument);
+std::optional<u32> parse_importer_profile(const char* name);
 void print_importer_flags_help(FILE* out);
 
 }
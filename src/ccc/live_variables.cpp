@@ -0,0 +1,201 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "live_variables.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+static void resolve_register_storage(LiveVariable& variable, const RegisterStorage& storage);
+static void resolve_stack_storage(LiveVariable& variable, const StackStorage& storage, s32 stack_frame_size);
+
+void LiveVariableIndex::build(const SymbolDatabase& database)
+{
+	m_functions.clear();
+	m_always_live.clear();
+	m_ranged.clear();
+	m_ranges.clear();
+	
+	std::vector<const Function*> functions;
+	for(const Function& function : database.functions) {
+		if(function.address().valid()) {
+			functions.emplace_back(&function);
+		}
+	}
+	
+	std::stable_sort(functions.begin(), functions.end(),
+		[](const Function* lhs, const Function* rhs) { return lhs->address().value < rhs->address().value; });
+	
+	struct RangedLocal {
+		LiveVariable variable;
+		LiveRange range;
+	};
+	std::vector<RangedLocal> ranged_locals;
+	
+	for(size_t i = 0; i < functions.size(); i++) {
+		const Function& function = *functions[i];
+		
+		FunctionEntry& entry = m_functions.emplace_back();
+		entry.address = function.address().value;
+		entry.end_address = entry.address + function.size();
+		entry.function = function.handle();
+		
+		// If the size of the function isn't known, assume it extends up to
+		// the next function.
+		if(i + 1 < functions.size() && (function.size() == 0 || entry.end_address > functions[i + 1]->address().value)) {
+			entry.end_address = functions[i + 1]->address().value;
+		}
+		
+		entry.first_always_live = (u32) m_always_live.size();
+		
+		if(function.parameter_variables().has_value()) {
+			for(ParameterVariableHandle handle : *function.parameter_variables()) {
+				const ParameterVariable* parameter_variable = database.parameter_variables.symbol_from_handle(handle);
+				if(!parameter_variable) {
+					continue;
+				}
+				
+				LiveVariable& variable = m_always_live.emplace_back();
+				variable.parameter_variable = handle;
+				if(const RegisterStorage* storage = std::get_if<RegisterStorage>(&parameter_variable->storage)) {
+					resolve_register_storage(variable, *storage);
+				} else if(const StackStorage* storage = std::get_if<StackStorage>(&parameter_variable->storage)) {
+					resolve_stack_storage(variable, *storage, function.stack_frame_size);
+				}
+			}
+		}
+		
+		ranged_locals.clear();
+		if(function.local_variables().has_value()) {
+			for(LocalVariableHandle handle : *function.local_variables()) {
+				const LocalVariable* local_variable = database.local_variables.symbol_from_handle(handle);
+				if(!local_variable) {
+					continue;
+				}
+				
+				LiveVariable variable;
+				variable.local_variable = handle;
+				if(std::holds_alternative<GlobalStorage>(local_variable->storage)) {
+					variable.storage = LiveVariableStorage::GLOBAL;
+					variable.global_address = local_variable->address();
+				} else if(const RegisterStorage* storage = std::get_if<RegisterStorage>(&local_variable->storage)) {
+					resolve_register_storage(variable, *storage);
+				} else if(const StackStorage* storage = std::get_if<StackStorage>(&local_variable->storage)) {
+					resolve_stack_storage(variable, *storage, function.stack_frame_size);
+				}
+				
+				// Static variables live forever, and if we don't know the live
+				// range of a variable we assume it's in scope for the whole
+				// function.
+				const AddressRange& range = local_variable->live_range;
+				bool has_range = range.low.valid() && range.high.valid() && range.high.value > range.low.value;
+				if(variable.storage == LiveVariableStorage::GLOBAL || !has_range) {
+					m_always_live.emplace_back(variable);
+				} else {
+					RangedLocal& ranged_local = ranged_locals.emplace_back();
+					ranged_local.variable = variable;
+					ranged_local.range.low = range.low.value;
+					ranged_local.range.high = range.high.value;
+				}
+			}
+		}
+		
+		entry.always_live_count = (u32) m_always_live.size() - entry.first_always_live;
+		
+		std::stable_sort(ranged_locals.begin(), ranged_locals.end(),
+			[](const RangedLocal& lhs, const RangedLocal& rhs) { return lhs.range.low < rhs.range.low; });
+		
+		entry.first_ranged = (u32) m_ranged.size();
+		entry.ranged_count = (u32) ranged_locals.size();
+		
+		u32 max_high = 0;
+		for(RangedLocal& ranged_local : ranged_locals) {
+			max_high = std::max(max_high, ranged_local.range.high);
+			ranged_local.range.max_high = max_high;
+			m_ranged.emplace_back(ranged_local.variable);
+			m_ranges.emplace_back(ranged_local.range);
+		}
+	}
+}
+
+void LiveVariableIndex::live_variables_at(u32 address, std::vector<LiveVariable>& output) const
+{
+	const FunctionEntry* entry = function_entry_at(address);
+	if(!entry) {
+		return;
+	}
+	
+	output.insert(output.end(),
+		m_always_live.begin() + entry->first_always_live,
+		m_always_live.begin() + entry->first_always_live + entry->always_live_count);
+	
+	auto ranges_begin = m_ranges.begin() + entry->first_ranged;
+	auto ranges_end = ranges_begin + entry->ranged_count;
+	auto iterator = std::upper_bound(ranges_begin, ranges_end, address,
+		[](u32 address, const LiveRange& range) { return address < range.low; });
+	
+	// Walk backwards until none of the remaining ranges could contain the
+	// address, then output the matches in ascending order.
+	size_t first_output = output.size();
+	for(auto range = iterator; range != ranges_begin && (range - 1)->max_high > address; range--) {
+		if(address < (range - 1)->high) {
+			output.emplace_back(m_ranged[(range - 1) - m_ranges.begin()]);
+		}
+	}
+	std::reverse(output.begin() + first_output, output.end());
+}
+
+std::vector<LiveVariable> LiveVariableIndex::live_variables_at(u32 address) const
+{
+	std::vector<LiveVariable> output;
+	live_variables_at(address, output);
+	return output;
+}
+
+FunctionHandle LiveVariableIndex::function_at(u32 address) const
+{
+	const FunctionEntry* entry = function_entry_at(address);
+	if(!entry) {
+		return FunctionHandle();
+	}
+	return entry->function;
+}
+
+const LiveVariableIndex::FunctionEntry* LiveVariableIndex::function_entry_at(u32 address) const
+{
+	auto iterator = std::upper_bound(m_functions.begin(), m_functions.end(), address,
+		[](u32 address, const FunctionEntry& entry) { return address < entry.address; });
+	if(iterator == m_functions.begin()) {
+		return nullptr;
+	}
+	
+	const FunctionEntry& entry = *(iterator - 1);
+	if(address >= entry.end_address) {
+		return nullptr;
+	}
+	
+	return &entry;
+}
+
+static void resolve_register_storage(LiveVariable& variable, const RegisterStorage& storage)
+{
+	auto [register_class, register_index] = mips::map_dbx_register_index(storage.dbx_register_number);
+	variable.storage = LiveVariableStorage::REGISTER;
+	variable.register_class = register_class;
+	variable.register_index = register_index;
+	variable.is_by_reference = storage.is_by_reference;
+}
+
+static void resolve_stack_storage(LiveVariable& variable, const StackStorage& storage, s32 stack_frame_size)
+{
+	variable.storage = LiveVariableStorage::STACK;
+	if(stack_frame_size > -1) {
+		variable.stack_offset = storage.stack_pointer_offset + stack_frame_size;
+	} else {
+		variable.stack_offset = storage.stack_pointer_offset;
+		variable.stack_offset_relative_to_caller = true;
+	}
+}
+
+}
@@ -0,0 +1,83 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "ast.h"
+#include "registers.h"
+
+namespace ccc {
+
+enum class LiveVariableStorage : u8 {
+	GLOBAL,
+	REGISTER,
+	STACK
+};
+
+// A parameter or local variable that is in scope at a given address, with its
+// storage resolved so that it can be read without consulting the function.
+struct LiveVariable {
+	// Only one of these will be valid.
+	ParameterVariableHandle parameter_variable;
+	LocalVariableHandle local_variable;
+	LiveVariableStorage storage = LiveVariableStorage::REGISTER;
+	// For variables stored in registers.
+	mips::RegisterClass register_class = mips::RegisterClass::INVALID;
+	s32 register_index = -1;
+	bool is_by_reference = false;
+	// For variables stored on the stack. If the stack frame size of the
+	// function is known, this is relative to the stack pointer after the
+	// prologue has run, otherwise it's relative to the caller's stack pointer.
+	s32 stack_offset = 0;
+	bool stack_offset_relative_to_caller = false;
+	// For static local variables.
+	Address global_address;
+};
+
+// An interval index over the live ranges of the parameters and local
+// variables of every function, for quickly determining which variables are in
+// scope at a given address. The index must be rebuilt if the symbol database
+// is modified.
+class LiveVariableIndex {
+public:
+	void build(const SymbolDatabase& database);
+	
+	// Append all the parameters and local variables that are live at the given
+	// address to the output. Parameters come first, followed by locals in
+	// order of where their live ranges begin.
+	void live_variables_at(u32 address, std::vector<LiveVariable>& output) const;
+	std::vector<LiveVariable> live_variables_at(u32 address) const;
+	
+	// Find the function containing the address, or an invalid handle.
+	FunctionHandle function_at(u32 address) const;
+	
+protected:
+	struct FunctionEntry {
+		u32 address = 0;
+		u32 end_address = 0;
+		FunctionHandle function;
+		// Parameters, static locals and locals without live ranges.
+		u32 first_always_live = 0;
+		u32 always_live_count = 0;
+		// Locals sorted by the start of their live ranges.
+		u32 first_ranged = 0;
+		u32 ranged_count = 0;
+	};
+	
+	struct LiveRange {
+		u32 low = 0;
+		u32 high = 0;
+		// The highest end address of the ranges up to and including this one
+		// in the same function.
+		u32 max_high = 0;
+	};
+	
+	const FunctionEntry* function_entry_at(u32 address) const;
+	
+	std::vector<FunctionEntry> m_functions;
+	std::vector<LiveVariable> m_always_live;
+	std::vector<LiveVariable> m_ranged;
+	std::vector<LiveRange> m_ranges; // Parallel to m_ranged.
+};
+
+}
@@ -24,7 +24,7 @@ Result<void> LocalSymbolTableAnalyser::source_file(const char* path, Address tex
 Result<void> LocalSymbolTableAnalyser::data_type(const ParsedSymbol& symbol)
 {
 	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(
-		*symbol.name_colon_type.type.get(), nullptr, m_stabs_to_ast_state, 0, false, false);
+		*symbol.name_colon_type.type.get(), nullptr, m_stabs_to_ast_state, false, false);
 	CCC_RETURN_IF_ERROR(node);
 	
 	if(symbol.is_typedef && (*node)->descriptor == ast::STRUCT_OR_UNION) {
@@ -69,6 +69,10 @@ Result<void> LocalSymbolTableAnalyser::data_type(const ParsedSymbol& symbol)
 Result<void> LocalSymbolTableAnalyser::global_variable(
 	const char* mangled_name, Address address, const StabsType& type, bool is_static, GlobalStorageLocation location)
 {
+	if(m_context.importer_flags & NO_GLOBAL_VARIABLES) {
+		return Result<void>();
+	}
+	
 	Result<GlobalVariable*> global = m_database.global_variables.create_symbol(
 		mangled_name, m_context.group.source, m_context.group.module_symbol, address, m_context.importer_flags, m_context.demangler);
 	CCC_RETURN_IF_ERROR(global);
@@ -76,7 +80,7 @@ Result<void> LocalSymbolTableAnalyser::global_variable(
 	
 	m_global_variables.emplace_back((*global)->handle());
 	
-	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, 0, true, false);
+	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, true, false);
 	CCC_RETURN_IF_ERROR(node);
 	
 	if(is_static) {
@@ -105,6 +109,10 @@ Result<void> LocalSymbolTableAnalyser::sub_source_file(const char* path, Address
 Result<void> LocalSymbolTableAnalyser::procedure(
 	const char* mangled_name, Address address, const ProcedureDescriptor* procedure_descriptor, bool is_static)
 {
+	if(m_context.importer_flags & NO_FUNCTIONS) {
+		return Result<void>();
+	}
+	
 	if(!m_current_function || strcmp(mangled_name, m_current_function->mangled_name().c_str()) != 0) {
 		Result<void> result = create_function(mangled_name, address);
 		CCC_RETURN_IF_ERROR(result);
@@ -116,6 +124,9 @@ Result<void> LocalSymbolTableAnalyser::procedure(
 	
 	if(procedure_descriptor) {
 		m_current_function->stack_frame_size = procedure_descriptor->frame_size;
+		m_current_function->saved_register_mask = (u32) procedure_descriptor->saved_register_mask;
+		m_current_function->saved_register_offset = procedure_descriptor->saved_register_offset;
+		m_current_function->return_pc_register = procedure_descriptor->return_pc_register;
 	}
 	
 	return Result<void>();
@@ -145,6 +156,10 @@ Result<void> LocalSymbolTableAnalyser::text_end(const char* name, s32 function_s
 
 Result<void> LocalSymbolTableAnalyser::function(const char* mangled_name, const StabsType& return_type, Address address)
 {
+	if(m_context.importer_flags & NO_FUNCTIONS) {
+		return Result<void>();
+	}
+	
 	if(!m_current_function || strcmp(mangled_name, m_current_function->mangled_name().c_str()) != 0) {
 		Result<void> result = create_function(mangled_name, address);
 		CCC_RETURN_IF_ERROR(result);
@@ -162,7 +177,7 @@ Result<void> LocalSymbolTableAnalyser::function(const char* mangled_name, const
 		}
 	}
 	
-	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(return_type, nullptr, m_stabs_to_ast_state, 0, true, true);
+	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(return_type, nullptr, m_stabs_to_ast_state, true, true);
 	CCC_RETURN_IF_ERROR(node);
 	m_current_function->set_type(std::move(*node));
 	
@@ -191,6 +206,10 @@ Result<void> LocalSymbolTableAnalyser::function_end()
 Result<void> LocalSymbolTableAnalyser::parameter(
 	const char* name, const StabsType& type, bool is_stack, s32 value, bool is_by_reference)
 {
+	if(m_context.importer_flags & (NO_FUNCTIONS | NO_LOCAL_VARIABLES)) {
+		return Result<void>();
+	}
+	
 	CCC_CHECK(m_current_function, "Parameter symbol before first func/proc symbol.");
 	
 	Result<ParameterVariable*> parameter_variable = m_database.parameter_variables.create_symbol(
@@ -199,7 +218,7 @@ Result<void> LocalSymbolTableAnalyser::parameter(
 	
 	m_current_parameter_variables.emplace_back((*parameter_variable)->handle());
 	
-	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, 0, true, true);
+	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, true, true);
 	CCC_RETURN_IF_ERROR(node);
 	(*parameter_variable)->set_type(std::move(*node));
 	
@@ -218,7 +237,7 @@ Result<void> LocalSymbolTableAnalyser::parameter(
 Result<void> LocalSymbolTableAnalyser::local_variable(
 	const char* name, const StabsType& type, u32 value, StabsSymbolDescriptor desc, SymbolClass sclass)
 {
-	if(!m_current_function) {
+	if(!m_current_function || (m_context.importer_flags & NO_LOCAL_VARIABLES)) {
 		return Result<void>();
 	}
 	
@@ -230,7 +249,7 @@ Result<void> LocalSymbolTableAnalyser::local_variable(
 	m_current_local_variables.emplace_back((*local_variable)->handle());
 	m_pending_local_variables.emplace_back((*local_variable)->handle());
 	
-	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, 0, true, false);
+	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(type, nullptr, m_stabs_to_ast_state, true, false);
 	CCC_RETURN_IF_ERROR(node);
 	
 	if(desc == StabsSymbolDescriptor::STATIC_LOCAL_VARIABLE) {
@@ -3,18 +3,30 @@
 
 #include "mdebug_importer.h"
 
+#include "profiler.h"
+
 namespace ccc::mdebug {
 
+static u32 imported_symbol_types(u32 importer_flags);
 static Result<void> resolve_type_names(
-	SymbolDatabase& database, const SymbolGroup& group, u32 importer_flags);
+	SymbolDatabase& database, const SymbolGroup& group, u32 importer_flags, u32 symbol_types);
 static Result<void> resolve_type_name(
 	ast::TypeName& type_name,
 	SymbolDatabase& database,
 	const SymbolGroup& group,
-	u32 importer_flags);
+	u32 importer_flags,
+	const LazySymbolTable* lazy_symbol_table);
 static void compute_size_bytes(ast::Node& node, SymbolDatabase& database);
+static std::optional<std::string> stabs_type_name(const char* string);
 static void detect_duplicate_functions(SymbolDatabase& database, const SymbolGroup& group);
+static void detect_duplicate_function(SymbolDatabase& database, const Function& test_function, const SymbolGroup& group);
 static void detect_fake_functions(SymbolDatabase& database, const std::map<u32, const mdebug::Symbol*>& external_functions, const SymbolGroup& group);
+static void detect_fake_function(
+	SymbolDatabase& database,
+	const Function& function,
+	const std::map<u32, const mdebug::Symbol*>& external_functions,
+	const SymbolGroup& group,
+	s32& fake_function_count);
 static void destroy_optimized_out_functions(
 	SymbolDatabase& database, const SymbolGroup& group);
 
@@ -84,6 +96,14 @@ Result<void> import_files(SymbolDatabase& database, const AnalysisContext& conte
 		CCC_RETURN_IF_ERROR(result);
 	}
 	
+	return run_analysis_passes(database, context);
+}
+
+Result<void> run_analysis_passes(SymbolDatabase& database, const AnalysisContext& context)
+{
+	// Skip the analysis passes for the types of symbols that weren't imported.
+	u32 symbol_types = imported_symbol_types(context.importer_flags);
+	
 	// The files field may be modified by further analysis passes, so we
 	// need to save this information here.
 	for(DataType& data_type : database.data_types) {
@@ -93,47 +113,55 @@ Result<void> import_files(SymbolDatabase& database, const AnalysisContext& conte
 	}
 	
 	// Lookup data types and store data type handles in type names.
-	Result<void> type_name_result = resolve_type_names(database, context.group, context.importer_flags);
+	Result<void> type_name_result = resolve_type_names(database, context.group, context.importer_flags, symbol_types);
 	CCC_RETURN_IF_ERROR(type_name_result);
 	
 	// Compute the size in bytes of all the AST nodes.
-	database.for_each_symbol([&](ccc::Symbol& symbol) {
+	database.for_each_symbol(symbol_types, [&](ccc::Symbol& symbol) {
 		if(context.group.is_in_group(symbol) && symbol.type()) {
 			compute_size_bytes(*symbol.type(), database);
 		}
 	});
 	
+	ProfileScope post_passes_profile(ProfilePhase::POST_PASSES);
+	
 	// Propagate the size information to the global variable symbols.
-	for(GlobalVariable& global_variable : database.global_variables) {
-		if(global_variable.type() && global_variable.type()->size_bytes > -1) {
-			global_variable.set_size((u32) global_variable.type()->size_bytes);
+	if(symbol_types & GLOBAL_VARIABLE) {
+		for(GlobalVariable& global_variable : database.global_variables) {
+			if(global_variable.type() && global_variable.type()->size_bytes > -1) {
+				global_variable.set_size((u32) global_variable.type()->size_bytes);
+			}
 		}
 	}
 	
 	// Propagate the size information to the static local variable symbols.
-	for(LocalVariable& local_variable : database.local_variables) {
-		bool is_static_local = std::holds_alternative<GlobalStorage>(local_variable.storage);
-		if(is_static_local && local_variable.type() && local_variable.type()->size_bytes > -1) {
-			local_variable.set_size((u32) local_variable.type()->size_bytes);
+	if(symbol_types & LOCAL_VARIABLE) {
+		for(LocalVariable& local_variable : database.local_variables) {
+			bool is_static_local = std::holds_alternative<GlobalStorage>(local_variable.storage);
+			if(is_static_local && local_variable.type() && local_variable.type()->size_bytes > -1) {
+				local_variable.set_size((u32) local_variable.type()->size_bytes);
+			}
 		}
 	}
 	
-	// Some games (e.g. Jet X2O) have multiple function symbols across different
-	// translation units with the same name and address.
-	if(context.importer_flags & UNIQUE_FUNCTIONS) {
-		detect_duplicate_functions(database, context.group);
-	}
-	
-	// If multiple functions appear at the same address, discard the addresses
-	// of all of them except the real one.
-	if(context.external_functions) {
-		detect_fake_functions(database, *context.external_functions, context.group);
-	}
-	
-	// Remove functions with no address. If there are any such functions, this
-	// will invalidate all pointers to symbols.
-	if(context.importer_flags & NO_OPTIMIZED_OUT_FUNCTIONS) {
-		destroy_optimized_out_functions(database, context.group);
+	if(symbol_types & FUNCTION) {
+		// Some games (e.g. Jet X2O) have multiple function symbols across
+		// different translation units with the same name and address.
+		if(context.importer_flags & UNIQUE_FUNCTIONS) {
+			detect_duplicate_functions(database, context.group);
+		}
+		
+		// If multiple functions appear at the same address, discard the
+		// addresses of all of them except the real one.
+		if(context.external_functions) {
+			detect_fake_functions(database, *context.external_functions, context.group);
+		}
+		
+		// Remove functions with no address. If there are any such functions,
+		// this will invalidate all pointers to symbols.
+		if(context.importer_flags & NO_OPTIMIZED_OUT_FUNCTIONS) {
+			destroy_optimized_out_functions(database, context.group);
+		}
 	}
 	
 	return Result<void>();
@@ -141,6 +169,8 @@ Result<void> import_files(SymbolDatabase& database, const AnalysisContext& conte
 
 Result<void> import_file(SymbolDatabase& database, const mdebug::File& input, const AnalysisContext& context)
 {
+	ProfileScope profile(ProfilePhase::TRANSLATION_UNIT, input.full_path);
+	
 	// Parse the stab strings into a data structure that's vaguely
 	// one-to-one with the text-based representation.
 	u32 importer_flags_for_this_file = context.importer_flags;
@@ -171,9 +201,12 @@ Result<void> import_file(SymbolDatabase& database, const mdebug::File& input, co
 		}
 	}
 	
+	StabsToAstCache stabs_to_ast_cache;
+	
 	StabsToAstState stabs_to_ast_state;
 	stabs_to_ast_state.file_handle = (*source_file)->handle().value;
 	stabs_to_ast_state.stabs_types = &stabs_types;
+	stabs_to_ast_state.cache = &stabs_to_ast_cache;
 	stabs_to_ast_state.importer_flags = importer_flags_for_this_file;
 	stabs_to_ast_state.demangler = context.demangler;
 	
@@ -310,15 +343,33 @@ Result<void> import_file(SymbolDatabase& database, const mdebug::File& input, co
 	return Result<void>();
 }
 
+static u32 imported_symbol_types(u32 importer_flags)
+{
+	u32 symbol_types = ALL_SYMBOL_TYPES;
+	if(importer_flags & NO_FUNCTIONS) {
+		symbol_types &= ~(FUNCTION | PARAMETER_VARIABLE | LOCAL_VARIABLE);
+	}
+	if(importer_flags & NO_GLOBAL_VARIABLES) {
+		symbol_types &= ~GLOBAL_VARIABLE;
+	}
+	if(importer_flags & NO_LOCAL_VARIABLES) {
+		symbol_types &= ~(PARAMETER_VARIABLE | LOCAL_VARIABLE);
+	}
+	return symbol_types;
+}
+
 static Result<void> resolve_type_names(
-	SymbolDatabase& database, const SymbolGroup& group, u32 importer_flags)
+	SymbolDatabase& database, const SymbolGroup& group, u32 importer_flags, u32 symbol_types)
 {
+	ProfileScope profile(ProfilePhase::RESOLVE_TYPE_NAMES);
+	
 	Result<void> result;
-	database.for_each_symbol([&](ccc::Symbol& symbol) {
+	database.for_each_symbol(symbol_types, [&](ccc::Symbol& symbol) {
 		if(group.is_in_group(symbol) && symbol.type()) {
 			ast::for_each_node(*symbol.type(), ast::PREORDER_TRAVERSAL, [&](ast::Node& node) {
 				if(node.descriptor == ast::TYPE_NAME) {
-					Result<void> type_name_result = resolve_type_name(node.as<ast::TypeName>(), database, group, importer_flags);
+					Result<void> type_name_result = resolve_type_name(
+						node.as<ast::TypeName>(), database, group, importer_flags, nullptr);
 					if(!type_name_result.success()) {
 						result = std::move(type_name_result);
 					}
@@ -334,7 +385,8 @@ static Result<void> resolve_type_name(
 	ast::TypeName& type_name,
 	SymbolDatabase& database,
 	const SymbolGroup& group,
-	u32 importer_flags)
+	u32 importer_flags,
+	const LazySymbolTable* lazy_symbol_table)
 {
 	ast::TypeName::UnresolvedStabs* unresolved_stabs = type_name.unresolved_stabs.get();
 	if(!unresolved_stabs) {
@@ -370,6 +422,12 @@ static Result<void> resolve_type_name(
 		}
 	}
 	
+	// When importing lazily, the type may be defined in a translation unit
+	// that hasn't been loaded yet, so leave the type name unresolved for now.
+	if(lazy_symbol_table && lazy_symbol_table->type_may_be_loaded_later(unresolved_stabs->type_name)) {
+		return Result<void>();
+	}
+	
 	// If this branch is taken it means the type name was probably from an
 	// automatically generated member function of a nested struct trying to
 	// reference the struct (for the this parameter). We shouldn't create a
@@ -409,10 +467,11 @@ static Result<void> resolve_type_name(
 			unresolved_stabs->type_name, group.source, group.module_symbol);
 		CCC_RETURN_IF_ERROR(forward_declared_type);
 		
-		(*forward_declared_type)->set_type(std::move(forward_declared_node));
+		DataTypeHandle forward_declared_handle = (*forward_declared_type)->handle();
+		database.data_types.retype_symbol(forward_declared_handle, std::move(forward_declared_node));
 		(*forward_declared_type)->not_defined_in_any_translation_unit = true;
 		
-		type_name.data_type_handle = (*forward_declared_type)->handle();
+		type_name.data_type_handle = forward_declared_handle;
 		type_name.is_forward_declared = true;
 		type_name.unresolved_stabs.reset();
 		
@@ -439,18 +498,59 @@ static Result<void> resolve_type_name(
 
 static void compute_size_bytes(ast::Node& node, SymbolDatabase& database)
 {
-	for_each_node(node, ast::POSTORDER_TRAVERSAL, [&](ast::Node& node) {
+	ProfileScope profile(ProfilePhase::COMPUTE_SIZE_BYTES);
+	
+	enum Step {
+		VISIT_CHILDREN,
+		COMPUTE_SIZE,
+		FINISH_TYPE_NAME
+	};
+	
+	struct Frame {
+		ast::Node* node = nullptr;
+		Step step = VISIT_CHILDREN;
+		ast::Node* resolved_node = nullptr;
+	};
+	
+	// Sizes are computed in postorder. If a type name references a type whose
+	// size hasn't been computed yet, that type is processed first, and then
+	// the type name is revisited.
+	SmallStack<Frame> stack;
+	stack.push_back({&node, VISIT_CHILDREN, nullptr});
+	
+	while(!stack.empty()) {
+		Frame& frame = stack.back();
+		ast::Node& current = *frame.node;
+		
+		if(frame.step == VISIT_CHILDREN) {
+			frame.step = COMPUTE_SIZE;
+			ast::for_each_child_reversed(current, [&](ast::Node& child) {
+				stack.push_back({&child, VISIT_CHILDREN, nullptr});
+			});
+			continue;
+		}
+		
+		if(frame.step == FINISH_TYPE_NAME) {
+			current.size_bytes = frame.resolved_node->size_bytes;
+			if(current.size_bytes > -1) {
+				current.cannot_compute_size = false;
+			}
+			stack.pop_back();
+			continue;
+		}
+		
 		// Skip nodes that have already been processed.
-		if(node.size_bytes > -1 || node.cannot_compute_size) {
-			return ast::EXPLORE_CHILDREN;
+		if(current.size_bytes > -1 || current.cannot_compute_size) {
+			stack.pop_back();
+			continue;
 		}
 		
 		// Can't compute size recursively.
-		node.cannot_compute_size = true;
+		current.cannot_compute_size = true;
 		
-		switch(node.descriptor) {
+		switch(current.descriptor) {
 			case ast::ARRAY: {
-				ast::Array& array = node.as<ast::Array>();
+				ast::Array& array = current.as<ast::Array>();
 				if(array.element_type->size_bytes > -1) {
 					array.size_bytes = array.element_type->size_bytes * array.element_count;
 				}
@@ -460,7 +560,7 @@ static void compute_size_bytes(ast::Node& node, SymbolDatabase& database)
 				break;
 			}
 			case ast::BUILTIN: {
-				ast::BuiltIn& built_in = node.as<ast::BuiltIn>();
+				ast::BuiltIn& built_in = current.as<ast::BuiltIn>();
 				built_in.size_bytes = builtin_class_size(built_in.bclass);
 				break;
 			}
@@ -468,31 +568,34 @@ static void compute_size_bytes(ast::Node& node, SymbolDatabase& database)
 				break;
 			}
 			case ast::ENUM: {
-				node.size_bytes = 4;
+				current.size_bytes = 4;
 				break;
 			}
 			case ast::ERROR_NODE: {
 				break;
 			}
 			case ast::STRUCT_OR_UNION: {
-				node.size_bytes = node.size_bits / 8;
+				current.size_bytes = current.size_bits / 8;
 				break;
 			}
 			case ast::POINTER_OR_REFERENCE: {
-				node.size_bytes = 4;
+				current.size_bytes = 4;
 				break;
 			}
 			case ast::POINTER_TO_DATA_MEMBER: {
 				break;
 			}
 			case ast::TYPE_NAME: {
-				ast::TypeName& type_name = node.as<ast::TypeName>();
+				ast::TypeName& type_name = current.as<ast::TypeName>();
 				DataType* resolved_type = database.data_types.symbol_from_handle(type_name.data_type_handle_unless_forward_declared());
 				if(resolved_type) {
 					ast::Node* resolved_node = resolved_type->type();
 					CCC_ASSERT(resolved_node);
 					if(resolved_node->size_bytes < 0 && !resolved_node->cannot_compute_size) {
-						compute_size_bytes(*resolved_node, database);
+						frame.step = FINISH_TYPE_NAME;
+						frame.resolved_node = resolved_node;
+						stack.push_back({resolved_node, VISIT_CHILDREN, nullptr});
+						continue;
 					}
 					type_name.size_bytes = resolved_node->size_bytes;
 				}
@@ -500,72 +603,75 @@ static void compute_size_bytes(ast::Node& node, SymbolDatabase& database)
 			}
 		}
 		
-		if(node.size_bytes > -1) {
-			node.cannot_compute_size = false;
+		if(current.size_bytes > -1) {
+			current.cannot_compute_size = false;
 		}
 		
-		return ast::EXPLORE_CHILDREN;
-	});
+		stack.pop_back();
+	}
 }
 
 static void detect_duplicate_functions(SymbolDatabase& database, const SymbolGroup& group)
 {
-	std::vector<FunctionHandle> duplicate_functions;
+	for(const Function& test_function : database.functions) {
+		detect_duplicate_function(database, test_function, group);
+	}
+}
+
+static void detect_duplicate_function(SymbolDatabase& database, const Function& test_function, const SymbolGroup& group)
+{
+	if(!test_function.address().valid() && !group.is_in_group(test_function)) {
+		return;
+	}
 	
-	for(Function& test_function : database.functions) {
-		if(!test_function.address().valid() && !group.is_in_group(test_function)) {
-			continue;
-		}
-		
-		// Find cases where there are two or more functions at the same address.
-		auto functions_with_same_address = database.functions.handles_from_starting_address(test_function.address());
-		if(functions_with_same_address.begin() == functions_with_same_address.end()) {
-			continue;
-		}
-		if(++functions_with_same_address.begin() == functions_with_same_address.end()) {
-			continue;
-		}
-		
-		// Try to figure out the address of the translation unit which the
-		// version of the function that actually ended up in the linked binary
-		// comes from. We can't just check which source file the symbol comes
-		// from because it may be present in multiple.
-		u32 source_file_address = UINT32_MAX;
-		for(SourceFile& source_file : database.source_files) {
-			if(source_file.address() < test_function.address()) {
-				source_file_address = std::min(source_file.address().value, source_file_address);
-			}
+	// Find cases where there are two or more functions at the same address.
+	auto functions_with_same_address = database.functions.handles_from_starting_address(test_function.address());
+	if(functions_with_same_address.begin() == functions_with_same_address.end()) {
+		return;
+	}
+	if(++functions_with_same_address.begin() == functions_with_same_address.end()) {
+		return;
+	}
+	
+	// Try to figure out the address of the translation unit which the
+	// version of the function that actually ended up in the linked binary
+	// comes from. We can't just check which source file the symbol comes
+	// from because it may be present in multiple.
+	u32 source_file_address = UINT32_MAX;
+	for(SourceFile& source_file : database.source_files) {
+		if(source_file.address() < test_function.address()) {
+			source_file_address = std::min(source_file.address().value, source_file_address);
 		}
-		
-		if(source_file_address == UINT32_MAX) {
+	}
+	
+	if(source_file_address == UINT32_MAX) {
+		return;
+	}
+	
+	// Remove the addresses from all the matching symbols from other
+	// translation units.
+	std::vector<FunctionHandle> duplicate_functions;
+	FunctionHandle best_handle;
+	u32 best_offset = UINT32_MAX;
+	for(FunctionHandle handle : functions_with_same_address) {
+		ccc::Function* function = database.functions.symbol_from_handle(handle);
+		if(!function || !group.is_in_group(*function) || function->mangled_name() != test_function.mangled_name()) {
 			continue;
 		}
 		
-		// Remove the addresses from all the matching symbols from other
-		// translation units.
-		FunctionHandle best_handle;
-		u32 best_offset = UINT32_MAX;
-		for(FunctionHandle handle : functions_with_same_address) {
-			ccc::Function* function = database.functions.symbol_from_handle(handle);
-			if(!function || !group.is_in_group(*function) || function->mangled_name() != test_function.mangled_name()) {
-				continue;
+		if(test_function.address().value - source_file_address < best_offset) {
+			if(best_handle.valid()) {
+				duplicate_functions.emplace_back(best_handle);
 			}
-			
-			if(test_function.address().value - source_file_address < best_offset) {
-				if(best_handle.valid()) {
-					duplicate_functions.emplace_back(best_handle);
-				}
-				best_handle = function->handle();
-				best_offset = test_function.address().value - source_file_address;
-			} else {
-				duplicate_functions.emplace_back(function->handle());
-			}
-		}
-		
-		for(FunctionHandle duplicate_function : duplicate_functions) {
-			database.functions.move_symbol(duplicate_function, Address());
+			best_handle = function->handle();
+			best_offset = test_function.address().value - source_file_address;
+		} else {
+			duplicate_functions.emplace_back(function->handle());
 		}
-		duplicate_functions.clear();
+	}
+	
+	for(FunctionHandle duplicate_function : duplicate_functions) {
+		database.functions.move_symbol(duplicate_function, Address());
 	}
 }
 
@@ -575,32 +681,42 @@ static void detect_fake_functions(SymbolDatabase& database, const std::map<u32,
 	// address and cross-reference with the external symbol table to try and
 	// find which one is the real one.
 	s32 fake_function_count = 0;
-	for(Function& function : database.functions) {
-		if(!function.address().valid() || !group.is_in_group(function)) {
-			continue;
-		}
+	for(const Function& function : database.functions) {
+		detect_fake_function(database, function, external_functions, group, fake_function_count);
+	}
+}
+
+static void detect_fake_function(
+	SymbolDatabase& database,
+	const Function& function,
+	const std::map<u32, const mdebug::Symbol*>& external_functions,
+	const SymbolGroup& group,
+	s32& fake_function_count)
+{
+	if(!function.address().valid() || !group.is_in_group(function)) {
+		return;
+	}
+	
+	// Find cases where there are two or more functions at the same address.
+	auto functions_with_same_address = database.functions.handles_from_starting_address(function.address());
+	if(functions_with_same_address.begin() == functions_with_same_address.end()) {
+		return;
+	}
+	if(++functions_with_same_address.begin() == functions_with_same_address.end()) {
+		return;
+	}
+	
+	auto external_function = external_functions.find(function.address().value);
+	if(external_function == external_functions.end() || strcmp(function.mangled_name().c_str(), external_function->second->string) != 0) {
+		database.functions.move_symbol(function.handle(), Address());
 		
-		// Find cases where there are two or more functions at the same address.
-		auto functions_with_same_address = database.functions.handles_from_starting_address(function.address());
-		if(functions_with_same_address.begin() == functions_with_same_address.end()) {
-			continue;
-		}
-		if(++functions_with_same_address.begin() == functions_with_same_address.end()) {
-			continue;
+		if(fake_function_count < 10) {
+			CCC_WARN("Discarding address of function symbol '%s' as it is probably incorrect.", function.mangled_name().c_str());
+		} else if(fake_function_count == 10) {
+			CCC_WARN("Discarding more addresses of function symbols.");
 		}
 		
-		auto external_function = external_functions.find(function.address().value);
-		if(external_function == external_functions.end() || strcmp(function.mangled_name().c_str(), external_function->second->string) != 0) {
-			database.functions.move_symbol(function.handle(), Address());
-			
-			if(fake_function_count < 10) {
-				CCC_WARN("Discarding address of function symbol '%s' as it is probably incorrect.", function.mangled_name().c_str());
-			} else if(fake_function_count == 10) {
-				CCC_WARN("Discarding more addresses of function symbols.");
-			}
-			
-			fake_function_count++;
-		}
+		fake_function_count++;
 	}
 }
 
@@ -611,7 +727,7 @@ static void destroy_optimized_out_functions(
 	
 	for(Function& function : database.functions) {
 		if(group.is_in_group(function) && !function.address().valid()) {
-			function.mark_for_destruction();
+			database.functions.mark_symbol_for_destruction(function.handle(), nullptr);
 			marked = true;
 		}
 	}
@@ -624,6 +740,8 @@ static void destroy_optimized_out_functions(
 
 void fill_in_pointers_to_member_function_definitions(SymbolDatabase& database)
 {
+	ProfileScope profile(ProfilePhase::POST_PASSES);
+	
 	// Fill in pointers from member function declaration to corresponding definitions.
 	for(Function& function : database.functions) {
 		const std::string& qualified_name = function.name();
@@ -665,4 +783,433 @@ void fill_in_pointers_to_member_function_definitions(SymbolDatabase& database)
 	}
 }
 
+Result<void> LazySymbolTable::open(
+	std::span<const u8> elf,
+	s32 section_offset,
+	const SymbolGroup& group,
+	u32 importer_flags,
+	const DemanglerFunctions& demangler)
+{
+	Result<void> reader_result = m_reader.init(elf, section_offset);
+	CCC_RETURN_IF_ERROR(reader_result);
+	
+	Result<std::vector<mdebug::Symbol>> external_symbols = m_reader.parse_external_symbols();
+	CCC_RETURN_IF_ERROR(external_symbols);
+	m_external_symbols = std::move(*external_symbols);
+	
+	for(const mdebug::Symbol& external : m_external_symbols) {
+		if(external.symbol_type == mdebug::SymbolType::PROC) {
+			m_external_functions[external.value] = &external;
+		}
+		
+		if(external.symbol_type == mdebug::SymbolType::GLOBAL
+			&& (external.symbol_class != mdebug::SymbolClass::UNDEFINED)) {
+			m_external_globals[external.string] = &external;
+		}
+	}
+	
+	m_group = group;
+	m_importer_flags = importer_flags;
+	m_demangler = demangler;
+	
+	// Build the skeleton. This only requires reading the file descriptors and
+	// the procedure descriptors, not parsing any of the local symbols.
+	Result<s32> file_count = m_reader.file_count();
+	CCC_RETURN_IF_ERROR(file_count);
+	
+	for(s32 i = 0; i < *file_count; i++) {
+		Result<mdebug::FileSummary> summary = m_reader.parse_file_summary(i);
+		CCC_RETURN_IF_ERROR(summary);
+		
+		LazyTranslationUnit& unit = m_units.emplace_back();
+		unit.file_index = i;
+		unit.full_path = std::move(summary->full_path);
+		
+		u32 low = UINT32_MAX;
+		for(const mdebug::Symbol& procedure : summary->procedures) {
+			unit.functions.emplace_back(procedure.string, procedure.value);
+			low = std::min(low, procedure.value);
+		}
+		
+		if(low < summary->procedures_end) {
+			unit.address_range = AddressRange(low, summary->procedures_end);
+			m_units_sorted_by_address.emplace_back(i);
+		}
+		
+		for(const auto& [name, address] : unit.functions) {
+			m_function_to_unit.emplace(name, i);
+		}
+		
+		// Index the names of the types defined in each file up front, so
+		// that it's cheap to find out where a type is defined, or that it
+		// isn't defined anywhere.
+		Result<std::vector<const char*>> stabs_strings = m_reader.parse_stabs_strings(i);
+		CCC_RETURN_IF_ERROR(stabs_strings);
+		
+		index_type_names(i, *stabs_strings);
+	}
+	
+	std::stable_sort(m_units_sorted_by_address.begin(), m_units_sorted_by_address.end(), [&](s32 lhs, s32 rhs) {
+		return m_units[lhs].address_range.low.value < m_units[rhs].address_range.low.value;
+	});
+	
+	return Result<void>();
+}
+
+s32 LazySymbolTable::translation_unit_from_address(u32 address) const
+{
+	auto iterator = std::upper_bound(m_units_sorted_by_address.begin(), m_units_sorted_by_address.end(), address,
+		[&](u32 address, s32 index) { return address < m_units[index].address_range.low.value; });
+	if(iterator == m_units_sorted_by_address.begin()) {
+		return -1;
+	}
+	
+	s32 index = *(iterator - 1);
+	if(address >= m_units[index].address_range.high.value) {
+		return -1;
+	}
+	
+	return index;
+}
+
+s32 LazySymbolTable::translation_unit_from_function(const std::string& mangled_name) const
+{
+	auto iterator = m_function_to_unit.find(mangled_name);
+	if(iterator == m_function_to_unit.end()) {
+		return -1;
+	}
+	return iterator->second;
+}
+
+Result<bool> LazySymbolTable::load_translation_unit(SymbolDatabase& database, s32 index)
+{
+	CCC_CHECK(index >= 0 && index < (s32) m_units.size(), "Translation unit index out of range.");
+	
+	if(m_units[index].loaded) {
+		return false;
+	}
+	
+	Result<mdebug::File> file = m_reader.parse_file(m_units[index].file_index);
+	CCC_RETURN_IF_ERROR(file);
+	
+	Result<void> result = import_translation_unit(database, index, *file);
+	CCC_RETURN_IF_ERROR(result);
+	
+	return true;
+}
+
+Result<void> LazySymbolTable::load_address(SymbolDatabase& database, u32 address)
+{
+	s32 index = translation_unit_from_address(address);
+	if(index > -1) {
+		Result<bool> result = load_translation_unit(database, index);
+		CCC_RETURN_IF_ERROR(result);
+	}
+	return Result<void>();
+}
+
+Result<void> LazySymbolTable::load_function(SymbolDatabase& database, const std::string& mangled_name)
+{
+	s32 index = translation_unit_from_function(mangled_name);
+	if(index > -1) {
+		Result<bool> result = load_translation_unit(database, index);
+		CCC_RETURN_IF_ERROR(result);
+	}
+	return Result<void>();
+}
+
+Result<void> LazySymbolTable::load_type(SymbolDatabase& database, const std::string& name)
+{
+	auto units = m_type_name_to_units.find(name);
+	if(units == m_type_name_to_units.end()) {
+		return Result<void>();
+	}
+	
+	// One definition is enough, since the importer would deduplicate the
+	// others anyway.
+	for(s32 index : units->second) {
+		if(m_units[index].loaded) {
+			return Result<void>();
+		}
+	}
+	
+	Result<bool> result = load_translation_unit(database, units->second.front());
+	CCC_RETURN_IF_ERROR(result);
+	
+	return Result<void>();
+}
+
+Result<void> LazySymbolTable::load_all(SymbolDatabase& database, const std::atomic_bool* interrupt)
+{
+	for(s32 i = 0; i < (s32) m_units.size(); i++) {
+		if(interrupt && *interrupt) {
+			return CCC_FAILURE("Operation interrupted by user.");
+		}
+		
+		Result<bool> result = load_translation_unit(database, i);
+		CCC_RETURN_IF_ERROR(result);
+	}
+	
+	return Result<void>();
+}
+
+bool LazySymbolTable::type_may_be_loaded_later(const std::string& name) const
+{
+	if(m_loaded_unit_count == (s32) m_units.size()) {
+		return false;
+	}
+	
+	auto units = m_type_name_to_units.find(name);
+	if(units == m_type_name_to_units.end()) {
+		return false;
+	}
+	
+	for(s32 index : units->second) {
+		if(!m_units[index].loaded) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+s32 LazySymbolTable::deferred_symbol_count() const
+{
+	std::set<MultiSymbolHandle> symbols;
+	for(const auto& [name, waiting] : m_deferred_symbols) {
+		symbols.insert(waiting.begin(), waiting.end());
+	}
+	return (s32) symbols.size();
+}
+
+Result<void> LazySymbolTable::import_translation_unit(SymbolDatabase& database, s32 index, const mdebug::File& file)
+{
+	LazyTranslationUnit& unit = m_units[index];
+	CCC_ASSERT(!unit.loaded);
+	
+	AnalysisContext context;
+	context.reader = &m_reader;
+	context.external_functions = &m_external_functions;
+	context.external_globals = &m_external_globals;
+	context.group = m_group;
+	context.importer_flags = m_importer_flags;
+	context.demangler = m_demangler;
+	
+	// If anything goes wrong, undo all the changes made to the database so
+	// that loading the translation unit again doesn't create duplicates.
+	database.begin_transaction();
+	UndoSavepoint savepoint = database.savepoint();
+	
+	Result<void> result = import_file(database, file, context);
+	if(!result.success()) {
+		database.rollback_transaction();
+		return result;
+	}
+	
+	// Find the symbols that were created, and the data types that were
+	// replaced by better versions from this file or had it added to their
+	// list of files. The handles of the new symbols aren't necessarily higher
+	// than those of the existing ones, so the journal is used for this.
+	std::vector<MultiSymbolHandle> symbols = database.symbols_changed_since(savepoint);
+	
+	database.commit_transaction();
+	
+	unit.loaded = true;
+	m_loaded_unit_count++;
+	
+	post_process(database, std::move(symbols));
+	
+	return Result<void>();
+}
+
+void LazySymbolTable::index_type_names(s32 index, std::span<const char* const> stabs_strings)
+{
+	std::set<std::string> type_names;
+	for(const char* string : stabs_strings) {
+		std::optional<std::string> type_name = stabs_type_name(string);
+		if(type_name.has_value()) {
+			type_names.emplace(std::move(*type_name));
+		}
+	}
+	
+	for(const std::string& type_name : type_names) {
+		m_type_name_to_units[type_name].emplace_back(index);
+	}
+	
+	m_units[index].type_names.assign(type_names.begin(), type_names.end());
+}
+
+void LazySymbolTable::post_process(SymbolDatabase& database, std::vector<MultiSymbolHandle> symbols)
+{
+	ProfileScope profile(ProfilePhase::POST_PASSES);
+	
+	// Symbols with type names that couldn't be resolved last time need to be
+	// processed again if their types may have just been loaded, or if they
+	// can't be loaded at all any more.
+	for(auto iterator = m_deferred_symbols.begin(); iterator != m_deferred_symbols.end();) {
+		if(!database.data_types.handles_from_name(iterator->first).empty()
+			|| !type_may_be_loaded_later(iterator->first)) {
+			symbols.insert(symbols.end(), iterator->second.begin(), iterator->second.end());
+			iterator = m_deferred_symbols.erase(iterator);
+		} else {
+			iterator++;
+		}
+	}
+	
+	std::sort(symbols.begin(), symbols.end());
+	symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+	
+	// This mirrors the passes run in run_analysis_passes, except that they
+	// only apply to the symbols that were touched.
+	std::vector<MultiSymbolHandle> resolved_symbols;
+	for(MultiSymbolHandle& handle : symbols) {
+		ccc::Symbol* symbol = handle.lookup_symbol(database);
+		if(!symbol || !m_group.is_in_group(*symbol) || !symbol->type()) {
+			continue;
+		}
+		
+		if(handle.descriptor() == DATA_TYPE) {
+			DataType& data_type = static_cast<DataType&>(*symbol);
+			data_type.only_defined_in_single_translation_unit = data_type.files.size() == 1;
+		}
+		
+		bool deferred = false;
+		ast::for_each_node(*symbol->type(), ast::PREORDER_TRAVERSAL, [&](ast::Node& node) {
+			if(node.descriptor == ast::TYPE_NAME) {
+				ast::TypeName& type_name = node.as<ast::TypeName>();
+				Result<void> type_name_result = resolve_type_name(
+					type_name, database, m_group, m_importer_flags, this);
+				if(!type_name_result.success()) {
+					report_warning(type_name_result.error());
+				}
+				if(type_name.unresolved_stabs && type_may_be_loaded_later(type_name.unresolved_stabs->type_name)) {
+					std::vector<MultiSymbolHandle>& waiting = m_deferred_symbols[type_name.unresolved_stabs->type_name];
+					if(std::find(waiting.begin(), waiting.end(), handle) == waiting.end()) {
+						waiting.emplace_back(handle);
+					}
+					deferred = true;
+				}
+			}
+			return ast::EXPLORE_CHILDREN;
+		});
+		
+		if(!deferred) {
+			resolved_symbols.emplace_back(handle);
+		}
+	}
+	
+	for(MultiSymbolHandle& handle : resolved_symbols) {
+		ccc::Symbol* symbol = handle.lookup_symbol(database);
+		
+		// Sizes that couldn't be computed before because a type was missing
+		// may be computable now.
+		ast::for_each_node(*symbol->type(), ast::PREORDER_TRAVERSAL, [&](ast::Node& node) {
+			if(node.size_bytes < 0) {
+				node.cannot_compute_size = false;
+			}
+			return ast::EXPLORE_CHILDREN;
+		});
+		compute_size_bytes(*symbol->type(), database);
+		
+		if(handle.descriptor() == GLOBAL_VARIABLE && symbol->type()->size_bytes > -1) {
+			symbol->set_size((u32) symbol->type()->size_bytes);
+		}
+		
+		if(handle.descriptor() == LOCAL_VARIABLE) {
+			LocalVariable& local_variable = static_cast<LocalVariable&>(*symbol);
+			bool is_static_local = std::holds_alternative<GlobalStorage>(local_variable.storage);
+			if(is_static_local && local_variable.type()->size_bytes > -1) {
+				local_variable.set_size((u32) local_variable.type()->size_bytes);
+			}
+		}
+	}
+	
+	if(imported_symbol_types(m_importer_flags) & FUNCTION) {
+		post_process_functions(database, symbols);
+	}
+}
+
+void LazySymbolTable::post_process_functions(SymbolDatabase& database, const std::vector<MultiSymbolHandle>& symbols)
+{
+	// Functions from translation units that were loaded earlier have already
+	// been checked, so only the functions that were just loaded and any that
+	// share an address with them need to be checked again.
+	std::vector<FunctionHandle> functions;
+	for(const MultiSymbolHandle& handle : symbols) {
+		if(handle.descriptor() != FUNCTION) {
+			continue;
+		}
+		
+		const Function* function = database.functions.symbol_from_handle(handle.handle());
+		if(!function) {
+			continue;
+		}
+		
+		functions.emplace_back(function->handle());
+		if(function->address().valid()) {
+			for(FunctionHandle other : database.functions.handles_from_starting_address(function->address())) {
+				functions.emplace_back(other);
+			}
+		}
+	}
+	
+	// Process them in the same order as the eager importer would.
+	std::sort(functions.begin(), functions.end());
+	functions.erase(std::unique(functions.begin(), functions.end()), functions.end());
+	
+	if(m_importer_flags & UNIQUE_FUNCTIONS) {
+		for(FunctionHandle handle : functions) {
+			const Function* function = database.functions.symbol_from_handle(handle);
+			if(function) {
+				detect_duplicate_function(database, *function, m_group);
+			}
+		}
+	}
+	
+	s32 fake_function_count = 0;
+	for(FunctionHandle handle : functions) {
+		const Function* function = database.functions.symbol_from_handle(handle);
+		if(function) {
+			detect_fake_function(database, *function, m_external_functions, m_group, fake_function_count);
+		}
+	}
+	
+	// This may invalidate pointers to symbols, but not handles.
+	if(m_importer_flags & NO_OPTIMIZED_OUT_FUNCTIONS) {
+		bool marked = false;
+		for(FunctionHandle handle : functions) {
+			const Function* function = database.functions.symbol_from_handle(handle);
+			if(function && m_group.is_in_group(*function) && !function->address().valid()) {
+				database.functions.mark_symbol_for_destruction(handle, nullptr);
+				marked = true;
+			}
+		}
+		
+		if(marked) {
+			database.destroy_marked_symbols();
+		}
+	}
+}
+
+static std::optional<std::string> stabs_type_name(const char* string)
+{
+	// Find the colon separating the name from the rest of the symbol,
+	// skipping over any scope operators.
+	const char* colon = strchr(string, ':');
+	while(colon && colon[1] == ':') {
+		colon = strchr(colon + 2, ':');
+	}
+	
+	if(!colon || colon == string || (colon[1] != 't' && colon[1] != 'T')) {
+		return std::nullopt;
+	}
+	
+	std::string name(string, colon);
+	if(name == " ") {
+		return std::nullopt;
+	}
+	
+	return name;
+}
+
 }
@@ -24,8 +24,92 @@ Result<void> import_symbol_table(
 Result<void> import_files(SymbolDatabase& database, const AnalysisContext& context, const std::atomic_bool* interrupt);
 Result<void> import_file(SymbolDatabase& database, const mdebug::File& input, const AnalysisContext& context);
 
+// Run the passes that operate on all the symbols imported from a symbol table
+// at once. This is called by import_files after import_file has been called
+// for every file.
+Result<void> run_analysis_passes(SymbolDatabase& database, const AnalysisContext& context);
+
 // Try to add pointers from member function declarations to their definitions
 // using a heuristic.
 void fill_in_pointers_to_member_function_definitions(SymbolDatabase& database);
 
+struct LazyTranslationUnit {
+	s32 file_index = -1;
+	std::string full_path;
+	// The range covered by the functions in this translation unit. The low
+	// address will be invalid if there are no functions.
+	AddressRange address_range;
+	std::vector<std::pair<std::string, Address>> functions; // Mangled names.
+	// The names of the types defined in this translation unit.
+	std::vector<std::string> type_names;
+	bool loaded = false;
+};
+
+// Imports a .mdebug symbol table one translation unit at a time, on demand.
+// Opening the symbol table only reads the file descriptors, procedure
+// descriptors and external symbols to build a skeleton, and scans the STABS
+// strings for the names of the types each file defines, which is much faster
+// than a full import. Type names that can't be resolved are left unresolved
+// until a type with that name is loaded, or until no unloaded translation unit
+// could define it.
+// The ELF image must outlive this object, and the same database must be passed
+// to every call.
+class LazySymbolTable {
+public:
+	Result<void> open(
+		std::span<const u8> elf,
+		s32 section_offset,
+		const SymbolGroup& group,
+		u32 importer_flags,
+		const DemanglerFunctions& demangler);
+	
+	const std::vector<LazyTranslationUnit>& translation_units() const { return m_units; }
+	
+	// Lookup the index of a translation unit, or return -1.
+	s32 translation_unit_from_address(u32 address) const;
+	s32 translation_unit_from_function(const std::string& mangled_name) const;
+	
+	// Import a single translation unit and run the analysis passes on the new
+	// symbols. Returns true if the translation unit wasn't already loaded.
+	Result<bool> load_translation_unit(SymbolDatabase& database, s32 index);
+	
+	// Make sure the translation unit containing the given address, function or
+	// a definition of the given type has been loaded.
+	Result<void> load_address(SymbolDatabase& database, u32 address);
+	Result<void> load_function(SymbolDatabase& database, const std::string& mangled_name);
+	Result<void> load_type(SymbolDatabase& database, const std::string& name);
+	
+	Result<void> load_all(SymbolDatabase& database, const std::atomic_bool* interrupt);
+	
+	// Check if a translation unit that hasn't been loaded yet could define a
+	// type with the given name.
+	bool type_may_be_loaded_later(const std::string& name) const;
+	
+	// The number of symbols with type names that are waiting on translation
+	// units that haven't been loaded yet.
+	s32 deferred_symbol_count() const;
+	
+protected:
+	Result<void> import_translation_unit(SymbolDatabase& database, s32 index, const mdebug::File& file);
+	void index_type_names(s32 index, std::span<const char* const> stabs_strings);
+	void post_process(SymbolDatabase& database, std::vector<MultiSymbolHandle> symbols);
+	void post_process_functions(SymbolDatabase& database, const std::vector<MultiSymbolHandle>& symbols);
+	
+	SymbolTableReader m_reader;
+	std::vector<mdebug::Symbol> m_external_symbols;
+	std::map<u32, const mdebug::Symbol*> m_external_functions;
+	std::map<std::string, const mdebug::Symbol*> m_external_globals;
+	SymbolGroup m_group;
+	u32 m_importer_flags = NO_IMPORTER_FLAGS;
+	DemanglerFunctions m_demangler;
+	
+	std::vector<LazyTranslationUnit> m_units;
+	std::vector<s32> m_units_sorted_by_address;
+	std::map<std::string, s32> m_function_to_unit;
+	std::map<std::string, std::vector<s32>> m_type_name_to_units;
+	s32 m_loaded_unit_count = 0;
+	// Symbols with unresolved type names, keyed by the names they're waiting on.
+	std::map<std::string, std::vector<MultiSymbolHandle>> m_deferred_symbols;
+};
+
 }
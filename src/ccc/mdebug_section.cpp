@@ -3,6 +3,9 @@
 
 #include "mdebug_section.h"
 
+#include "elf.h"
+#include "profiler.h"
+
 namespace ccc::mdebug {
 
 // MIPS debug symbol table headers.
@@ -97,6 +100,12 @@ static void print_symbol(FILE* out, const Symbol& symbol);
 static void print_procedure_descriptor(FILE* out, const ProcedureDescriptor& procedure_descriptor);
 static Result<s32> get_corruption_fixing_fudge_offset(s32 section_offset, const SymbolicHeader& hdrr);
 static Result<Symbol> get_symbol(const SymbolHeader& header, std::span<const u8> elf, s32 strings_offset);
+static Result<SymbolHeader> make_symbol_header(const Symbol& symbol, u32 iss);
+static bool is_file_path_symbol(const Symbol& symbol, const File& file);
+static u32 write_string(std::vector<u8>& output, u64 offset, const char* string);
+static u64 align_offset(u64 offset, u64 alignment);
+template <typename T>
+static void write_packed(std::vector<u8>& output, u64 offset, const T& value);
 
 Result<void> SymbolTableReader::init(std::span<const u8> elf, s32 section_offset)
 {
@@ -126,6 +135,8 @@ Result<File> SymbolTableReader::parse_file(s32 index) const
 {
 	CCC_ASSERT(m_ready);
 	
+	ProfileScope profile(ProfilePhase::PARSE_FILE);
+	
 	File file;
 	
 	u64 fd_offset = m_hdrr->file_descriptors_offset + index * sizeof(FileDescriptor);
@@ -181,6 +192,145 @@ Result<File> SymbolTableReader::parse_file(s32 index) const
 	return file;
 }
 
+Result<FileSummary> SymbolTableReader::parse_file_summary(s32 index) const
+{
+	CCC_ASSERT(m_ready);
+	
+	FileSummary summary;
+	
+	u64 fd_offset = m_hdrr->file_descriptors_offset + index * sizeof(FileDescriptor);
+	const FileDescriptor* fd_header = get_packed<FileDescriptor>(m_elf, fd_offset + m_fudge_offset);
+	CCC_CHECK(fd_header != nullptr, "MIPS debug file descriptor out of bounds.");
+	CCC_CHECK(fd_header->f_big_endian() == 0, "Not little endian or bad file descriptor table.");
+	
+	summary.address = fd_header->address;
+	
+	s32 strings_offset = m_hdrr->local_strings_offset + fd_header->strings_offset + m_fudge_offset;
+	u64 symbols_offset = m_hdrr->local_symbols_offset + fd_header->isym_base * sizeof(SymbolHeader) + m_fudge_offset;
+	
+	std::string command_line_path;
+	const char* raw_path = get_string(m_elf, strings_offset + fd_header->file_path_string_offset);
+	if(raw_path) {
+		command_line_path = raw_path;
+	}
+	
+	// The working directory is stored in the N_SO symbol before the one that
+	// points to the path, so only the symbol headers up to that point need to
+	// be read. This uses the same rules as parse_file.
+	std::string working_dir;
+	for(s64 j = 3; j < fd_header->symbol_count; j++) {
+		const SymbolHeader* symbol_header = get_packed<SymbolHeader>(m_elf, symbols_offset + j * sizeof(SymbolHeader));
+		CCC_CHECK(symbol_header != nullptr, "Symbol header out of bounds.");
+		
+		if((s32) symbol_header->iss != fd_header->file_path_string_offset) {
+			continue;
+		}
+		
+		const SymbolHeader* previous_header = get_packed<SymbolHeader>(m_elf, symbols_offset + (j - 1) * sizeof(SymbolHeader));
+		CCC_CHECK(previous_header != nullptr, "Symbol header out of bounds.");
+		
+		Result<Symbol> path_symbol = get_symbol(*symbol_header, m_elf, strings_offset);
+		CCC_RETURN_IF_ERROR(path_symbol);
+		
+		Result<Symbol> working_dir_symbol = get_symbol(*previous_header, m_elf, strings_offset);
+		CCC_RETURN_IF_ERROR(working_dir_symbol);
+		
+		if(path_symbol->is_stabs() && path_symbol->code() == N_SO
+			&& working_dir_symbol->is_stabs() && working_dir_symbol->code() == N_SO) {
+			working_dir = working_dir_symbol->string;
+			break;
+		}
+	}
+	
+	summary.full_path = merge_paths(working_dir, command_line_path);
+	
+	// Read the procedure symbols.
+	s32 last_procedure_index = -1;
+	for(s64 i = 0; i < fd_header->procedure_descriptor_count; i++) {
+		u64 rel_procedure_offset = (fd_header->ipd_first + i) * sizeof(ProcedureDescriptor);
+		u64 procedure_offset = m_hdrr->procedure_descriptors_offset + rel_procedure_offset + m_fudge_offset;
+		const ProcedureDescriptor* procedure_descriptor = get_packed<ProcedureDescriptor>(m_elf, procedure_offset);
+		CCC_CHECK(procedure_descriptor != nullptr, "Procedure descriptor out of bounds.");
+		CCC_CHECK(procedure_descriptor->symbol_index < (u32) fd_header->symbol_count, "Symbol index out of bounds.");
+		
+		u64 symbol_offset = symbols_offset + procedure_descriptor->symbol_index * sizeof(SymbolHeader);
+		const SymbolHeader* symbol_header = get_packed<SymbolHeader>(m_elf, symbol_offset);
+		CCC_CHECK(symbol_header != nullptr, "Symbol header out of bounds.");
+		
+		Result<Symbol> symbol = get_symbol(*symbol_header, m_elf, strings_offset);
+		CCC_RETURN_IF_ERROR(symbol);
+		
+		if(symbol->symbol_class != SymbolClass::TEXT
+			|| (symbol->symbol_type != SymbolType::PROC && symbol->symbol_type != SymbolType::STATICPROC)) {
+			continue;
+		}
+		
+		symbol->procedure_descriptor = procedure_descriptor;
+		
+		if(last_procedure_index == -1 || symbol->value >= summary.procedures[last_procedure_index].value) {
+			last_procedure_index = (s32) summary.procedures.size();
+		}
+		
+		summary.procedures.emplace_back(std::move(*symbol));
+	}
+	
+	// Find the size of the last procedure from its end symbol. The sizes of
+	// the other procedures aren't needed to determine the end address.
+	if(last_procedure_index > -1) {
+		const Symbol& last_procedure = summary.procedures[last_procedure_index];
+		summary.procedures_end = last_procedure.value + 4;
+		
+		u32 procedure_symbol_index = last_procedure.procedure_descriptor->symbol_index;
+		for(s64 j = procedure_symbol_index + 1; j < fd_header->symbol_count; j++) {
+			const SymbolHeader* symbol_header = get_packed<SymbolHeader>(m_elf, symbols_offset + j * sizeof(SymbolHeader));
+			CCC_CHECK(symbol_header != nullptr, "Symbol header out of bounds.");
+			
+			if((SymbolType) symbol_header->symbol_type() != SymbolType::END
+				|| (SymbolClass) symbol_header->symbol_class() != SymbolClass::TEXT) {
+				continue;
+			}
+			
+			const char* string = get_string(m_elf, strings_offset + symbol_header->iss);
+			if(string && strcmp(string, last_procedure.string) == 0) {
+				summary.procedures_end = std::max(summary.procedures_end, last_procedure.value + symbol_header->value);
+				break;
+			}
+		}
+	}
+	
+	return summary;
+}
+
+Result<std::vector<const char*>> SymbolTableReader::parse_stabs_strings(s32 index) const
+{
+	CCC_ASSERT(m_ready);
+	
+	u64 fd_offset = m_hdrr->file_descriptors_offset + index * sizeof(FileDescriptor);
+	const FileDescriptor* fd_header = get_packed<FileDescriptor>(m_elf, fd_offset + m_fudge_offset);
+	CCC_CHECK(fd_header != nullptr, "MIPS debug file descriptor out of bounds.");
+	CCC_CHECK(fd_header->f_big_endian() == 0, "Not little endian or bad file descriptor table.");
+	
+	s32 strings_offset = m_hdrr->local_strings_offset + fd_header->strings_offset + m_fudge_offset;
+	u64 symbols_offset = m_hdrr->local_symbols_offset + fd_header->isym_base * sizeof(SymbolHeader) + m_fudge_offset;
+	
+	std::vector<const char*> strings;
+	for(s64 j = 0; j < fd_header->symbol_count; j++) {
+		const SymbolHeader* symbol_header = get_packed<SymbolHeader>(m_elf, symbols_offset + j * sizeof(SymbolHeader));
+		CCC_CHECK(symbol_header != nullptr, "Symbol header out of bounds.");
+		
+		// Same check as Symbol::is_stabs.
+		if((symbol_header->index() & 0xfff00) != 0x8f300) {
+			continue;
+		}
+		
+		const char* string = get_string(m_elf, strings_offset + symbol_header->iss);
+		CCC_CHECK(string, "Symbol has invalid string.");
+		strings.emplace_back(string);
+	}
+	
+	return strings;
+}
+
 Result<std::vector<Symbol>> SymbolTableReader::parse_external_symbols() const
 {
 	CCC_ASSERT(m_ready);
@@ -380,6 +530,239 @@ static Result<Symbol> get_symbol(const SymbolHeader& header, std::span<const u8>
 	return symbol;
 }
 
+Result<std::vector<u8>> write_symbol_table(
+	std::span<const File> files, std::span<const Symbol> external_symbols, u32 section_offset)
+{
+	// Work out how big each of the tables is going to be up front so that the
+	// output buffer only has to be allocated once.
+	u64 procedure_descriptor_count = 0;
+	u64 local_symbol_count = 0;
+	u64 local_strings_size = 0;
+	for(const File& file : files) {
+		local_strings_size += file.command_line_path.size() + 1;
+		for(const Symbol& symbol : file.symbols) {
+			if(symbol.procedure_descriptor) {
+				procedure_descriptor_count++;
+			}
+			if(!is_file_path_symbol(symbol, file)) {
+				local_strings_size += strlen(symbol.string) + 1;
+			}
+		}
+		local_symbol_count += file.symbols.size();
+	}
+	
+	u64 external_strings_size = 0;
+	for(const Symbol& symbol : external_symbols) {
+		external_strings_size += strlen(symbol.string) + 1;
+	}
+	
+	// The tables are laid out in the same order as GNU as would use, skipping
+	// the ones that are empty.
+	u64 procedure_descriptors_offset = section_offset + sizeof(SymbolicHeader);
+	u64 local_symbols_offset = procedure_descriptors_offset + procedure_descriptor_count * sizeof(ProcedureDescriptor);
+	u64 local_strings_offset = local_symbols_offset + local_symbol_count * sizeof(SymbolHeader);
+	u64 external_strings_offset = local_strings_offset + local_strings_size;
+	u64 file_descriptors_offset = align_offset(external_strings_offset + external_strings_size, 4);
+	u64 external_symbols_offset = file_descriptors_offset + files.size() * sizeof(FileDescriptor);
+	u64 end_offset = external_symbols_offset + external_symbols.size() * sizeof(ExternalSymbolHeader);
+	
+	CCC_CHECK(end_offset <= INT32_MAX, "Symbol table too large.");
+	
+	std::vector<u8> output(end_offset - section_offset);
+	
+	SymbolicHeader hdrr = {};
+	hdrr.magic = 0x7009;
+	hdrr.procedure_descriptor_count = (s32) procedure_descriptor_count;
+	hdrr.procedure_descriptors_offset = (s32) procedure_descriptors_offset;
+	hdrr.local_symbol_count = (s32) local_symbol_count;
+	hdrr.local_symbols_offset = (s32) local_symbols_offset;
+	hdrr.local_strings_size_bytes = (s32) local_strings_size;
+	hdrr.local_strings_offset = (s32) local_strings_offset;
+	hdrr.external_strings_size_bytes = (s32) external_strings_size;
+	hdrr.external_strings_offset = (s32) external_strings_offset;
+	hdrr.file_descriptor_count = (s32) files.size();
+	hdrr.file_descriptors_offset = (s32) file_descriptors_offset;
+	hdrr.external_symbols_count = (s32) external_symbols.size();
+	hdrr.external_symbols_offset = (s32) external_symbols_offset;
+	write_packed(output, 0, hdrr);
+	
+	// The offsets below are relative to the beginning of the section.
+	procedure_descriptors_offset -= section_offset;
+	local_symbols_offset -= section_offset;
+	local_strings_offset -= section_offset;
+	external_strings_offset -= section_offset;
+	file_descriptors_offset -= section_offset;
+	external_symbols_offset -= section_offset;
+	
+	u32 procedure_descriptor_index = 0;
+	u32 symbol_index = 0;
+	u32 strings_offset = 0;
+	for(size_t i = 0; i < files.size(); i++) {
+		const File& file = files[i];
+		
+		FileDescriptor fd = {};
+		fd.address = file.address;
+		fd.strings_offset = (s32) strings_offset;
+		fd.isym_base = (s32) symbol_index;
+		fd.symbol_count = (s32) file.symbols.size();
+		
+		// The file descriptors can only refer to procedure descriptors within
+		// the first 64k entries.
+		CCC_CHECK(procedure_descriptor_index <= UINT16_MAX, "Too many procedure descriptors.");
+		fd.ipd_first = (u16) procedure_descriptor_index;
+		
+		// The path of the file is written first so that the N_SO symbol
+		// containing the same path can point to it. This is how the reader
+		// finds the working directory.
+		fd.file_path_string_offset = 0;
+		u32 file_strings_size = write_string(output, local_strings_offset + strings_offset, file.command_line_path.c_str());
+		
+		for(size_t j = 0; j < file.symbols.size(); j++) {
+			const Symbol& symbol = file.symbols[j];
+			
+			u32 iss = 0;
+			if(!is_file_path_symbol(symbol, file)) {
+				iss = file_strings_size;
+				file_strings_size += write_string(output, local_strings_offset + strings_offset + iss, symbol.string);
+			}
+			
+			Result<SymbolHeader> header = make_symbol_header(symbol, iss);
+			CCC_RETURN_IF_ERROR(header);
+			write_packed(output, local_symbols_offset + (symbol_index + j) * sizeof(SymbolHeader), *header);
+			
+			if(symbol.procedure_descriptor) {
+				ProcedureDescriptor procedure_descriptor = *symbol.procedure_descriptor;
+				procedure_descriptor.symbol_index = (u32) j;
+				u64 offset = procedure_descriptors_offset + procedure_descriptor_index * sizeof(ProcedureDescriptor);
+				write_packed(output, offset, procedure_descriptor);
+				procedure_descriptor_index++;
+			}
+		}
+		
+		u32 file_procedure_descriptor_count = procedure_descriptor_index - fd.ipd_first;
+		CCC_CHECK(file_procedure_descriptor_count <= UINT16_MAX, "Too many procedure descriptors in file %d.", (s32) i);
+		fd.procedure_descriptor_count = (u16) file_procedure_descriptor_count;
+		fd.cb_ss = (s32) file_strings_size;
+		
+		write_packed(output, file_descriptors_offset + i * sizeof(FileDescriptor), fd);
+		
+		symbol_index += (u32) file.symbols.size();
+		strings_offset += file_strings_size;
+	}
+	
+	u32 external_string_offset = 0;
+	for(size_t i = 0; i < external_symbols.size(); i++) {
+		const Symbol& symbol = external_symbols[i];
+		
+		ExternalSymbolHeader external_header = {};
+		external_header.ifd = -1;
+		
+		Result<SymbolHeader> header = make_symbol_header(symbol, external_string_offset);
+		CCC_RETURN_IF_ERROR(header);
+		external_header.symbol = *header;
+		
+		external_string_offset += write_string(output, external_strings_offset + external_string_offset, symbol.string);
+		write_packed(output, external_symbols_offset + i * sizeof(ExternalSymbolHeader), external_header);
+	}
+	
+	return output;
+}
+
+Result<std::vector<u8>> write_elf_file_with_symbol_table(
+	std::span<const File> files, std::span<const Symbol> external_symbols)
+{
+	static const char SECTION_NAMES[] = "\0.mdebug\0.shstrtab";
+	static const u32 MDEBUG_NAME_OFFSET = 1;
+	static const u32 SHSTRTAB_NAME_OFFSET = 9;
+	
+	u32 section_offset = (u32) align_offset(sizeof(ElfIdentHeader) + sizeof(ElfFileHeader), 16);
+	
+	Result<std::vector<u8>> section = write_symbol_table(files, external_symbols, section_offset);
+	CCC_RETURN_IF_ERROR(section);
+	
+	u64 names_offset = section_offset + section->size();
+	u64 section_headers_offset = align_offset(names_offset + sizeof(SECTION_NAMES), 4);
+	u64 end_offset = section_headers_offset + 3 * sizeof(ElfSectionHeader);
+	CCC_CHECK(end_offset <= UINT32_MAX, "ELF file too large.");
+	
+	std::vector<u8> image(end_offset);
+	
+	ElfIdentHeader ident = {};
+	ident.magic = CCC_FOURCC("\x7f\x45\x4c\x46");
+	ident.e_class = ElfIdentClass::B32;
+	ident.endianess = 1;
+	ident.version = 1;
+	write_packed(image, 0, ident);
+	
+	ElfFileHeader header = {};
+	header.type = ElfFileType::EXEC;
+	header.machine = ElfMachine::MIPS;
+	header.version = 1;
+	header.shoff = (u32) section_headers_offset;
+	header.ehsize = (u16) (sizeof(ElfIdentHeader) + sizeof(ElfFileHeader));
+	header.shentsize = (u16) sizeof(ElfSectionHeader);
+	header.shnum = 3;
+	header.shstrndx = 2;
+	write_packed(image, sizeof(ElfIdentHeader), header);
+	
+	memcpy(&image[section_offset], section->data(), section->size());
+	memcpy(&image[names_offset], SECTION_NAMES, sizeof(SECTION_NAMES));
+	
+	ElfSectionHeader mdebug_header = {};
+	mdebug_header.name = MDEBUG_NAME_OFFSET;
+	mdebug_header.type = ElfSectionType::MIPS_DEBUG;
+	mdebug_header.offset = section_offset;
+	mdebug_header.size = (u32) section->size();
+	mdebug_header.addralign = 4;
+	write_packed(image, section_headers_offset + 1 * sizeof(ElfSectionHeader), mdebug_header);
+	
+	ElfSectionHeader shstrtab_header = {};
+	shstrtab_header.name = SHSTRTAB_NAME_OFFSET;
+	shstrtab_header.type = ElfSectionType::STRTAB;
+	shstrtab_header.offset = (u32) names_offset;
+	shstrtab_header.size = sizeof(SECTION_NAMES);
+	shstrtab_header.addralign = 1;
+	write_packed(image, section_headers_offset + 2 * sizeof(ElfSectionHeader), shstrtab_header);
+	
+	return image;
+}
+
+static Result<SymbolHeader> make_symbol_header(const Symbol& symbol, u32 iss)
+{
+	CCC_CHECK((u32) symbol.symbol_type <= 0b111111, "Symbol type %u out of range.", (u32) symbol.symbol_type);
+	CCC_CHECK((u32) symbol.symbol_class <= 0b11111, "Symbol class %u out of range.", (u32) symbol.symbol_class);
+	CCC_CHECK(symbol.index <= 0b11111111111111111111, "Symbol index %u out of range.", symbol.index);
+	
+	SymbolHeader header;
+	header.iss = iss;
+	header.value = symbol.value;
+	header.bitfields = (u32) symbol.symbol_type | ((u32) symbol.symbol_class << 6) | (symbol.index << 12);
+	return header;
+}
+
+static bool is_file_path_symbol(const Symbol& symbol, const File& file)
+{
+	return symbol.is_stabs() && symbol.code() == N_SO && file.command_line_path == symbol.string;
+}
+
+static u32 write_string(std::vector<u8>& output, u64 offset, const char* string)
+{
+	size_t size = strlen(string) + 1;
+	memcpy(&output[offset], string, size);
+	return (u32) size;
+}
+
+static u64 align_offset(u64 offset, u64 alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+static void write_packed(std::vector<u8>& output, u64 offset, const T& value)
+{
+	memcpy(&output[offset], &value, sizeof(T));
+}
+
 const char* symbol_type(SymbolType type)
 {
 	switch(type) {
@@ -145,12 +145,26 @@ struct File {
 	std::string full_path; // The full combined path.
 };
 
+// The parts of a file that can be read from its file descriptor and procedure
+// descriptors without parsing all of its local symbols.
+struct FileSummary {
+	u32 address = 0;
+	std::string full_path;
+	std::vector<Symbol> procedures; // The symbols pointed to by the procedure descriptors.
+	u32 procedures_end = 0; // The end address of the last procedure, or zero if there are none.
+};
+
 class SymbolTableReader {
 public:
 	Result<void> init(std::span<const u8> elf, s32 section_offset);
 	
 	s32 file_count() const;
 	Result<File> parse_file(s32 index) const;
+	Result<FileSummary> parse_file_summary(s32 index) const;
+	// Read the strings of the STABS symbols in a file, which is all that's
+	// needed to find out which types it defines, without parsing the rest of
+	// its local symbols.
+	Result<std::vector<const char*>> parse_stabs_strings(s32 index) const;
 	Result<std::vector<Symbol>> parse_external_symbols() const;
 	
 	void print_header(FILE* out) const;
@@ -169,6 +183,20 @@ protected:
 	const SymbolicHeader* m_hdrr;
 };
 
+// Serialise a set of files and external symbols into a .mdebug section. This
+// isn't lossless: only the parts of the format that SymbolTableReader parses
+// into File and Symbol objects are written, so line numbers, auxiliary symbols
+// and relative file descriptors from the original section are dropped. The
+// section contains absolute file offsets, so the offset it will be written to
+// in the ELF file must be known up front.
+Result<std::vector<u8>> write_symbol_table(
+	std::span<const File> files, std::span<const Symbol> external_symbols, u32 section_offset);
+
+// Wrap a newly written .mdebug section in a minimal ELF file, so that it can be
+// loaded like the symbol table of a real executable.
+Result<std::vector<u8>> write_elf_file_with_symbol_table(
+	std::span<const File> files, std::span<const Symbol> external_symbols);
+
 const char* symbol_type(SymbolType type);
 const char* symbol_class(SymbolClass symbol_class);
 const char* stabs_code_to_string(StabsCode code);
@@ -4,13 +4,17 @@
 #include "mdebug_symbols.h"
 
 #include "importer_flags.h"
+#include "profiler.h"
 
 namespace ccc::mdebug {
 
+static bool can_skip_stab(const char* string, u32 importer_flags);
 static void mark_duplicate_symbols(std::vector<ParsedSymbol>& symbols);
 
 Result<std::vector<ParsedSymbol>> parse_symbols(const std::vector<mdebug::Symbol>& input, u32& importer_flags)
 {
+	ProfileScope profile(ProfilePhase::PARSE_SYMBOLS);
+	
 	std::vector<ParsedSymbol> output;
 	std::string prefix;
 	for(const mdebug::Symbol& symbol : input) {
@@ -38,6 +42,10 @@ Result<std::vector<ParsedSymbol>> parse_symbols(const std::vector<mdebug::Symbol
 								string = symbol.string;
 							}
 							
+							if(can_skip_stab(string, importer_flags)) {
+								break;
+							}
+							
 							const char* input = string;
 							Result<StabsSymbol> parse_result = parse_stabs_symbol(input);
 							if(parse_result.success()) {
@@ -143,9 +151,63 @@ Result<std::vector<ParsedSymbol>> parse_symbols(const std::vector<mdebug::Symbol
 	
 	mark_duplicate_symbols(output);
 	
+	profile_count(ProfileCounter::PARSED_SYMBOLS, output.size());
+	
 	return output;
 }
 
+static bool can_skip_stab(const char* string, u32 importer_flags)
+{
+	if(!(importer_flags & (NO_FUNCTIONS | NO_GLOBAL_VARIABLES | NO_LOCAL_VARIABLES))) {
+		return false;
+	}
+	
+	const char* input = string;
+	Result<std::string> name = parse_dodgy_stabs_identifier(input, ':');
+	if(!name.success() || *input != ':') {
+		return false;
+	}
+	input++;
+	
+	u32 required_flags;
+	switch(*input) {
+		case 'F':
+		case 'f': {
+			required_flags = NO_FUNCTIONS;
+			break;
+		}
+		case 'G':
+		case 'S': {
+			required_flags = NO_GLOBAL_VARIABLES;
+			break;
+		}
+		case 'a':
+		case 'P':
+		case 'p':
+		case 'r':
+		case 'V':
+		case 'v': {
+			required_flags = NO_FUNCTIONS | NO_LOCAL_VARIABLES;
+			break;
+		}
+		default: {
+			if((*input >= '0' && *input <= '9') || *input == '(') {
+				required_flags = NO_FUNCTIONS | NO_LOCAL_VARIABLES;
+			} else {
+				return false;
+			}
+		}
+	}
+	
+	if(!(importer_flags & required_flags)) {
+		return false;
+	}
+	
+	// Types can be defined inline and then referenced by their type number
+	// from other symbols, so we still have to parse symbols that do that.
+	return strchr(input, '=') == nullptr;
+}
+
 static void mark_duplicate_symbols(std::vector<ParsedSymbol>& symbols)
 {
 	std::map<StabsTypeNumber, size_t> stabs_type_number_to_symbol;
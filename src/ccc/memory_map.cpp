@@ -0,0 +1,389 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "memory_map.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+static s32 type_size_bytes(const ast::Node& type, const SymbolDatabase& database);
+static void append_field_path(std::string& output, const std::string& path);
+static bool is_address_covered(const std::map<u32, u64>& ranges, u32 address);
+static void add_covered_range(std::map<u32, u64>& ranges, u32 begin, u64 end);
+
+MemoryMap::MemoryMap(const SymbolDatabase& database, std::span<const u8> memory, u32 memory_base)
+	: m_database(database)
+	, m_memory(memory)
+	, m_memory_base(memory_base) {}
+
+void MemoryMap::build(const MemoryMapConfig& config)
+{
+	m_objects.clear();
+	m_sorted.clear();
+	m_max_end_addresses.clear();
+	m_pointer_slots.clear();
+	
+	add_global_variables();
+	
+	// Build the index now so that we can check if a pointer points into a
+	// global variable, in which case it doesn't need to be followed. The index
+	// is extended after each level so the same goes for all the objects that
+	// have been discovered so far.
+	build_index();
+	
+	std::vector<s32> frontier;
+	for(s32 i = 0; i < (s32) m_objects.size(); i++) {
+		frontier.emplace_back(i);
+	}
+	
+	s32 thread_count = resolve_thread_count(config.thread_count);
+	std::vector<std::vector<Candidate>> candidates(thread_count);
+	
+	for(s32 depth = 1; depth <= config.max_depth && !frontier.empty(); depth++) {
+		// Compile the pointer slots up front so that the parallel part of the
+		// algorithm only has to read from the cache.
+		std::vector<const std::vector<PointerSlot>*> slots(frontier.size());
+		for(size_t i = 0; i < frontier.size(); i++) {
+			slots[i] = &pointer_slots(*m_objects[frontier[i]].type);
+		}
+		
+		parallel_for((s32) frontier.size(), config.thread_count, [&](s32 i, s32 thread) {
+			scan_object(frontier[i], *slots[i], candidates[thread]);
+		});
+		
+		// Merge the results in order so the output is deterministic. Pointers
+		// into objects discovered earlier in this level, including interior
+		// pointers, are caught by keeping track of the ranges they cover.
+		std::vector<s32> next_frontier;
+		std::map<u32, u64> covered_ranges;
+		for(std::vector<Candidate>& buffer : candidates) {
+			for(const Candidate& candidate : buffer) {
+				if((s32) m_objects.size() >= config.max_objects) {
+					break;
+				}
+				
+				if(object_at_address(candidate.address) > -1 || is_address_covered(covered_ranges, candidate.address)) {
+					continue;
+				}
+				
+				add_covered_range(covered_ranges, candidate.address, (u64) candidate.address + candidate.slot->value_size);
+				
+				MemoryMapObject& object = m_objects.emplace_back();
+				object.address = candidate.address;
+				object.size = candidate.slot->value_size;
+				object.type = candidate.slot->value_type;
+				object.parent = candidate.parent;
+				object.parent_offset = candidate.parent_offset;
+				object.depth = depth;
+				
+				next_frontier.emplace_back((s32) m_objects.size() - 1);
+			}
+			buffer.clear();
+		}
+		
+		build_index();
+		
+		frontier = std::move(next_frontier);
+	}
+}
+
+s32 MemoryMap::object_at_address(u32 address) const
+{
+	auto iterator = std::upper_bound(m_sorted.begin(), m_sorted.end(), address,
+		[&](u32 address, s32 index) { return address < m_objects[index].address; });
+	
+	// Walk backwards until none of the remaining objects could contain the
+	// address. Unless objects overlap this will only check a single object.
+	for(s32 i = (s32) (iterator - m_sorted.begin()) - 1; i >= 0 && m_max_end_addresses[i] > address; i--) {
+		const MemoryMapObject& object = m_objects[m_sorted[i]];
+		if(address < (u64) object.address + object.size) {
+			return m_sorted[i];
+		}
+	}
+	
+	return -1;
+}
+
+std::optional<MemoryMapLookupResult> MemoryMap::lookup(u32 address, FieldLayoutCache& cache) const
+{
+	s32 object_index = object_at_address(address);
+	if(object_index < 0) {
+		return std::nullopt;
+	}
+	
+	MemoryMapLookupResult result;
+	result.object_index = object_index;
+	result.object = &m_objects[object_index];
+	result.object_name = object_name(object_index, cache);
+	result.offset_in_object = address - result.object->address;
+	
+	std::optional<FieldLookupResult> field = cache.field_at_offset(
+		*result.object->type, (s32) result.offset_in_object, m_database);
+	if(field.has_value()) {
+		result.field_path = std::move(field->path);
+		result.node = field->node;
+		result.offset_in_node = (u32) field->offset_in_node;
+	} else {
+		result.node = result.object->type;
+		result.offset_in_node = result.offset_in_object;
+	}
+	
+	return result;
+}
+
+std::string MemoryMap::object_name(s32 object_index, FieldLayoutCache& cache) const
+{
+	if(object_index < 0 || object_index >= (s32) m_objects.size()) {
+		return std::string();
+	}
+	
+	// Find the global variable that this object was discovered from.
+	std::vector<s32> chain;
+	for(s32 index = object_index; index > -1; index = m_objects[index].parent) {
+		chain.emplace_back(index);
+	}
+	
+	const GlobalVariable* global_variable =
+		m_database.global_variables.symbol_from_handle(m_objects[chain.back()].global_variable);
+	std::string name = global_variable ? global_variable->name() : "(unknown)";
+	
+	for(s32 i = (s32) chain.size() - 2; i >= 0; i--) {
+		const MemoryMapObject& object = m_objects[chain[i]];
+		const MemoryMapObject& parent = m_objects[object.parent];
+		
+		std::optional<FieldLookupResult> field = cache.field_at_offset(
+			*parent.type, (s32) object.parent_offset, m_database);
+		if(field.has_value()) {
+			append_field_path(name, field->path);
+		}
+		
+		name = "*(" + name + ")";
+	}
+	
+	return name;
+}
+
+void MemoryMap::add_global_variables()
+{
+	for(const GlobalVariable& global_variable : m_database.global_variables) {
+		if(!global_variable.address().valid() || !global_variable.type()) {
+			continue;
+		}
+		
+		u32 size = global_variable.size();
+		if(size == 0) {
+			s32 type_size = type_size_bytes(*global_variable.type(), m_database);
+			if(type_size <= 0) {
+				continue;
+			}
+			size = (u32) type_size;
+		}
+		
+		if(!is_in_range(global_variable.address().value, size)) {
+			continue;
+		}
+		
+		MemoryMapObject& object = m_objects.emplace_back();
+		object.address = global_variable.address().value;
+		object.size = size;
+		object.type = global_variable.type();
+		object.global_variable = global_variable.handle();
+	}
+}
+
+const std::vector<MemoryMap::PointerSlot>& MemoryMap::pointer_slots(const ast::Node& type)
+{
+	const ast::Node* physical_type = type.physical_type(m_database).first;
+	
+	auto iterator = m_pointer_slots.find(physical_type);
+	if(iterator != m_pointer_slots.end()) {
+		return iterator->second;
+	}
+	
+	std::vector<PointerSlot>& slots = m_pointer_slots[physical_type];
+	compile_pointer_slots(*physical_type, 0, slots, 0);
+	return slots;
+}
+
+void MemoryMap::compile_pointer_slots(const ast::Node& type, u32 offset, std::vector<PointerSlot>& output, s32 depth)
+{
+	if(depth > 200) {
+		return;
+	}
+	
+	const ast::Node& physical_type = *type.physical_type(m_database).first;
+	switch(physical_type.descriptor) {
+		case ast::ARRAY: {
+			const ast::Array& array = physical_type.as<ast::Array>();
+			s32 element_size = type_size_bytes(*array.element_type, m_database);
+			if(element_size <= 0 || array.element_count <= 0) {
+				break;
+			}
+			
+			// Compile the first element and then replicate it.
+			size_t first = output.size();
+			compile_pointer_slots(*array.element_type, offset, output, depth + 1);
+			size_t last = output.size();
+			if(first == last) {
+				break;
+			}
+			
+			for(s32 i = 1; i < array.element_count; i++) {
+				for(size_t j = first; j < last; j++) {
+					PointerSlot slot = output[j];
+					slot.offset += i * element_size;
+					output.emplace_back(slot);
+				}
+			}
+			break;
+		}
+		case ast::POINTER_OR_REFERENCE: {
+			const ast::Node& value_type = *physical_type.as<ast::PointerOrReference>().value_type;
+			const ast::Node& value_physical_type = *value_type.physical_type(m_database).first;
+			
+			// We can't say anything useful about what void pointers and
+			// function pointers are pointing to.
+			if(value_physical_type.descriptor == ast::FUNCTION) {
+				break;
+			}
+			if(value_physical_type.descriptor == ast::BUILTIN
+				&& value_physical_type.as<ast::BuiltIn>().bclass == ast::BuiltInClass::VOID_TYPE) {
+				break;
+			}
+			
+			s32 value_size = type_size_bytes(value_type, m_database);
+			if(value_size <= 0) {
+				break;
+			}
+			
+			PointerSlot& slot = output.emplace_back();
+			slot.offset = offset;
+			slot.value_type = &value_type;
+			slot.value_size = (u32) value_size;
+			break;
+		}
+		case ast::STRUCT_OR_UNION: {
+			const ast::StructOrUnion& struct_or_union = physical_type.as<ast::StructOrUnion>();
+			for(const std::unique_ptr<ast::Node>& base_class : struct_or_union.base_classes) {
+				compile_pointer_slots(*base_class, offset + base_class->offset_bytes, output, depth + 1);
+			}
+			
+			for(const std::unique_ptr<ast::Node>& field : struct_or_union.fields) {
+				if(field->storage_class == STORAGE_CLASS_STATIC) {
+					continue;
+				}
+				
+				compile_pointer_slots(*field, offset + field->offset_bytes, output, depth + 1);
+				
+				// We don't know which member of a union is active, so only
+				// follow pointers in the first one, since that's the one that
+				// would be initialised by an aggregate initialiser.
+				if(!struct_or_union.is_struct) {
+					break;
+				}
+			}
+			break;
+		}
+		default: {}
+	}
+}
+
+void MemoryMap::scan_object(s32 object_index, const std::vector<PointerSlot>& slots, std::vector<Candidate>& output) const
+{
+	const MemoryMapObject& object = m_objects[object_index];
+	const u8* data = &m_memory[object.address - m_memory_base];
+	
+	for(const PointerSlot& slot : slots) {
+		if(slot.offset + 4 > object.size) {
+			continue;
+		}
+		
+		u32 address;
+		memcpy(&address, data + slot.offset, 4);
+		
+		if(address == 0 || !is_in_range(address, slot.value_size)) {
+			continue;
+		}
+		
+		Candidate& candidate = output.emplace_back();
+		candidate.parent = object_index;
+		candidate.parent_offset = slot.offset;
+		candidate.address = address;
+		candidate.slot = &slot;
+	}
+}
+
+bool MemoryMap::is_in_range(u32 address, u32 size) const
+{
+	return address >= m_memory_base && (u64) address - m_memory_base + size <= m_memory.size();
+}
+
+void MemoryMap::build_index()
+{
+	// Only the objects added since the index was last built need to be
+	// sorted, and then they can be merged in with the others.
+	size_t old_size = m_sorted.size();
+	m_sorted.resize(m_objects.size());
+	for(size_t i = old_size; i < m_objects.size(); i++) {
+		m_sorted[i] = (s32) i;
+	}
+	
+	auto compare = [&](s32 lhs, s32 rhs) { return m_objects[lhs].address < m_objects[rhs].address; };
+	std::stable_sort(m_sorted.begin() + old_size, m_sorted.end(), compare);
+	std::inplace_merge(m_sorted.begin(), m_sorted.begin() + old_size, m_sorted.end(), compare);
+	
+	u64 max_end_address = 0;
+	m_max_end_addresses.resize(m_sorted.size());
+	for(size_t i = 0; i < m_sorted.size(); i++) {
+		const MemoryMapObject& object = m_objects[m_sorted[i]];
+		max_end_address = std::max(max_end_address, (u64) object.address + object.size);
+		m_max_end_addresses[i] = max_end_address;
+	}
+}
+
+static s32 type_size_bytes(const ast::Node& type, const SymbolDatabase& database)
+{
+	if(type.size_bytes > 0) {
+		return type.size_bytes;
+	}
+	return type.physical_type(database).first->size_bytes;
+}
+
+static void append_field_path(std::string& output, const std::string& path)
+{
+	if(path.empty()) {
+		return;
+	}
+	if(path[0] != '[') {
+		output += '.';
+	}
+	output += path;
+}
+
+static bool is_address_covered(const std::map<u32, u64>& ranges, u32 address)
+{
+	auto iterator = ranges.upper_bound(address);
+	return iterator != ranges.begin() && std::prev(iterator)->second > address;
+}
+
+static void add_covered_range(std::map<u32, u64>& ranges, u32 begin, u64 end)
+{
+	// Keep the ranges disjoint so that only the one before an address has to
+	// be checked to find out if it's covered.
+	auto iterator = ranges.upper_bound(begin);
+	if(iterator != ranges.begin() && std::prev(iterator)->second >= begin) {
+		iterator--;
+		begin = iterator->first;
+		end = std::max(end, iterator->second);
+	}
+	
+	while(iterator != ranges.end() && iterator->first <= end) {
+		end = std::max(end, iterator->second);
+		iterator = ranges.erase(iterator);
+	}
+	
+	ranges.emplace(begin, end);
+}
+
+}
@@ -0,0 +1,107 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "field_layout.h"
+
+namespace ccc {
+
+struct MemoryMapConfig {
+	s32 thread_count = 0; // Zero means use one thread per core.
+	// Stop following pointers once this many objects have been discovered.
+	s32 max_objects = 1000000;
+	// The maximum number of pointers to follow starting from a global.
+	s32 max_depth = 32;
+};
+
+struct MemoryMapObject {
+	u32 address = 0;
+	u32 size = 0;
+	const ast::Node* type = nullptr;
+	// Only valid for global variables, otherwise the object was discovered by
+	// following a pointer.
+	GlobalVariableHandle global_variable;
+	// The index of the object containing the pointer that was followed to find
+	// this object, or -1 for global variables.
+	s32 parent = -1;
+	// The offset of said pointer relative to the start of the parent object.
+	u32 parent_offset = 0;
+	s32 depth = 0;
+};
+
+struct MemoryMapLookupResult {
+	s32 object_index = -1;
+	const MemoryMapObject* object = nullptr;
+	// e.g. "gPlayer" or "*(gPlayer.inventory)".
+	std::string object_name;
+	// e.g. "items[3].count", or empty if the address isn't inside a field.
+	std::string field_path;
+	// The innermost field, or the type of the object if there isn't one.
+	const ast::Node* node = nullptr;
+	u32 offset_in_object = 0;
+	u32 offset_in_node = 0;
+};
+
+// Labels every byte of a memory dump that belongs to a global variable, or to
+// an object reachable by following typed pointers from a global variable. The
+// objects are stored as sorted intervals so that an address can be looked up
+// quickly. Objects are only valid for as long as the symbol database is
+// unmodified.
+class MemoryMap {
+public:
+	MemoryMap(const SymbolDatabase& database, std::span<const u8> memory, u32 memory_base = 0);
+	
+	// Build the map from scratch. Pointers are followed breadth first with each
+	// level of the graph being scanned in parallel. The result doesn't depend on
+	// the number of threads used.
+	void build(const MemoryMapConfig& config = {});
+	
+	// Objects in the order they were discovered, globals first.
+	const std::vector<MemoryMapObject>& objects() const { return m_objects; }
+	
+	// Returns the index of the object containing the address, or -1 if there
+	// isn't one. If multiple objects overlap, the one that starts last wins.
+	s32 object_at_address(u32 address) const;
+	
+	// Determine which object and which field of that object the given address
+	// belongs to.
+	std::optional<MemoryMapLookupResult> lookup(u32 address, FieldLayoutCache& cache) const;
+	
+	// Generate a C-like expression that evaluates to the given object.
+	std::string object_name(s32 object_index, FieldLayoutCache& cache) const;
+	
+protected:
+	struct PointerSlot {
+		u32 offset = 0;
+		const ast::Node* value_type = nullptr;
+		u32 value_size = 0;
+	};
+	
+	struct Candidate {
+		s32 parent = -1;
+		u32 parent_offset = 0;
+		u32 address = 0;
+		const PointerSlot* slot = nullptr;
+	};
+	
+	void add_global_variables();
+	const std::vector<PointerSlot>& pointer_slots(const ast::Node& type);
+	void compile_pointer_slots(const ast::Node& type, u32 offset, std::vector<PointerSlot>& output, s32 depth);
+	void scan_object(s32 object_index, const std::vector<PointerSlot>& slots, std::vector<Candidate>& output) const;
+	bool is_in_range(u32 address, u32 size) const;
+	void build_index();
+	
+	const SymbolDatabase& m_database;
+	std::span<const u8> m_memory;
+	u32 m_memory_base;
+	std::vector<MemoryMapObject> m_objects;
+	// Object indices sorted by address, and the highest end address of all the
+	// objects up to and including each position.
+	std::vector<s32> m_sorted;
+	std::vector<u64> m_max_end_addresses;
+	// Pointer slots for each physical type, fully expanded through arrays.
+	std::map<const ast::Node*, std::vector<PointerSlot>> m_pointer_slots;
+};
+
+}
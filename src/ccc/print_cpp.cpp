@@ -260,12 +260,13 @@ void CppPrinter::function(const Function& symbol, const SymbolDatabase& database
 						to_refine.storage = std::get_if<GlobalStorage>(&variable->storage);
 						to_refine.type = variable->type();
 						if(can_refine_variable(to_refine)) {
-							fprintf(out, " = ");
-							Result<RefinedData> refine_result = refine_variable(to_refine, database, *elf);
-							if(refine_result.success()) {
-								refined_data(*refine_result, 1);
+							DataRefiner& refiner = data_refiner(database, *elf);
+							Result<PreparedVariable> prepare_result = refiner.prepare_variable(to_refine);
+							if(prepare_result.success()) {
+								fprintf(out, " = ");
+								refiner.write_variable(*prepare_result, 1, out);
 							} else {
-								report_warning(refine_result.error());
+								report_warning(prepare_result.error());
 							}
 						}
 					}
@@ -301,25 +302,25 @@ void CppPrinter::global_variable(
 		return;
 	}
 	
-	std::optional<RefinedData> data;
+	std::optional<PreparedVariable> data;
 	if(elf) {
 		VariableToRefine to_refine;
 		to_refine.address = symbol.address();
 		to_refine.storage = &symbol.storage;
 		to_refine.type = symbol.type();
 		if(can_refine_variable(to_refine)) {
-			Result<RefinedData> refine_result = refine_variable(to_refine, database, *elf);
-			if(refine_result.success()) {
-				data = std::move(*refine_result);
+			Result<PreparedVariable> prepare_result = data_refiner(database, *elf).prepare_variable(to_refine);
+			if(prepare_result.success()) {
+				data = std::move(*prepare_result);
 			} else {
-				report_warning(refine_result.error());
+				report_warning(prepare_result.error());
 			}
 		}
 	}
 	
 	bool wants_spacing = m_config.print_variable_data
 		&& data.has_value()
-		&& std::get_if<std::vector<RefinedData>>(&data->value);
+		&& data->is_list();
 	if(m_has_anything_been_printed && (m_last_wants_spacing || wants_spacing)) {
 		fprintf(out, "\n");
 	}
@@ -341,7 +342,7 @@ void CppPrinter::global_variable(
 	}
 	if(data.has_value()) {
 		fprintf(out, " = ");
-		refined_data(*data, 0);
+		data_refiner(database, *elf).write_variable(*data, 0, out);
 	}
 	fprintf(out, ";\n");
 	
@@ -357,7 +358,7 @@ void CppPrinter::ast_node(
 	SymbolDescriptor symbol_descriptor,
 	bool print_body)
 {
-	VariableName this_name{&node.name};
+	VariableName this_name{&node.name.str()};
 	VariableName& name = node.name.empty() ? parent_name : this_name;
 	
 	if(node.descriptor == ast::FUNCTION) {
@@ -666,30 +667,14 @@ void CppPrinter::function_parameters(std::span<const ParameterVariable*> paramet
 	}
 }
 
-void CppPrinter::refined_data(const RefinedData& data, s32 indentation_level)
+DataRefiner& CppPrinter::data_refiner(const SymbolDatabase& database, const ElfFile& elf)
 {
-	if(!data.field_name.empty()) {
-		fprintf(out, "/* %s = */ ", data.field_name.c_str());
-	}
-	
-	if(const std::string* string = std::get_if<std::string>(&data.value)) {
-		fprintf(out, "%s", string->c_str());
-	}
-	
-	if(const std::vector<RefinedData>* list = std::get_if<std::vector<RefinedData>>(&data.value)) {
-		fprintf(out, "{\n");
-		for(size_t i = 0; i < list->size(); i++) {
-			indent(out, indentation_level + 1);
-			VariableName dummy;
-			refined_data((*list)[i], indentation_level + 1);
-			if(i != list->size() - 1) {
-				fprintf(out, ",");
-			}
-			fprintf(out, "\n");
-		}
-		indent(out, indentation_level);
-		fprintf(out, "}");
+	// Keep the compiled data type layouts around between calls as long as
+	// we're still printing from the same database.
+	if(!m_data_refiner || &m_data_refiner->database() != &database || &m_data_refiner->elf() != &elf) {
+		m_data_refiner = std::make_unique<DataRefiner>(database, elf);
 	}
+	return *m_data_refiner;
 }
 
 static void print_cpp_storage_class(FILE* out, StorageClass storage_class)
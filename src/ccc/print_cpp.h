@@ -59,13 +59,14 @@ protected:
 		SymbolDescriptor symbol_descriptor,
 		bool print_body = true);
 	void function_parameters(std::span<const ParameterVariable*> parameters, const SymbolDatabase& database, s32 stack_frame_size = -1);
-	void refined_data(const RefinedData& data, s32 indentation_level);
+	DataRefiner& data_refiner(const SymbolDatabase& database, const ElfFile& elf);
 	void global_storage_comment(const GlobalStorage& storage, Address address);
 	void register_storage_comment(const RegisterStorage& storage);
 	void stack_storage_comment(const StackStorage& storage, s32 stack_frame_size = -1);
 	void offset(const ast::Node& node, s32 base_offset);
 
 	CppPrinterConfig m_config;
+	std::unique_ptr<DataRefiner> m_data_refiner;
 	s32 m_digits_for_offset = 3;
 	bool m_last_wants_spacing = false;
 	bool m_has_anything_been_printed = false;
@@ -0,0 +1,362 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace ccc {
+
+struct ProfileEvent {
+	ProfilePhase phase;
+	u64 begin_ns = 0;
+	u64 duration_ns = 0;
+	std::string detail;
+};
+
+// Each thread records into its own buffer so that no locking is required
+// while importing. The buffers are owned by the global profiler state, so
+// they outlive the threads that created them, until the profile is reset.
+struct ThreadProfile {
+	s32 thread = 0;
+	std::array<ProfilePhaseTotals, PROFILE_PHASE_COUNT> phases;
+	std::array<u64, PROFILE_COUNTER_COUNT> counters = {};
+	std::array<u16, PROFILE_PHASE_COUNT> depth = {};
+	std::vector<ProfileEvent> events;
+};
+
+struct ProfilerState {
+	std::atomic_bool enabled = false;
+	u64 min_trace_event_ns = 0;
+	std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadProfile>> threads;
+	// Incremented when the buffers are freed, so that each thread knows to
+	// allocate a new one.
+	std::atomic<u32> generation = 0;
+};
+
+static ProfilerState& profiler_state();
+static ThreadProfile& thread_profile();
+static u64 now_ns();
+
+void set_profiling_enabled(bool enabled, u64 min_trace_event_ns)
+{
+	ProfilerState& state = profiler_state();
+	state.min_trace_event_ns = min_trace_event_ns;
+	state.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool profiling_enabled()
+{
+	return profiler_state().enabled.load(std::memory_order_relaxed);
+}
+
+void reset_profile()
+{
+	ProfilerState& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	state.threads.clear();
+	state.threads.shrink_to_fit();
+	state.generation.fetch_add(1, std::memory_order_relaxed);
+	state.epoch = std::chrono::steady_clock::now();
+}
+
+ProfileScope::ProfileScope(ProfilePhase phase)
+	: m_phase(phase)
+{
+	if(profiling_enabled()) {
+		begin(std::string_view());
+	}
+}
+
+ProfileScope::ProfileScope(ProfilePhase phase, std::string_view detail)
+	: m_phase(phase)
+{
+	if(profiling_enabled()) {
+		begin(detail);
+	}
+}
+
+ProfileScope::~ProfileScope()
+{
+	if(!m_active) {
+		return;
+	}
+	
+	ThreadProfile& profile = thread_profile();
+	if(--profile.depth[(s32) m_phase] > 0) {
+		return;
+	}
+	
+	u64 duration_ns = now_ns() - m_begin_ns;
+	
+	ProfilePhaseTotals& totals = profile.phases[(s32) m_phase];
+	totals.calls++;
+	totals.total_ns += duration_ns;
+	
+	if(!m_detail.empty() || duration_ns >= profiler_state().min_trace_event_ns) {
+		ProfileEvent& event = profile.events.emplace_back();
+		event.phase = m_phase;
+		event.begin_ns = m_begin_ns;
+		event.duration_ns = duration_ns;
+		event.detail = std::move(m_detail);
+	}
+}
+
+void ProfileScope::begin(std::string_view detail)
+{
+	ThreadProfile& profile = thread_profile();
+	m_active = true;
+	
+	// Only time the outermost scope for each phase.
+	if(profile.depth[(s32) m_phase]++ > 0) {
+		return;
+	}
+	
+	m_detail = detail;
+	m_begin_ns = now_ns();
+}
+
+void profile_count(ProfileCounter counter, u64 value)
+{
+	if(profiling_enabled()) {
+		thread_profile().counters[(s32) counter] += value;
+	}
+}
+
+ProfileSummary collect_profile_summary()
+{
+	ProfileSummary summary;
+	
+	ProfilerState& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	
+	for(const std::unique_ptr<ThreadProfile>& thread : state.threads) {
+		ProfileThreadSummary& thread_summary = summary.threads.emplace_back();
+		thread_summary.thread = thread->thread;
+		thread_summary.phases = thread->phases;
+		
+		for(s32 i = 0; i < PROFILE_PHASE_COUNT; i++) {
+			summary.phases[i].calls += thread->phases[i].calls;
+			summary.phases[i].total_ns += thread->phases[i].total_ns;
+		}
+		
+		for(s32 i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+			summary.counters[i] += thread->counters[i];
+		}
+		
+		for(const ProfileEvent& event : thread->events) {
+			if(event.phase == ProfilePhase::TRANSLATION_UNIT) {
+				ProfileTranslationUnit& translation_unit = summary.translation_units.emplace_back();
+				translation_unit.name = event.detail;
+				translation_unit.thread = thread->thread;
+				translation_unit.duration_ns = event.duration_ns;
+			}
+		}
+	}
+	
+	std::stable_sort(CCC_BEGIN_END(summary.translation_units),
+		[](const ProfileTranslationUnit& lhs, const ProfileTranslationUnit& rhs) {
+			return lhs.duration_ns > rhs.duration_ns;
+		});
+	
+	return summary;
+}
+
+void print_profile_summary(FILE* out, const ProfileSummary& summary, s32 max_translation_units)
+{
+	fprintf(out, "%-28s %10s %12s %12s\n", "Phase", "Calls", "Total (ms)", "Mean (us)");
+	for(s32 i = 0; i < PROFILE_PHASE_COUNT; i++) {
+		const ProfilePhaseTotals& totals = summary.phases[i];
+		if(totals.calls == 0) {
+			continue;
+		}
+		
+		fprintf(out, "%-28s %10llu %12.3f %12.3f\n",
+			profile_phase_to_string((ProfilePhase) i),
+			(unsigned long long) totals.calls,
+			totals.total_ns / 1e6,
+			totals.total_ns / 1e3 / totals.calls);
+	}
+	
+	fprintf(out, "\n%-28s %10s\n", "Counter", "Value");
+	for(s32 i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+		fprintf(out, "%-28s %10llu\n",
+			profile_counter_to_string((ProfileCounter) i),
+			(unsigned long long) summary.counters[i]);
+	}
+	
+	if(summary.threads.size() > 1) {
+		fprintf(out, "\n%-8s %-28s %10s %12s\n", "Thread", "Phase", "Calls", "Total (ms)");
+		for(const ProfileThreadSummary& thread : summary.threads) {
+			for(s32 i = 0; i < PROFILE_PHASE_COUNT; i++) {
+				if(thread.phases[i].calls > 0) {
+					fprintf(out, "%-8d %-28s %10llu %12.3f\n",
+						thread.thread,
+						profile_phase_to_string((ProfilePhase) i),
+						(unsigned long long) thread.phases[i].calls,
+						thread.phases[i].total_ns / 1e6);
+				}
+			}
+		}
+	}
+	
+	if(!summary.translation_units.empty()) {
+		fprintf(out, "\n%-12s %-8s %s\n", "Time (ms)", "Thread", "Slowest Translation Units");
+		s32 count = std::min((s32) summary.translation_units.size(), max_translation_units);
+		for(s32 i = 0; i < count; i++) {
+			const ProfileTranslationUnit& translation_unit = summary.translation_units[i];
+			fprintf(out, "%-12.3f %-8d %s\n",
+				translation_unit.duration_ns / 1e6, translation_unit.thread, translation_unit.name.c_str());
+		}
+	}
+}
+
+void write_profile_trace(FILE* out)
+{
+	ProfilerState& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	
+	writer.StartObject();
+	writer.Key("traceEvents");
+	writer.StartArray();
+	
+	for(const std::unique_ptr<ThreadProfile>& thread : state.threads) {
+		writer.StartObject();
+		writer.Key("name");
+		writer.String("thread_name");
+		writer.Key("ph");
+		writer.String("M");
+		writer.Key("pid");
+		writer.Int(1);
+		writer.Key("tid");
+		writer.Int(thread->thread);
+		writer.Key("args");
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(("Thread " + std::to_string(thread->thread)).c_str());
+		writer.EndObject();
+		writer.EndObject();
+		
+		for(const ProfileEvent& event : thread->events) {
+			writer.StartObject();
+			writer.Key("name");
+			writer.String(profile_phase_to_string(event.phase));
+			writer.Key("cat");
+			writer.String("import");
+			writer.Key("ph");
+			writer.String("X");
+			writer.Key("ts");
+			writer.Double(event.begin_ns / 1e3);
+			writer.Key("dur");
+			writer.Double(event.duration_ns / 1e3);
+			writer.Key("pid");
+			writer.Int(1);
+			writer.Key("tid");
+			writer.Int(thread->thread);
+			if(!event.detail.empty()) {
+				writer.Key("args");
+				writer.StartObject();
+				writer.Key("detail");
+				writer.String(event.detail.c_str());
+				writer.EndObject();
+			}
+			writer.EndObject();
+		}
+	}
+	
+	writer.EndArray();
+	writer.Key("displayTimeUnit");
+	writer.String("ms");
+	writer.EndObject();
+	
+	fprintf(out, "%s\n", buffer.GetString());
+}
+
+Result<void> finish_profile(FILE* summary_out, const std::string& trace_path)
+{
+	set_profiling_enabled(false);
+	
+	print_profile_summary(summary_out, collect_profile_summary());
+	
+	FILE* file = fopen(trace_path.c_str(), "w");
+	bool opened = file != nullptr;
+	if(opened) {
+		write_profile_trace(file);
+		fclose(file);
+	}
+	
+	reset_profile();
+	
+	CCC_CHECK(opened, "Failed to open trace file '%s'.", trace_path.c_str());
+	
+	return Result<void>();
+}
+
+const char* profile_phase_to_string(ProfilePhase phase)
+{
+	switch(phase) {
+		case ProfilePhase::IMPORT_SYMBOL_TABLE: return "import_symbol_table";
+		case ProfilePhase::STAGE_SYMBOLS: return "stage_symbols";
+		case ProfilePhase::TRANSLATION_UNIT: return "translation_unit";
+		case ProfilePhase::PARSE_FILE: return "parse_file";
+		case ProfilePhase::PARSE_SYMBOLS: return "parse_symbols";
+		case ProfilePhase::STABS_TYPE_TO_AST: return "stabs_type_to_ast";
+		case ProfilePhase::CREATE_DATA_TYPE: return "create_data_type_if_unique";
+		case ProfilePhase::RESOLVE_TYPE_NAMES: return "resolve_type_names";
+		case ProfilePhase::COMPUTE_SIZE_BYTES: return "compute_size_bytes";
+		case ProfilePhase::DEMANGLE: return "demangle";
+		case ProfilePhase::POST_PASSES: return "post_passes";
+	}
+	return "";
+}
+
+const char* profile_counter_to_string(ProfileCounter counter)
+{
+	switch(counter) {
+		case ProfileCounter::PARSED_SYMBOLS: return "parsed_symbols";
+		case ProfileCounter::DEDUPLICATED_DATA_TYPES: return "deduplicated_data_types";
+		case ProfileCounter::DEMANGLED_NAMES: return "demangled_names";
+	}
+	return "";
+}
+
+static ProfilerState& profiler_state()
+{
+	// Intentionally leaked so that threads that are still running during
+	// static destruction can't access a destroyed object.
+	static ProfilerState* state = new ProfilerState;
+	return *state;
+}
+
+static ThreadProfile& thread_profile()
+{
+	thread_local ThreadProfile* profile = nullptr;
+	thread_local u32 generation = 0;
+	
+	ProfilerState& state = profiler_state();
+	if(!profile || generation != state.generation.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(state.mutex);
+		std::unique_ptr<ThreadProfile>& new_profile = state.threads.emplace_back(std::make_unique<ThreadProfile>());
+		new_profile->thread = (s32) state.threads.size() - 1;
+		profile = new_profile.get();
+		generation = state.generation.load(std::memory_order_relaxed);
+	}
+	return *profile;
+}
+
+static u64 now_ns()
+{
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::now() - profiler_state().epoch;
+	return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+}
@@ -0,0 +1,113 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "util.h"
+
+namespace ccc {
+
+// The phases of the import process that are timed. Scopes for the same phase
+// that are nested inside each other, for example from recursive calls, are
+// only counted once.
+enum class ProfilePhase : u8 {
+	IMPORT_SYMBOL_TABLE,
+	STAGE_SYMBOLS,
+	TRANSLATION_UNIT,
+	PARSE_FILE,
+	PARSE_SYMBOLS,
+	STABS_TYPE_TO_AST,
+	CREATE_DATA_TYPE,
+	RESOLVE_TYPE_NAMES,
+	COMPUTE_SIZE_BYTES,
+	DEMANGLE,
+	POST_PASSES
+};
+
+static const constexpr s32 PROFILE_PHASE_COUNT = (s32) ProfilePhase::POST_PASSES + 1;
+
+enum class ProfileCounter : u8 {
+	PARSED_SYMBOLS,
+	DEDUPLICATED_DATA_TYPES,
+	DEMANGLED_NAMES
+};
+
+static const constexpr s32 PROFILE_COUNTER_COUNT = (s32) ProfileCounter::DEMANGLED_NAMES + 1;
+
+// Profiling is disabled by default, in which case a scope costs a single
+// relaxed atomic load. Trace events are only recorded for scopes that take at
+// least min_trace_event_ns, or that have a detail string, so that the trace
+// doesn't get too large.
+void set_profiling_enabled(bool enabled, u64 min_trace_event_ns = 10000);
+bool profiling_enabled();
+
+// Throw away everything that has been recorded so far and free the buffers of
+// all the threads that recorded anything. This must not be called while other
+// threads are recording.
+void reset_profile();
+
+// Time a phase of the import process for as long as this object is alive.
+class ProfileScope {
+public:
+	ProfileScope(ProfilePhase phase);
+	ProfileScope(ProfilePhase phase, std::string_view detail);
+	~ProfileScope();
+	
+	ProfileScope(const ProfileScope& rhs) = delete;
+	ProfileScope& operator=(const ProfileScope& rhs) = delete;
+	
+protected:
+	void begin(std::string_view detail);
+	
+	ProfilePhase m_phase;
+	bool m_active = false;
+	u64 m_begin_ns = 0;
+	std::string m_detail;
+};
+
+void profile_count(ProfileCounter counter, u64 value = 1);
+
+struct ProfilePhaseTotals {
+	u64 calls = 0;
+	u64 total_ns = 0;
+};
+
+struct ProfileThreadSummary {
+	s32 thread = 0;
+	std::array<ProfilePhaseTotals, PROFILE_PHASE_COUNT> phases;
+};
+
+struct ProfileTranslationUnit {
+	std::string name;
+	s32 thread = 0;
+	u64 duration_ns = 0;
+};
+
+struct ProfileSummary {
+	std::array<ProfilePhaseTotals, PROFILE_PHASE_COUNT> phases;
+	std::array<u64, PROFILE_COUNTER_COUNT> counters = {};
+	std::vector<ProfileThreadSummary> threads;
+	// Sorted from slowest to fastest.
+	std::vector<ProfileTranslationUnit> translation_units;
+};
+
+// Gather up the results from all threads. This must not be called while other
+// threads are recording.
+ProfileSummary collect_profile_summary();
+
+// Print a table of the time spent in each phase, the counters, and the slowest
+// translation units.
+void print_profile_summary(FILE* out, const ProfileSummary& summary, s32 max_translation_units = 10);
+
+// Write out all the recorded events in the Chrome trace event format, which
+// can be loaded into chrome://tracing or Perfetto.
+void write_profile_trace(FILE* out);
+
+// Stop profiling, print a summary, write a trace to the given file and then
+// free everything that was recorded.
+Result<void> finish_profile(FILE* summary_out, const std::string& trace_path);
+
+const char* profile_phase_to_string(ProfilePhase phase);
+const char* profile_counter_to_string(ProfileCounter counter);
+
+}
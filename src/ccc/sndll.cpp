@@ -119,6 +119,18 @@ Result<void> import_sndll_symbols(
 	u32 importer_flags,
 	DemanglerFunctions demangler)
 {
+	Result<std::vector<StagedSymbol>> symbols = stage_sndll_symbols(sndll, importer_flags, demangler);
+	CCC_RETURN_IF_ERROR(symbols);
+	
+	return insert_staged_symbols(database, group, *symbols, importer_flags);
+}
+
+Result<std::vector<StagedSymbol>> stage_sndll_symbols(
+	const SNDLLFile& sndll,
+	u32 importer_flags,
+	DemanglerFunctions demangler)
+{
+	std::vector<StagedSymbol> output;
 	for(const SNDLLSymbol& symbol : sndll.symbols) {
 		if(symbol.value == 0 || symbol.string.empty()) {
 			continue;
@@ -129,41 +141,16 @@ Result<void> import_sndll_symbols(
 			address += sndll.address.get_or_zero();
 		}
 		
-		if(!(importer_flags & DONT_DEDUPLICATE_SYMBOLS)) {
-			if(database.functions.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-			
-			if(database.global_variables.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-			
-			if(database.local_variables.first_handle_from_starting_address(address).valid()) {
-				continue;
-			}
-		}
-		
-		const Section* section = database.sections.symbol_overlapping_address(address);
-		if(section) {
-			if(section->contains_code()) {
-				Result<Function*> function = database.functions.create_symbol(
-					symbol.string, group.source, group.module_symbol, address, importer_flags, demangler);
-				CCC_RETURN_IF_ERROR(function);
-				continue;
-			} else if(section->contains_data()) {
-				Result<GlobalVariable*> global_variable = database.global_variables.create_symbol(
-					symbol.string, group.source, group.module_symbol, address, importer_flags, demangler);
-				CCC_RETURN_IF_ERROR(global_variable);
-				continue;
-			}
-		}
-		
-		Result<Label*> label = database.labels.create_symbol(
-			symbol.string, group.source, group.module_symbol, address, importer_flags, demangler);
-		CCC_RETURN_IF_ERROR(label);
+		// Whether this is a function or a global variable depends on which
+		// section it's in, and the sections may not have been imported yet.
+		StagedSymbol& staged = output.emplace_back();
+		staged.type = StagedSymbolType::CODE_OR_DATA;
+		staged.name = symbol.string;
+		staged.demangled_name = demangle_symbol_name(staged.name, importer_flags, demangler);
+		staged.address = address;
 	}
 	
-	return Result<void>();
+	return output;
 }
 
 void print_sndll_symbols(FILE* out, const SNDLLFile& sndll)
@@ -50,6 +50,13 @@ Result<void> import_sndll_symbols(
 	u32 importer_flags,
 	DemanglerFunctions demangler);
 
+// Read the symbols and demangle their names. This doesn't access the symbol
+// database, so it's safe to run while another symbol table is being imported.
+Result<std::vector<StagedSymbol>> stage_sndll_symbols(
+	const SNDLLFile& sndll,
+	u32 importer_flags,
+	DemanglerFunctions demangler);
+
 void print_sndll_symbols(FILE* out, const SNDLLFile& sndll);
 
 }
@@ -8,10 +8,36 @@ namespace ccc {
 #define STABS_DEBUG(...) //__VA_ARGS__
 #define STABS_DEBUG_PRINTF(...) STABS_DEBUG(printf(__VA_ARGS__);)
 
+enum class StabsParseStep : u8 {
+	BEGIN,
+	FIRST_CHILD_DONE,
+	SECOND_CHILD_DONE,
+	METHOD_PARAMETER,
+	BASE_CLASS,
+	BASE_CLASS_DONE,
+	FIELD,
+	FIELD_DONE,
+	MEMBER_FUNCTIONS,
+	MEMBER_FUNCTION_SET,
+	OVERLOAD,
+	OVERLOAD_DONE,
+	VIRTUAL_TYPE_DONE,
+	DONE
+};
+
+// A type that has been allocated but that may still have children left to
+// parse. See parse_stabs_type.
+struct StabsParseFrame {
+	StabsType* type = nullptr;
+	StabsParseStep step = StabsParseStep::BEGIN;
+	s32 remaining_base_classes = 0;
+};
+
 static bool validate_symbol_descriptor(StabsSymbolDescriptor descriptor);
 static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input);
-static Result<std::vector<StabsStructOrUnionType::Field>> parse_field_list(const char*& input);
-static Result<std::vector<StabsStructOrUnionType::MemberFunctionSet>> parse_member_functions(const char*& input);
+static Result<std::unique_ptr<StabsType>> begin_parsing_type(const char*& input);
+static Result<std::unique_ptr<StabsType>*> continue_parsing_type(StabsParseFrame& frame, const char*& input);
+static Result<std::unique_ptr<StabsType>*> continue_parsing_struct_or_union(StabsParseFrame& frame, const char*& input);
 static Result<StabsStructOrUnionType::Visibility> parse_visibility_character(const char*& input);
 STABS_DEBUG(static void print_field(const StabsStructOrUnionType::Field& field);)
 
@@ -138,6 +164,45 @@ Result<std::unique_ptr<StabsType>> parse_top_level_stabs_type(const char*& input
 }
 
 static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
+{
+	// Types are parsed using an explicit stack rather than by recursing so
+	// that deeply nested types can't overflow the call stack. Each frame
+	// represents a type that has been allocated but that still has children
+	// left to parse.
+	std::unique_ptr<StabsType> result;
+	SmallStack<StabsParseFrame> stack;
+	
+	std::unique_ptr<StabsType>* slot = &result;
+	for(;;) {
+		if(slot) {
+			Result<std::unique_ptr<StabsType>> type = begin_parsing_type(input);
+			CCC_RETURN_IF_ERROR(type);
+			*slot = std::move(*type);
+			
+			if((*slot)->descriptor.has_value()) {
+				StabsParseFrame frame;
+				frame.type = slot->get();
+				stack.push_back(frame);
+			}
+		}
+		
+		if(stack.empty()) {
+			break;
+		}
+		
+		Result<std::unique_ptr<StabsType>*> next_slot = continue_parsing_type(stack.back(), input);
+		CCC_RETURN_IF_ERROR(next_slot);
+		slot = *next_slot;
+		
+		if(!slot) {
+			stack.pop_back();
+		}
+	}
+	
+	return result;
+}
+
+static Result<std::unique_ptr<StabsType>> begin_parsing_type(const char*& input)
 {
 	StabsTypeNumber type_number;
 	
@@ -191,35 +256,68 @@ static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
 		descriptor = (StabsTypeDescriptor) descriptor_char;
 	}
 	
+	// Only allocate the type here, the rest of it is parsed by the
+	// continue_parsing_type function.
 	std::unique_ptr<StabsType> out_type;
 	
 	switch(descriptor) {
+		case StabsTypeDescriptor::TYPE_REFERENCE: out_type = std::make_unique<StabsTypeReferenceType>(type_number); break; // 0..9
+		case StabsTypeDescriptor::ARRAY: out_type = std::make_unique<StabsArrayType>(type_number); break; // a
+		case StabsTypeDescriptor::ENUM: out_type = std::make_unique<StabsEnumType>(type_number); break; // e
+		case StabsTypeDescriptor::FUNCTION: out_type = std::make_unique<StabsFunctionType>(type_number); break; // f
+		case StabsTypeDescriptor::VOLATILE_QUALIFIER: out_type = std::make_unique<StabsVolatileQualifierType>(type_number); break; // B
+		case StabsTypeDescriptor::CONST_QUALIFIER: out_type = std::make_unique<StabsConstQualifierType>(type_number); break; // k
+		case StabsTypeDescriptor::RANGE: out_type = std::make_unique<StabsRangeType>(type_number); break; // r
+		case StabsTypeDescriptor::STRUCT: out_type = std::make_unique<StabsStructType>(type_number); break; // s
+		case StabsTypeDescriptor::UNION: out_type = std::make_unique<StabsUnionType>(type_number); break; // u
+		case StabsTypeDescriptor::CROSS_REFERENCE: out_type = std::make_unique<StabsCrossReferenceType>(type_number); break; // x
+		case StabsTypeDescriptor::FLOATING_POINT_BUILTIN: out_type = std::make_unique<StabsFloatingPointBuiltInType>(type_number); break; // R
+		case StabsTypeDescriptor::METHOD: out_type = std::make_unique<StabsMethodType>(type_number); break; // #
+		case StabsTypeDescriptor::REFERENCE: out_type = std::make_unique<StabsReferenceType>(type_number); break; // &
+		case StabsTypeDescriptor::POINTER: out_type = std::make_unique<StabsPointerType>(type_number); break; // *
+		case StabsTypeDescriptor::TYPE_ATTRIBUTE: { // @
+			if((*input >= '0' && *input <= '9') || *input == '(') {
+				out_type = std::make_unique<StabsPointerToDataMemberType>(type_number);
+			} else {
+				out_type = std::make_unique<StabsSizeTypeAttributeType>(type_number);
+			}
+			break;
+		}
+		case StabsTypeDescriptor::BUILTIN: out_type = std::make_unique<StabsBuiltInType>(type_number); break; // -
+		default: {
+			return CCC_FAILURE(
+				"Invalid type descriptor '%c' (%02x).",
+				(u32) descriptor, (u32) descriptor);
+		}
+	}
+	
+	return out_type;
+}
+
+static Result<std::unique_ptr<StabsType>*> continue_parsing_type(StabsParseFrame& frame, const char*& input)
+{
+	StabsParseStep step = frame.step;
+	frame.step = StabsParseStep::FIRST_CHILD_DONE;
+	
+	switch(*frame.type->descriptor) {
 		case StabsTypeDescriptor::TYPE_REFERENCE: { // 0..9
-			auto type_reference = std::make_unique<StabsTypeReferenceType>(type_number);
-			
-			auto type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(type);
-			type_reference->type = std::move(*type);
-			
-			out_type = std::move(type_reference);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsTypeReferenceType>().type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::ARRAY: { // a
-			auto array = std::make_unique<StabsArrayType>(type_number);
-			
-			auto index_type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(index_type);
-			array->index_type = std::move(*index_type);
-			
-			auto element_type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(element_type);
-			array->element_type = std::move(*element_type);
-			
-			out_type = std::move(array);
+			StabsArrayType& array = frame.type->as<StabsArrayType>();
+			if(step == StabsParseStep::BEGIN) {
+				return &array.index_type;
+			} else if(step == StabsParseStep::FIRST_CHILD_DONE) {
+				frame.step = StabsParseStep::SECOND_CHILD_DONE;
+				return &array.element_type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::ENUM: { // e
-			auto enum_type = std::make_unique<StabsEnumType>(type_number);
+			StabsEnumType& enum_type = frame.type->as<StabsEnumType>();
 			STABS_DEBUG_PRINTF("enum {\n");
 			while(*input != ';') {
 				std::optional<std::string> name = parse_stabs_identifier(input, ':');
@@ -230,52 +328,37 @@ static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
 				std::optional<s32> value = parse_number_s32(input);
 				CCC_CHECK(value.has_value(), "Failed to parse enum value.");
 				
-				enum_type->fields.emplace_back(*value, std::move(*name));
+				enum_type.fields.emplace_back(*value, std::move(*name));
 				
 				CCC_EXPECT_CHAR(input, ',', "enum");
 			}
 			input++;
 			STABS_DEBUG_PRINTF("}\n");
-			
-			out_type = std::move(enum_type);
 			break;
 		}
 		case StabsTypeDescriptor::FUNCTION: { // f
-			auto function = std::make_unique<StabsFunctionType>(type_number);
-			
-			auto return_type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(return_type);
-			function->return_type = std::move(*return_type);
-			
-			out_type = std::move(function);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsFunctionType>().return_type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::VOLATILE_QUALIFIER: { // B
-			auto volatile_qualifier = std::make_unique<StabsVolatileQualifierType>(type_number);
-			
-			auto type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(type);
-			volatile_qualifier->type = std::move(*type);
-			
-			out_type = std::move(volatile_qualifier);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsVolatileQualifierType>().type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::CONST_QUALIFIER: { // k
-			auto const_qualifier = std::make_unique<StabsConstQualifierType>(type_number);
-			
-			auto type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(type);
-			const_qualifier->type = std::move(*type);
-			
-			out_type = std::move(const_qualifier);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsConstQualifierType>().type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::RANGE: { // r
-			auto range = std::make_unique<StabsRangeType>(type_number);
-			
-			auto type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(type);
-			range->type = std::move(*type);
+			StabsRangeType& range = frame.type->as<StabsRangeType>();
+			if(step == StabsParseStep::BEGIN) {
+				return &range.type;
+			}
 			
 			CCC_EXPECT_CHAR(input, ';', "range type descriptor");
 			
@@ -287,126 +370,49 @@ static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
 			CCC_CHECK(high.has_value(), "Failed to parse high part of range.");
 			CCC_EXPECT_CHAR(input, ';', "high range value");
 			
-			range->low = std::move(*low);
-			range->high = std::move(*high);
-			
-			out_type = std::move(range);
-			break;
-		}
-		case StabsTypeDescriptor::STRUCT: { // s
-			auto struct_type = std::make_unique<StabsStructType>(type_number);
-			STABS_DEBUG_PRINTF("struct {\n");
-			
-			std::optional<s64> struct_size = parse_number_s64(input);
-			CCC_CHECK(struct_size.has_value(), "Failed to parse struct size.");
-			struct_type->size = *struct_size;
-			
-			if(*input == '!') {
-				input++;
-				std::optional<s32> base_class_count = parse_number_s32(input);
-				CCC_CHECK(base_class_count.has_value(), "Failed to parse base class count.");
-				
-				CCC_EXPECT_CHAR(input, ',', "base class section");
-				
-				for(s64 i = 0; i < *base_class_count; i++) {
-					StabsStructOrUnionType::BaseClass base_class;
-					
-					char is_virtual = *(input++);
-					switch(is_virtual) {
-						case '0': base_class.is_virtual = false; break;
-						case '1': base_class.is_virtual = true; break;
-						default: return CCC_FAILURE("Failed to parse base class (virtual character).");
-					}
-					
-					Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
-					CCC_RETURN_IF_ERROR(visibility);
-					base_class.visibility = *visibility;
-					
-					std::optional<s32> offset = parse_number_s32(input);
-					CCC_CHECK(offset.has_value(), "Failed to parse base class offset.");
-					base_class.offset = (s32) *offset;
-					
-					CCC_EXPECT_CHAR(input, ',', "base class section");
-					
-					auto base_class_type = parse_stabs_type(input);
-					CCC_RETURN_IF_ERROR(base_class_type);
-					base_class.type = std::move(*base_class_type);
-					
-					CCC_EXPECT_CHAR(input, ';', "base class section");
-					struct_type->base_classes.emplace_back(std::move(base_class));
-				}
-			}
-			
-			auto fields = parse_field_list(input);
-			CCC_RETURN_IF_ERROR(fields);
-			struct_type->fields = std::move(*fields);
-			
-			auto member_functions = parse_member_functions(input);
-			CCC_RETURN_IF_ERROR(member_functions);
-			struct_type->member_functions = std::move(*member_functions);
-			
-			STABS_DEBUG_PRINTF("}\n");
-			
-			out_type = std::move(struct_type);
+			range.low = std::move(*low);
+			range.high = std::move(*high);
 			break;
 		}
+		case StabsTypeDescriptor::STRUCT: // s
 		case StabsTypeDescriptor::UNION: { // u
-			auto union_type = std::make_unique<StabsUnionType>(type_number);
-			STABS_DEBUG_PRINTF("union {\n");
-			
-			std::optional<s64> union_size = parse_number_s64(input);
-			CCC_CHECK(union_size.has_value(), "Failed to parse struct size.");
-			union_type->size = *union_size;
-			
-			auto fields = parse_field_list(input);
-			CCC_RETURN_IF_ERROR(fields);
-			union_type->fields = std::move(*fields);
-			
-			auto member_functions = parse_member_functions(input);
-			CCC_RETURN_IF_ERROR(member_functions);
-			union_type->member_functions = std::move(*member_functions);
-			
-			STABS_DEBUG_PRINTF("}\n");
-			
-			out_type = std::move(union_type);
-			break;
+			frame.step = step;
+			return continue_parsing_struct_or_union(frame, input);
 		}
 		case StabsTypeDescriptor::CROSS_REFERENCE: { // x
-			auto cross_reference = std::make_unique<StabsCrossReferenceType>(type_number);
+			StabsCrossReferenceType& cross_reference = frame.type->as<StabsCrossReferenceType>();
 			
 			char cross_reference_type = *(input++);
 			CCC_CHECK(cross_reference_type != '\0', "Failed to parse cross reference type.");
 			
 			switch(cross_reference_type) {
-				case 'e': cross_reference->type = ast::ForwardDeclaredType::ENUM; break;
-				case 's': cross_reference->type = ast::ForwardDeclaredType::STRUCT; break;
-				case 'u': cross_reference->type = ast::ForwardDeclaredType::UNION; break;
+				case 'e': cross_reference.type = ast::ForwardDeclaredType::ENUM; break;
+				case 's': cross_reference.type = ast::ForwardDeclaredType::STRUCT; break;
+				case 'u': cross_reference.type = ast::ForwardDeclaredType::UNION; break;
 				default:
-					return CCC_FAILURE("Invalid cross reference type '%c'.", cross_reference->type);
+					return CCC_FAILURE("Invalid cross reference type '%c'.", cross_reference.type);
 			}
 			
 			Result<std::string> identifier = parse_dodgy_stabs_identifier(input, ':');
 			CCC_RETURN_IF_ERROR(identifier);
-			cross_reference->identifier = std::move(*identifier);
+			cross_reference.identifier = std::move(*identifier);
 			
-			cross_reference->name = cross_reference->identifier;
+			cross_reference.name = cross_reference.identifier;
 			CCC_EXPECT_CHAR(input, ':', "cross reference");
-			
-			out_type = std::move(cross_reference);
 			break;
 		}
 		case StabsTypeDescriptor::FLOATING_POINT_BUILTIN: { // R
-			auto fp_builtin = std::make_unique<StabsFloatingPointBuiltInType>(type_number);
+			StabsFloatingPointBuiltInType& fp_builtin = frame.type->as<StabsFloatingPointBuiltInType>();
 			
 			std::optional<s32> fpclass = parse_number_s32(input);
 			CCC_CHECK(fpclass.has_value(), "Failed to parse floating point built-in class.");
-			fp_builtin->fpclass = *fpclass;
+			fp_builtin.fpclass = *fpclass;
 			
 			CCC_EXPECT_CHAR(input, ';', "floating point builtin");
 			
 			std::optional<s32> bytes = parse_number_s32(input);
 			CCC_CHECK(bytes.has_value(), "Failed to parse floating point built-in.");
-			fp_builtin->bytes = *bytes;
+			fp_builtin.bytes = *bytes;
 			
 			CCC_EXPECT_CHAR(input, ';', "floating point builtin");
 			
@@ -414,35 +420,35 @@ static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
 			CCC_CHECK(value.has_value(), "Failed to parse floating point built-in.");
 			
 			CCC_EXPECT_CHAR(input, ';', "floating point builtin");
-			
-			out_type = std::move(fp_builtin);
 			break;
 		}
 		case StabsTypeDescriptor::METHOD: { // #
-			auto method = std::make_unique<StabsMethodType>(type_number);
-			
-			if(*input == '#') {
-				input++;
-				
-				auto return_type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(return_type);
-				method->return_type = std::move(*return_type);
-				
-				if(*input == ';') {
-					input++;
+			StabsMethodType& method = frame.type->as<StabsMethodType>();
+			switch(step) {
+				case StabsParseStep::BEGIN: {
+					if(*input == '#') {
+						input++;
+						frame.step = StabsParseStep::SECOND_CHILD_DONE;
+						return &method.return_type;
+					}
+					return &method.class_type.emplace();
 				}
-			} else {
-				auto class_type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(class_type);
-				method->class_type = std::move(*class_type);
-				
-				CCC_EXPECT_CHAR(input, ',', "method");
-				
-				auto return_type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(return_type);
-				method->return_type = std::move(*return_type);
-				
-				while(*input != '\0') {
+				case StabsParseStep::FIRST_CHILD_DONE: {
+					CCC_EXPECT_CHAR(input, ',', "method");
+					frame.step = StabsParseStep::METHOD_PARAMETER;
+					return &method.return_type;
+				}
+				case StabsParseStep::SECOND_CHILD_DONE: {
+					if(*input == ';') {
+						input++;
+					}
+					break;
+				}
+				case StabsParseStep::METHOD_PARAMETER: {
+					if(*input == '\0') {
+						break;
+					}
+					
 					if(*input == ';') {
 						input++;
 						break;
@@ -450,276 +456,354 @@ static Result<std::unique_ptr<StabsType>> parse_stabs_type(const char*& input)
 					
 					CCC_EXPECT_CHAR(input, ',', "method");
 					
-					auto parameter_type = parse_stabs_type(input);
-					CCC_RETURN_IF_ERROR(parameter_type);
-					method->parameter_types.emplace_back(std::move(*parameter_type));
+					frame.step = StabsParseStep::METHOD_PARAMETER;
+					return &method.parameter_types.emplace_back();
 				}
+				default: {}
 			}
-			
-			out_type = std::move(method);
 			break;
 		}
 		case StabsTypeDescriptor::REFERENCE: { // &
-			auto reference = std::make_unique<StabsReferenceType>(type_number);
-			
-			auto value_type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(value_type);
-			reference->value_type = std::move(*value_type);
-			
-			out_type = std::move(reference);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsReferenceType>().value_type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::POINTER: { // *
-			auto pointer = std::make_unique<StabsPointerType>(type_number);
-			
-			auto value_type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(value_type);
-			pointer->value_type = std::move(*value_type);
-			
-			out_type = std::move(pointer);
+			if(step == StabsParseStep::BEGIN) {
+				return &frame.type->as<StabsPointerType>().value_type;
+			}
 			break;
 		}
 		case StabsTypeDescriptor::TYPE_ATTRIBUTE: { // @
-			if((*input >= '0' && *input <= '9') || *input == '(') {
-				auto member_pointer = std::make_unique<StabsPointerToDataMemberType>(type_number);
-				
-				auto class_type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(class_type);
-				member_pointer->class_type = std::move(*class_type);
-				
-				CCC_EXPECT_CHAR(input, ',', "pointer to non-static data member");
-				
-				auto member_type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(member_type);
-				member_pointer->member_type = std::move(*member_type);
-				
-				out_type = std::move(member_pointer);
-			} else {
-				auto type_attribute = std::make_unique<StabsSizeTypeAttributeType>(type_number);
+			StabsSizeTypeAttributeType& type_attribute = frame.type->as<StabsSizeTypeAttributeType>();
+			if(step == StabsParseStep::BEGIN) {
 				CCC_CHECK(*input == 's', "Weird value following '@' type descriptor.");
 				input++;
 				
 				std::optional<s64> size_bits = parse_number_s64(input);
 				CCC_CHECK(size_bits.has_value(), "Failed to parse type attribute.")
-				type_attribute->size_bits = *size_bits;
+				type_attribute.size_bits = *size_bits;
 				CCC_EXPECT_CHAR(input, ';', "type attribute");
 				
-				auto type = parse_stabs_type(input);
-				CCC_RETURN_IF_ERROR(type);
-				type_attribute->type = std::move(*type);
-				
-				out_type = std::move(type_attribute);
+				return &type_attribute.type;
+			}
+			break;
+		}
+		case StabsTypeDescriptor::POINTER_TO_DATA_MEMBER: { // @
+			StabsPointerToDataMemberType& member_pointer = frame.type->as<StabsPointerToDataMemberType>();
+			if(step == StabsParseStep::BEGIN) {
+				return &member_pointer.class_type;
+			} else if(step == StabsParseStep::FIRST_CHILD_DONE) {
+				CCC_EXPECT_CHAR(input, ',', "pointer to non-static data member");
+				frame.step = StabsParseStep::SECOND_CHILD_DONE;
+				return &member_pointer.member_type;
 			}
 			break;
 		}
 		case StabsTypeDescriptor::BUILTIN: { // -
-			auto built_in = std::make_unique<StabsBuiltInType>(type_number);
+			StabsBuiltInType& built_in = frame.type->as<StabsBuiltInType>();
 			
 			std::optional<s64> type_id = parse_number_s64(input);
 			CCC_CHECK(type_id.has_value(), "Failed to parse built-in.");
-			built_in->type_id = *type_id;
+			built_in.type_id = *type_id;
 			
 			CCC_EXPECT_CHAR(input, ';', "builtin");
-			
-			out_type = std::move(built_in);
 			break;
 		}
-		default: {
-			return CCC_FAILURE(
-				"Invalid type descriptor '%c' (%02x).",
-				(u32) descriptor, (u32) descriptor);
-		}
 	}
 	
-	return out_type;
+	return nullptr;
 }
 
-static Result<std::vector<StabsStructOrUnionType::Field>> parse_field_list(const char*& input)
+static Result<std::unique_ptr<StabsType>*> continue_parsing_struct_or_union(StabsParseFrame& frame, const char*& input)
 {
-	std::vector<StabsStructOrUnionType::Field> fields;
+	StabsStructOrUnionType& struct_or_union = static_cast<StabsStructOrUnionType&>(*frame.type);
 	
-	while(*input != '\0') {
-		if(*input == ';') {
-			input++;
-			break;
-		}
-		
-		const char* before_field = input;
-		StabsStructOrUnionType::Field field;
-		
-		Result<std::string> name = parse_dodgy_stabs_identifier(input, ':');
-		CCC_RETURN_IF_ERROR(name);
-		field.name = std::move(*name);
-		
-		CCC_EXPECT_CHAR(input, ':', "identifier");
-		if(*input == '/') {
-			input++;
-			
-			Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
-			CCC_RETURN_IF_ERROR(visibility);
-			field.visibility = *visibility;
-		}
-		if(*input == ':') {
-			input = before_field;
-			break;
-		}
-		auto type = parse_stabs_type(input);
-		CCC_RETURN_IF_ERROR(type);
-		field.type = std::move(*type);
-		
-		if(field.name.size() >= 1 && field.name[0] == '$') {
-			// Virtual function table pointers and virtual base class pointers.
-			CCC_EXPECT_CHAR(input, ',', "field type");
-			
-			std::optional<s32> offset_bits = parse_number_s32(input);
-			CCC_CHECK(offset_bits.has_value(), "Failed to parse field offset.");
-			field.offset_bits = *offset_bits;
-			
-			CCC_EXPECT_CHAR(input, ';', "field offset");
-		} else if(*input == ':') {
-			// Static fields.
-			input++;
-			field.is_static = true;
-			
-			std::optional<std::string> type_name = parse_stabs_identifier(input, ';');
-			CCC_CHECK(type_name.has_value(), "Failed to parse static field type name.");
-
-			field.type_name = std::move(*type_name);
-			
-			CCC_EXPECT_CHAR(input, ';', "identifier");
-		} else if(*input == ',') {
-			// Normal fields.
-			input++;
-			
-			std::optional<s32> offset_bits = parse_number_s32(input);
-			CCC_CHECK(offset_bits.has_value(), "Failed to parse field offset.");
-			field.offset_bits = *offset_bits;
-			
-			CCC_EXPECT_CHAR(input, ',', "field offset");
-			
-			std::optional<s32> size_bits = parse_number_s32(input);
-			CCC_CHECK(size_bits.has_value(), "Failed to parse field size.");
-			field.size_bits = *size_bits;
-			
-			CCC_EXPECT_CHAR(input, ';', "field size");
-		} else {
-			return CCC_FAILURE("Expected ':' or ',', got '%c' (%hhx).", *input, *input);
-		}
-
-		STABS_DEBUG(print_field(field);)
-
-		fields.emplace_back(std::move(field));
-	}
-	
-	return fields;
-}
-
-static Result<std::vector<StabsStructOrUnionType::MemberFunctionSet>> parse_member_functions(const char*& input)
-{
-	// Check for if the next character is from an enclosing field list. If this
-	// is the case, the next character will be ',' for normal fields and ':' for
-	// static fields (see above).
-	if(*input == ',' || *input == ':') {
-		return std::vector<StabsStructOrUnionType::MemberFunctionSet>();
-	}
-	
-	std::vector<StabsStructOrUnionType::MemberFunctionSet> member_functions;
-	while(*input != '\0') {
-		if(*input == ';') {
-			input++;
-			break;
-		}
-		StabsStructOrUnionType::MemberFunctionSet member_function_set;
-		
-		std::optional<std::string> name = parse_stabs_identifier(input, ':');
-		CCC_CHECK(name.has_value(), "Failed to parse member function name.");
-		member_function_set.name = std::move(*name);
-		
-		CCC_EXPECT_CHAR(input, ':', "member function");
-		CCC_EXPECT_CHAR(input, ':', "member function");
-		while(*input != '\0') {
-			if(*input == ';') {
-				input++;
+	for(;;) {
+		switch(frame.step) {
+			case StabsParseStep::BEGIN: {
+				if(struct_or_union.descriptor == StabsTypeDescriptor::STRUCT) {
+					STABS_DEBUG_PRINTF("struct {\n");
+					
+					std::optional<s64> struct_size = parse_number_s64(input);
+					CCC_CHECK(struct_size.has_value(), "Failed to parse struct size.");
+					struct_or_union.size = *struct_size;
+					
+					if(*input == '!') {
+						input++;
+						std::optional<s32> base_class_count = parse_number_s32(input);
+						CCC_CHECK(base_class_count.has_value(), "Failed to parse base class count.");
+						
+						CCC_EXPECT_CHAR(input, ',', "base class section");
+						
+						frame.remaining_base_classes = *base_class_count;
+					}
+					
+					frame.step = StabsParseStep::BASE_CLASS;
+				} else {
+					STABS_DEBUG_PRINTF("union {\n");
+					
+					std::optional<s64> union_size = parse_number_s64(input);
+					CCC_CHECK(union_size.has_value(), "Failed to parse struct size.");
+					struct_or_union.size = *union_size;
+					
+					frame.step = StabsParseStep::FIELD;
+				}
 				break;
 			}
-			
-			StabsStructOrUnionType::MemberFunction function;
-			
-			auto type = parse_stabs_type(input);
-			CCC_RETURN_IF_ERROR(type);
-			function.type = std::move(*type);
-			
-			CCC_EXPECT_CHAR(input, ':', "member function");
-			std::optional<std::string> identifier = parse_stabs_identifier(input, ';');
-			CCC_CHECK(identifier.has_value(), "Invalid member function identifier.");
-			
-			CCC_EXPECT_CHAR(input, ';', "member function");
-			
-			Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
-			CCC_RETURN_IF_ERROR(visibility);
-			function.visibility = *visibility;
-			
-			char modifiers = *(input++);
-			CCC_CHECK(modifiers != '\0', "Failed to parse member function modifiers.");
-			switch(modifiers) {
-				case 'A':
-					function.is_const = false;
-					function.is_volatile = false;
+			case StabsParseStep::BASE_CLASS: {
+				if(frame.remaining_base_classes <= 0) {
+					frame.step = StabsParseStep::FIELD;
 					break;
-				case 'B':
-					function.is_const = true;
-					function.is_volatile = false;
+				}
+				
+				StabsStructOrUnionType::BaseClass base_class;
+				
+				char is_virtual = *(input++);
+				switch(is_virtual) {
+					case '0': base_class.is_virtual = false; break;
+					case '1': base_class.is_virtual = true; break;
+					default: return CCC_FAILURE("Failed to parse base class (virtual character).");
+				}
+				
+				Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
+				CCC_RETURN_IF_ERROR(visibility);
+				base_class.visibility = *visibility;
+				
+				std::optional<s32> offset = parse_number_s32(input);
+				CCC_CHECK(offset.has_value(), "Failed to parse base class offset.");
+				base_class.offset = (s32) *offset;
+				
+				CCC_EXPECT_CHAR(input, ',', "base class section");
+				
+				frame.step = StabsParseStep::BASE_CLASS_DONE;
+				return &struct_or_union.base_classes.emplace_back(std::move(base_class)).type;
+			}
+			case StabsParseStep::BASE_CLASS_DONE: {
+				CCC_EXPECT_CHAR(input, ';', "base class section");
+				frame.remaining_base_classes--;
+				frame.step = StabsParseStep::BASE_CLASS;
+				break;
+			}
+			case StabsParseStep::FIELD: {
+				if(*input == '\0') {
+					frame.step = StabsParseStep::MEMBER_FUNCTIONS;
 					break;
-				case 'C':
-					function.is_const = false;
-					function.is_volatile = true;
+				}
+				
+				if(*input == ';') {
+					input++;
+					frame.step = StabsParseStep::MEMBER_FUNCTIONS;
 					break;
-				case 'D':
-					function.is_const = true;
-					function.is_volatile = true;
+				}
+				
+				const char* before_field = input;
+				StabsStructOrUnionType::Field field;
+				
+				Result<std::string> name = parse_dodgy_stabs_identifier(input, ':');
+				CCC_RETURN_IF_ERROR(name);
+				field.name = std::move(*name);
+				
+				CCC_EXPECT_CHAR(input, ':', "identifier");
+				if(*input == '/') {
+					input++;
+					
+					Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
+					CCC_RETURN_IF_ERROR(visibility);
+					field.visibility = *visibility;
+				}
+				if(*input == ':') {
+					input = before_field;
+					frame.step = StabsParseStep::MEMBER_FUNCTIONS;
 					break;
-				case '?':
-				case '.':
+				}
+				
+				frame.step = StabsParseStep::FIELD_DONE;
+				return &struct_or_union.fields.emplace_back(std::move(field)).type;
+			}
+			case StabsParseStep::FIELD_DONE: {
+				StabsStructOrUnionType::Field& field = struct_or_union.fields.back();
+				
+				if(field.name.size() >= 1 && field.name[0] == '$') {
+					// Virtual function table pointers and virtual base class pointers.
+					CCC_EXPECT_CHAR(input, ',', "field type");
+					
+					std::optional<s32> offset_bits = parse_number_s32(input);
+					CCC_CHECK(offset_bits.has_value(), "Failed to parse field offset.");
+					field.offset_bits = *offset_bits;
+					
+					CCC_EXPECT_CHAR(input, ';', "field offset");
+				} else if(*input == ':') {
+					// Static fields.
+					input++;
+					field.is_static = true;
+					
+					std::optional<std::string> type_name = parse_stabs_identifier(input, ';');
+					CCC_CHECK(type_name.has_value(), "Failed to parse static field type name.");
+					
+					field.type_name = std::move(*type_name);
+					
+					CCC_EXPECT_CHAR(input, ';', "identifier");
+				} else if(*input == ',') {
+					// Normal fields.
+					input++;
+					
+					std::optional<s32> offset_bits = parse_number_s32(input);
+					CCC_CHECK(offset_bits.has_value(), "Failed to parse field offset.");
+					field.offset_bits = *offset_bits;
+					
+					CCC_EXPECT_CHAR(input, ',', "field offset");
+					
+					std::optional<s32> size_bits = parse_number_s32(input);
+					CCC_CHECK(size_bits.has_value(), "Failed to parse field size.");
+					field.size_bits = *size_bits;
+					
+					CCC_EXPECT_CHAR(input, ';', "field size");
+				} else {
+					return CCC_FAILURE("Expected ':' or ',', got '%c' (%hhx).", *input, *input);
+				}
+				
+				STABS_DEBUG(print_field(field);)
+				
+				frame.step = StabsParseStep::FIELD;
+				break;
+			}
+			case StabsParseStep::MEMBER_FUNCTIONS: {
+				// Check for if the next character is from an enclosing field list.
+				// If this is the case, the next character will be ',' for normal
+				// fields and ':' for static fields (see above).
+				if(*input == ',' || *input == ':') {
+					frame.step = StabsParseStep::DONE;
 					break;
-				default:
-					return CCC_FAILURE("Invalid member function modifiers.");
+				}
+				
+				frame.step = StabsParseStep::MEMBER_FUNCTION_SET;
+				break;
 			}
-			
-			char flag = *(input++);
-			CCC_CHECK(flag != '\0', "Failed to parse member function type.");
-			switch(flag) {
-				case '.': { // normal member function
-					function.modifier = ast::MemberFunctionModifier::NONE;
+			case StabsParseStep::MEMBER_FUNCTION_SET: {
+				if(*input == '\0') {
+					frame.step = StabsParseStep::DONE;
 					break;
 				}
-				case '?': { // static member function
-					function.modifier = ast::MemberFunctionModifier::STATIC;
+				
+				if(*input == ';') {
+					input++;
+					frame.step = StabsParseStep::DONE;
 					break;
 				}
-				case '*': { // virtual member function
-					std::optional<s32> vtable_index = parse_number_s32(input);
-					CCC_CHECK(vtable_index.has_value(), "Failed to parse vtable index.");
-					function.vtable_index = *vtable_index;
-					
-					CCC_EXPECT_CHAR(input, ';', "virtual member function");
-					
-					auto virtual_type = parse_stabs_type(input);
-					CCC_RETURN_IF_ERROR(virtual_type);
-					function.virtual_type = std::move(*virtual_type);
+				
+				StabsStructOrUnionType::MemberFunctionSet& member_function_set = struct_or_union.member_functions.emplace_back();
+				
+				std::optional<std::string> name = parse_stabs_identifier(input, ':');
+				CCC_CHECK(name.has_value(), "Failed to parse member function name.");
+				member_function_set.name = std::move(*name);
+				
+				CCC_EXPECT_CHAR(input, ':', "member function");
+				CCC_EXPECT_CHAR(input, ':', "member function");
+				
+				frame.step = StabsParseStep::OVERLOAD;
+				break;
+			}
+			case StabsParseStep::OVERLOAD: {
+				if(*input == '\0' || *input == ';') {
+					if(*input == ';') {
+						input++;
+					}
 					
-					CCC_EXPECT_CHAR(input, ';', "virtual member function");
-					function.modifier = ast::MemberFunctionModifier::VIRTUAL;
+					STABS_DEBUG_PRINTF("member func: %s\n", struct_or_union.member_functions.back().name.c_str());
+					frame.step = StabsParseStep::MEMBER_FUNCTION_SET;
 					break;
 				}
-				default:
-					return CCC_FAILURE("Invalid member function type.");
+				
+				frame.step = StabsParseStep::OVERLOAD_DONE;
+				return &struct_or_union.member_functions.back().overloads.emplace_back().type;
+			}
+			case StabsParseStep::OVERLOAD_DONE: {
+				StabsStructOrUnionType::MemberFunction& function = struct_or_union.member_functions.back().overloads.back();
+				
+				CCC_EXPECT_CHAR(input, ':', "member function");
+				std::optional<std::string> identifier = parse_stabs_identifier(input, ';');
+				CCC_CHECK(identifier.has_value(), "Invalid member function identifier.");
+				
+				CCC_EXPECT_CHAR(input, ';', "member function");
+				
+				Result<StabsStructOrUnionType::Visibility> visibility = parse_visibility_character(input);
+				CCC_RETURN_IF_ERROR(visibility);
+				function.visibility = *visibility;
+				
+				char modifiers = *(input++);
+				CCC_CHECK(modifiers != '\0', "Failed to parse member function modifiers.");
+				switch(modifiers) {
+					case 'A':
+						function.is_const = false;
+						function.is_volatile = false;
+						break;
+					case 'B':
+						function.is_const = true;
+						function.is_volatile = false;
+						break;
+					case 'C':
+						function.is_const = false;
+						function.is_volatile = true;
+						break;
+					case 'D':
+						function.is_const = true;
+						function.is_volatile = true;
+						break;
+					case '?':
+					case '.':
+						break;
+					default:
+						return CCC_FAILURE("Invalid member function modifiers.");
+				}
+				
+				char flag = *(input++);
+				CCC_CHECK(flag != '\0', "Failed to parse member function type.");
+				switch(flag) {
+					case '.': { // normal member function
+						function.modifier = ast::MemberFunctionModifier::NONE;
+						frame.step = StabsParseStep::OVERLOAD;
+						break;
+					}
+					case '?': { // static member function
+						function.modifier = ast::MemberFunctionModifier::STATIC;
+						frame.step = StabsParseStep::OVERLOAD;
+						break;
+					}
+					case '*': { // virtual member function
+						std::optional<s32> vtable_index = parse_number_s32(input);
+						CCC_CHECK(vtable_index.has_value(), "Failed to parse vtable index.");
+						function.vtable_index = *vtable_index;
+						
+						CCC_EXPECT_CHAR(input, ';', "virtual member function");
+						
+						frame.step = StabsParseStep::VIRTUAL_TYPE_DONE;
+						return &function.virtual_type;
+					}
+					default:
+						return CCC_FAILURE("Invalid member function type.");
+				}
+				break;
+			}
+			case StabsParseStep::VIRTUAL_TYPE_DONE: {
+				StabsStructOrUnionType::MemberFunction& function = struct_or_union.member_functions.back().overloads.back();
+				
+				CCC_EXPECT_CHAR(input, ';', "virtual member function");
+				function.modifier = ast::MemberFunctionModifier::VIRTUAL;
+				
+				frame.step = StabsParseStep::OVERLOAD;
+				break;
+			}
+			case StabsParseStep::DONE: {
+				STABS_DEBUG_PRINTF("}\n");
+				return nullptr;
+			}
+			default: {
+				return CCC_FAILURE("Invalid struct or union parser step.");
 			}
-			member_function_set.overloads.emplace_back(std::move(function));
 		}
-		STABS_DEBUG_PRINTF("member func: %s\n", member_function_set.name.c_str());
-		member_functions.emplace_back(std::move(member_function_set));
 	}
-	return member_functions;
 }
 
 static Result<StabsStructOrUnionType::Visibility> parse_visibility_character(const char*& input)
@@ -4,6 +4,7 @@
 #include "stabs_to_ast.h"
 
 #include "importer_flags.h"
+#include "profiler.h"
 
 #define AST_DEBUG(...) //__VA_ARGS__
 #define AST_DEBUG_PRINTF(...) AST_DEBUG(printf(__VA_ARGS__);)
@@ -17,16 +18,53 @@ struct MemberFunctionInfo {
 	bool is_operator_member_function = false;
 };
 
+// The type that should be converted next, and the arguments that would have
+// been passed to stabs_type_to_ast if it were recursive.
+struct StabsToAstChild {
+	const StabsType* type = nullptr;
+	const StabsType* enclosing_struct = nullptr;
+	bool substitute_type_name = false;
+	bool force_substitute = false;
+};
+
+// A type that is in the process of being converted. See stabs_type_to_ast.
+struct StabsToAstFrame {
+	const StabsType* type = nullptr;
+	const StabsType* enclosing_struct = nullptr;
+	bool substitute_type_name = false;
+	bool force_substitute = false;
+	// The number of children that have been converted so far.
+	u32 child_index = 0;
+	std::unique_ptr<ast::Node> node;
+	// Used for types that have to be looked up by their type number.
+	std::optional<StabsToAstCacheKey> lookup_key;
+	const StabsType* lookup_type = nullptr;
+	bool cacheable = true;
+	// Used for structs and unions.
+	bool is_bitfield = false;
+	size_t member_function_set_index = 0;
+	size_t overload_index = 0;
+	MemberFunctionInfo member_function_info;
+	bool only_special_functions = true;
+};
+
+static Result<std::unique_ptr<ast::Node>> begin_type_to_ast(
+	StabsToAstFrame& frame,
+	std::vector<StabsToAstFrame>& stack,
+	const std::set<StabsToAstCacheKey>& in_progress,
+	const StabsToAstState& state);
+static Result<std::optional<StabsToAstChild>> continue_type_to_ast(
+	StabsToAstFrame& frame, std::unique_ptr<ast::Node> returned, const StabsToAstState& state);
+static Result<std::optional<StabsToAstChild>> continue_struct_or_union_to_ast(
+	StabsToAstFrame& frame, std::unique_ptr<ast::Node> returned, const StabsToAstState& state);
 static bool is_void_like(const StabsType& type);
 static Result<ast::BuiltInClass> classify_range(const StabsRangeType& type);
-static Result<std::unique_ptr<ast::Node>> field_to_ast(
+static std::unique_ptr<ast::Node> field_to_ast(
 	const StabsStructOrUnionType::Field& field,
-	const StabsType& enclosing_struct,
-	const StabsToAstState& state,
-	s32 depth);
+	std::unique_ptr<ast::Node> node,
+	bool is_bitfield,
+	const StabsToAstState& state);
 static Result<bool> detect_bitfield(const StabsStructOrUnionType::Field& field, const StabsToAstState& state);
-static Result<std::vector<std::unique_ptr<ast::Node>>> member_functions_to_ast(
-	const StabsStructOrUnionType& type, const StabsToAstState& state, s32 depth);
 static MemberFunctionInfo check_member_function(
 	const std::string& mangled_name,
 	std::string_view type_name_no_template_args,
@@ -37,34 +75,88 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 	const StabsType& type,
 	const StabsType* enclosing_struct,
 	const StabsToAstState& state,
-	s32 depth,
 	bool substitute_type_name,
 	bool force_substitute)
 {
+	ProfileScope profile(ProfilePhase::STABS_TYPE_TO_AST);
+	
+	// Types are converted using an explicit stack rather than by recursing so
+	// that deeply nested types can't overflow the call stack. Each frame
+	// represents a type that has children left to convert. The lookup keys of
+	// the frames on the stack are also stored in a set, so that cycles can be
+	// detected without searching the whole stack.
+	std::vector<StabsToAstFrame> stack;
+	std::set<StabsToAstCacheKey> in_progress;
+	
+	std::optional<StabsToAstChild> next;
+	next.emplace();
+	next->type = &type;
+	next->enclosing_struct = enclosing_struct;
+	next->substitute_type_name = substitute_type_name;
+	next->force_substitute = force_substitute;
+	
+	std::unique_ptr<ast::Node> returned;
+	for(;;) {
+		if(next.has_value()) {
+			StabsToAstFrame frame;
+			frame.type = next->type;
+			frame.enclosing_struct = next->enclosing_struct;
+			frame.substitute_type_name = next->substitute_type_name;
+			frame.force_substitute = next->force_substitute;
+			
+			Result<std::unique_ptr<ast::Node>> node = begin_type_to_ast(frame, stack, in_progress, state);
+			CCC_RETURN_IF_ERROR(node);
+			
+			returned = std::move(*node);
+			if(!returned) {
+				if(frame.lookup_key.has_value()) {
+					in_progress.emplace(*frame.lookup_key);
+				}
+				stack.emplace_back(std::move(frame));
+			}
+		}
+		
+		if(stack.empty()) {
+			break;
+		}
+		
+		Result<std::optional<StabsToAstChild>> child = continue_type_to_ast(stack.back(), std::move(returned), state);
+		CCC_RETURN_IF_ERROR(child);
+		next = *child;
+		
+		if(!next.has_value()) {
+			CCC_CHECK(stack.back().node, "Result of stabs_type_to_ast call is nullptr.");
+			returned = std::move(stack.back().node);
+			if(stack.back().lookup_key.has_value()) {
+				in_progress.erase(*stack.back().lookup_key);
+			}
+			stack.pop_back();
+		}
+	}
+	
+	CCC_CHECK(returned, "Result of stabs_type_to_ast call is nullptr.");
+	return returned;
+}
+
+static Result<std::unique_ptr<ast::Node>> begin_type_to_ast(
+	StabsToAstFrame& frame,
+	std::vector<StabsToAstFrame>& stack,
+	const std::set<StabsToAstCacheKey>& in_progress,
+	const StabsToAstState& state)
+{
+	const StabsType& type = *frame.type;
+	
 	AST_DEBUG_PRINTF("%-*stype desc=%hhx '%c' num=(%d,%d) name=%s\n",
-		depth * 4, "",
+		(s32) stack.size() * 4, "",
 		type.descriptor.has_value() ? (u8) *type.descriptor : 'X',
 		(type.descriptor.has_value() && isprint((u8) *type.descriptor)) ? (u8) *type.descriptor : '!',
 		type.type_number.file, type.type_number.type,
 		type.name.has_value() ? type.name->c_str() : "");
 	
-	if(depth > 200) {
-		const char* error_message = "Call depth greater than 200 in stabs_type_to_ast, probably infinite recursion.";
-		if(state.importer_flags & STRICT_PARSING) {
-			return CCC_FAILURE(error_message);
-		} else {
-			CCC_WARN(error_message);
-			
-			auto error = std::make_unique<ast::Error>();
-			error->message = error_message;
-			return std::unique_ptr<ast::Node>(std::move(error));
-		}
-	}
-	
 	// This makes sure that types are replaced with their type name in cases
 	// where that would be more appropriate.
 	if(type.name.has_value()) {
-		bool try_substitute = depth > 0 && (type.is_root
+		bool try_substitute = !stack.empty() && (type.is_root
 			|| type.descriptor == StabsTypeDescriptor::RANGE
 			|| type.descriptor == StabsTypeDescriptor::BUILTIN);
 		// GCC emits anonymous enums with a name of " " since apparently some
@@ -73,7 +165,7 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 		// Cross references will be handled below.
 		bool is_cross_reference = type.descriptor == StabsTypeDescriptor::CROSS_REFERENCE;
 		bool is_void = is_void_like(type);
-		if((substitute_type_name || try_substitute) && !is_name_empty && !is_cross_reference && !is_void) {
+		if((frame.substitute_type_name || try_substitute) && !is_name_empty && !is_cross_reference && !is_void) {
 			auto type_name = std::make_unique<ast::TypeName>();
 			type_name->source = ast::TypeNameSource::REFERENCE;
 			type_name->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>();
@@ -86,8 +178,9 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 	
 	// This prevents infinite recursion when an automatically generated member
 	// function references an unnamed type.
+	const StabsType* enclosing_struct = frame.enclosing_struct;
 	bool can_compare_type_numbers = type.type_number.valid() && enclosing_struct && enclosing_struct->type_number.valid();
-	if(force_substitute && can_compare_type_numbers && type.type_number == enclosing_struct->type_number) {
+	if(frame.force_substitute && can_compare_type_numbers && type.type_number == enclosing_struct->type_number) {
 		// It's probably a this parameter (or return type) for an unnamed type.
 		auto type_name = std::make_unique<ast::TypeName>();
 		type_name->source = ast::TypeNameSource::UNNAMED_THIS;
@@ -115,13 +208,46 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 				return std::unique_ptr<ast::Node>(std::move(error));
 			}
 		}
-		return stabs_type_to_ast(
-			*stabs_type->second,
-			enclosing_struct,
-			state,
-			depth + 1,
-			substitute_type_name,
-			force_substitute);
+		
+		StabsToAstCacheKey key;
+		key.type_number = type.type_number;
+		key.enclosing_struct = frame.enclosing_struct;
+		key.substitute_type_name = frame.substitute_type_name;
+		key.force_substitute = frame.force_substitute;
+		
+		// If we're already in the middle of converting this exact type, then
+		// converting it again would produce the same result, and so we would
+		// recurse forever.
+		if(in_progress.contains(key)) {
+			// Whatever is being converted now is incomplete, so it shouldn't
+			// end up in the cache.
+			for(StabsToAstFrame& other : stack) {
+				other.cacheable = false;
+			}
+			
+			std::string error_message = "STABS type ("
+				+ std::to_string(type.type_number.file) + "," + std::to_string(type.type_number.type)
+				+ ") contains itself, probably a corrupted symbol table.";
+			if(state.importer_flags & STRICT_PARSING) {
+				return CCC_FAILURE("%s", error_message.c_str());
+			} else {
+				CCC_WARN("%s", error_message.c_str());
+				std::unique_ptr<ast::Error> error = std::make_unique<ast::Error>();
+				error->message = std::move(error_message);
+				return std::unique_ptr<ast::Node>(std::move(error));
+			}
+		}
+		
+		if(state.cache) {
+			auto cached_node = state.cache->nodes.find(key);
+			if(cached_node != state.cache->nodes.end()) {
+				return ast::clone_node(*cached_node->second);
+			}
+		}
+		
+		frame.lookup_key = key;
+		frame.lookup_type = stabs_type->second;
+		return std::unique_ptr<ast::Node>();
 	}
 	
 	std::unique_ptr<ast::Node> result;
@@ -129,17 +255,7 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 	switch(*type.descriptor) {
 		case StabsTypeDescriptor::TYPE_REFERENCE: {
 			const auto& stabs_type_ref = type.as<StabsTypeReferenceType>();
-			if(!type.type_number.valid() || !stabs_type_ref.type->type_number.valid() || stabs_type_ref.type->type_number != type.type_number) {
-				auto node = stabs_type_to_ast(
-					*stabs_type_ref.type,
-					enclosing_struct,
-					state,
-					depth + 1,
-					substitute_type_name,
-					force_substitute);
-				CCC_RETURN_IF_ERROR(node);
-				result = std::move(*node);
-			} else {
+			if(type.type_number.valid() && stabs_type_ref.type->type_number.valid() && stabs_type_ref.type->type_number == type.type_number) {
 				// I still don't know why in STABS void is a reference to
 				// itself, maybe because I'm not a philosopher.
 				auto builtin = std::make_unique<ast::BuiltIn>();
@@ -148,43 +264,6 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 			}
 			break;
 		}
-		case StabsTypeDescriptor::ARRAY: {
-			auto array = std::make_unique<ast::Array>();
-			const auto& stabs_array = type.as<StabsArrayType>();
-			
-			auto element_node = stabs_type_to_ast(
-				*stabs_array.element_type,
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(element_node);
-			array->element_type = std::move(*element_node);
-			
-			const StabsRangeType& index = stabs_array.index_type->as<StabsRangeType>();
-			
-			char* end = nullptr;
-			
-			const char* low = index.low.c_str();
-			s64 low_value = strtoll(low, &end, 10);
-			CCC_CHECK(end != low, "Failed to parse low part of range as integer.");
-			CCC_CHECK(low_value == 0, "Invalid index type for array.");
-			
-			const char* high = index.high.c_str();
-			s64 high_value = strtoll(high, &end, 10);
-			CCC_CHECK(end != high, "Failed to parse low part of range as integer.");
-			
-			if(high_value == 4294967295) {
-				// Some compilers wrote out a wrapped around value here.
-				array->element_count = 0;
-			} else {
-				array->element_count = (s32) high_value + 1;
-			}
-			
-			result = std::move(array);
-			break;
-		}
 		case StabsTypeDescriptor::ENUM: {
 			auto inline_enum = std::make_unique<ast::Enum>();
 			const auto& stabs_enum = type.as<StabsEnumType>();
@@ -192,53 +271,6 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 			result = std::move(inline_enum);
 			break;
 		}
-		case StabsTypeDescriptor::FUNCTION: {
-			auto function = std::make_unique<ast::Function>();
-			
-			auto node = stabs_type_to_ast(
-				*type.as<StabsFunctionType>().return_type,
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(node);
-			function->return_type = std::move(*node);
-			
-			result = std::move(function);
-			break;
-		}
-		case StabsTypeDescriptor::VOLATILE_QUALIFIER: {
-			const auto& volatile_qualifier = type.as<StabsVolatileQualifierType>();
-			
-			auto node = stabs_type_to_ast(
-				*volatile_qualifier.type.get(),
-				enclosing_struct,
-				state,
-				depth + 1,
-				substitute_type_name,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(node);
-			result = std::move(*node);
-			
-			result->is_volatile = true;
-			break;
-		}
-		case StabsTypeDescriptor::CONST_QUALIFIER: {
-			const auto& const_qualifier = type.as<StabsConstQualifierType>();
-			
-			auto node = stabs_type_to_ast(
-				*const_qualifier.type.get(),
-				enclosing_struct,
-				state,
-				depth + 1,
-				substitute_type_name,
-				force_substitute);
-			result = std::move(*node);
-			
-			result->is_const = true;
-			break;
-		}
 		case StabsTypeDescriptor::RANGE: {
 			auto builtin = std::make_unique<ast::BuiltIn>();
 			Result<ast::BuiltInClass> bclass = classify_range(type.as<StabsRangeType>());
@@ -247,57 +279,6 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 			result = std::move(builtin);
 			break;
 		}
-		case StabsTypeDescriptor::STRUCT:
-		case StabsTypeDescriptor::UNION: {
-			const StabsStructOrUnionType* stabs_struct_or_union;
-			if(type.descriptor == StabsTypeDescriptor::STRUCT) {
-				stabs_struct_or_union = &type.as<StabsStructType>();
-			} else {
-				stabs_struct_or_union = &type.as<StabsUnionType>();
-			}
-			
-			auto struct_or_union = std::make_unique<ast::StructOrUnion>();
-			struct_or_union->is_struct = type.descriptor == StabsTypeDescriptor::STRUCT;
-			struct_or_union->size_bits = (s32) stabs_struct_or_union->size * 8;
-			
-			for(const StabsStructOrUnionType::BaseClass& stabs_base_class : stabs_struct_or_union->base_classes) {
-				auto base_class = stabs_type_to_ast(
-					*stabs_base_class.type,
-					&type,
-					state,
-					depth + 1,
-					true,
-					force_substitute);
-				CCC_RETURN_IF_ERROR(base_class);
-				
-				(*base_class)->offset_bytes = stabs_base_class.offset;
-				(*base_class)->set_access_specifier(stabs_field_visibility_to_access_specifier(stabs_base_class.visibility), state.importer_flags);
-				
-				if(stabs_base_class.is_virtual) {
-					(*base_class)->is_virtual_base_class = true;
-				}
-				
-				struct_or_union->base_classes.emplace_back(std::move(*base_class));
-			}
-			
-			AST_DEBUG_PRINTF("%-*s beginfields\n", depth * 4, "");
-			for(const StabsStructOrUnionType::Field& field : stabs_struct_or_union->fields) {
-				auto node = field_to_ast(field, type, state, depth);
-				CCC_RETURN_IF_ERROR(node);
-				struct_or_union->fields.emplace_back(std::move(*node));
-			}
-			AST_DEBUG_PRINTF("%-*s endfields\n", depth * 4, "");
-			
-			AST_DEBUG_PRINTF("%-*s beginmemberfuncs\n", depth * 4, "");
-			Result<std::vector<std::unique_ptr<ast::Node>>> member_functions =
-				member_functions_to_ast(*stabs_struct_or_union, state, depth);
-			CCC_RETURN_IF_ERROR(member_functions);
-			struct_or_union->member_functions = std::move(*member_functions);
-			AST_DEBUG_PRINTF("%-*s endmemberfuncs\n", depth * 4, "");
-			
-			result = std::move(struct_or_union);
-			break;
-		}
 		case StabsTypeDescriptor::CROSS_REFERENCE: {
 			const auto& cross_reference = type.as<StabsCrossReferenceType>();
 			auto type_name = std::make_unique<ast::TypeName>();
@@ -322,124 +303,337 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 			result = std::move(builtin);
 			break;
 		}
-		case StabsTypeDescriptor::METHOD: {
-			const auto& stabs_method = type.as<StabsMethodType>();
+		case StabsTypeDescriptor::BUILTIN: {
+			CCC_CHECK(type.as<StabsBuiltInType>().type_id == 16,
+				"Unknown built-in type!");
+			auto builtin = std::make_unique<ast::BuiltIn>();
+			builtin->bclass = ast::BuiltInClass::BOOL_8;
+			result = std::move(builtin);
+			break;
+		}
+		default: {
+			// The type has children, so it will be converted by the
+			// continue_type_to_ast function.
+			break;
+		}
+	}
+	
+	return result;
+}
+
+static Result<std::optional<StabsToAstChild>> continue_type_to_ast(
+	StabsToAstFrame& frame, std::unique_ptr<ast::Node> returned, const StabsToAstState& state)
+{
+	const StabsType& type = *frame.type;
+	
+	if(type.descriptor == StabsTypeDescriptor::STRUCT || type.descriptor == StabsTypeDescriptor::UNION) {
+		return continue_struct_or_union_to_ast(frame, std::move(returned), state);
+	}
+	
+	u32 child_index = frame.child_index++;
+	
+	// Most types only have a single child, which is converted first.
+	StabsToAstChild child;
+	child.enclosing_struct = frame.enclosing_struct;
+	child.substitute_type_name = true;
+	child.force_substitute = frame.force_substitute;
+	
+	if(!type.descriptor.has_value()) {
+		if(child_index == 0) {
+			child.type = frame.lookup_type;
+			child.substitute_type_name = frame.substitute_type_name;
+			return std::optional<StabsToAstChild>(child);
+		}
+		
+		if(state.cache && frame.cacheable) {
+			state.cache->nodes.emplace(*frame.lookup_key, ast::clone_node(*returned));
+		}
+		
+		frame.node = std::move(returned);
+		return std::optional<StabsToAstChild>();
+	}
+	
+	switch(*type.descriptor) {
+		case StabsTypeDescriptor::TYPE_REFERENCE: {
+			if(child_index == 0) {
+				child.type = type.as<StabsTypeReferenceType>().type.get();
+				child.substitute_type_name = frame.substitute_type_name;
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			frame.node = std::move(returned);
+			break;
+		}
+		case StabsTypeDescriptor::ARRAY: {
+			const auto& stabs_array = type.as<StabsArrayType>();
+			if(child_index == 0) {
+				child.type = stabs_array.element_type.get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			auto array = std::make_unique<ast::Array>();
+			array->element_type = std::move(returned);
+			
+			const StabsRangeType& index = stabs_array.index_type->as<StabsRangeType>();
+			
+			char* end = nullptr;
+			
+			const char* low = index.low.c_str();
+			s64 low_value = strtoll(low, &end, 10);
+			CCC_CHECK(end != low, "Failed to parse low part of range as integer.");
+			CCC_CHECK(low_value == 0, "Invalid index type for array.");
+			
+			const char* high = index.high.c_str();
+			s64 high_value = strtoll(high, &end, 10);
+			CCC_CHECK(end != high, "Failed to parse low part of range as integer.");
+			
+			if(high_value == 4294967295) {
+				// Some compilers wrote out a wrapped around value here.
+				array->element_count = 0;
+			} else {
+				array->element_count = (s32) high_value + 1;
+			}
+			
+			frame.node = std::move(array);
+			break;
+		}
+		case StabsTypeDescriptor::FUNCTION: {
+			if(child_index == 0) {
+				child.type = type.as<StabsFunctionType>().return_type.get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
 			auto function = std::make_unique<ast::Function>();
+			function->return_type = std::move(returned);
+			frame.node = std::move(function);
+			break;
+		}
+		case StabsTypeDescriptor::VOLATILE_QUALIFIER: {
+			if(child_index == 0) {
+				child.type = type.as<StabsVolatileQualifierType>().type.get();
+				child.substitute_type_name = frame.substitute_type_name;
+				return std::optional<StabsToAstChild>(child);
+			}
 			
-			auto return_node = stabs_type_to_ast(
-				*stabs_method.return_type.get(),
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				true);
-			CCC_RETURN_IF_ERROR(return_node);
-			function->return_type = std::move(*return_node);
-			
-			function->parameters.emplace();
-			for(const std::unique_ptr<StabsType>& parameter_type : stabs_method.parameter_types) {
-				auto parameter_node = stabs_type_to_ast(
-					*parameter_type,
-					enclosing_struct,
-					state,
-					depth + 1,
-					true,
-					true);
-				CCC_RETURN_IF_ERROR(parameter_node);
-				function->parameters->emplace_back(std::move(*parameter_node));
-			}
-			result = std::move(function);
+			frame.node = std::move(returned);
+			frame.node->is_volatile = true;
 			break;
 		}
-		case StabsTypeDescriptor::POINTER: {
-			auto pointer = std::make_unique<ast::PointerOrReference>();
-			pointer->is_pointer = true;
-			
-			auto value_node = stabs_type_to_ast(
-				*type.as<StabsPointerType>().value_type,
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(value_node);
-			pointer->value_type = std::move(*value_node);
-			
-			result = std::move(pointer);
+		case StabsTypeDescriptor::CONST_QUALIFIER: {
+			if(child_index == 0) {
+				child.type = type.as<StabsConstQualifierType>().type.get();
+				child.substitute_type_name = frame.substitute_type_name;
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			frame.node = std::move(returned);
+			frame.node->is_const = true;
 			break;
 		}
+		case StabsTypeDescriptor::METHOD: {
+			const auto& stabs_method = type.as<StabsMethodType>();
+			child.force_substitute = true;
+			
+			if(child_index == 0) {
+				frame.node = std::make_unique<ast::Function>();
+				child.type = stabs_method.return_type.get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			ast::Function& function = frame.node->as<ast::Function>();
+			if(child_index == 1) {
+				function.return_type = std::move(returned);
+				function.parameters.emplace();
+			} else {
+				function.parameters->emplace_back(std::move(returned));
+			}
+			
+			if(child_index - 1 < stabs_method.parameter_types.size()) {
+				child.type = stabs_method.parameter_types[child_index - 1].get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			break;
+		}
+		case StabsTypeDescriptor::POINTER:
 		case StabsTypeDescriptor::REFERENCE: {
-			auto reference = std::make_unique<ast::PointerOrReference>();
-			reference->is_pointer = false;
-			
-			auto value_node = stabs_type_to_ast(
-				*type.as<StabsReferenceType>().value_type,
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(value_node);
-			reference->value_type = std::move(*value_node);
-			
-			result = std::move(reference);
+			bool is_pointer = type.descriptor == StabsTypeDescriptor::POINTER;
+			if(child_index == 0) {
+				if(is_pointer) {
+					child.type = type.as<StabsPointerType>().value_type.get();
+				} else {
+					child.type = type.as<StabsReferenceType>().value_type.get();
+				}
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			auto pointer_or_reference = std::make_unique<ast::PointerOrReference>();
+			pointer_or_reference->is_pointer = is_pointer;
+			pointer_or_reference->value_type = std::move(returned);
+			frame.node = std::move(pointer_or_reference);
 			break;
 		}
 		case StabsTypeDescriptor::TYPE_ATTRIBUTE: {
 			const auto& stabs_type_attribute = type.as<StabsSizeTypeAttributeType>();
+			if(child_index == 0) {
+				child.type = stabs_type_attribute.type.get();
+				child.substitute_type_name = frame.substitute_type_name;
+				return std::optional<StabsToAstChild>(child);
+			}
 			
-			auto node = stabs_type_to_ast(
-				*stabs_type_attribute.type,
-				enclosing_struct,
-				state,
-				depth + 1,
-				substitute_type_name,
-				force_substitute);
-			CCC_RETURN_IF_ERROR(node);
-			result = std::move(*node);
-			
-			result->size_bits = (s32) stabs_type_attribute.size_bits;
+			frame.node = std::move(returned);
+			frame.node->size_bits = (s32) stabs_type_attribute.size_bits;
 			break;
 		}
 		case StabsTypeDescriptor::POINTER_TO_DATA_MEMBER: {
 			const auto& stabs_member_pointer = type.as<StabsPointerToDataMemberType>();
-			auto member_pointer = std::make_unique<ast::PointerToDataMember>();
-			
-			auto class_node = stabs_type_to_ast(
-				*stabs_member_pointer.class_type.get(),
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				true);
-			CCC_RETURN_IF_ERROR(class_node);
-			member_pointer->class_type = std::move(*class_node);
-			
-			auto member_node = stabs_type_to_ast(
-				*stabs_member_pointer.member_type.get(),
-				enclosing_struct,
-				state,
-				depth + 1,
-				true,
-				true);
-			CCC_RETURN_IF_ERROR(member_node);
-			member_pointer->member_type = std::move(*member_node);
-			
-			result = std::move(member_pointer);
+			child.force_substitute = true;
+			
+			if(child_index == 0) {
+				frame.node = std::make_unique<ast::PointerToDataMember>();
+				child.type = stabs_member_pointer.class_type.get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			ast::PointerToDataMember& member_pointer = frame.node->as<ast::PointerToDataMember>();
+			if(child_index == 1) {
+				member_pointer.class_type = std::move(returned);
+				child.type = stabs_member_pointer.member_type.get();
+				return std::optional<StabsToAstChild>(child);
+			}
+			
+			member_pointer.member_type = std::move(returned);
 			break;
 		}
-		case StabsTypeDescriptor::BUILTIN: {
-			CCC_CHECK(type.as<StabsBuiltInType>().type_id == 16,
-				"Unknown built-in type!");
-			auto builtin = std::make_unique<ast::BuiltIn>();
-			builtin->bclass = ast::BuiltInClass::BOOL_8;
-			result = std::move(builtin);
-			break;
+		default: {
+			return CCC_FAILURE("Unexpected type descriptor in continue_type_to_ast.");
 		}
 	}
 	
-	CCC_CHECK(result, "Result of stabs_type_to_ast call is nullptr.");
-	return result;
+	return std::optional<StabsToAstChild>();
+}
+
+static Result<std::optional<StabsToAstChild>> continue_struct_or_union_to_ast(
+	StabsToAstFrame& frame, std::unique_ptr<ast::Node> returned, const StabsToAstState& state)
+{
+	const StabsType& type = *frame.type;
+	const StabsStructOrUnionType& stabs_struct_or_union = static_cast<const StabsStructOrUnionType&>(type);
+	
+	if(!frame.node) {
+		auto struct_or_union = std::make_unique<ast::StructOrUnion>();
+		struct_or_union->is_struct = type.descriptor == StabsTypeDescriptor::STRUCT;
+		struct_or_union->size_bits = (s32) stabs_struct_or_union.size * 8;
+		frame.node = std::move(struct_or_union);
+	}
+	
+	ast::StructOrUnion& struct_or_union = frame.node->as<ast::StructOrUnion>();
+	
+	size_t base_class_count = stabs_struct_or_union.base_classes.size();
+	size_t field_count = stabs_struct_or_union.fields.size();
+	
+	// Attach the node for the previous child.
+	if(returned) {
+		if(frame.child_index <= base_class_count) {
+			const StabsStructOrUnionType::BaseClass& stabs_base_class = stabs_struct_or_union.base_classes[frame.child_index - 1];
+			
+			returned->offset_bytes = stabs_base_class.offset;
+			returned->set_access_specifier(stabs_field_visibility_to_access_specifier(stabs_base_class.visibility), state.importer_flags);
+			
+			if(stabs_base_class.is_virtual) {
+				returned->is_virtual_base_class = true;
+			}
+			
+			struct_or_union.base_classes.emplace_back(std::move(returned));
+		} else if(frame.child_index <= base_class_count + field_count) {
+			const StabsStructOrUnionType::Field& field = stabs_struct_or_union.fields[frame.child_index - base_class_count - 1];
+			struct_or_union.fields.emplace_back(field_to_ast(field, std::move(returned), frame.is_bitfield, state));
+		} else {
+			const StabsStructOrUnionType::MemberFunction& stabs_func =
+				stabs_struct_or_union.member_functions[frame.member_function_set_index].overloads[frame.overload_index];
+			const MemberFunctionInfo& info = frame.member_function_info;
+			
+			returned->is_constructor_or_destructor = info.is_constructor_or_destructor;
+			returned->is_special_member_function = info.is_special_member_function;
+			returned->is_operator_member_function = info.is_operator_member_function;
+			
+			returned->name = info.name;
+			returned->set_access_specifier(stabs_field_visibility_to_access_specifier(stabs_func.visibility), state.importer_flags);
+			
+			if(returned->descriptor == ast::FUNCTION) {
+				ast::Function& function = returned->as<ast::Function>();
+				function.modifier = stabs_func.modifier;
+				function.vtable_index = stabs_func.vtable_index;
+			}
+			
+			struct_or_union.member_functions.emplace_back(std::move(returned));
+			frame.overload_index++;
+		}
+	}
+	
+	StabsToAstChild child;
+	child.enclosing_struct = &type;
+	child.substitute_type_name = true;
+	
+	if(frame.child_index < base_class_count) {
+		child.type = stabs_struct_or_union.base_classes[frame.child_index].type.get();
+		child.force_substitute = frame.force_substitute;
+		frame.child_index++;
+		return std::optional<StabsToAstChild>(child);
+	}
+	
+	if(frame.child_index < base_class_count + field_count) {
+		const StabsStructOrUnionType::Field& field = stabs_struct_or_union.fields[frame.child_index - base_class_count];
+		AST_DEBUG_PRINTF("field %s\n", field.name.c_str());
+		
+		Result<bool> is_bitfield = detect_bitfield(field, state);
+		CCC_RETURN_IF_ERROR(is_bitfield);
+		frame.is_bitfield = *is_bitfield;
+		
+		child.type = field.type.get();
+		child.force_substitute = false;
+		frame.child_index++;
+		return std::optional<StabsToAstChild>(child);
+	}
+	
+	if(state.importer_flags & NO_MEMBER_FUNCTIONS) {
+		return std::optional<StabsToAstChild>();
+	}
+	
+	while(frame.member_function_set_index < stabs_struct_or_union.member_functions.size()) {
+		const StabsStructOrUnionType::MemberFunctionSet& function_set =
+			stabs_struct_or_union.member_functions[frame.member_function_set_index];
+		
+		if(frame.overload_index == 0) {
+			std::string_view type_name_no_template_args;
+			if(type.name.has_value()) {
+				type_name_no_template_args =
+					std::string_view(*type.name).substr(0, type.name->find("<"));
+			}
+			
+			frame.member_function_info = check_member_function(
+				function_set.name, type_name_no_template_args, state.demangler, state.importer_flags);
+			
+			if(!frame.member_function_info.is_special_member_function) {
+				frame.only_special_functions = false;
+			}
+		}
+		
+		if(frame.overload_index < function_set.overloads.size()) {
+			child.type = function_set.overloads[frame.overload_index].type.get();
+			child.force_substitute = true;
+			frame.child_index++;
+			return std::optional<StabsToAstChild>(child);
+		}
+		
+		frame.member_function_set_index++;
+		frame.overload_index = 0;
+	}
+	
+	if(frame.only_special_functions && (state.importer_flags & INCLUDE_GENERATED_MEMBER_FUNCTIONS) == 0) {
+		struct_or_union.member_functions.clear();
+	}
+	
+	return std::optional<StabsToAstChild>();
 }
 
 static bool is_void_like(const StabsType& type)
@@ -521,59 +715,36 @@ static Result<ast::BuiltInClass> classify_range(const StabsRangeType& type)
 	return CCC_FAILURE("Failed to classify range.");
 }
 
-static Result<std::unique_ptr<ast::Node>> field_to_ast(
+static std::unique_ptr<ast::Node> field_to_ast(
 	const StabsStructOrUnionType::Field& field,
-	const StabsType& enclosing_struct,
-	const StabsToAstState& state,
-	s32 depth)
+	std::unique_ptr<ast::Node> node,
+	bool is_bitfield,
+	const StabsToAstState& state)
 {
-	AST_DEBUG_PRINTF("%-*s  field %s\n", depth * 4, "", field.name.c_str());
-	
-	Result<bool> is_bitfield = detect_bitfield(field, state);
-	CCC_RETURN_IF_ERROR(is_bitfield);
-	
-	if(*is_bitfield) {
+	if(is_bitfield) {
 		// Process bitfields.
-		auto bitfield_node = stabs_type_to_ast(
-			*field.type,
-			&enclosing_struct,
-			state,
-			depth + 1,
-			true,
-			false);
-		CCC_RETURN_IF_ERROR(bitfield_node);
-		
 		std::unique_ptr<ast::BitField> bitfield = std::make_unique<ast::BitField>();
 		bitfield->name = (field.name == " ") ? "" : field.name;
 		bitfield->offset_bytes = field.offset_bits / 8;
 		bitfield->size_bits = field.size_bits;
-		bitfield->underlying_type = std::move(*bitfield_node);
+		bitfield->underlying_type = std::move(node);
 		bitfield->bitfield_offset_bits = field.offset_bits % 8;
 		bitfield->set_access_specifier(stabs_field_visibility_to_access_specifier(field.visibility), state.importer_flags);
 		
-		return std::unique_ptr<ast::Node>(std::move(bitfield));
+		return bitfield;
 	} else {
 		// Process a normal field.
-		Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(
-			*field.type,
-			&enclosing_struct,
-			state,
-			depth + 1,
-			true,
-			false);
-		CCC_RETURN_IF_ERROR(node);
-		
-		(*node)->name = field.name;
-		(*node)->offset_bytes = field.offset_bits / 8;
-		(*node)->size_bits = field.size_bits;
-		(*node)->set_access_specifier(stabs_field_visibility_to_access_specifier(field.visibility), state.importer_flags);
+		node->name = field.name;
+		node->offset_bytes = field.offset_bits / 8;
+		node->size_bits = field.size_bits;
+		node->set_access_specifier(stabs_field_visibility_to_access_specifier(field.visibility), state.importer_flags);
 		
 		if(field.name.starts_with("$vf") || field.name.starts_with("_vptr$") || field.name.starts_with("_vptr.")) {
-			(*node)->is_vtable_pointer = true;
+			node->is_vtable_pointer = true;
 		}
 		
 		if(field.is_static) {
-			(*node)->storage_class = STORAGE_CLASS_STATIC;
+			node->storage_class = STORAGE_CLASS_STATIC;
 		}
 		
 		return node;
@@ -652,64 +823,6 @@ static Result<bool> detect_bitfield(const StabsStructOrUnionType::Field& field,
 	return field.size_bits != underlying_type_size_bits;
 }
 
-static Result<std::vector<std::unique_ptr<ast::Node>>> member_functions_to_ast(
-	const StabsStructOrUnionType& type, const StabsToAstState& state, s32 depth)
-{
-	if(state.importer_flags & NO_MEMBER_FUNCTIONS) {
-		return std::vector<std::unique_ptr<ast::Node>>();
-	}
-	
-	std::string_view type_name_no_template_args;
-	if(type.name.has_value()) {
-		type_name_no_template_args =
-			std::string_view(*type.name).substr(0, type.name->find("<"));
-	}
-	
-	std::vector<std::unique_ptr<ast::Node>> member_functions;
-	bool only_special_functions = true;
-	
-	for(const StabsStructOrUnionType::MemberFunctionSet& function_set : type.member_functions) {
-		MemberFunctionInfo info = check_member_function(
-			function_set.name, type_name_no_template_args, state.demangler, state.importer_flags);
-		
-		if(!info.is_special_member_function) {
-			only_special_functions = false;
-		}
-		
-		for(const StabsStructOrUnionType::MemberFunction& stabs_func : function_set.overloads) {
-			auto node = stabs_type_to_ast(
-				*stabs_func.type,
-				&type,
-				state,
-				depth + 1,
-				true,
-				true);
-			CCC_RETURN_IF_ERROR(node);
-			
-			(*node)->is_constructor_or_destructor = info.is_constructor_or_destructor;
-			(*node)->is_special_member_function = info.is_special_member_function;
-			(*node)->is_operator_member_function = info.is_operator_member_function;
-			
-			(*node)->name = info.name;
-			(*node)->set_access_specifier(stabs_field_visibility_to_access_specifier(stabs_func.visibility), state.importer_flags);
-			
-			if((*node)->descriptor == ast::FUNCTION) {
-				ast::Function& function = (*node)->as<ast::Function>();
-				function.modifier = stabs_func.modifier;
-				function.vtable_index = stabs_func.vtable_index;
-			}
-			
-			member_functions.emplace_back(std::move(*node));
-		}
-	}
-	
-	if(only_special_functions && (state.importer_flags & INCLUDE_GENERATED_MEMBER_FUNCTIONS) == 0) {
-		return std::vector<std::unique_ptr<ast::Node>>();
-	}
-	
-	return member_functions;
-}
-
 static MemberFunctionInfo check_member_function(
 	const std::string& mangled_name,
 	std::string_view type_name_no_template_args,
@@ -721,6 +834,7 @@ static MemberFunctionInfo check_member_function(
 	// Some compiler versions output gcc opnames for overloaded operators
 	// instead of their proper names.
 	if((importer_flags & DONT_DEMANGLE_NAMES) == 0 && demangler.cplus_demangle_opname) {
+		ProfileScope profile(ProfilePhase::DEMANGLE);
 		char* demangled_name = demangler.cplus_demangle_opname(mangled_name.c_str(), 0);
 		if(demangled_name) {
 			info.name = demangled_name;
@@ -8,10 +8,28 @@
 #include "symbol_database.h"
 
 namespace ccc {
+
+struct StabsToAstCacheKey {
+	StabsTypeNumber type_number;
+	const StabsType* enclosing_struct = nullptr;
+	bool substitute_type_name = false;
+	bool force_substitute = false;
 	
+	friend auto operator<=>(const StabsToAstCacheKey& lhs, const StabsToAstCacheKey& rhs) = default;
+};
+
+// Types that are referenced by their type number are converted once per
+// translation unit and then cloned each time they are referenced again, since
+// the same anonymous pointer, array and struct types are often used by lots of
+// different parameters, locals and fields.
+struct StabsToAstCache {
+	std::map<StabsToAstCacheKey, std::unique_ptr<ast::Node>> nodes;
+};
+
 struct StabsToAstState {
 	SourceFileHandle file_handle;
 	std::map<StabsTypeNumber, const StabsType*>* stabs_types;
+	StabsToAstCache* cache = nullptr;
 	u32 importer_flags;
 	DemanglerFunctions demangler;
 };
@@ -20,7 +38,6 @@ Result<std::unique_ptr<ast::Node>> stabs_type_to_ast(
 	const StabsType& type,
 	const StabsType* enclosing_struct,
 	const StabsToAstState& state,
-	s32 depth,
 	bool substitute_type_name,
 	bool force_substitute);
 void fix_recursively_emitted_structures(
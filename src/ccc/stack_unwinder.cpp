@@ -0,0 +1,235 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "stack_unwinder.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+static const s32 MAX_PROLOGUE_INSTRUCTIONS = 64;
+
+static std::optional<u32> read_u32(std::span<const u8> memory, u32 memory_base, u32 address);
+static void scan_prologue(
+	const UnwindEntry& entry,
+	u32 pc,
+	std::span<const u8> memory,
+	u32 memory_base,
+	bool& stack_pointer_adjusted,
+	bool& return_address_saved);
+
+const UnwindEntry* UnwindTable::entry_at_address(u32 address) const
+{
+	auto iterator = std::upper_bound(entries.begin(), entries.end(), address,
+		[](u32 address, const UnwindEntry& entry) { return address < entry.address; });
+	if(iterator == entries.begin()) {
+		return nullptr;
+	}
+	
+	const UnwindEntry& entry = *(iterator - 1);
+	if(address >= (u64) entry.address + entry.size) {
+		return nullptr;
+	}
+	
+	return &entry;
+}
+
+UnwindTable build_unwind_table(const SymbolDatabase& database)
+{
+	UnwindTable table;
+	for(const Function& function : database.functions) {
+		if(!function.address().valid() || function.stack_frame_size < 0) {
+			continue;
+		}
+		
+		UnwindEntry& entry = table.entries.emplace_back();
+		entry.address = function.address().value;
+		entry.size = function.size();
+		entry.frame_size = function.stack_frame_size;
+		entry.function = function.handle();
+		
+		// Registers are saved in descending order starting at the saved
+		// register offset, so the return address will normally be in the
+		// first slot. For other registers assume 4 byte slots.
+		s32 return_pc_register = function.return_pc_register > -1 ? function.return_pc_register : 31;
+		if(return_pc_register < 32 && (function.saved_register_mask >> return_pc_register) & 1) {
+			s32 slots_above = 0;
+			for(s32 i = return_pc_register + 1; i < 32; i++) {
+				slots_above += (function.saved_register_mask >> i) & 1;
+			}
+			entry.return_address_offset = function.stack_frame_size + function.saved_register_offset - slots_above * 4;
+		}
+	}
+	
+	std::stable_sort(table.entries.begin(), table.entries.end(),
+		[](const UnwindEntry& lhs, const UnwindEntry& rhs) { return lhs.address < rhs.address; });
+	
+	// If the size of a function isn't known, assume it extends up to the next
+	// function. Also make sure entries don't overlap.
+	for(size_t i = 0; i < table.entries.size(); i++) {
+		if(i + 1 < table.entries.size()) {
+			u32 max_size = table.entries[i + 1].address - table.entries[i].address;
+			if(table.entries[i].size == 0 || table.entries[i].size > max_size) {
+				table.entries[i].size = max_size;
+			}
+		}
+	}
+	
+	return table;
+}
+
+s32 unwind_stack(
+	const UnwindTable& table,
+	const UnwindRegisters& registers,
+	std::span<const u8> memory,
+	u32 memory_base,
+	std::vector<BacktraceFrame>& output,
+	s32 max_frames)
+{
+	u32 pc = registers.pc;
+	u32 sp = registers.sp;
+	
+	s32 frame_count = 0;
+	while(frame_count < max_frames) {
+		bool innermost = frame_count == 0;
+		
+		// Return addresses point past the delay slot of the call instruction,
+		// so look up the call itself in case it was the last instruction.
+		const UnwindEntry* entry = table.entry_at_address(innermost ? pc : pc - 8);
+		if(!entry) {
+			break;
+		}
+		
+		BacktraceFrame& frame = output.emplace_back();
+		frame.pc = pc;
+		frame.sp = sp;
+		frame.function = entry->function;
+		frame_count++;
+		
+		// If we stopped in the middle of the prologue of the innermost
+		// function, the frame may not have been set up yet.
+		bool stack_pointer_adjusted = true;
+		bool return_address_saved = true;
+		if(innermost) {
+			scan_prologue(*entry, pc, memory, memory_base, stack_pointer_adjusted, return_address_saved);
+		}
+		
+		u32 return_address;
+		if(entry->return_address_offset > -1 && return_address_saved) {
+			std::optional<u32> saved = read_u32(memory, memory_base, sp + entry->return_address_offset);
+			if(!saved.has_value()) {
+				break;
+			}
+			return_address = *saved;
+		} else if(innermost) {
+			return_address = registers.ra;
+		} else {
+			break;
+		}
+		
+		u32 caller_sp = stack_pointer_adjusted ? sp + entry->frame_size : sp;
+		if(return_address == 0 || caller_sp < sp || (caller_sp == sp && return_address == pc)) {
+			break;
+		}
+		
+		pc = return_address;
+		sp = caller_sp;
+	}
+	
+	return frame_count;
+}
+
+std::span<const BacktraceFrame> BatchBacktraces::backtrace(size_t sample) const
+{
+	return std::span<const BacktraceFrame>(frames).subspan(
+		first_frames[sample], first_frames[sample + 1] - first_frames[sample]);
+}
+
+BatchBacktraces unwind_stacks(
+	const UnwindTable& table, std::span<const StackSample> samples, s32 thread_count, s32 max_frames)
+{
+	std::vector<std::vector<BacktraceFrame>> thread_frames(resolve_thread_count(thread_count));
+	std::vector<u32> frame_counts(samples.size());
+	
+	parallel_for((s32) samples.size(), thread_count, [&](s32 i, s32 thread) {
+		const StackSample& sample = samples[i];
+		frame_counts[i] = (u32) unwind_stack(
+			table, sample.registers, sample.memory, sample.memory_base, thread_frames[thread], max_frames);
+	});
+	
+	// Each thread processes a contiguous range of samples, in order, so the
+	// buffers can just be concatenated.
+	BatchBacktraces result;
+	
+	size_t total_frames = 0;
+	for(const std::vector<BacktraceFrame>& frames : thread_frames) {
+		total_frames += frames.size();
+	}
+	
+	result.frames.reserve(total_frames);
+	for(std::vector<BacktraceFrame>& frames : thread_frames) {
+		result.frames.insert(result.frames.end(), frames.begin(), frames.end());
+		frames = {};
+	}
+	
+	result.first_frames.resize(samples.size() + 1);
+	result.first_frames[0] = 0;
+	for(size_t i = 0; i < samples.size(); i++) {
+		result.first_frames[i + 1] = result.first_frames[i] + frame_counts[i];
+	}
+	
+	return result;
+}
+
+static std::optional<u32> read_u32(std::span<const u8> memory, u32 memory_base, u32 address)
+{
+	if(address < memory_base || (u64) address - memory_base + 4 > memory.size()) {
+		return std::nullopt;
+	}
+	u32 value;
+	memcpy(&value, &memory[address - memory_base], 4);
+	return value;
+}
+
+static void scan_prologue(
+	const UnwindEntry& entry,
+	u32 pc,
+	std::span<const u8> memory,
+	u32 memory_base,
+	bool& stack_pointer_adjusted,
+	bool& return_address_saved)
+{
+	if(pc - entry.address > MAX_PROLOGUE_INSTRUCTIONS * 4) {
+		return;
+	}
+	
+	bool adjusted = entry.frame_size == 0;
+	bool saved = entry.return_address_offset < 0;
+	for(u32 address = entry.address; address < pc; address += 4) {
+		std::optional<u32> instruction = read_u32(memory, memory_base, address);
+		if(!instruction.has_value()) {
+			// The code isn't included in the snapshot, so assume we're past
+			// the prologue.
+			return;
+		}
+		
+		u32 opcode = *instruction >> 26;
+		u32 rs = (*instruction >> 21) & 0x1f;
+		u32 rt = (*instruction >> 16) & 0x1f;
+		
+		// addiu/daddiu sp, sp, -frame_size
+		if((opcode == 0x09 || opcode == 0x19) && rs == 29 && rt == 29 && (s16) *instruction < 0) {
+			adjusted = true;
+		}
+		
+		// sw/sd/sq ra, offset(sp)
+		if((opcode == 0x2b || opcode == 0x3f || opcode == 0x1f) && rs == 29 && rt == 31) {
+			saved = true;
+		}
+	}
+	
+	stack_pointer_adjusted = adjusted;
+	return_address_saved = saved;
+}
+
+}
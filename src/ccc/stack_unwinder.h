@@ -0,0 +1,78 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "ast.h"
+
+namespace ccc {
+
+// The information needed to unwind a single stack frame, taken from the
+// procedure descriptor of a function.
+struct UnwindEntry {
+	u32 address = 0;
+	u32 size = 0;
+	s32 frame_size = 0;
+	// Offset of the saved return address relative to the stack pointer after
+	// the prologue has run, or -1 if it stays in a register.
+	s32 return_address_offset = -1;
+	FunctionHandle function;
+};
+
+struct UnwindTable {
+	std::vector<UnwindEntry> entries; // Sorted by address.
+	
+	const UnwindEntry* entry_at_address(u32 address) const;
+};
+
+// Build an unwind table from all the functions that have procedure descriptors.
+UnwindTable build_unwind_table(const SymbolDatabase& database);
+
+struct UnwindRegisters {
+	u32 pc = 0;
+	u32 sp = 0;
+	u32 ra = 0;
+};
+
+struct BacktraceFrame {
+	// For the innermost frame this is the program counter, for all the other
+	// frames it's the return address.
+	u32 pc = 0;
+	u32 sp = 0;
+	FunctionHandle function;
+};
+
+// Walk the stack starting from the given register state, appending a frame to
+// the output for each function found. Stops when the program counter isn't
+// inside a known function, the stack can't be read or max_frames is reached.
+// Returns the number of frames appended.
+s32 unwind_stack(
+	const UnwindTable& table,
+	const UnwindRegisters& registers,
+	std::span<const u8> memory,
+	u32 memory_base,
+	std::vector<BacktraceFrame>& output,
+	s32 max_frames = 256);
+
+// A sampled register state and a copy of (at least) the stack memory at the
+// time the sample was taken.
+struct StackSample {
+	UnwindRegisters registers;
+	std::span<const u8> memory;
+	u32 memory_base = 0;
+};
+
+struct BatchBacktraces {
+	std::vector<BacktraceFrame> frames;
+	// The frames for sample i are in the range [first_frames[i], first_frames[i + 1]).
+	std::vector<u32> first_frames;
+	
+	std::span<const BacktraceFrame> backtrace(size_t sample) const;
+};
+
+// Unwind many samples in parallel. The output doesn't depend on the number of
+// threads used. If thread_count is zero, one thread per core is used.
+BatchBacktraces unwind_stacks(
+	const UnwindTable& table, std::span<const StackSample> samples, s32 thread_count = 0, s32 max_frames = 256);
+
+}
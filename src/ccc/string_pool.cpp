@@ -0,0 +1,169 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "string_pool.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace ccc {
+
+// The pool is split into shards, each with its own lock, so that importer
+// threads interning strings at the same time rarely have to wait on each
+// other. The entries are allocated separately so pointers to them stay valid,
+// and the keys point to the strings stored in the entries.
+struct StringPoolShard {
+	std::mutex mutex;
+	std::unordered_map<std::string_view, std::unique_ptr<StringPoolEntry>> entries;
+	size_t byte_count = 0;
+};
+
+static const size_t STRING_POOL_SHARD_COUNT = 16;
+
+static StringPoolEntry* intern(std::string_view string);
+static void acquire(StringPoolEntry* entry);
+static void release(StringPoolEntry* entry);
+static StringPoolShard* string_pool_shards();
+
+// The empty string isn't reference counted.
+static StringPoolEntry EMPTY_ENTRY;
+
+InternedString::InternedString()
+	: m_entry(&EMPTY_ENTRY) {}
+
+InternedString::InternedString(const std::string& string)
+	: m_entry(intern(string)) {}
+
+InternedString::InternedString(std::string_view string)
+	: m_entry(intern(string)) {}
+
+InternedString::InternedString(const char* string)
+	: m_entry(intern(string)) {}
+
+InternedString::InternedString(const InternedString& rhs)
+	: m_entry(rhs.m_entry)
+{
+	acquire(m_entry);
+}
+
+InternedString::InternedString(InternedString&& rhs)
+	: m_entry(rhs.m_entry)
+{
+	rhs.m_entry = &EMPTY_ENTRY;
+}
+
+InternedString::~InternedString()
+{
+	release(m_entry);
+}
+
+InternedString& InternedString::operator=(const InternedString& rhs)
+{
+	if(m_entry != rhs.m_entry) {
+		acquire(rhs.m_entry);
+		release(m_entry);
+		m_entry = rhs.m_entry;
+	}
+	return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& rhs)
+{
+	if(this != &rhs) {
+		release(m_entry);
+		m_entry = rhs.m_entry;
+		rhs.m_entry = &EMPTY_ENTRY;
+	}
+	return *this;
+}
+
+StringPoolStats string_pool_stats()
+{
+	StringPoolStats stats;
+	
+	StringPoolShard* shards = string_pool_shards();
+	for(size_t i = 0; i < STRING_POOL_SHARD_COUNT; i++) {
+		std::lock_guard<std::mutex> lock(shards[i].mutex);
+		stats.string_count += shards[i].entries.size();
+		stats.byte_count += shards[i].byte_count;
+	}
+	
+	return stats;
+}
+
+static StringPoolEntry* intern(std::string_view string)
+{
+	if(string.empty()) {
+		return &EMPTY_ENTRY;
+	}
+	
+	u32 shard_index = (u32) ((std::hash<std::string_view>()(string) >> 8) % STRING_POOL_SHARD_COUNT);
+	StringPoolShard& shard = string_pool_shards()[shard_index];
+	
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	
+	StringPoolEntry* entry;
+	auto iterator = shard.entries.find(string);
+	if(iterator != shard.entries.end()) {
+		entry = iterator->second.get();
+	} else {
+		std::unique_ptr<StringPoolEntry> new_entry = std::make_unique<StringPoolEntry>();
+		new_entry->string = string;
+		new_entry->shard = shard_index;
+		entry = new_entry.get();
+		shard.entries.emplace(entry->string, std::move(new_entry));
+		shard.byte_count += string.size();
+	}
+	
+	// This happens while the lock is held so that the entry can't be freed
+	// by another thread at the same time.
+	entry->reference_count.fetch_add(1, std::memory_order_relaxed);
+	
+	return entry;
+}
+
+static void acquire(StringPoolEntry* entry)
+{
+	if(entry == &EMPTY_ENTRY) {
+		return;
+	}
+	
+	entry->reference_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void release(StringPoolEntry* entry)
+{
+	if(entry == &EMPTY_ENTRY) {
+		return;
+	}
+	
+	// Only take the lock if this may be the last reference. Since intern is
+	// the only thing that can create a new reference to an entry without
+	// already having one, and it holds the lock while doing so, the entry
+	// can't be revived while it's being freed.
+	u32 count = entry->reference_count.load(std::memory_order_relaxed);
+	while(count > 1) {
+		if(entry->reference_count.compare_exchange_weak(count, count - 1, std::memory_order_release, std::memory_order_relaxed)) {
+			return;
+		}
+	}
+	
+	StringPoolShard& shard = string_pool_shards()[entry->shard];
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	
+	if(entry->reference_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		shard.byte_count -= entry->string.size();
+		shard.entries.erase(shard.entries.find(entry->string));
+	}
+}
+
+static StringPoolShard* string_pool_shards()
+{
+	// Intentionally leaked so that interned strings stored in static objects
+	// can still be released during static destruction. The strings themselves
+	// are freed once they're no longer referenced.
+	static StringPoolShard* shards = new StringPoolShard[STRING_POOL_SHARD_COUNT];
+	return shards;
+}
+
+}
@@ -0,0 +1,72 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+
+#include "util.h"
+
+namespace ccc {
+
+// A string in the string pool along with the number of InternedString objects
+// referring to it.
+struct StringPoolEntry {
+	std::string string;
+	std::atomic<u32> reference_count = 0;
+	u32 shard = 0;
+};
+
+// A string stored in the global string pool. Each distinct string is only
+// stored once no matter how many symbols or AST nodes use it, so names and
+// paths that are repeated many times across a symbol table only cost a pointer
+// each. Interned strings are reference counted and are freed when the last
+// InternedString referring to them is destroyed, for example when the symbol
+// database that used them is destroyed. They are safe to create, copy and
+// destroy from multiple threads. Comparing two interned strings for equality
+// is a pointer compare.
+class InternedString {
+public:
+	InternedString();
+	InternedString(const std::string& string);
+	InternedString(std::string_view string);
+	InternedString(const char* string);
+	InternedString(const InternedString& rhs);
+	InternedString(InternedString&& rhs);
+	~InternedString();
+	
+	InternedString& operator=(const InternedString& rhs);
+	InternedString& operator=(InternedString&& rhs);
+	
+	const std::string& str() const { return m_entry->string; }
+	std::string_view view() const { return m_entry->string; }
+	const char* c_str() const { return m_entry->string.c_str(); }
+	const char* data() const { return m_entry->string.data(); }
+	size_t size() const { return m_entry->string.size(); }
+	bool empty() const { return m_entry->string.empty(); }
+	
+	operator const std::string&() const { return m_entry->string; }
+	
+	friend bool operator==(const InternedString& lhs, const InternedString& rhs) { return lhs.m_entry == rhs.m_entry; }
+	friend bool operator==(const InternedString& lhs, const std::string& rhs) { return lhs.m_entry->string == rhs; }
+	friend bool operator==(const InternedString& lhs, std::string_view rhs) { return lhs.m_entry->string == rhs; }
+	friend bool operator==(const InternedString& lhs, const char* rhs) { return lhs.m_entry->string == rhs; }
+	friend auto operator<=>(const InternedString& lhs, const InternedString& rhs) { return lhs.m_entry->string <=> rhs.m_entry->string; }
+	
+	friend std::string operator+(const InternedString& lhs, std::string_view rhs) { return std::string(lhs.view()).append(rhs); }
+	friend std::string operator+(std::string_view lhs, const InternedString& rhs) { return std::string(lhs).append(rhs.view()); }
+	
+protected:
+	StringPoolEntry* m_entry;
+};
+
+struct StringPoolStats {
+	size_t string_count = 0;
+	size_t byte_count = 0;
+};
+
+// Count the strings that are currently interned and the number of bytes taken
+// up by their characters.
+StringPoolStats string_pool_stats();
+
+}
@@ -3,11 +3,19 @@
 
 #include "symbol_database.h"
 
+#include <algorithm>
+
 #include "ast.h"
 #include "importer_flags.h"
+#include "profiler.h"
 
 namespace ccc {
 
+static std::vector<u32> name_trigrams(std::string_view name);
+static bool contains(std::string_view haystack, std::string_view needle, bool case_sensitive);
+template <typename Element>
+static u64 shrink_vector(std::vector<Element>& vector);
+
 template <typename SymbolType>
 SymbolType* SymbolList<SymbolType>::symbol_from_handle(SymbolHandle<SymbolType> handle)
 {
@@ -186,6 +194,32 @@ SymbolHandle<SymbolType> SymbolList<SymbolType>::first_handle_from_name(const st
 	}
 }
 
+template <typename SymbolType>
+std::vector<SymbolHandle<SymbolType>> SymbolList<SymbolType>::handles_from_name_prefix(const std::string& prefix) const
+{
+	std::vector<SymbolHandle<SymbolType>> handles;
+	
+	for(auto iterator = m_name_to_handle.lower_bound(prefix); iterator != m_name_to_handle.end(); iterator++) {
+		if(!iterator->first.starts_with(prefix)) {
+			break;
+		}
+		handles.emplace_back(iterator->second);
+	}
+	
+	return handles;
+}
+
+template <typename SymbolType>
+std::span<const SymbolHandle<SymbolType>> SymbolList<SymbolType>::handles_from_module(ModuleHandle module_handle) const
+{
+	auto iterator = m_module_to_handles.find(module_handle);
+	if(iterator != m_module_to_handles.end()) {
+		return iterator->second;
+	} else {
+		return std::span<const SymbolHandle<SymbolType>>();
+	}
+}
+
 template <typename SymbolType>
 SymbolType* SymbolList<SymbolType>::symbol_overlapping_address(Address address)
 {
@@ -246,18 +280,42 @@ s32 SymbolList<SymbolType>::size() const
 	return (s32) m_symbols.size();
 }
 
+template <typename SymbolType>
+SymbolListContainerSizes SymbolList<SymbolType>::container_sizes() const
+{
+	SymbolListContainerSizes sizes;
+	sizes.symbols = m_symbols.size();
+	sizes.symbol_capacity = m_symbols.capacity();
+	sizes.graveyard_capacity = m_graveyard.capacity();
+	sizes.address_map = m_address_to_handle.size();
+	sizes.name_map = m_name_to_handle.size();
+	sizes.modules = m_module_to_handles.size();
+	for(const auto& [module_handle, handles] : m_module_to_handles) {
+		sizes.module_handle_capacity += handles.capacity();
+	}
+	sizes.changes_capacity = m_changes.capacity();
+	return sizes;
+}
+
 template <typename SymbolType>
 Result<SymbolType*> SymbolList<SymbolType>::create_symbol(
 	std::string name, Address address, SymbolSourceHandle source, const Module* module_symbol)
 {
-	RawSymbolHandle handle;
-	do {
-		handle = m_next_handle;
-		CCC_CHECK(handle != NULL_SYMBOL_HANDLE,
-			"Ran out of handles to use for %s symbols.", SymbolType::NAME);
-	} while(!m_next_handle.compare_exchange_weak(handle, handle + 1));
+	CCC_CHECK(m_handle_block.begin < m_handle_block.end,
+		"Ran out of handles to use for %s symbols.", SymbolType::NAME);
+	RawSymbolHandle handle = m_handle_block.begin++;
+	
+	// If this list has previously allocated handles from a later block, we
+	// have to insert the symbol in the middle to keep the list sorted.
+	SymbolType* symbol_pointer;
+	if(m_symbols.empty() || m_symbols.back().m_handle < handle) {
+		symbol_pointer = &m_symbols.emplace_back();
+	} else {
+		size_t index = binary_search(handle);
+		symbol_pointer = &*m_symbols.emplace(m_symbols.begin() + index);
+	}
 	
-	SymbolType& symbol = m_symbols.emplace_back();
+	SymbolType& symbol = *symbol_pointer;
 	
 	symbol.m_handle = handle;
 	symbol.m_name = std::move(name);
@@ -276,6 +334,13 @@ Result<SymbolType*> SymbolList<SymbolType>::create_symbol(
 	
 	link_address_map(symbol);
 	link_name_map(symbol);
+	link_module_map(symbol);
+	
+	if(m_journal) {
+		record(SymbolOperation::CREATE, handle, 0);
+	}
+	
+	note_change(SymbolOperation::CREATE, handle);
 	
 	return &symbol;
 }
@@ -291,21 +356,9 @@ template <typename SymbolType>
 Result<SymbolType*> SymbolList<SymbolType>::create_symbol(
 	std::string name, SymbolSourceHandle source, const Module* module_symbol, Address address, u32 importer_flags, DemanglerFunctions demangler)
 {
-	static const int DMGL_PARAMS = 1 << 0;
-	static const int DMGL_RET_POSTFIX = 1 << 5;
-	
 	std::string demangled_name;
 	if constexpr(SymbolType::FLAGS & NAME_NEEDS_DEMANGLING) {
-		if((importer_flags & DONT_DEMANGLE_NAMES) == 0 && demangler.cplus_demangle) {
-			int demangler_flags = 0;
-			if(importer_flags & DEMANGLE_PARAMETERS) demangler_flags |= DMGL_PARAMS;
-			if(importer_flags & DEMANGLE_RETURN_TYPE) demangler_flags |= DMGL_RET_POSTFIX;
-			char* demangled_name_ptr = demangler.cplus_demangle(name.c_str(), demangler_flags);
-			if(demangled_name_ptr) {
-				demangled_name = demangled_name_ptr;
-				free(static_cast<void*>(demangled_name_ptr));
-			}
-		}
+		demangled_name = demangle_symbol_name(name, importer_flags, demangler);
 	}
 	
 	std::string& non_mangled_name = demangled_name.empty() ? name : demangled_name;
@@ -331,9 +384,15 @@ bool SymbolList<SymbolType>::move_symbol(SymbolHandle<SymbolType> handle, Addres
 	}
 	
 	if(symbol->address() != new_address) {
+		if(m_journal) {
+			record(SymbolOperation::MOVE, symbol->m_handle, symbol->m_address.value);
+		}
+		
 		unlink_address_map(*symbol);
 		symbol->m_address = new_address;
 		link_address_map(*symbol);
+		
+		note_change(SymbolOperation::MOVE, symbol->m_handle);
 	}
 	
 	return true;
@@ -349,18 +408,63 @@ bool SymbolList<SymbolType>::rename_symbol(SymbolHandle<SymbolType> handle, std:
 	
 	if(symbol->name() != new_name) {
 		unlink_name_map(*symbol);
+		
+		if(m_journal) {
+			record(SymbolOperation::RENAME, symbol->m_handle, (u32) m_journal->old_names.size());
+			m_journal->old_names.emplace_back(std::move(symbol->m_name));
+		}
+		
 		symbol->m_name = std::move(new_name);
 		link_name_map(*symbol);
+		
+		note_change(SymbolOperation::RENAME, symbol->m_handle);
+	}
+	
+	return true;
+}
+
+template <typename SymbolType>
+bool SymbolList<SymbolType>::retype_symbol(SymbolHandle<SymbolType> handle, std::unique_ptr<ast::Node> new_type)
+{
+	SymbolType* symbol = symbol_from_handle(handle);
+	if(!symbol) {
+		return false;
+	}
+	
+	if(m_journal) {
+		record(SymbolOperation::RETYPE, symbol->m_handle, (u32) m_journal->old_types.size());
+		m_journal->old_types.emplace_back(std::move(symbol->m_type));
 	}
 	
+	symbol->set_type(std::move(new_type));
+	
+	note_change(SymbolOperation::RETYPE, symbol->m_handle);
+	
 	return true;
 }
 
+template <typename SymbolType>
+Result<SymbolHandleBlock> SymbolList<SymbolType>::reserve_handles(u32 count)
+{
+	CCC_CHECK(count <= m_handle_block.end - m_handle_block.begin,
+		"Ran out of handles to reserve for %s symbols.", SymbolType::NAME);
+	
+	SymbolHandleBlock block;
+	block.begin = m_handle_block.begin;
+	block.end = m_handle_block.begin + count;
+	m_handle_block.begin = block.end;
+	
+	return block;
+}
+
 template <typename SymbolType>
 void SymbolList<SymbolType>::merge_from(SymbolList<SymbolType>& list)
 {
 	m_address_to_handle.clear();
 	m_name_to_handle.clear();
+	m_module_to_handles.clear();
+	
+	m_first_marked_handle = std::min(m_first_marked_handle, list.m_first_marked_handle);
 	
 	std::vector<SymbolType> lhs = std::move(m_symbols);
 	std::vector<SymbolType> rhs = std::move(list.m_symbols);
@@ -372,16 +476,22 @@ void SymbolList<SymbolType>::merge_from(SymbolList<SymbolType>& list)
 	size_t rhs_pos = 0;
 	for(;;) {
 		SymbolType* symbol;
+		CCC_ASSERT(lhs_pos >= lhs.size() || rhs_pos >= rhs.size() || lhs[lhs_pos].handle() != rhs[rhs_pos].handle());
 		if(lhs_pos < lhs.size() && (rhs_pos >= rhs.size() || lhs[lhs_pos].handle() < rhs[rhs_pos].handle())) {
 			symbol = &m_symbols.emplace_back(std::move(lhs[lhs_pos++]));
 		} else if(rhs_pos < rhs.size()) {
 			symbol = &m_symbols.emplace_back(std::move(rhs[rhs_pos++]));
+			if(m_journal) {
+				record(SymbolOperation::CREATE, symbol->m_handle, 0);
+			}
+			note_change(SymbolOperation::CREATE, symbol->m_handle);
 		} else {
 			break;
 		}
 		
 		link_address_map(*symbol);
 		link_name_map(*symbol);
+		link_module_map(*symbol);
 	}
 	
 	CCC_ASSERT(m_symbols.size() == lhs.size() + rhs.size());
@@ -389,6 +499,64 @@ void SymbolList<SymbolType>::merge_from(SymbolList<SymbolType>& list)
 	list.m_symbols.clear();
 	list.m_address_to_handle.clear();
 	list.m_name_to_handle.clear();
+	list.m_module_to_handles.clear();
+	list.m_first_marked_handle = NULL_SYMBOL_HANDLE;
+}
+
+template <typename SymbolType>
+bool SymbolList<SymbolType>::handles_collide(const SymbolList<SymbolType>& list) const
+{
+	for(const SymbolType& symbol : list.m_symbols) {
+		if(symbol.m_handle >= m_handle_block.begin && symbol.m_handle < m_handle_block.end) {
+			return true;
+		}
+		
+		if(symbol_from_handle(symbol.m_handle)) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::remap_handles(const SymbolHandleRemap& remap)
+{
+	m_address_to_handle.clear();
+	m_name_to_handle.clear();
+	m_module_to_handles.clear();
+	
+	// The remap must preserve the order of the handles of the symbols in this
+	// list, so that it stays sorted.
+	for(SymbolType& symbol : m_symbols) {
+		symbol.m_handle = remap.remap(SymbolType::DESCRIPTOR, symbol.m_handle);
+		remap.remap(symbol.m_source);
+		remap.remap(symbol.m_module);
+		symbol.on_remap(remap);
+		
+		if(symbol.m_type) {
+			ast::for_each_node(*symbol.m_type, ast::PREORDER_TRAVERSAL, [&](ast::Node& node) {
+				if(node.descriptor == ast::TYPE_NAME) {
+					ast::TypeName& type_name = node.as<ast::TypeName>();
+					remap.remap(type_name.data_type_handle);
+					if(type_name.unresolved_stabs) {
+						remap.remap(type_name.unresolved_stabs->referenced_file_handle);
+					}
+				} else if(node.descriptor == ast::FUNCTION) {
+					remap.remap(node.as<ast::Function>().definition_handle);
+				}
+				return ast::EXPLORE_CHILDREN;
+			});
+		}
+		
+		link_address_map(symbol);
+		link_name_map(symbol);
+		link_module_map(symbol);
+	}
+	
+	if(m_first_marked_handle != NULL_SYMBOL_HANDLE) {
+		m_first_marked_handle = remap.remap(SymbolType::DESCRIPTOR, m_first_marked_handle);
+	}
 }
 
 template <typename SymbolType>
@@ -399,7 +567,7 @@ bool SymbolList<SymbolType>::mark_symbol_for_destruction(SymbolHandle<SymbolType
 		return false;
 	}
 	
-	symbol->mark_for_destruction();
+	mark_symbol(*symbol);
 	
 	symbol->on_destroy(database);
 	
@@ -414,7 +582,7 @@ void SymbolList<SymbolType>::mark_symbols_from_source_for_destruction(SymbolSour
 			continue;
 		}
 		
-		symbol.mark_for_destruction();
+		mark_symbol(symbol);
 		
 		symbol.on_destroy(database);
 	}
@@ -423,39 +591,93 @@ void SymbolList<SymbolType>::mark_symbols_from_source_for_destruction(SymbolSour
 template <typename SymbolType>
 void SymbolList<SymbolType>::mark_symbols_from_module_for_destruction(ModuleHandle module_handle, SymbolDatabase* database)
 {
-	for(SymbolType& symbol : m_symbols) {
-		if(symbol.module_handle() != module_handle) {
-			continue;
-		}
+	// Only visit the symbols that belong to the module instead of scanning the
+	// whole list.
+	for(SymbolHandle<SymbolType> handle : handles_from_module(module_handle)) {
+		SymbolType* symbol = symbol_from_handle(handle);
+		CCC_ASSERT(symbol);
 		
-		symbol.mark_for_destruction();
+		mark_symbol(*symbol);
 		
-		symbol.on_destroy(database);
+		symbol->on_destroy(database);
 	}
 }
 
 template <typename SymbolType>
 void SymbolList<SymbolType>::destroy_marked_symbols()
 {
-	std::vector<SymbolType> remaining_symbols;
-	for(SymbolType& symbol : m_symbols) {
+	if(m_first_marked_handle == NULL_SYMBOL_HANDLE) {
+		return;
+	}
+	
+	// Compact the list in place. Everything before the first marked symbol
+	// can stay where it is.
+	size_t first = binary_search(m_first_marked_handle);
+	size_t remaining = first;
+	std::vector<ModuleHandle> affected_modules;
+	for(size_t i = first; i < m_symbols.size(); i++) {
+		SymbolType& symbol = m_symbols[i];
 		if(symbol.m_marked_for_destruction) {
 			unlink_address_map(symbol);
 			unlink_name_map(symbol);
+			
+			if(symbol.m_module.valid() && (affected_modules.empty() || affected_modules.back() != symbol.m_module)) {
+				affected_modules.emplace_back(symbol.m_module);
+			}
+			
+			note_change(SymbolOperation::DESTROY, symbol.m_handle);
+			
+			if(m_journal) {
+				record(SymbolOperation::DESTROY, symbol.m_handle, (u32) m_graveyard.size());
+				m_graveyard.emplace_back(std::move(symbol));
+			}
 		} else {
-			remaining_symbols.emplace_back(std::move(symbol));
+			if(remaining != i) {
+				m_symbols[remaining] = std::move(symbol);
+			}
+			remaining++;
 		}
 	}
 	
-	m_symbols = std::move(remaining_symbols);
+	m_symbols.erase(m_symbols.begin() + remaining, m_symbols.end());
+	m_first_marked_handle = NULL_SYMBOL_HANDLE;
+	
+	// Remove the destroyed symbols from the module map in one go per module,
+	// rather than erasing them from the middle of the vectors one at a time.
+	std::sort(affected_modules.begin(), affected_modules.end());
+	affected_modules.erase(std::unique(affected_modules.begin(), affected_modules.end()), affected_modules.end());
+	for(ModuleHandle module_handle : affected_modules) {
+		auto iterator = m_module_to_handles.find(module_handle);
+		if(iterator == m_module_to_handles.end()) {
+			continue;
+		}
+		
+		std::vector<SymbolHandle<SymbolType>>& handles = iterator->second;
+		std::erase_if(handles, [&](SymbolHandle<SymbolType> handle) { return !symbol_from_handle(handle); });
+		if(handles.empty()) {
+			m_module_to_handles.erase(iterator);
+		}
+	}
 }
 
 template <typename SymbolType>
 void SymbolList<SymbolType>::clear()
 {
+	if(m_journal || m_has_observers || m_name_index) {
+		// Keep the symbols around so the transaction can be rolled back, and
+		// make sure the observers and the name index are told about them.
+		for(SymbolType& symbol : m_symbols) {
+			mark_symbol(symbol);
+		}
+		destroy_marked_symbols();
+		return;
+	}
+	
 	m_symbols.clear();
 	m_address_to_handle.clear();
 	m_name_to_handle.clear();
+	m_module_to_handles.clear();
+	m_first_marked_handle = NULL_SYMBOL_HANDLE;
 }
 
 template <typename SymbolType>
@@ -508,7 +730,10 @@ template <typename SymbolType>
 void SymbolList<SymbolType>::link_name_map(SymbolType& symbol)
 {
 	if constexpr(SymbolType::FLAGS & WITH_NAME_MAP) {
-		m_name_to_handle.emplace(symbol.name(), symbol.handle());
+		m_name_to_handle.emplace(symbol.m_name.view(), symbol.handle());
+		if(m_name_index) {
+			m_name_index->insert(MultiSymbolHandle(SymbolType::DESCRIPTOR, symbol.m_handle), symbol.name());
+		}
 	}
 }
 
@@ -523,11 +748,260 @@ void SymbolList<SymbolType>::unlink_name_map(SymbolType& symbol)
 				break;
 			}
 		}
+		if(m_name_index) {
+			m_name_index->remove(MultiSymbolHandle(SymbolType::DESCRIPTOR, symbol.m_handle));
+		}
+	}
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::link_module_map(SymbolType& symbol)
+{
+	if(symbol.m_module.valid()) {
+		std::vector<SymbolHandle<SymbolType>>& handles = m_module_to_handles[symbol.m_module];
+		if(handles.empty() || handles.back() < symbol.handle()) {
+			handles.emplace_back(symbol.handle());
+		} else {
+			handles.emplace(std::lower_bound(handles.begin(), handles.end(), symbol.handle()), symbol.handle());
+		}
+	}
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::unlink_module_map(SymbolType& symbol)
+{
+	if(symbol.m_module.valid()) {
+		auto iterator = m_module_to_handles.find(symbol.m_module);
+		if(iterator != m_module_to_handles.end()) {
+			std::vector<SymbolHandle<SymbolType>>& handles = iterator->second;
+			auto handle = std::lower_bound(handles.begin(), handles.end(), symbol.handle());
+			if(handle != handles.end() && *handle == symbol.handle()) {
+				handles.erase(handle);
+			}
+			if(handles.empty()) {
+				m_module_to_handles.erase(iterator);
+			}
+		}
+	}
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::mark_symbol(SymbolType& symbol)
+{
+	symbol.m_marked_for_destruction = true;
+	m_first_marked_handle = std::min(m_first_marked_handle, symbol.m_handle);
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::record(SymbolOperation operation, RawSymbolHandle handle, u32 payload)
+{
+	UndoEntry& entry = m_journal->entries.emplace_back();
+	entry.operation = operation;
+	entry.descriptor = (u16) SymbolType::DESCRIPTOR;
+	entry.handle = handle;
+	entry.payload = payload;
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::note_change(SymbolOperation operation, RawSymbolHandle handle)
+{
+	if(m_has_observers) {
+		SymbolChange& change = m_changes.emplace_back();
+		change.operation = operation;
+		change.handle = handle;
+	}
+}
+
+template <typename SymbolType>
+bool SymbolList<SymbolType>::take_changes(SymbolListChanges& output)
+{
+	if(m_changes.empty()) {
+		return false;
+	}
+	
+	enum {
+		CREATED = 1 << 0,
+		DESTROYED = 1 << 1,
+		MOVED = 1 << 2,
+		RENAMED = 1 << 3,
+		RETYPED = 1 << 4
+	};
+	
+	// Group the changes by handle while keeping them in the order they were
+	// made, and then work out the net effect for each symbol.
+	std::stable_sort(m_changes.begin(), m_changes.end(),
+		[](const SymbolChange& lhs, const SymbolChange& rhs) { return lhs.handle < rhs.handle; });
+	
+	bool any = false;
+	for(size_t i = 0; i < m_changes.size();) {
+		RawSymbolHandle handle = m_changes[i].handle;
+		u32 state = 0;
+		for(; i < m_changes.size() && m_changes[i].handle == handle; i++) {
+			switch(m_changes[i].operation) {
+				case SymbolOperation::CREATE: {
+					// If the symbol was destroyed earlier in this batch, it was
+					// restored by a rollback, so it existed all along.
+					if(state & DESTROYED) {
+						state &= ~DESTROYED;
+					} else {
+						state |= CREATED;
+					}
+					break;
+				}
+				case SymbolOperation::DESTROY: {
+					state = (state & CREATED) ? 0 : DESTROYED;
+					break;
+				}
+				case SymbolOperation::MOVE: {
+					if(!(state & CREATED)) {
+						state |= MOVED;
+					}
+					break;
+				}
+				case SymbolOperation::RENAME: {
+					if(!(state & CREATED)) {
+						state |= RENAMED;
+					}
+					break;
+				}
+				case SymbolOperation::RETYPE: {
+					if(!(state & CREATED)) {
+						state |= RETYPED;
+					}
+					break;
+				}
+				case SymbolOperation::APPEND_FILE: {
+					break;
+				}
+			}
+		}
+		
+		if(state & CREATED) {
+			output.created.emplace_back(handle);
+		}
+		if(state & DESTROYED) {
+			output.destroyed.emplace_back(handle);
+		}
+		if(state & MOVED) {
+			output.moved.emplace_back(handle);
+		}
+		if(state & RENAMED) {
+			output.renamed.emplace_back(handle);
+		}
+		if(state & RETYPED) {
+			output.retyped.emplace_back(handle);
+		}
+		
+		any |= state != 0;
+	}
+	
+	m_changes.clear();
+	
+	return any;
+}
+
+template <typename SymbolType>
+void SymbolList<SymbolType>::undo(const UndoEntry& entry, UndoJournal& journal)
+{
+	switch(entry.operation) {
+		case SymbolOperation::CREATE: {
+			// Symbols are usually created at the end of the list, and the
+			// journal is undone in reverse order, so this is normally cheap.
+			s32 index = index_from_handle(entry.handle);
+			CCC_ASSERT(index > -1);
+			unlink_address_map(m_symbols[index]);
+			unlink_name_map(m_symbols[index]);
+			unlink_module_map(m_symbols[index]);
+			m_symbols.erase(m_symbols.begin() + index);
+			note_change(SymbolOperation::DESTROY, entry.handle);
+			break;
+		}
+		case SymbolOperation::DESTROY: {
+			CCC_ASSERT(entry.payload + 1 == m_graveyard.size());
+			size_t index = binary_search(entry.handle);
+			SymbolType& symbol = *m_symbols.emplace(m_symbols.begin() + index, std::move(m_graveyard.back()));
+			m_graveyard.pop_back();
+			symbol.m_marked_for_destruction = false;
+			link_address_map(symbol);
+			link_name_map(symbol);
+			link_module_map(symbol);
+			note_change(SymbolOperation::CREATE, entry.handle);
+			break;
+		}
+		case SymbolOperation::MOVE: {
+			SymbolType* symbol = symbol_from_handle(entry.handle);
+			CCC_ASSERT(symbol);
+			unlink_address_map(*symbol);
+			symbol->m_address = entry.payload;
+			link_address_map(*symbol);
+			note_change(SymbolOperation::MOVE, entry.handle);
+			break;
+		}
+		case SymbolOperation::RENAME: {
+			SymbolType* symbol = symbol_from_handle(entry.handle);
+			CCC_ASSERT(symbol && entry.payload + 1 == journal.old_names.size());
+			unlink_name_map(*symbol);
+			symbol->m_name = std::move(journal.old_names.back());
+			journal.old_names.pop_back();
+			link_name_map(*symbol);
+			note_change(SymbolOperation::RENAME, entry.handle);
+			break;
+		}
+		case SymbolOperation::RETYPE: {
+			SymbolType* symbol = symbol_from_handle(entry.handle);
+			CCC_ASSERT(symbol && entry.payload + 1 == journal.old_types.size());
+			symbol->set_type(std::move(journal.old_types.back()));
+			journal.old_types.pop_back();
+			note_change(SymbolOperation::RETYPE, entry.handle);
+			break;
+		}
+		case SymbolOperation::APPEND_FILE: {
+			if constexpr(std::is_same_v<SymbolType, DataType>) {
+				SymbolType* symbol = symbol_from_handle(entry.handle);
+				CCC_ASSERT(symbol && !symbol->files.empty());
+				symbol->files.pop_back();
+			}
+			break;
+		}
 	}
 }
 
 template <typename SymbolType>
-std::atomic<RawSymbolHandle> SymbolList<SymbolType>::m_next_handle = 0;
+void SymbolList<SymbolType>::compact(u32 flags, CompactionStats& stats)
+{
+	for(SymbolType& symbol : m_symbols) {
+		stats.bytes_reclaimed += symbol.on_compact(flags);
+		
+		if(!symbol.m_type) {
+			continue;
+		}
+		
+		if(flags & DROP_STABS_TYPE_NUMBERS) {
+			ast::for_each_node(*symbol.m_type, ast::PREORDER_TRAVERSAL, [&](ast::Node& node) {
+				if(node.descriptor == ast::TYPE_NAME) {
+					ast::TypeName& type_name = node.as<ast::TypeName>();
+					if(type_name.unresolved_stabs && type_name.data_type_handle.valid()) {
+						stats.bytes_reclaimed += sizeof(ast::TypeName::UnresolvedStabs) + type_name.unresolved_stabs->type_name.capacity();
+						type_name.unresolved_stabs.reset();
+					}
+				}
+				return ast::EXPLORE_CHILDREN;
+			});
+		}
+		
+		if(flags & RELOCATE_NODES) {
+			stats.nodes_relocated += ast::relocate_nodes(symbol.m_type);
+			symbol.invalidate_node_handles();
+		}
+	}
+	
+	stats.bytes_reclaimed += shrink_vector(m_symbols);
+	for(auto& [module_handle, handles] : m_module_to_handles) {
+		stats.bytes_reclaimed += shrink_vector(handles);
+	}
+	stats.bytes_reclaimed += shrink_vector(m_graveyard);
+	stats.bytes_reclaimed += shrink_vector(m_changes);
+}
 
 #define CCC_X(SymbolType, symbol_list) template class SymbolList<SymbolType>;
 CCC_FOR_EACH_SYMBOL_TYPE_DO_X
@@ -535,6 +1009,54 @@ CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 
 // *****************************************************************************
 
+UndoJournal::~UndoJournal() {}
+
+// *****************************************************************************
+
+void SymbolHandleRemap::add(SymbolDescriptor descriptor, std::vector<RawSymbolHandle> old_handles, RawSymbolHandle new_begin)
+{
+	CCC_ASSERT(std::is_sorted(old_handles.begin(), old_handles.end()));
+	
+	Table& table = m_tables[descriptor];
+	CCC_ASSERT(table.old_handles.empty());
+	
+	table.new_handles.resize(old_handles.size());
+	for(size_t i = 0; i < old_handles.size(); i++) {
+		table.new_handles[i] = new_begin + (RawSymbolHandle) i;
+	}
+	table.old_handles = std::move(old_handles);
+}
+
+void SymbolHandleRemap::add(SymbolDescriptor descriptor, RawSymbolHandle old_handle, RawSymbolHandle new_handle)
+{
+	Table& table = m_tables[descriptor];
+	
+	auto iterator = std::lower_bound(table.old_handles.begin(), table.old_handles.end(), old_handle);
+	size_t index = iterator - table.old_handles.begin();
+	CCC_ASSERT(iterator == table.old_handles.end() || *iterator != old_handle);
+	
+	table.old_handles.insert(iterator, old_handle);
+	table.new_handles.insert(table.new_handles.begin() + index, new_handle);
+}
+
+RawSymbolHandle SymbolHandleRemap::remap(SymbolDescriptor descriptor, RawSymbolHandle handle) const
+{
+	auto table = m_tables.find(descriptor);
+	if(table == m_tables.end()) {
+		return handle;
+	}
+	
+	const std::vector<RawSymbolHandle>& old_handles = table->second.old_handles;
+	auto iterator = std::lower_bound(old_handles.begin(), old_handles.end(), handle);
+	if(iterator == old_handles.end() || *iterator != handle) {
+		return handle;
+	}
+	
+	return table->second.new_handles[iterator - old_handles.begin()];
+}
+
+// *****************************************************************************
+
 void Symbol::set_type(std::unique_ptr<ast::Node> type)
 {
 	m_type = std::move(type);
@@ -562,6 +1084,26 @@ const char* global_storage_location_to_string(GlobalStorageLocation location)
 
 // *****************************************************************************
 
+u64 DataType::on_compact(u32 flags)
+{
+	if(flags & DROP_DATA_TYPE_FILES) {
+		u64 bytes = files.capacity() * sizeof(SourceFileHandle);
+		files = std::vector<SourceFileHandle>();
+		return bytes;
+	}
+	
+	return shrink_vector(files);
+}
+
+void DataType::on_remap(const SymbolHandleRemap& remap)
+{
+	for(SourceFileHandle& file : files) {
+		remap.remap(file);
+	}
+}
+
+// *****************************************************************************
+
 const std::optional<std::vector<ParameterVariableHandle>>& Function::parameter_variables() const
 {
 	return m_parameter_variables;
@@ -590,7 +1132,7 @@ void Function::set_parameter_variables(
 		}
 	}
 }
-	
+
 const std::optional<std::vector<LocalVariableHandle>>& Function::local_variables() const
 {
 	return m_local_variables;
@@ -673,22 +1215,63 @@ void Function::on_destroy(SymbolDatabase* database)
 	}
 }
 
-// *****************************************************************************
-
-const std::string& GlobalVariable::mangled_name() const
+u64 Function::on_compact(u32 flags)
 {
-	if(!m_mangled_name.empty()) {
-		return m_mangled_name;
-	} else {
-		return name();
+	u64 bytes = 0;
+	bytes += shrink_vector(line_numbers);
+	bytes += shrink_vector(sub_source_files);
+	if(m_parameter_variables.has_value()) {
+		bytes += shrink_vector(*m_parameter_variables);
+	}
+	if(m_local_variables.has_value()) {
+		bytes += shrink_vector(*m_local_variables);
 	}
+	return bytes;
 }
 
-void GlobalVariable::set_mangled_name(std::string mangled)
+void Function::on_remap(const SymbolHandleRemap& remap)
 {
-	m_mangled_name = std::move(mangled);
-}
-
+	remap.remap(m_source_file);
+	if(m_parameter_variables.has_value()) {
+		for(ParameterVariableHandle& parameter_variable : *m_parameter_variables) {
+			remap.remap(parameter_variable);
+		}
+	}
+	if(m_local_variables.has_value()) {
+		for(LocalVariableHandle& local_variable : *m_local_variables) {
+			remap.remap(local_variable);
+		}
+	}
+}
+
+// *****************************************************************************
+
+const std::string& GlobalVariable::mangled_name() const
+{
+	if(!m_mangled_name.empty()) {
+		return m_mangled_name;
+	} else {
+		return name();
+	}
+}
+
+void GlobalVariable::set_mangled_name(std::string mangled)
+{
+	m_mangled_name = std::move(mangled);
+}
+
+void GlobalVariable::on_remap(const SymbolHandleRemap& remap)
+{
+	remap.remap(m_source_file);
+}
+
+// *****************************************************************************
+
+void LocalVariable::on_remap(const SymbolHandleRemap& remap)
+{
+	remap.remap(m_function);
+}
+
 // *****************************************************************************
 
 void Module::on_create()
@@ -698,6 +1281,13 @@ void Module::on_create()
 
 // *****************************************************************************
 
+void ParameterVariable::on_remap(const SymbolHandleRemap& remap)
+{
+	remap.remap(m_function);
+}
+
+// *****************************************************************************
+
 bool Section::contains_code() const
 {
 	return name() == ".text";
@@ -807,6 +1397,35 @@ void SourceFile::on_destroy(SymbolDatabase* database)
 	}
 }
 
+u64 SourceFile::on_compact(u32 flags)
+{
+	u64 bytes = 0;
+	bytes += shrink_vector(m_functions);
+	bytes += shrink_vector(m_global_variables);
+	
+	if(flags & DROP_STABS_TYPE_NUMBERS) {
+		// Estimate the size of each red-black tree node.
+		using Element = std::pair<const StabsTypeNumber, DataTypeHandle>;
+		bytes += stabs_type_number_to_handle.size() * (sizeof(Element) + 4 * sizeof(void*));
+		stabs_type_number_to_handle.clear();
+	}
+	
+	return bytes;
+}
+
+void SourceFile::on_remap(const SymbolHandleRemap& remap)
+{
+	for(FunctionHandle& function : m_functions) {
+		remap.remap(function);
+	}
+	for(GlobalVariableHandle& global_variable : m_global_variables) {
+		remap.remap(global_variable);
+	}
+	for(auto& [type_number, data_type] : stabs_type_number_to_handle) {
+		remap.remap(data_type);
+	}
+}
+
 // *****************************************************************************
 
 void SymbolSource::on_create()
@@ -934,6 +1553,8 @@ Result<DataType*> SymbolDatabase::create_data_type_if_unique(
 	SourceFile& source_file,
 	const SymbolGroup& group)
 {
+	ProfileScope profile(ProfilePhase::CREATE_DATA_TYPE);
+	
 	auto types_with_same_name = data_types.handles_from_name(name);
 	const char* compare_fail_reason = nullptr;
 	if(types_with_same_name.begin() == types_with_same_name.end()) {
@@ -976,16 +1597,17 @@ Result<DataType*> SymbolDatabase::create_data_type_if_unique(
 				}
 			} else {
 				// The new node matches this existing node.
-				existing_type->files.emplace_back(source_file.handle());
+				append_data_type_file(*existing_type, source_file.handle());
 				if(number.type > -1) {
 					source_file.stabs_type_number_to_handle[number] = existing_type->handle();
 				}
 				if(compare_result.type == ast::CompareResultType::MATCHES_FAVOUR_RHS) {
 					// The new node almost matches the old one, but the new one
 					// is slightly better, so we replace the old type.
-					existing_type->set_type(std::move(node));
+					data_types.retype_symbol(existing_type->handle(), std::move(node));
 				}
 				match = true;
+				profile_count(ProfileCounter::DEDUPLICATED_DATA_TYPES);
 				break;
 			}
 		}
@@ -1011,11 +1633,91 @@ Result<DataType*> SymbolDatabase::create_data_type_if_unique(
 	return nullptr;
 }
 
-void SymbolDatabase::merge_from(SymbolDatabase& database)
+void SymbolDatabase::append_data_type_file(DataType& data_type, SourceFileHandle file)
+{
+	if(data_types.m_journal) {
+		data_types.record(SymbolOperation::APPEND_FILE, data_type.raw_handle(), 0);
+	}
+	
+	data_type.files.emplace_back(file);
+}
+
+Result<SymbolDatabaseHandleBlocks> SymbolDatabase::reserve_handles(u32 count)
+{
+	SymbolDatabaseHandleBlocks blocks;
+	#define CCC_X(SymbolType, symbol_list) \
+		{ \
+			Result<SymbolHandleBlock> block = symbol_list.reserve_handles(count); \
+			CCC_RETURN_IF_ERROR(block); \
+			blocks.symbol_list = *block; \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	return blocks;
+}
+
+SymbolDatabaseHandleBlocks SymbolDatabase::handle_blocks() const
+{
+	SymbolDatabaseHandleBlocks blocks;
+	#define CCC_X(SymbolType, symbol_list) blocks.symbol_list = symbol_list.handle_block();
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	return blocks;
+}
+
+void SymbolDatabase::set_handle_blocks(const SymbolDatabaseHandleBlocks& blocks)
+{
+	#define CCC_X(SymbolType, symbol_list) symbol_list.set_handle_block(blocks.symbol_list);
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+}
+
+Result<void> SymbolDatabase::merge_from(SymbolDatabase& database)
 {
+	// Allocate new handles for the symbols in any list where they would
+	// collide with the handles used by this database.
+	SymbolHandleRemap remap;
+	#define CCC_X(SymbolType, symbol_list) \
+		if(symbol_list.handles_collide(database.symbol_list)) { \
+			Result<SymbolHandleBlock> block = symbol_list.reserve_handles((u32) database.symbol_list.size()); \
+			CCC_RETURN_IF_ERROR(block); \
+			std::vector<RawSymbolHandle> old_handles; \
+			for(const SymbolType& symbol : database.symbol_list) { \
+				old_handles.emplace_back(symbol.raw_handle()); \
+			} \
+			remap.add(SymbolType::DESCRIPTOR, std::move(old_handles), block->begin); \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	if(!remap.empty()) {
+		database.remap_handles(remap);
+	}
+	
 	#define CCC_X(SymbolType, symbol_list) symbol_list.merge_from(database.symbol_list);
 	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 	#undef CCC_X
+	
+	// The symbol lists of the other database are cleared without unlinking
+	// each symbol individually.
+	if(database.m_name_index) {
+		database.m_name_index->clear();
+	}
+	
+	return Result<void>();
+}
+
+void SymbolDatabase::remap_handles(const SymbolHandleRemap& remap)
+{
+	#define CCC_X(SymbolType, symbol_list) symbol_list.remap_handles(remap);
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	// The name index is keyed on the handles, so rebuild it.
+	if(m_name_index) {
+		disable_name_index();
+		enable_name_index();
+	}
 }
 
 void SymbolDatabase::destroy_symbols_from_source(SymbolSourceHandle source, bool destroy_descendants)
@@ -1054,6 +1756,203 @@ void SymbolDatabase::clear()
 	#undef CCC_X
 }
 
+CompactionStats SymbolDatabase::compact(u32 flags)
+{
+	CompactionStats stats;
+	
+	#define CCC_X(SymbolType, symbol_list) symbol_list.compact(flags, stats);
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	stats.bytes_reclaimed += shrink_vector(m_observers);
+	
+	return stats;
+}
+
+void SymbolDatabase::begin_transaction()
+{
+	if(!m_journal) {
+		m_journal = std::make_unique<UndoJournal>();
+		
+		#define CCC_X(SymbolType, symbol_list) symbol_list.m_journal = m_journal.get();
+		CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+		#undef CCC_X
+	}
+	
+	m_journal->transactions.emplace_back(m_journal->entries.size());
+}
+
+void SymbolDatabase::commit_transaction()
+{
+	CCC_ASSERT(in_transaction());
+	
+	m_journal->transactions.pop_back();
+	if(m_journal->transactions.empty()) {
+		end_transactions();
+		flush_changes();
+	}
+}
+
+void SymbolDatabase::rollback_transaction()
+{
+	CCC_ASSERT(in_transaction());
+	
+	undo_until(m_journal->transactions.back());
+	
+	m_journal->transactions.pop_back();
+	if(m_journal->transactions.empty()) {
+		end_transactions();
+		flush_changes();
+	}
+}
+
+bool SymbolDatabase::in_transaction() const
+{
+	return m_journal != nullptr;
+}
+
+UndoSavepoint SymbolDatabase::savepoint() const
+{
+	CCC_ASSERT(in_transaction());
+	
+	UndoSavepoint savepoint;
+	savepoint.position = m_journal->entries.size();
+	return savepoint;
+}
+
+void SymbolDatabase::rollback_to_savepoint(UndoSavepoint savepoint)
+{
+	CCC_ASSERT(in_transaction());
+	CCC_ASSERT(savepoint.position >= m_journal->transactions.back());
+	CCC_ASSERT(savepoint.position <= m_journal->entries.size());
+	
+	undo_until(savepoint.position);
+}
+
+std::vector<MultiSymbolHandle> SymbolDatabase::symbols_changed_since(UndoSavepoint savepoint) const
+{
+	CCC_ASSERT(in_transaction());
+	CCC_ASSERT(savepoint.position <= m_journal->entries.size());
+	
+	std::vector<MultiSymbolHandle> symbols;
+	for(size_t i = savepoint.position; i < m_journal->entries.size(); i++) {
+		const UndoEntry& entry = m_journal->entries[i];
+		if(entry.operation != SymbolOperation::DESTROY) {
+			symbols.emplace_back((SymbolDescriptor) entry.descriptor, entry.handle);
+		}
+	}
+	
+	std::sort(symbols.begin(), symbols.end());
+	symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+	
+	return symbols;
+}
+
+void SymbolDatabase::add_observer(SymbolDatabaseObserver* observer)
+{
+	m_observers.emplace_back(observer);
+	
+	#define CCC_X(SymbolType, symbol_list) symbol_list.m_has_observers = true;
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+}
+
+void SymbolDatabase::remove_observer(SymbolDatabaseObserver* observer)
+{
+	std::erase(m_observers, observer);
+	
+	if(m_observers.empty()) {
+		#define CCC_X(SymbolType, symbol_list) \
+			symbol_list.m_has_observers = false; \
+			symbol_list.m_changes.clear();
+		CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+		#undef CCC_X
+	}
+}
+
+void SymbolDatabase::flush_changes()
+{
+	if(m_observers.empty()) {
+		return;
+	}
+	
+	SymbolDatabaseChanges changes;
+	#define CCC_X(SymbolType, symbol_list) \
+		{ \
+			SymbolListChanges list_changes; \
+			list_changes.descriptor = SymbolType::DESCRIPTOR; \
+			if(symbol_list.take_changes(list_changes)) { \
+				changes.lists.emplace_back(std::move(list_changes)); \
+			} \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	if(changes.lists.empty()) {
+		return;
+	}
+	
+	for(SymbolDatabaseObserver* observer : m_observers) {
+		observer->on_symbols_changed(changes);
+	}
+}
+
+void SymbolDatabase::enable_name_index()
+{
+	if(m_name_index) {
+		return;
+	}
+	
+	m_name_index = std::make_unique<SymbolNameIndex>();
+	
+	#define CCC_X(SymbolType, symbol_list) \
+		if constexpr(SymbolType::FLAGS & WITH_NAME_MAP) { \
+			for(const SymbolType& symbol : symbol_list) { \
+				m_name_index->insert(MultiSymbolHandle(symbol), symbol.name()); \
+			} \
+			symbol_list.m_name_index = m_name_index.get(); \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+}
+
+void SymbolDatabase::disable_name_index()
+{
+	#define CCC_X(SymbolType, symbol_list) symbol_list.m_name_index = nullptr;
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	m_name_index.reset();
+}
+
+void SymbolDatabase::undo_until(size_t position)
+{
+	while(m_journal->entries.size() > position) {
+		UndoEntry entry = m_journal->entries.back();
+		m_journal->entries.pop_back();
+		
+		switch(entry.descriptor) {
+			#define CCC_X(SymbolType, symbol_list) \
+				case SymbolType::DESCRIPTOR: \
+					symbol_list.undo(entry, *m_journal); \
+					break;
+			CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+			#undef CCC_X
+		}
+	}
+}
+
+void SymbolDatabase::end_transactions()
+{
+	#define CCC_X(SymbolType, symbol_list) \
+		symbol_list.m_journal = nullptr; \
+		symbol_list.m_graveyard.clear();
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	m_journal.reset();
+}
+
 // *****************************************************************************
 
 MultiSymbolHandle::MultiSymbolHandle() {}
@@ -1148,6 +2047,21 @@ bool MultiSymbolHandle::rename_symbol(std::string new_name, SymbolDatabase& data
 	return false;
 }
 
+bool MultiSymbolHandle::retype_symbol(std::unique_ptr<ast::Node> new_type, SymbolDatabase& database) const
+{
+	if(m_handle != NULL_SYMBOL_HANDLE) {
+		switch(m_descriptor) {
+			#define CCC_X(SymbolType, symbol_list) \
+				case SymbolType::DESCRIPTOR: \
+					return database.symbol_list.retype_symbol(m_handle, std::move(new_type));
+			CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+			#undef CCC_X
+		}
+	}
+	
+	return false;
+}
+
 bool MultiSymbolHandle::destroy_symbol(SymbolDatabase& database, bool destroy_descendants) const
 {
 	bool success = false;
@@ -1226,4 +2140,354 @@ NodeHandle NodeHandle::handle_for_child(const ast::Node* child_node) const
 CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 #undef CCC_X
 
+// *****************************************************************************
+
+void SymbolNameIndex::insert(MultiSymbolHandle symbol, const std::string& name)
+{
+	u64 key = ((u64) symbol.descriptor() << 32) | symbol.handle();
+	auto iterator = m_symbol_to_entry.find(key);
+	if(iterator != m_symbol_to_entry.end()) {
+		if(m_entries[iterator->second].name == name) {
+			return;
+		}
+		remove(symbol);
+	}
+	
+	u32 entry_index = (u32) m_entries.size();
+	Entry& entry = m_entries.emplace_back();
+	entry.symbol = symbol;
+	entry.name = name;
+	entry.live = true;
+	add_postings(entry_index);
+	
+	m_symbol_to_entry[key] = entry_index;
+	m_live_count++;
+}
+
+void SymbolNameIndex::remove(MultiSymbolHandle symbol)
+{
+	u64 key = ((u64) symbol.descriptor() << 32) | symbol.handle();
+	auto iterator = m_symbol_to_entry.find(key);
+	if(iterator == m_symbol_to_entry.end()) {
+		return;
+	}
+	
+	Entry& entry = m_entries[iterator->second];
+	entry.live = false;
+	entry.name = InternedString();
+	m_symbol_to_entry.erase(iterator);
+	m_live_count--;
+	
+	// Once most of the entries are dead, the posting lists are mostly
+	// garbage, so compact everything.
+	if(m_entries.size() > 1024 && m_live_count < m_entries.size() / 2) {
+		rebuild();
+	}
+}
+
+void SymbolNameIndex::clear()
+{
+	m_entries.clear();
+	m_postings.clear();
+	m_symbol_to_entry.clear();
+	m_live_count = 0;
+}
+
+std::vector<MultiSymbolHandle> SymbolNameIndex::find_substring(
+	std::string_view string, u32 descriptors, bool case_sensitive) const
+{
+	std::vector<MultiSymbolHandle> output;
+	
+	std::vector<u32> trigrams = name_trigrams(string);
+	
+	auto check = [&](const Entry& entry) {
+		if(entry.live && (entry.symbol.descriptor() & descriptors) && contains(entry.name.view(), string, case_sensitive)) {
+			output.emplace_back(entry.symbol);
+		}
+	};
+	
+	if(trigrams.empty()) {
+		// The string is too short to use the index.
+		for(const Entry& entry : m_entries) {
+			check(entry);
+		}
+	} else {
+		// Intersect the posting lists, starting with the shortest.
+		std::vector<const std::vector<u32>*> lists;
+		for(u32 trigram : trigrams) {
+			auto postings = m_postings.find(trigram);
+			if(postings == m_postings.end()) {
+				return output;
+			}
+			lists.emplace_back(&postings->second);
+		}
+		
+		std::sort(CCC_BEGIN_END(lists), [](const std::vector<u32>* lhs, const std::vector<u32>* rhs) {
+			return lhs->size() < rhs->size();
+		});
+		
+		std::vector<u32> candidates = *lists[0];
+		std::vector<u32> intersection;
+		for(size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+			intersection.clear();
+			std::set_intersection(CCC_BEGIN_END(candidates), CCC_BEGIN_END(*lists[i]), std::back_inserter(intersection));
+			std::swap(candidates, intersection);
+		}
+		
+		for(u32 entry_index : candidates) {
+			check(m_entries[entry_index]);
+		}
+	}
+	
+	std::sort(CCC_BEGIN_END(output));
+	
+	return output;
+}
+
+std::vector<SymbolNameMatch> SymbolNameIndex::find_similar(
+	std::string_view query, size_t max_results, u32 descriptors) const
+{
+	std::vector<SymbolNameMatch> output;
+	
+	std::vector<u32> trigrams = name_trigrams(query);
+	if(trigrams.empty()) {
+		// The query is too short to use the index, so just look for names
+		// that contain it and prefer shorter names.
+		for(const Entry& entry : m_entries) {
+			if(entry.live && (entry.symbol.descriptor() & descriptors) && contains(entry.name.view(), query, false)) {
+				SymbolNameMatch& match = output.emplace_back();
+				match.symbol = entry.symbol;
+				match.score = 1.f + (float) query.size() / (float) std::max(entry.name.size(), (size_t) 1);
+			}
+		}
+	} else {
+		// Count the trigrams each name has in common with the query.
+		std::unordered_map<u32, u32> shared;
+		for(u32 trigram : trigrams) {
+			auto postings = m_postings.find(trigram);
+			if(postings != m_postings.end()) {
+				for(u32 entry_index : postings->second) {
+					shared[entry_index]++;
+				}
+			}
+		}
+		
+		for(auto [entry_index, count] : shared) {
+			const Entry& entry = m_entries[entry_index];
+			if(!entry.live || !(entry.symbol.descriptor() & descriptors)) {
+				continue;
+			}
+			
+			SymbolNameMatch& match = output.emplace_back();
+			match.symbol = entry.symbol;
+			// Dice coefficient of the two trigram sets.
+			match.score = 2.f * (float) count / (float) (trigrams.size() + entry.trigram_count);
+			if(count == trigrams.size() && contains(entry.name.view(), query, false)) {
+				match.score += 1.f;
+			}
+		}
+	}
+	
+	auto compare = [](const SymbolNameMatch& lhs, const SymbolNameMatch& rhs) {
+		if(lhs.score != rhs.score) {
+			return lhs.score > rhs.score;
+		}
+		return lhs.symbol < rhs.symbol;
+	};
+	
+	if(output.size() > max_results) {
+		std::partial_sort(output.begin(), output.begin() + max_results, output.end(), compare);
+		output.resize(max_results);
+	} else {
+		std::sort(CCC_BEGIN_END(output), compare);
+	}
+	
+	return output;
+}
+
+void SymbolNameIndex::add_postings(u32 entry_index)
+{
+	Entry& entry = m_entries[entry_index];
+	
+	std::vector<u32> trigrams = name_trigrams(entry.name.view());
+	for(u32 trigram : trigrams) {
+		m_postings[trigram].emplace_back(entry_index);
+	}
+	
+	entry.trigram_count = (u32) trigrams.size();
+}
+
+void SymbolNameIndex::rebuild()
+{
+	std::vector<Entry> entries = std::move(m_entries);
+	clear();
+	
+	for(Entry& entry : entries) {
+		if(entry.live) {
+			u32 entry_index = (u32) m_entries.size();
+			m_symbol_to_entry[((u64) entry.symbol.descriptor() << 32) | entry.symbol.handle()] = entry_index;
+			m_entries.emplace_back(std::move(entry));
+			add_postings(entry_index);
+			m_live_count++;
+		}
+	}
+}
+
+static std::vector<u32> name_trigrams(std::string_view name)
+{
+	std::vector<u32> trigrams;
+	if(name.size() < 3) {
+		return trigrams;
+	}
+	
+	trigrams.reserve(name.size() - 2);
+	for(size_t i = 0; i + 2 < name.size(); i++) {
+		trigrams.emplace_back(
+			(u32) tolower((u8) name[i]) << 16 |
+			(u32) tolower((u8) name[i + 1]) << 8 |
+			(u32) tolower((u8) name[i + 2]));
+	}
+	
+	std::sort(CCC_BEGIN_END(trigrams));
+	trigrams.erase(std::unique(CCC_BEGIN_END(trigrams)), trigrams.end());
+	
+	return trigrams;
+}
+
+static bool contains(std::string_view haystack, std::string_view needle, bool case_sensitive)
+{
+	if(case_sensitive) {
+		return haystack.find(needle) != std::string_view::npos;
+	}
+	
+	auto iterator = std::search(CCC_BEGIN_END(haystack), CCC_BEGIN_END(needle), [](char lhs, char rhs) {
+		return tolower((u8) lhs) == tolower((u8) rhs);
+	});
+	return iterator != haystack.end();
+}
+
+std::string demangle_symbol_name(const std::string& mangled_name, u32 importer_flags, const DemanglerFunctions& demangler)
+{
+	static const int DMGL_PARAMS = 1 << 0;
+	static const int DMGL_RET_POSTFIX = 1 << 5;
+	
+	std::string demangled_name;
+	if((importer_flags & DONT_DEMANGLE_NAMES) == 0 && demangler.cplus_demangle) {
+		ProfileScope profile(ProfilePhase::DEMANGLE);
+		int demangler_flags = 0;
+		if(importer_flags & DEMANGLE_PARAMETERS) demangler_flags |= DMGL_PARAMS;
+		if(importer_flags & DEMANGLE_RETURN_TYPE) demangler_flags |= DMGL_RET_POSTFIX;
+		char* demangled_name_ptr = demangler.cplus_demangle(mangled_name.c_str(), demangler_flags);
+		if(demangled_name_ptr) {
+			demangled_name = demangled_name_ptr;
+			free(static_cast<void*>(demangled_name_ptr));
+			profile_count(ProfileCounter::DEMANGLED_NAMES);
+		}
+	}
+	
+	return demangled_name;
+}
+
+Result<void> insert_staged_symbols(
+	SymbolDatabase& database, const SymbolGroup& group, std::span<const StagedSymbol> symbols, u32 importer_flags)
+{
+	for(const StagedSymbol& symbol : symbols) {
+		if(!(importer_flags & DONT_DEDUPLICATE_SYMBOLS) && symbol.address.valid()) {
+			if(database.functions.first_handle_from_starting_address(symbol.address).valid()) {
+				continue;
+			}
+			
+			if(database.global_variables.first_handle_from_starting_address(symbol.address).valid()) {
+				continue;
+			}
+			
+			if(database.local_variables.first_handle_from_starting_address(symbol.address).valid()) {
+				continue;
+			}
+		}
+		
+		StagedSymbolType type = symbol.type;
+		if(type == StagedSymbolType::CODE_OR_DATA) {
+			type = StagedSymbolType::LABEL;
+			if(const Section* section = database.sections.symbol_overlapping_address(symbol.address)) {
+				if(section->contains_code()) {
+					type = StagedSymbolType::FUNCTION;
+				} else if(section->contains_data()) {
+					type = StagedSymbolType::GLOBAL_VARIABLE;
+				}
+			}
+		}
+		
+		const std::string& name = symbol.demangled_name.empty() ? symbol.name : symbol.demangled_name;
+		
+		switch(type) {
+			case StagedSymbolType::LABEL: {
+				Result<Label*> label = database.labels.create_symbol(
+					symbol.name, symbol.address, group.source, group.module_symbol);
+				CCC_RETURN_IF_ERROR(label);
+				
+				(*label)->is_junk = symbol.is_junk;
+				
+				break;
+			}
+			case StagedSymbolType::FUNCTION: {
+				if(importer_flags & NO_FUNCTIONS) {
+					break;
+				}
+				
+				Result<Function*> function = database.functions.create_symbol(
+					name, symbol.address, group.source, group.module_symbol);
+				CCC_RETURN_IF_ERROR(function);
+				
+				if(!symbol.demangled_name.empty()) {
+					(*function)->set_mangled_name(symbol.name);
+				}
+				
+				if(symbol.size != 0) {
+					(*function)->set_size(symbol.size);
+				}
+				
+				break;
+			}
+			case StagedSymbolType::GLOBAL_VARIABLE: {
+				if(importer_flags & NO_GLOBAL_VARIABLES) {
+					break;
+				}
+				
+				Result<GlobalVariable*> global_variable = database.global_variables.create_symbol(
+					name, symbol.address, group.source, group.module_symbol);
+				CCC_RETURN_IF_ERROR(global_variable);
+				
+				if(!symbol.demangled_name.empty()) {
+					(*global_variable)->set_mangled_name(symbol.name);
+				}
+				
+				if(symbol.size != 0) {
+					(*global_variable)->set_size(symbol.size);
+				}
+				
+				break;
+			}
+			case StagedSymbolType::SOURCE_FILE: {
+				Result<SourceFile*> source_file = database.source_files.create_symbol(
+					symbol.name, group.source, group.module_symbol);
+				CCC_RETURN_IF_ERROR(source_file);
+				
+				break;
+			}
+			case StagedSymbolType::CODE_OR_DATA: {}
+		}
+	}
+	
+	return Result<void>();
+}
+
+template <typename Element>
+static u64 shrink_vector(std::vector<Element>& vector)
+{
+	u64 bytes = (vector.capacity() - vector.size()) * sizeof(Element);
+	vector.shrink_to_fit();
+	return bytes;
+}
+
 }
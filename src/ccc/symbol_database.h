@@ -7,8 +7,10 @@
 #include <atomic>
 #include <limits>
 #include <variant>
+#include <unordered_map>
 
 #include "util.h"
+#include "string_pool.h"
 
 namespace ccc {
 
@@ -48,7 +50,10 @@ enum {
 CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 #undef CCC_X
 
+class MultiSymbolHandle;
 class SymbolDatabase;
+class SymbolNameIndex;
+struct CompactionStats;
 
 using RawSymbolHandle = u32;
 
@@ -76,6 +81,119 @@ struct SymbolHandle {
 CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 #undef CCC_X
 
+// A range of handles that symbols can be allocated from. Symbols created in
+// different symbol lists using disjoint blocks can later be merged without
+// having to rewrite any handles.
+struct SymbolHandleBlock {
+	RawSymbolHandle begin = 0;
+	RawSymbolHandle end = NULL_SYMBOL_HANDLE;
+	
+	friend auto operator<=>(const SymbolHandleBlock& lhs, const SymbolHandleBlock& rhs) = default;
+};
+
+// Maps the handles of symbols being moved into another database to new
+// handles. This is used when merging databases that were built separately,
+// since their handles will have been allocated from the same range, and for
+// pointing symbols at a symbol source shared between databases.
+class SymbolHandleRemap {
+public:
+	// Map each of the old handles, which must be sorted, to a handle in the
+	// block starting at new_begin.
+	void add(SymbolDescriptor descriptor, std::vector<RawSymbolHandle> old_handles, RawSymbolHandle new_begin);
+	
+	// Map a single old handle to a new handle.
+	void add(SymbolDescriptor descriptor, RawSymbolHandle old_handle, RawSymbolHandle new_handle);
+	
+	bool empty() const { return m_tables.empty(); }
+	
+	// Handles that aren't in the map are returned unchanged.
+	RawSymbolHandle remap(SymbolDescriptor descriptor, RawSymbolHandle handle) const;
+	
+	template <typename SymbolType>
+	void remap(SymbolHandle<SymbolType>& handle) const
+	{
+		handle.value = remap(SymbolType::DESCRIPTOR, handle.value);
+	}
+	
+protected:
+	struct Table {
+		std::vector<RawSymbolHandle> old_handles;
+		std::vector<RawSymbolHandle> new_handles;
+	};
+	
+	std::map<SymbolDescriptor, Table> m_tables;
+};
+
+// The operations that are recorded in the undo journal and reported to
+// observers. Appending a file to a data type is only recorded in the journal.
+enum class SymbolOperation : u8 {
+	CREATE,
+	DESTROY,
+	MOVE,
+	RENAME,
+	RETYPE,
+	APPEND_FILE
+};
+
+// A single operation recorded in the undo journal. For moves the payload is
+// the old address, for renames and retypes it's an index into the side tables
+// of the journal, for destroys it's an index into the graveyard of the symbol
+// list, and for file appends it's unused.
+struct UndoEntry {
+	SymbolOperation operation = SymbolOperation::CREATE;
+	u16 descriptor = 0;
+	RawSymbolHandle handle = NULL_SYMBOL_HANDLE;
+	u32 payload = 0;
+};
+
+// Records the changes made to a symbol database while a transaction is active
+// so that they can be undone later.
+struct UndoJournal {
+	std::vector<UndoEntry> entries;
+	std::vector<InternedString> old_names;
+	std::vector<std::unique_ptr<ast::Node>> old_types;
+	// The position in the journal where each open transaction began.
+	std::vector<size_t> transactions;
+	
+	~UndoJournal();
+};
+
+// A position in the undo journal that can be rolled back to.
+struct UndoSavepoint {
+	size_t position = 0;
+};
+
+struct SymbolChange {
+	SymbolOperation operation = SymbolOperation::CREATE;
+	RawSymbolHandle handle = NULL_SYMBOL_HANDLE;
+};
+
+// The changes made to the symbols of a single type since the last batch was
+// delivered. Symbols that were both created and destroyed within the batch
+// aren't reported, and symbols that were created aren't also reported as
+// having been moved, renamed or retyped. Each list is sorted by handle.
+struct SymbolListChanges {
+	SymbolDescriptor descriptor = DATA_TYPE;
+	std::vector<RawSymbolHandle> created;
+	std::vector<RawSymbolHandle> destroyed;
+	std::vector<RawSymbolHandle> moved;
+	std::vector<RawSymbolHandle> renamed;
+	std::vector<RawSymbolHandle> retyped;
+};
+
+struct SymbolDatabaseChanges {
+	// Only symbol types with changes are included.
+	std::vector<SymbolListChanges> lists;
+};
+
+// Receives batches of changes made to a symbol database, so that views can be
+// updated incrementally instead of rescanning the whole database.
+class SymbolDatabaseObserver {
+public:
+	virtual ~SymbolDatabaseObserver() {}
+	virtual void on_symbols_changed(const SymbolDatabaseChanges& changes) = 0;
+};
+
 enum SymbolFlag {
 	NO_SYMBOL_FLAGS = 0,
 	WITH_ADDRESS_MAP = 1 << 0,
@@ -83,10 +201,24 @@ enum SymbolFlag {
 	NAME_NEEDS_DEMANGLING = 1 << 2
 };
 
+// The number of elements stored in each of the containers owned by a symbol
+// list, used for memory accounting.
+struct SymbolListContainerSizes {
+	size_t symbols = 0;
+	size_t symbol_capacity = 0;
+	size_t graveyard_capacity = 0;
+	size_t address_map = 0;
+	size_t name_map = 0;
+	size_t modules = 0;
+	size_t module_handle_capacity = 0;
+	size_t changes_capacity = 0;
+};
+
 // A container class for symbols of a given type that maintains maps of their
 // names and addresses depending on the value of SymbolType::FLAGS.
 template <typename SymbolType>
 class SymbolList {
+	friend SymbolDatabase;
 public:
 	// Lookup symbols from their handles using binary search.
 	SymbolType* symbol_from_handle(SymbolHandle<SymbolType> handle);
@@ -117,6 +249,12 @@ public:
 	std::vector<SymbolHandle<SymbolType>> handles_from_name(const std::string& name) const;
 	SymbolHandle<SymbolType> first_handle_from_name(const std::string& name) const;
 	
+	// Lookup symbols with names that start with the given prefix.
+	std::vector<SymbolHandle<SymbolType>> handles_from_name_prefix(const std::string& prefix) const;
+	
+	// Lookup the symbols that belong to a given module. The handles are sorted.
+	std::span<const SymbolHandle<SymbolType>> handles_from_module(ModuleHandle module_handle) const;
+	
 	// Find a symbol with an address range that contains the provided address.
 	// For example, to find which function an instruction belongs to.
 	SymbolType* symbol_overlapping_address(Address address);
@@ -135,6 +273,9 @@ public:
 	// Retrieve the number of symbols stored.
 	s32 size() const;
 	
+	// Count the elements stored in each of the underlying containers.
+	SymbolListContainerSizes container_sizes() const;
+	
 	// Create a new symbol. If it's a SymbolSource symbol, source can be left
 	// empty, otherwise it has to be valid.
 	Result<SymbolType*> create_symbol(
@@ -160,7 +301,25 @@ public:
 	// Update the name of a symbol without changing its handle.
 	bool rename_symbol(SymbolHandle<SymbolType> handle, std::string new_name);
 	
-	// Move all the symbols from the passed list into this list.
+	// Replace the type of a symbol. Unlike Symbol::set_type, this is recorded
+	// in the undo journal if a transaction is active.
+	bool retype_symbol(SymbolHandle<SymbolType> handle, std::unique_ptr<ast::Node> new_type);
+	
+	// Reserve a block of handles from the block this list is currently
+	// allocating from. The reserved handles won't be assigned to any new
+	// symbols in this list unless it is explicitly told to use the block.
+	Result<SymbolHandleBlock> reserve_handles(u32 count);
+	
+	// Set the block that handles for new symbols will be allocated from.
+	// Switching between blocks doesn't break the ordering of the list.
+	SymbolHandleBlock handle_block() const { return m_handle_block; }
+	void set_handle_block(SymbolHandleBlock block) { m_handle_block = block; }
+	
+	// Move all the symbols from the passed list into this list. The handles
+	// of the symbols in the two lists must not overlap, which can be achieved
+	// by creating the symbols in the passed list using a block of handles
+	// reserved from this list. SymbolDatabase::merge_from doesn't have this
+	// requirement.
 	void merge_from(SymbolList<SymbolType>& list);
 	
 	// Mark a symbol for destruction. If the correct symbol database pointer is
@@ -179,11 +338,13 @@ public:
 	void mark_symbols_from_module_for_destruction(ModuleHandle module_handle, SymbolDatabase* database);
 	
 	// Destroy all symbols that have previously been marked for destruction.
-	// This invalidates all pointers to symbols in this list.
+	// The list is compacted in place starting from the first marked symbol, so
+	// symbols before it aren't touched. This invalidates all pointers to
+	// symbols in this list.
 	void destroy_marked_symbols();
 	
-	// Destroy all symbols, but don't reset m_next_handle so we don't have to
-	// worry about dangling handles.
+	// Destroy all symbols, but don't reset the handle block so we don't have
+	// to worry about dangling handles.
 	void clear();
 	
 protected:
@@ -191,6 +352,14 @@ protected:
 	// index where it could be inserted.
 	size_t binary_search(SymbolHandle<SymbolType> handle) const;
 	
+	// Check if any of the handles in the passed list are in use by this list,
+	// or could be allocated by it in the future.
+	bool handles_collide(const SymbolList<SymbolType>& list) const;
+	
+	// Rewrite the handles of all the symbols in this list, and all the handles
+	// stored in those symbols, using the passed map.
+	void remap_handles(const SymbolHandleRemap& remap);
+	
 	// Keep the address map in sync with the symbol list.
 	void link_address_map(SymbolType& symbol);
 	void unlink_address_map(SymbolType& symbol);
@@ -199,16 +368,60 @@ protected:
 	void link_name_map(SymbolType& symbol);
 	void unlink_name_map(SymbolType& symbol);
 	
+	// Keep the module map in sync with the symbol list.
+	void link_module_map(SymbolType& symbol);
+	void unlink_module_map(SymbolType& symbol);
+	
+	// Mark a single symbol and keep track of where the first marked symbol is.
+	void mark_symbol(SymbolType& symbol);
+	
+	// Append an entry to the undo journal.
+	void record(SymbolOperation operation, RawSymbolHandle handle, u32 payload);
+	
+	// Remember a change so it can be reported to observers later.
+	void note_change(SymbolOperation operation, RawSymbolHandle handle);
+	
+	// Coalesce the changes noted since the last call into the output. Returns
+	// false if there are no changes to report.
+	bool take_changes(SymbolListChanges& output);
+	
+	// Undo a single operation previously recorded by this list.
+	void undo(const UndoEntry& entry, UndoJournal& journal);
+	
+	// Free memory that is only needed while importing symbol tables.
+	void compact(u32 flags, CompactionStats& stats);
+	
 	using AddressToHandleMap = std::multimap<u32, SymbolHandle<SymbolType>>;
-	using NameToHandleMap = std::multimap<std::string, SymbolHandle<SymbolType>>;
+	using NameToHandleMap = std::multimap<std::string_view, SymbolHandle<SymbolType>>;
+	using ModuleToHandlesMap = std::map<ModuleHandle, std::vector<SymbolHandle<SymbolType>>>;
 	
 	std::vector<SymbolType> m_symbols;
 	AddressToHandleMap m_address_to_handle;
 	NameToHandleMap m_name_to_handle;
+	ModuleToHandlesMap m_module_to_handles;
+	
+	// The lowest handle of any symbol that has been marked for destruction, so
+	// destroy_marked_symbols knows where to start.
+	RawSymbolHandle m_first_marked_handle = NULL_SYMBOL_HANDLE;
+	
+	// Handles are allocated from the start of this block. Each list has its
+	// own so that the handles assigned don't depend on other lists.
+	SymbolHandleBlock m_handle_block;
 	
-	// We share this between symbol lists of the same type so that we can merge
-	// them without having to rewrite all the handles.
-	static std::atomic<RawSymbolHandle> m_next_handle;
+	// Owned by the symbol database. Only set while a transaction is active.
+	UndoJournal* m_journal = nullptr;
+	
+	// Owned by the symbol database. Only set if the name index is enabled.
+	SymbolNameIndex* m_name_index = nullptr;
+	
+	// Symbols destroyed during a transaction are kept here until it ends, in
+	// case they need to be restored.
+	std::vector<SymbolType> m_graveyard;
+	
+	// Only set if the symbol database has observers, so that changes are only
+	// noted when someone is interested in them.
+	bool m_has_observers = false;
+	std::vector<SymbolChange> m_changes;
 };
 
 // Base class for all the symbols.
@@ -216,7 +429,7 @@ class Symbol {
 	template <typename SymbolType>
 	friend class SymbolList;
 public:
-	const std::string& name() const { return m_name; }
+	const std::string& name() const { return m_name.str(); }
 	RawSymbolHandle raw_handle() const { return m_handle; }
 	SymbolSourceHandle source() const { return m_source; }
 	ModuleHandle module_handle() const { return m_module; }
@@ -228,6 +441,10 @@ public:
 	
 	ast::Node* type() { return m_type.get(); }
 	const ast::Node* type() const { return m_type.get(); }
+	
+	// This isn't recorded in the undo journal or reported to observers, so it
+	// should only be used to fill in symbols that were just created. Use
+	// SymbolList::retype_symbol to replace the type of an existing symbol.
 	void set_type(std::unique_ptr<ast::Node> type);
 	
 	u32 generation() const { return m_generation; }
@@ -236,19 +453,19 @@ public:
 	// For the set_type function this is done for you.
 	void invalidate_node_handles() { m_generation++; }
 	
-	// Mark a single symbol for destruction, not including its descendants.
-	void mark_for_destruction() { m_marked_for_destruction = true; }
 	bool is_marked_for_destruction() { return m_marked_for_destruction; }
 	
 protected:
 	void on_create() {}
 	void on_destroy(SymbolDatabase* database) {}
+	u64 on_compact(u32 flags) { return 0; }
+	void on_remap(const SymbolHandleRemap& remap) {}
 	
 	RawSymbolHandle m_handle = NULL_SYMBOL_HANDLE;
 	SymbolSourceHandle m_source;
 	Address m_address;
 	u32 m_size = 0;
-	std::string m_name;
+	InternedString m_name;
 	std::unique_ptr<ast::Node> m_type;
 	u32 m_generation : 31 = 0;
 	u32 m_marked_for_destruction : 1 = false;
@@ -323,6 +540,7 @@ protected:
 // A C/C++ data type.
 class DataType : public Symbol {
 	friend SourceFile;
+	friend SymbolList<DataType>;
 public:
 	static constexpr const SymbolDescriptor DESCRIPTOR = DATA_TYPE;
 	static constexpr const char* NAME = "Data Type";
@@ -335,6 +553,10 @@ public:
 	
 	bool not_defined_in_any_translation_unit : 1 = false;
 	bool only_defined_in_single_translation_unit : 1 = false;
+	
+protected:
+	u64 on_compact(u32 flags);
+	void on_remap(const SymbolHandleRemap& remap);
 };
 
 // A function. The type stored is the return type.
@@ -370,15 +592,20 @@ public:
 		Address address;
 		s32 line_number;
 	};
-
+	
 	struct SubSourceFile {
 		Address address;
-		std::string relative_path;
+		InternedString relative_path;
 	};
 	
-	std::string relative_path;
+	InternedString relative_path;
 	StorageClass storage_class;
 	s32 stack_frame_size = -1;
+	// Unwinding information from the procedure descriptor. The saved register
+	// offset is relative to the virtual frame pointer (sp + stack_frame_size).
+	u32 saved_register_mask = 0;
+	s32 saved_register_offset = 0;
+	s16 return_pc_register = -1;
 	std::vector<LineNumberPair> line_numbers;
 	std::vector<SubSourceFile> sub_source_files;
 	bool is_member_function_ish = false; // Filled in by fill_in_pointers_to_member_function_definitions.
@@ -386,12 +613,14 @@ public:
 	
 protected:
 	void on_destroy(SymbolDatabase* database);
+	u64 on_compact(u32 flags);
+	void on_remap(const SymbolHandleRemap& remap);
 	
 	SourceFileHandle m_source_file;
 	std::optional<std::vector<ParameterVariableHandle>> m_parameter_variables;
 	std::optional<std::vector<LocalVariableHandle>> m_local_variables;
 	
-	std::string m_mangled_name;
+	InternedString m_mangled_name;
 	
 	u32 m_original_hash = 0;
 	u32 m_current_hash = 0;
@@ -400,6 +629,7 @@ protected:
 // A global variable.
 class GlobalVariable : public Symbol {
 	friend SourceFile;
+	friend SymbolList<GlobalVariable>;
 public:
 	static constexpr const SymbolDescriptor DESCRIPTOR = GLOBAL_VARIABLE;
 	static constexpr const char* NAME = "Global Variable";
@@ -415,8 +645,10 @@ public:
 	StorageClass storage_class;
 	
 protected:
+	void on_remap(const SymbolHandleRemap& remap);
+	
 	SourceFileHandle m_source_file;
-	std::string m_mangled_name;
+	InternedString m_mangled_name;
 };
 
 // A label. This could be a label defined in assembly, C/C++, or just a symbol
@@ -437,6 +669,7 @@ public:
 // storage.
 class LocalVariable : public Symbol {
 	friend Function;
+	friend SymbolList<LocalVariable>;
 public:
 	static constexpr const SymbolDescriptor DESCRIPTOR = LOCAL_VARIABLE;
 	static constexpr const char* NAME = "Local Variable";
@@ -449,6 +682,8 @@ public:
 	AddressRange live_range;
 	
 protected:
+	void on_remap(const SymbolHandleRemap& remap);
+	
 	FunctionHandle m_function;
 };
 
@@ -478,6 +713,7 @@ protected:
 // A parameter variable.
 class ParameterVariable : public Symbol {
 	friend Function;
+	friend SymbolList<ParameterVariable>;
 public:
 	static constexpr const SymbolDescriptor DESCRIPTOR = PARAMETER_VARIABLE;
 	static constexpr const char* NAME = "Parameter Variable";
@@ -489,6 +725,8 @@ public:
 	std::variant<RegisterStorage, StackStorage> storage;
 	
 protected:
+	void on_remap(const SymbolHandleRemap& remap);
+	
 	FunctionHandle m_function;
 };
 
@@ -531,13 +769,15 @@ public:
 	bool functions_match() const;
 	void check_functions_match(const SymbolDatabase& database);
 	
-	std::string working_dir;
-	std::string command_line_path;
+	InternedString working_dir;
+	InternedString command_line_path;
 	std::map<StabsTypeNumber, DataTypeHandle> stabs_type_number_to_handle;
 	std::set<std::string> toolchain_version_info;
 	
 protected:
 	void on_destroy(SymbolDatabase* database);
+	u64 on_compact(u32 flags);
+	void on_remap(const SymbolHandleRemap& remap);
 	
 	std::vector<FunctionHandle> m_functions;
 	std::vector<GlobalVariableHandle> m_global_variables;
@@ -571,6 +811,35 @@ struct SymbolGroup {
 	bool is_in_group(const Symbol& symbol) const;
 };
 
+// Flags controlling which memory SymbolDatabase::compact frees.
+enum CompactionFlags {
+	NO_COMPACTION_FLAGS = 0,
+	// Drop the maps from STABS type numbers to data types stored for each
+	// source file, and the STABS type numbers of type names that have already
+	// been resolved. Symbol tables can't be imported into a database after
+	// this flag has been used.
+	DROP_STABS_TYPE_NUMBERS = 1 << 0,
+	// Drop the lists of files that each data type is defined in.
+	DROP_DATA_TYPE_FILES = 1 << 1,
+	// Reallocate the AST nodes of each symbol in preorder. This invalidates
+	// all node handles.
+	RELOCATE_NODES = 1 << 2,
+	ALL_COMPACTION_FLAGS = DROP_STABS_TYPE_NUMBERS | DROP_DATA_TYPE_FILES | RELOCATE_NODES
+};
+
+struct CompactionStats {
+	// An estimate, since the overhead of the allocator isn't known.
+	u64 bytes_reclaimed = 0;
+	u32 nodes_relocated = 0;
+};
+
+// A block of handles for each symbol list in a database.
+struct SymbolDatabaseHandleBlocks {
+	#define CCC_X(SymbolType, symbol_list) SymbolHandleBlock symbol_list;
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+};
+
 // The symbol database itself. This owns all the symbols.
 class SymbolDatabase {
 public:
@@ -617,8 +886,28 @@ public:
 		SourceFile& source_file,
 		const SymbolGroup& group);
 	
-	// Move all the symbols in the passed database into this database.
-	void merge_from(SymbolDatabase& database);
+	// Reserve a block of handles from each symbol list. The blocks can be
+	// passed to set_handle_blocks on another database (for example one per
+	// translation unit being imported on a separate thread) so that its
+	// symbols can later be merged into this one. Since the blocks are reserved
+	// up front, the handles assigned don't depend on thread scheduling.
+	Result<SymbolDatabaseHandleBlocks> reserve_handles(u32 count);
+	
+	SymbolDatabaseHandleBlocks handle_blocks() const;
+	void set_handle_blocks(const SymbolDatabaseHandleBlocks& blocks);
+	
+	// Move all the symbols in the passed database into this database. If the
+	// handles of the symbols being moved collide with handles used by this
+	// database, for example because the two databases were built separately,
+	// the symbols will be given new handles and all the references to them
+	// will be updated. Otherwise the handles are kept as they are.
+	Result<void> merge_from(SymbolDatabase& database);
+	
+	// Rewrite the handles of the symbols in this database, and all the
+	// references to them, using the passed map. The map must not change the
+	// order of the handles within a symbol list or map a handle to one that is
+	// already in use.
+	void remap_handles(const SymbolHandleRemap& remap);
 	
 	// Destroy all the symbols from a given symbol source. For example you can
 	// use this to free a symbol table without destroying user-defined symbols.
@@ -634,6 +923,61 @@ public:
 	// Destroy all the symbols in the symbol database.
 	void clear();
 	
+	// Free memory that is only needed while symbol tables are being imported,
+	// and shrink containers that were grown during importing to fit their
+	// contents. This should be called once all the symbol tables have been
+	// imported, outside of any transaction.
+	CompactionStats compact(u32 flags = ALL_COMPACTION_FLAGS);
+	
+	// Start a transaction. Until it is committed or rolled back, symbols that
+	// are created, destroyed, moved, renamed or retyped using the functions
+	// provided by the symbol lists are recorded in an undo journal. Fields
+	// that are modified directly are not recorded. Transactions can be nested,
+	// in which case committing the inner transaction hands its changes over to
+	// the outer one.
+	void begin_transaction();
+	void commit_transaction();
+	
+	// Undo all the changes made since the matching call to begin_transaction.
+	// This takes time proportional to the number of changes made, not the size
+	// of the database, and invalidates all pointers to symbols in this
+	// database. Handles allocated during the transaction are not reused.
+	void rollback_transaction();
+	
+	bool in_transaction() const;
+	
+	// Mark a position within the innermost transaction that can be rolled back
+	// to without ending the transaction.
+	UndoSavepoint savepoint() const;
+	void rollback_to_savepoint(UndoSavepoint savepoint);
+	
+	// List the symbols that have been created, moved, renamed or retyped, or
+	// had files appended, since the savepoint was taken. Some of them may have
+	// been destroyed since. The result is sorted.
+	std::vector<MultiSymbolHandle> symbols_changed_since(UndoSavepoint savepoint) const;
+	
+	// Register an observer to be notified of symbols being created, destroyed,
+	// moved, renamed or retyped using the functions provided by the symbol
+	// lists. Changes made using Symbol::set_type or by modifying fields
+	// directly aren't reported. The database doesn't take ownership.
+	void add_observer(SymbolDatabaseObserver* observer);
+	void remove_observer(SymbolDatabaseObserver* observer);
+	
+	// Changes are batched up and coalesced until this is called, or until the
+	// outermost transaction is committed or rolled back, at which point they
+	// are delivered to all the observers.
+	void flush_changes();
+	
+	// Build a trigram index over the names of all the symbols in lists that
+	// have name maps, and keep it up to date as symbols are created, destroyed
+	// and renamed. This makes substring and fuzzy searches fast at the cost of
+	// some memory and slightly slower modifications.
+	void enable_name_index();
+	void disable_name_index();
+	
+	// Returns nullptr if the name index isn't enabled.
+	const SymbolNameIndex* name_index() const { return m_name_index.get(); }
+	
 	template <typename Callback>
 	void for_each_symbol(Callback callback) {
 		// Use indices here to avoid iterator invalidation.
@@ -644,6 +988,31 @@ public:
 		CCC_FOR_EACH_SYMBOL_TYPE_DO_X
 		#undef CCC_X
 	}
+	
+	// Same as above, but only for the symbol types included in the mask.
+	template <typename Callback>
+	void for_each_symbol(u32 descriptors, Callback callback) {
+		#define CCC_X(SymbolType, symbol_list) \
+			if(descriptors & SymbolType::DESCRIPTOR) { \
+				for(s32 i = 0; i < symbol_list.size(); i++) { \
+					callback(symbol_list.symbol_from_index(i)); \
+				} \
+			}
+		CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+		#undef CCC_X
+	}
+	
+protected:
+	// Append a file to the list of files a data type is present in, recording
+	// it in the undo journal if a transaction is active.
+	void append_data_type_file(DataType& data_type, SourceFileHandle file);
+	
+	void undo_until(size_t position);
+	void end_transactions();
+	
+	std::unique_ptr<UndoJournal> m_journal;
+	std::vector<SymbolDatabaseObserver*> m_observers;
+	std::unique_ptr<SymbolNameIndex> m_name_index;
 };
 
 // A handle to a symbol of any type.
@@ -667,6 +1036,7 @@ public:
 	bool is_flag_set(SymbolFlag flag) const;
 	bool move_symbol(Address new_address, SymbolDatabase& database) const;
 	bool rename_symbol(std::string new_name, SymbolDatabase& database) const;
+	bool retype_symbol(std::unique_ptr<ast::Node> new_type, SymbolDatabase& database) const;
 	bool destroy_symbol(SymbolDatabase& database, bool destroy_descendants) const;
 	
 	friend auto operator<=>(const MultiSymbolHandle& lhs, const MultiSymbolHandle& rhs) = default;
@@ -708,4 +1078,85 @@ protected:
 	u32 m_generation = 0;
 };
 
+struct SymbolNameMatch {
+	MultiSymbolHandle symbol;
+	float score = 0.f;
+};
+
+// An index of the trigrams (runs of three characters, ignoring case) that
+// appear in symbol names, so that names containing a given string or similar
+// to a given string can be found without comparing against every name.
+class SymbolNameIndex {
+public:
+	// If the symbol is already present its name is updated.
+	void insert(MultiSymbolHandle symbol, const std::string& name);
+	void remove(MultiSymbolHandle symbol);
+	void clear();
+	
+	size_t size() const { return m_live_count; }
+	
+	// Find all the symbols with names that contain the given string. The
+	// results are sorted by descriptor, then by handle.
+	std::vector<MultiSymbolHandle> find_substring(
+		std::string_view string, u32 descriptors = ALL_SYMBOL_TYPES, bool case_sensitive = false) const;
+	
+	// Rank symbols by how many trigrams their names have in common with the
+	// query, so that misspelled queries still produce useful results. Names
+	// that contain the query are always ranked first.
+	std::vector<SymbolNameMatch> find_similar(
+		std::string_view query, size_t max_results, u32 descriptors = ALL_SYMBOL_TYPES) const;
+	
+protected:
+	struct Entry {
+		MultiSymbolHandle symbol;
+		InternedString name;
+		u32 trigram_count = 0;
+		bool live = false;
+	};
+	
+	void add_postings(u32 entry_index);
+	void rebuild();
+	
+	// Entries are only ever appended, so the posting lists stay sorted.
+	// Removed entries are skipped until there are enough of them to make it
+	// worth rebuilding the index.
+	std::vector<Entry> m_entries;
+	std::unordered_map<u32, std::vector<u32>> m_postings;
+	std::unordered_map<u64, u32> m_symbol_to_entry;
+	size_t m_live_count = 0;
+};
+
+// Demangle a symbol name according to the importer flags. Returns an empty
+// string if the name couldn't be demangled or demangling is disabled. This is
+// thread safe.
+std::string demangle_symbol_name(const std::string& mangled_name, u32 importer_flags, const DemanglerFunctions& demangler);
+
+enum class StagedSymbolType : u8 {
+	LABEL,
+	FUNCTION,
+	GLOBAL_VARIABLE,
+	SOURCE_FILE,
+	// Becomes a function, global variable or label depending on the section
+	// the symbol is in, which may not be known until the symbol is inserted.
+	CODE_OR_DATA
+};
+
+// A symbol that has been read from a symbol table and had its name demangled,
+// but hasn't been added to a database yet. This lets the expensive parts of
+// importing a simple symbol table run without access to the database.
+struct StagedSymbol {
+	StagedSymbolType type = StagedSymbolType::LABEL;
+	std::string name;
+	std::string demangled_name; // Empty if the name couldn't be demangled.
+	Address address;
+	u32 size = 0;
+	bool is_junk = false;
+};
+
+// Add staged symbols to a database, skipping those that are at the same
+// address as a function or variable that already exists unless
+// DONT_DEDUPLICATE_SYMBOLS is set.
+Result<void> insert_staged_symbols(
+	SymbolDatabase& database, const SymbolGroup& group, std::span<const StagedSymbol> symbols, u32 importer_flags);
+
 }
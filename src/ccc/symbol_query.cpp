@@ -0,0 +1,519 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "symbol_query.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+// The handle sets that the query filters by, resolved once up front.
+struct ResolvedSymbolQuery {
+	std::vector<ModuleHandle> modules;
+	std::vector<SymbolSourceHandle> sources;
+	std::vector<SourceFileHandle> source_files;
+	std::vector<DataTypeHandle> referenced_types;
+	std::vector<MultiSymbolHandle> referencing_symbols;
+	bool has_module_filter = false;
+	bool has_source_filter = false;
+	bool has_source_file_filter = false;
+	bool has_type_filter = false;
+};
+
+template <typename SymbolType>
+static void run_symbol_list_query(
+	const SymbolList<SymbolType>& list,
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const ResolvedSymbolQuery& resolved,
+	bool has_type_references,
+	const SymbolQueryCallback& callback);
+template <typename SymbolType>
+static bool symbol_matches_query(
+	const SymbolType& symbol,
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const ResolvedSymbolQuery& resolved);
+template <typename SymbolType>
+static SourceFileHandle source_file_of(const SymbolType& symbol, const SymbolDatabase& database);
+template <typename Handle>
+static bool sorted_contains(const std::vector<Handle>& handles, Handle handle);
+static void collect_type_references(const ast::Node& node, std::vector<DataTypeHandle>& output);
+static std::string_view literal_prefix(std::string_view glob);
+static bool is_glob_literal(std::string_view glob);
+
+Result<void> SymbolQuery::set_name_regex(const std::string& pattern)
+{
+	try {
+		name_regex = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+	} catch(const std::regex_error& error) {
+		return CCC_FAILURE("Invalid regular expression '%s': %s", pattern.c_str(), error.what());
+	}
+	
+	return Result<void>();
+}
+
+const char* symbol_query_plan_to_string(SymbolQueryPlan plan)
+{
+	switch(plan) {
+		case SymbolQueryPlan::NAME_MAP: return "name map";
+		case SymbolQueryPlan::TYPE_REFERENCES: return "type references";
+		case SymbolQueryPlan::MODULE: return "module";
+		case SymbolQueryPlan::ADDRESS_MAP: return "address map";
+		case SymbolQueryPlan::NAME_PREFIX: return "name prefix";
+		case SymbolQueryPlan::SCAN: return "scan";
+	}
+	return "";
+}
+
+// *****************************************************************************
+
+void TypeReferenceIndex::build(const SymbolDatabase& database)
+{
+	std::vector<std::pair<DataTypeHandle, MultiSymbolHandle>> entries;
+	std::vector<DataTypeHandle> referenced;
+	
+	#define CCC_X(SymbolType, symbol_list) \
+		for(const SymbolType& symbol : database.symbol_list) { \
+			if(symbol.type()) { \
+				referenced.clear(); \
+				collect_type_references(*symbol.type(), referenced); \
+				for(DataTypeHandle data_type : referenced) { \
+					entries.emplace_back(data_type, MultiSymbolHandle(symbol)); \
+				} \
+			} \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	std::sort(entries.begin(), entries.end());
+	entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+	
+	m_data_types.clear();
+	m_symbols.clear();
+	m_data_types.reserve(entries.size());
+	m_symbols.reserve(entries.size());
+	
+	for(auto& [data_type, symbol] : entries) {
+		m_data_types.emplace_back(data_type);
+		m_symbols.emplace_back(symbol);
+	}
+}
+
+std::span<const MultiSymbolHandle> TypeReferenceIndex::symbols_referencing(DataTypeHandle data_type) const
+{
+	auto [begin, end] = std::equal_range(m_data_types.begin(), m_data_types.end(), data_type);
+	return std::span<const MultiSymbolHandle>(
+		m_symbols.data() + (begin - m_data_types.begin()),
+		m_symbols.data() + (end - m_data_types.begin()));
+}
+
+static void collect_type_references(const ast::Node& node, std::vector<DataTypeHandle>& output)
+{
+	ast::for_each_node(node, ast::PREORDER_TRAVERSAL, [&](const ast::Node& child) {
+		if(child.descriptor == ast::TYPE_NAME) {
+			DataTypeHandle data_type = child.as<ast::TypeName>().data_type_handle;
+			if(data_type.valid()) {
+				output.emplace_back(data_type);
+			}
+		}
+		return ast::EXPLORE_CHILDREN;
+	});
+	
+	std::sort(output.begin(), output.end());
+	output.erase(std::unique(output.begin(), output.end()), output.end());
+}
+
+// *****************************************************************************
+
+SymbolQueryPlan plan_symbol_query(const SymbolQuery& query, SymbolDescriptor descriptor, bool has_type_references)
+{
+	u32 flags = 0;
+	#define CCC_X(SymbolType, symbol_list) \
+		if(descriptor == SymbolType::DESCRIPTOR) { \
+			flags = SymbolType::FLAGS; \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	if((flags & WITH_NAME_MAP) && !query.name_glob.empty() && is_glob_literal(query.name_glob)) {
+		return SymbolQueryPlan::NAME_MAP;
+	}
+	
+	if(has_type_references && !query.referenced_type_name.empty()) {
+		return SymbolQueryPlan::TYPE_REFERENCES;
+	}
+	
+	// Module symbols are considered to belong to themselves, so this works for
+	// them too.
+	if(!query.module_name.empty()) {
+		return SymbolQueryPlan::MODULE;
+	}
+	
+	if((flags & WITH_ADDRESS_MAP) && (query.address_range.low.valid() || query.address_range.high.valid())) {
+		return SymbolQueryPlan::ADDRESS_MAP;
+	}
+	
+	if((flags & WITH_NAME_MAP) && !literal_prefix(query.name_glob).empty()) {
+		return SymbolQueryPlan::NAME_PREFIX;
+	}
+	
+	return SymbolQueryPlan::SCAN;
+}
+
+void run_symbol_query(
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const TypeReferenceIndex* type_references,
+	const SymbolQueryCallback& callback)
+{
+	ResolvedSymbolQuery resolved;
+	
+	if(!query.module_name.empty()) {
+		resolved.has_module_filter = true;
+		for(ModuleHandle module : database.modules.handles_from_name(query.module_name)) {
+			resolved.modules.emplace_back(module);
+		}
+		std::sort(resolved.modules.begin(), resolved.modules.end());
+	}
+	
+	if(!query.source_name.empty()) {
+		resolved.has_source_filter = true;
+		for(const SymbolSource& source : database.symbol_sources) {
+			if(source.name() == query.source_name) {
+				resolved.sources.emplace_back(source.handle());
+			}
+		}
+		std::sort(resolved.sources.begin(), resolved.sources.end());
+	}
+	
+	if(!query.source_file_glob.empty()) {
+		resolved.has_source_file_filter = true;
+		for(const SourceFile& source_file : database.source_files) {
+			if(glob_match(query.source_file_glob, source_file.full_path())) {
+				resolved.source_files.emplace_back(source_file.handle());
+			}
+		}
+		std::sort(resolved.source_files.begin(), resolved.source_files.end());
+	}
+	
+	if(!query.referenced_type_name.empty()) {
+		resolved.has_type_filter = true;
+		for(DataTypeHandle data_type : database.data_types.handles_from_name(query.referenced_type_name)) {
+			resolved.referenced_types.emplace_back(data_type);
+		}
+		std::sort(resolved.referenced_types.begin(), resolved.referenced_types.end());
+		
+		if(type_references) {
+			for(DataTypeHandle data_type : resolved.referenced_types) {
+				std::span<const MultiSymbolHandle> symbols = type_references->symbols_referencing(data_type);
+				resolved.referencing_symbols.insert(resolved.referencing_symbols.end(), symbols.begin(), symbols.end());
+			}
+			std::sort(resolved.referencing_symbols.begin(), resolved.referencing_symbols.end());
+		}
+	}
+	
+	#define CCC_X(SymbolType, symbol_list) \
+		if(query.descriptors & SymbolType::DESCRIPTOR) { \
+			run_symbol_list_query(database.symbol_list, database, query, resolved, type_references != nullptr, callback); \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+}
+
+template <typename SymbolType>
+static void run_symbol_list_query(
+	const SymbolList<SymbolType>& list,
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const ResolvedSymbolQuery& resolved,
+	bool has_type_references,
+	const SymbolQueryCallback& callback)
+{
+	SymbolQueryPlan plan = plan_symbol_query(query, SymbolType::DESCRIPTOR, has_type_references);
+	
+	if(plan == SymbolQueryPlan::SCAN) {
+		for(const SymbolType& symbol : list) {
+			if(symbol_matches_query(symbol, database, query, resolved)) {
+				callback(symbol, SymbolType::DESCRIPTOR);
+			}
+		}
+		return;
+	}
+	
+	std::vector<SymbolHandle<SymbolType>> candidates;
+	switch(plan) {
+		case SymbolQueryPlan::NAME_MAP: {
+			candidates = list.handles_from_name(query.name_glob);
+			break;
+		}
+		case SymbolQueryPlan::TYPE_REFERENCES: {
+			auto begin = std::lower_bound(resolved.referencing_symbols.begin(), resolved.referencing_symbols.end(),
+				MultiSymbolHandle(SymbolType::DESCRIPTOR, 0));
+			for(auto iterator = begin; iterator != resolved.referencing_symbols.end(); iterator++) {
+				if(iterator->descriptor() != SymbolType::DESCRIPTOR) {
+					break;
+				}
+				candidates.emplace_back(iterator->handle());
+			}
+			break;
+		}
+		case SymbolQueryPlan::MODULE: {
+			for(ModuleHandle module : resolved.modules) {
+				std::span<const SymbolHandle<SymbolType>> handles = list.handles_from_module(module);
+				candidates.insert(candidates.end(), handles.begin(), handles.end());
+			}
+			break;
+		}
+		case SymbolQueryPlan::ADDRESS_MAP: {
+			candidates = list.handles_from_address_range(query.address_range);
+			break;
+		}
+		case SymbolQueryPlan::NAME_PREFIX: {
+			candidates = list.handles_from_name_prefix(std::string(literal_prefix(query.name_glob)));
+			break;
+		}
+		case SymbolQueryPlan::SCAN: {
+			break;
+		}
+	}
+	
+	// Report the matches in handle order regardless of which index was used.
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	
+	for(SymbolHandle<SymbolType> handle : candidates) {
+		const SymbolType* symbol = list.symbol_from_handle(handle);
+		if(symbol && symbol_matches_query(*symbol, database, query, resolved)) {
+			callback(*symbol, SymbolType::DESCRIPTOR);
+		}
+	}
+}
+
+template <typename SymbolType>
+static bool symbol_matches_query(
+	const SymbolType& symbol,
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const ResolvedSymbolQuery& resolved)
+{
+	if(!query.name_glob.empty() && !glob_match(query.name_glob, symbol.name())) {
+		return false;
+	}
+	
+	if(query.name_regex.has_value() && !std::regex_search(symbol.name(), *query.name_regex)) {
+		return false;
+	}
+	
+	if(resolved.has_module_filter && !sorted_contains(resolved.modules, symbol.module_handle())) {
+		return false;
+	}
+	
+	if(resolved.has_source_filter && !sorted_contains(resolved.sources, symbol.source())) {
+		return false;
+	}
+	
+	if(resolved.has_source_file_filter && !sorted_contains(resolved.source_files, source_file_of(symbol, database))) {
+		return false;
+	}
+	
+	const AddressRange& range = query.address_range;
+	if(range.low.valid() || range.high.valid()) {
+		if(!symbol.address().valid()) {
+			return false;
+		}
+		if(range.low.valid() && symbol.address().value < range.low.value) {
+			return false;
+		}
+		if(range.high.valid() && symbol.address().value >= range.high.value) {
+			return false;
+		}
+	}
+	
+	if(query.min_size.has_value() && symbol.size() < *query.min_size) {
+		return false;
+	}
+	
+	if(query.max_size.has_value() && symbol.size() > *query.max_size) {
+		return false;
+	}
+	
+	if(query.storage_class.has_value()) {
+		if constexpr(requires { symbol.storage_class; }) {
+			if(symbol.storage_class != *query.storage_class) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	
+	if(query.storage_location.has_value()) {
+		if constexpr(std::is_same_v<SymbolType, GlobalVariable>) {
+			if(symbol.storage.location != *query.storage_location) {
+				return false;
+			}
+		} else if constexpr(std::is_same_v<SymbolType, LocalVariable>) {
+			const GlobalStorage* storage = std::get_if<GlobalStorage>(&symbol.storage);
+			if(!storage || storage->location != *query.storage_location) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	
+	if(resolved.has_type_filter) {
+		if(!symbol.type()) {
+			return false;
+		}
+		
+		std::vector<DataTypeHandle> referenced;
+		collect_type_references(*symbol.type(), referenced);
+		
+		bool found = false;
+		for(DataTypeHandle data_type : referenced) {
+			if(sorted_contains(resolved.referenced_types, data_type)) {
+				found = true;
+				break;
+			}
+		}
+		
+		if(!found) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+template <typename SymbolType>
+static SourceFileHandle source_file_of(const SymbolType& symbol, const SymbolDatabase& database)
+{
+	if constexpr(std::is_same_v<SymbolType, Function> || std::is_same_v<SymbolType, GlobalVariable>) {
+		return symbol.source_file();
+	} else if constexpr(std::is_same_v<SymbolType, ParameterVariable> || std::is_same_v<SymbolType, LocalVariable>) {
+		const Function* function = database.functions.symbol_from_handle(symbol.function());
+		if(function) {
+			return function->source_file();
+		}
+	} else if constexpr(std::is_same_v<SymbolType, DataType>) {
+		// Data types can be present in multiple files, so just use the first.
+		if(!symbol.files.empty()) {
+			return symbol.files.front();
+		}
+	} else if constexpr(std::is_same_v<SymbolType, SourceFile>) {
+		return symbol.handle();
+	}
+	
+	return SourceFileHandle();
+}
+
+template <typename Handle>
+static bool sorted_contains(const std::vector<Handle>& handles, Handle handle)
+{
+	return std::binary_search(handles.begin(), handles.end(), handle);
+}
+
+// *****************************************************************************
+
+bool glob_match(std::string_view pattern, std::string_view text)
+{
+	size_t p = 0;
+	size_t t = 0;
+	size_t star = std::string_view::npos;
+	size_t star_text = 0;
+	
+	while(t < text.size()) {
+		if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+			p++;
+			t++;
+		} else if(p < pattern.size() && pattern[p] == '*') {
+			star = p++;
+			star_text = t;
+		} else if(star != std::string_view::npos) {
+			// Backtrack and let the last star consume one more character.
+			p = star + 1;
+			t = ++star_text;
+		} else {
+			return false;
+		}
+	}
+	
+	while(p < pattern.size() && pattern[p] == '*') {
+		p++;
+	}
+	
+	return p == pattern.size();
+}
+
+static std::string_view literal_prefix(std::string_view glob)
+{
+	return glob.substr(0, std::min(glob.find_first_of("*?"), glob.size()));
+}
+
+static bool is_glob_literal(std::string_view glob)
+{
+	return glob.find_first_of("*?") == std::string_view::npos;
+}
+
+std::optional<u32> parse_symbol_descriptors(const char* names)
+{
+	u32 descriptors = 0;
+	
+	std::string_view remaining = names;
+	while(!remaining.empty()) {
+		size_t comma = std::min(remaining.find(','), remaining.size());
+		std::string_view name = remaining.substr(0, comma);
+		remaining = remaining.substr(std::min(comma + 1, remaining.size()));
+		
+		u32 descriptor = 0;
+		#define CCC_X(SymbolType, symbol_list) \
+			if(name == #symbol_list) { \
+				descriptor = SymbolType::DESCRIPTOR; \
+			}
+		CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+		#undef CCC_X
+		
+		if(descriptor == 0) {
+			return std::nullopt;
+		}
+		
+		descriptors |= descriptor;
+	}
+	
+	return descriptors;
+}
+
+const char* symbol_descriptor_to_string(SymbolDescriptor descriptor)
+{
+	#define CCC_X(SymbolType, symbol_list) \
+		if(descriptor == SymbolType::DESCRIPTOR) { \
+			return SymbolType::NAME; \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	return "";
+}
+
+std::optional<StorageClass> storage_class_from_string(const char* string)
+{
+	for(s32 storage_class = STORAGE_CLASS_NONE; storage_class <= STORAGE_CLASS_REGISTER; storage_class++) {
+		if(strcmp(string, ast::storage_class_to_string((StorageClass) storage_class)) == 0) {
+			return (StorageClass) storage_class;
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<GlobalStorageLocation> global_storage_location_from_string(const char* string)
+{
+	for(s32 location = NIL; location <= SUNDEFINED; location++) {
+		if(strcmp(string, global_storage_location_to_string((GlobalStorageLocation) location)) == 0) {
+			return (GlobalStorageLocation) location;
+		}
+	}
+	return std::nullopt;
+}
+
+}
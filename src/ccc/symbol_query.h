@@ -0,0 +1,92 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <regex>
+#include <functional>
+
+#include "ast.h"
+
+namespace ccc {
+
+// A set of filters used to search for symbols. Only the symbols that pass all
+// of the filters that have been set will be matched.
+struct SymbolQuery {
+	u32 descriptors = ALL_SYMBOL_TYPES;
+	// A pattern where * matches any sequence of characters and ? matches any
+	// single character.
+	std::string name_glob;
+	std::optional<std::regex> name_regex;
+	std::string module_name;
+	std::string source_name;
+	// Matched against the full path of the source file the symbol belongs to.
+	std::string source_file_glob;
+	// The starting address of the symbol must be inside this range. Either
+	// bound can be left invalid.
+	AddressRange address_range;
+	std::optional<u32> min_size;
+	std::optional<u32> max_size;
+	std::optional<StorageClass> storage_class;
+	std::optional<GlobalStorageLocation> storage_location;
+	// Only match symbols with types that reference a data type with this name,
+	// for example "CEntity" will match a variable of type CEntity*.
+	std::string referenced_type_name;
+	
+	Result<void> set_name_regex(const std::string& pattern);
+};
+
+// How the candidate symbols for a given symbol list are found, from most to
+// least selective.
+enum class SymbolQueryPlan {
+	NAME_MAP,
+	TYPE_REFERENCES,
+	MODULE,
+	ADDRESS_MAP,
+	NAME_PREFIX,
+	SCAN
+};
+
+const char* symbol_query_plan_to_string(SymbolQueryPlan plan);
+
+// Maps data types to the symbols with types that reference them. This must be
+// rebuilt if the symbol database is modified.
+class TypeReferenceIndex {
+public:
+	void build(const SymbolDatabase& database);
+	
+	// Sorted by descriptor, then by handle.
+	std::span<const MultiSymbolHandle> symbols_referencing(DataTypeHandle data_type) const;
+	
+protected:
+	std::vector<DataTypeHandle> m_data_types;
+	std::vector<MultiSymbolHandle> m_symbols; // Parallel to m_data_types.
+};
+
+using SymbolQueryCallback = std::function<void(const Symbol& symbol, SymbolDescriptor descriptor)>;
+
+// Choose how to find the candidate symbols of a given type.
+SymbolQueryPlan plan_symbol_query(const SymbolQuery& query, SymbolDescriptor descriptor, bool has_type_references);
+
+// Call the callback for each symbol that matches the query, grouped by symbol
+// type. The type reference index is optional, and is only used to speed up
+// queries that filter by referenced type.
+void run_symbol_query(
+	const SymbolDatabase& database,
+	const SymbolQuery& query,
+	const TypeReferenceIndex* type_references,
+	const SymbolQueryCallback& callback);
+
+// Match a string against a pattern where * matches any sequence of characters
+// and ? matches any single character.
+bool glob_match(std::string_view pattern, std::string_view text);
+
+// Parse a comma separated list of symbol list names e.g. "functions,labels".
+std::optional<u32> parse_symbol_descriptors(const char* names);
+
+const char* symbol_descriptor_to_string(SymbolDescriptor descriptor);
+
+std::optional<StorageClass> storage_class_from_string(const char* string);
+std::optional<GlobalStorageLocation> global_storage_location_from_string(const char* string);
+
+}
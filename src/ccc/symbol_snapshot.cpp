@@ -0,0 +1,209 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "symbol_snapshot.h"
+
+#include <algorithm>
+
+namespace ccc {
+
+s32 SymbolDatabaseSnapshot::symbol_count() const
+{
+	s32 sum = 0;
+	for(const std::shared_ptr<const SymbolDatabase>& database : m_databases) {
+		sum += database->symbol_count();
+	}
+	for(const std::shared_ptr<const SymbolDatabase>& database : m_symbol_sources) {
+		sum += database->symbol_count();
+	}
+	return sum;
+}
+
+const SymbolDatabase* SymbolDatabaseSnapshot::database_containing(MultiSymbolHandle handle) const
+{
+	const SymbolDatabase* result = nullptr;
+	search([&](const SymbolDatabase& database) -> const Symbol* {
+		const Symbol* symbol = handle.lookup_symbol(database);
+		if(symbol) {
+			result = &database;
+		}
+		return symbol;
+	});
+	return result;
+}
+
+const Symbol* SymbolDatabaseSnapshot::lookup_symbol(MultiSymbolHandle handle) const
+{
+	return search([&](const SymbolDatabase& database) {
+		return handle.lookup_symbol(database);
+	});
+}
+
+const Symbol* SymbolDatabaseSnapshot::symbol_starting_at_address(
+	Address address, u32 descriptors, SymbolDescriptor* descriptor_out) const
+{
+	return search([&](const SymbolDatabase& database) {
+		return database.symbol_starting_at_address(address, descriptors, descriptor_out);
+	});
+}
+
+const Symbol* SymbolDatabaseSnapshot::symbol_overlapping_address(
+	Address address, u32 descriptors, SymbolDescriptor* descriptor_out) const
+{
+	return search([&](const SymbolDatabase& database) {
+		return database.symbol_overlapping_address(address, descriptors, descriptor_out);
+	});
+}
+
+const Symbol* SymbolDatabaseSnapshot::symbol_with_name(
+	const std::string& name, u32 descriptors, SymbolDescriptor* descriptor_out) const
+{
+	return search([&](const SymbolDatabase& database) {
+		return database.symbol_with_name(name, descriptors, descriptor_out);
+	});
+}
+
+template <typename Callback>
+const Symbol* SymbolDatabaseSnapshot::search(Callback callback) const
+{
+	for(const std::shared_ptr<const SymbolDatabase>& database : m_databases) {
+		const Symbol* symbol = callback(*database);
+		if(symbol) {
+			return symbol;
+		}
+	}
+	for(const std::shared_ptr<const SymbolDatabase>& database : m_symbol_sources) {
+		const Symbol* symbol = callback(*database);
+		if(symbol) {
+			return symbol;
+		}
+	}
+	return nullptr;
+}
+
+// *****************************************************************************
+
+SymbolSnapshotPublisher::SymbolSnapshotPublisher()
+{
+	m_snapshot.store(std::make_shared<const SymbolDatabaseSnapshot>());
+}
+
+std::shared_ptr<const SymbolDatabaseSnapshot> SymbolSnapshotPublisher::snapshot() const
+{
+	return m_snapshot.load(std::memory_order_acquire);
+}
+
+void SymbolSnapshotPublisher::prepare_database(SymbolDatabase& database) const
+{
+	database.set_handle_blocks(m_free_handles);
+}
+
+Result<std::shared_ptr<const SymbolDatabase>> SymbolSnapshotPublisher::publish(SymbolDatabase database)
+{
+	CCC_CHECK(!database.in_transaction(), "Cannot publish a symbol database with a transaction in progress.");
+	
+	// Make sure the handles don't collide with those of a database that has
+	// already been published.
+	#define CCC_X(SymbolType, symbol_list) \
+		CCC_CHECK(database.symbol_list.empty() \
+			|| database.symbol_list.symbol_from_index(0).raw_handle() >= m_free_handles.symbol_list.begin, \
+			"Cannot publish %s symbols with handles that may already be in use.", SymbolType::NAME);
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	// Give the handles that weren't used back so the next database can use
+	// them.
+	#define CCC_X(SymbolType, symbol_list) \
+		m_free_handles.symbol_list.begin = std::max( \
+			m_free_handles.symbol_list.begin, database.symbol_list.handle_block().begin);
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	std::shared_ptr<const SymbolDatabaseSnapshot> previous = snapshot();
+	std::vector<std::shared_ptr<const SymbolDatabase>> symbol_sources = previous->symbol_sources();
+	
+	Result<std::shared_ptr<const SymbolDatabase>> new_sources = share_symbol_sources(database);
+	CCC_RETURN_IF_ERROR(new_sources);
+	if(*new_sources) {
+		symbol_sources.emplace_back(std::move(*new_sources));
+	}
+	
+	std::shared_ptr<const SymbolDatabase> published = std::make_shared<const SymbolDatabase>(std::move(database));
+	
+	std::vector<std::shared_ptr<const SymbolDatabase>> databases = previous->databases();
+	databases.emplace_back(published);
+	store(std::move(databases), std::move(symbol_sources));
+	
+	return published;
+}
+
+bool SymbolSnapshotPublisher::unpublish(const SymbolDatabase* database)
+{
+	std::shared_ptr<const SymbolDatabaseSnapshot> previous = snapshot();
+	std::vector<std::shared_ptr<const SymbolDatabase>> databases = previous->databases();
+	
+	auto iterator = std::find_if(databases.begin(), databases.end(),
+		[&](const std::shared_ptr<const SymbolDatabase>& published) { return published.get() == database; });
+	if(iterator == databases.end()) {
+		return false;
+	}
+	
+	// The symbol sources are kept since they may be shared with other
+	// databases.
+	databases.erase(iterator);
+	store(std::move(databases), previous->symbol_sources());
+	
+	return true;
+}
+
+Result<std::shared_ptr<const SymbolDatabase>> SymbolSnapshotPublisher::share_symbol_sources(SymbolDatabase& database)
+{
+	std::unique_ptr<SymbolDatabase> new_sources;
+	SymbolHandleRemap remap;
+	
+	for(const SymbolSource& source : database.symbol_sources) {
+		auto shared = m_shared_sources.find(source.name());
+		if(shared != m_shared_sources.end()) {
+			remap.add(SymbolSource::DESCRIPTOR, source.raw_handle(), shared->second.value);
+		} else {
+			// Recreate the symbol source in a separate database, keeping its
+			// handle so the symbols that reference it don't have to change.
+			if(!new_sources) {
+				new_sources = std::make_unique<SymbolDatabase>();
+			}
+			
+			new_sources->symbol_sources.set_handle_block({source.raw_handle(), source.raw_handle() + 1});
+			Result<SymbolSource*> new_source = new_sources->symbol_sources.create_symbol(
+				source.name(), SymbolSourceHandle(), nullptr);
+			CCC_RETURN_IF_ERROR(new_source);
+		}
+	}
+	
+	if(new_sources) {
+		for(const SymbolSource& source : new_sources->symbol_sources) {
+			m_shared_sources.emplace(source.name(), source.handle());
+		}
+	}
+	
+	database.symbol_sources.clear();
+	
+	if(!remap.empty()) {
+		database.remap_handles(remap);
+	}
+	
+	return std::shared_ptr<const SymbolDatabase>(std::move(new_sources));
+}
+
+void SymbolSnapshotPublisher::store(
+	std::vector<std::shared_ptr<const SymbolDatabase>> databases,
+	std::vector<std::shared_ptr<const SymbolDatabase>> symbol_sources)
+{
+	std::shared_ptr<SymbolDatabaseSnapshot> next = std::make_shared<SymbolDatabaseSnapshot>();
+	next->m_version = snapshot()->version() + 1;
+	next->m_databases = std::move(databases);
+	next->m_symbol_sources = std::move(symbol_sources);
+	
+	m_snapshot.store(std::move(next), std::memory_order_release);
+}
+
+}
@@ -0,0 +1,110 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <map>
+
+#include "ast.h"
+
+namespace ccc {
+
+// An immutable view of a set of symbol databases that have been published
+// together. Since nothing in a snapshot can change, any number of threads can
+// query it at the same time without synchronising with each other or with the
+// writer. The handles of the symbols in the different databases never overlap,
+// so a handle identifies a single symbol across the whole snapshot.
+class SymbolDatabaseSnapshot {
+	friend class SymbolSnapshotPublisher;
+public:
+	// Incremented each time a new snapshot is published.
+	u64 version() const { return m_version; }
+	
+	// The databases in the order they were published.
+	const std::vector<std::shared_ptr<const SymbolDatabase>>& databases() const { return m_databases; }
+	
+	// Databases containing only the symbol sources, which are shared between
+	// all the published databases. These are searched after the databases
+	// above.
+	const std::vector<std::shared_ptr<const SymbolDatabase>>& symbol_sources() const { return m_symbol_sources; }
+	
+	// Sum up the symbol counts for each database, including the symbol sources.
+	s32 symbol_count() const;
+	
+	// Find the database that owns a given symbol.
+	const SymbolDatabase* database_containing(MultiSymbolHandle handle) const;
+	
+	const Symbol* lookup_symbol(MultiSymbolHandle handle) const;
+	
+	template <typename SymbolType>
+	const SymbolType* symbol_from_handle(SymbolHandle<SymbolType> handle) const
+	{
+		return static_cast<const SymbolType*>(lookup_symbol(MultiSymbolHandle(SymbolType::DESCRIPTOR, handle.value)));
+	}
+	
+	// Same as the functions on SymbolDatabase, except that all the databases
+	// are searched, in the order they were published.
+	const Symbol* symbol_starting_at_address(
+		Address address, u32 descriptors = ALL_SYMBOL_TYPES, SymbolDescriptor* descriptor_out = nullptr) const;
+	const Symbol* symbol_overlapping_address(
+		Address address, u32 descriptors = ALL_SYMBOL_TYPES, SymbolDescriptor* descriptor_out = nullptr) const;
+	const Symbol* symbol_with_name(
+		const std::string& name, u32 descriptors = ALL_SYMBOL_TYPES, SymbolDescriptor* descriptor_out = nullptr) const;
+	
+protected:
+	template <typename Callback>
+	const Symbol* search(Callback callback) const;
+	
+	u64 m_version = 0;
+	std::vector<std::shared_ptr<const SymbolDatabase>> m_databases;
+	std::vector<std::shared_ptr<const SymbolDatabase>> m_symbol_sources;
+};
+
+// Publishes snapshots of symbol databases so that reader threads (for example
+// a symbol browser) can keep answering queries while symbols are being
+// imported on another thread.
+//
+// The writer imports symbols into a separate database that was prepared by
+// calling prepare_database, and then publishes it. Readers that grab a
+// snapshot before that point keep seeing the old set of databases for as long
+// as they hold on to it. All the functions except snapshot must only be called
+// from a single writer thread.
+class SymbolSnapshotPublisher {
+public:
+	SymbolSnapshotPublisher();
+	
+	// Get the latest snapshot. This is safe to call from any thread. Note that
+	// std::atomic<std::shared_ptr> isn't lock-free on all standard libraries,
+	// so this may briefly contend with a concurrent publish, but it never
+	// waits for an import to finish.
+	std::shared_ptr<const SymbolDatabaseSnapshot> snapshot() const;
+	
+	// Set the handle blocks of a new, empty database such that the handles it
+	// allocates won't collide with those from any published database.
+	void prepare_database(SymbolDatabase& database) const;
+	
+	// Make a database visible to readers. It must have been prepared using
+	// the function above and must not be in the middle of a transaction. Its
+	// symbol sources are moved out into the shared list of symbol sources, and
+	// where a source with the same name has already been published the symbols
+	// are pointed at that instead, so each source is only stored once.
+	Result<std::shared_ptr<const SymbolDatabase>> publish(SymbolDatabase database);
+	
+	// Stop a database from being visible to readers, for example when a module
+	// is unloaded. Readers that already have a snapshot containing it can keep
+	// using it until they release the snapshot.
+	bool unpublish(const SymbolDatabase* database);
+	
+protected:
+	Result<std::shared_ptr<const SymbolDatabase>> share_symbol_sources(SymbolDatabase& database);
+	void store(
+		std::vector<std::shared_ptr<const SymbolDatabase>> databases,
+		std::vector<std::shared_ptr<const SymbolDatabase>> symbol_sources);
+	
+	std::atomic<std::shared_ptr<const SymbolDatabaseSnapshot>> m_snapshot;
+	SymbolDatabaseHandleBlocks m_free_handles;
+	std::map<std::string, SymbolSourceHandle> m_shared_sources;
+};
+
+}
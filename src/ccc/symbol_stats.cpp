@@ -0,0 +1,278 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "symbol_stats.h"
+
+#include <unordered_set>
+
+namespace ccc {
+
+// The size of the left, right and parent pointers plus the colour of a node in
+// a red-black tree, rounded up.
+static const u64 MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+struct StatsState {
+	SymbolDatabaseStats& output;
+	std::unordered_set<const std::string*> seen_strings;
+	std::map<SymbolSourceHandle, SymbolOwnerStats> sources;
+	std::map<ModuleHandle, SymbolOwnerStats> modules;
+};
+
+template <typename SymbolType>
+static void compute_symbol_list_stats(
+	const SymbolList<SymbolType>& list, SymbolListStats& output, StatsState& state);
+template <typename SymbolType>
+static u64 symbol_heap_bytes(const SymbolType& symbol, SymbolListStats& output, StatsState& state);
+static u64 node_bytes(const ast::Node& node, SymbolListStats& output, StatsState& state);
+static u64 string_bytes(const std::string& string, SymbolListStats& output, StatsState& state);
+template <typename Element>
+static u64 vector_bytes(const std::vector<Element>& vector);
+
+u64 SymbolListStats::total_bytes() const
+{
+	return records.bytes
+		+ address_map.bytes
+		+ name_map.bytes
+		+ module_map.bytes
+		+ strings.bytes
+		+ ast_nodes.bytes
+		+ other.bytes;
+}
+
+u64 SymbolDatabaseStats::total_bytes() const
+{
+	u64 total = 0;
+	for(const SymbolListStats& list : symbol_lists) {
+		total += list.total_bytes();
+	}
+	return total;
+}
+
+SymbolDatabaseStats compute_symbol_database_stats(const SymbolDatabase& database)
+{
+	SymbolDatabaseStats stats;
+	StatsState state{stats};
+	
+	#define CCC_X(SymbolType, symbol_list) \
+		{ \
+			SymbolListStats& list_stats = stats.symbol_lists.emplace_back(); \
+			list_stats.descriptor = SymbolType::DESCRIPTOR; \
+			list_stats.name = SymbolType::NAME; \
+			compute_symbol_list_stats(database.symbol_list, list_stats, state); \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	for(auto& [handle, source] : state.sources) {
+		if(const SymbolSource* symbol_source = database.symbol_sources.symbol_from_handle(handle)) {
+			source.name = symbol_source->name();
+		}
+		stats.sources.emplace_back(std::move(source));
+	}
+	
+	for(auto& [handle, module] : state.modules) {
+		if(const Module* module_symbol = database.modules.symbol_from_handle(handle)) {
+			module.name = module_symbol->name();
+		}
+		stats.modules.emplace_back(std::move(module));
+	}
+	
+	stats.string_pool = string_pool_stats();
+	
+	return stats;
+}
+
+const char* node_descriptor_to_string(ast::NodeDescriptor descriptor)
+{
+	switch(descriptor) {
+		case ast::ARRAY: return "array";
+		case ast::BITFIELD: return "bitfield";
+		case ast::BUILTIN: return "builtin";
+		case ast::ENUM: return "enum";
+		case ast::ERROR_NODE: return "error";
+		case ast::FUNCTION: return "function";
+		case ast::POINTER_OR_REFERENCE: return "pointer_or_reference";
+		case ast::POINTER_TO_DATA_MEMBER: return "pointer_to_data_member";
+		case ast::STRUCT_OR_UNION: return "struct_or_union";
+		case ast::TYPE_NAME: return "type_name";
+	}
+	return "";
+}
+
+template <typename SymbolType>
+static void compute_symbol_list_stats(
+	const SymbolList<SymbolType>& list, SymbolListStats& output, StatsState& state)
+{
+	SymbolListContainerSizes sizes = list.container_sizes();
+	
+	using Handle = SymbolHandle<SymbolType>;
+	output.records.add(sizes.symbols, (sizes.symbol_capacity + sizes.graveyard_capacity) * sizeof(SymbolType));
+	output.address_map.add(sizes.address_map, sizes.address_map * (sizeof(std::pair<const u32, Handle>) + MAP_NODE_OVERHEAD));
+	output.name_map.add(sizes.name_map, sizes.name_map * (sizeof(std::pair<const std::string_view, Handle>) + MAP_NODE_OVERHEAD));
+	output.module_map.add(sizes.module_handle_capacity,
+		sizes.modules * (sizeof(std::pair<const ModuleHandle, std::vector<Handle>>) + MAP_NODE_OVERHEAD)
+		+ sizes.module_handle_capacity * sizeof(Handle));
+	output.other.bytes += sizes.changes_capacity * sizeof(SymbolChange);
+	
+	for(const SymbolType& symbol : list) {
+		u64 bytes = sizeof(SymbolType) + symbol_heap_bytes(symbol, output, state);
+		
+		SymbolOwnerStats& source = state.sources[symbol.source()];
+		source.handle = symbol.source().value;
+		source.symbol_count++;
+		source.bytes += bytes;
+		
+		if(symbol.module_handle().valid()) {
+			SymbolOwnerStats& module = state.modules[symbol.module_handle()];
+			module.handle = symbol.module_handle().value;
+			module.symbol_count++;
+			module.bytes += bytes;
+		}
+	}
+}
+
+template <typename SymbolType>
+static u64 symbol_heap_bytes(const SymbolType& symbol, SymbolListStats& output, StatsState& state)
+{
+	u64 bytes = string_bytes(symbol.name(), output, state);
+	
+	if(symbol.type()) {
+		u64 ast_bytes = 0;
+		ast::for_each_node(*symbol.type(), ast::PREORDER_TRAVERSAL, [&](const ast::Node& node) {
+			ast_bytes += node_bytes(node, output, state);
+			return ast::EXPLORE_CHILDREN;
+		});
+		bytes += ast_bytes;
+	}
+	
+	u64 other_bytes = 0;
+	if constexpr(std::is_same_v<SymbolType, DataType>) {
+		other_bytes += vector_bytes(symbol.files);
+	} else if constexpr(std::is_same_v<SymbolType, Function>) {
+		bytes += string_bytes(symbol.mangled_name(), output, state);
+		bytes += string_bytes(symbol.relative_path, output, state);
+		for(const Function::SubSourceFile& sub_source_file : symbol.sub_source_files) {
+			bytes += string_bytes(sub_source_file.relative_path, output, state);
+		}
+		other_bytes += vector_bytes(symbol.line_numbers);
+		other_bytes += vector_bytes(symbol.sub_source_files);
+		if(symbol.parameter_variables().has_value()) {
+			other_bytes += vector_bytes(*symbol.parameter_variables());
+		}
+		if(symbol.local_variables().has_value()) {
+			other_bytes += vector_bytes(*symbol.local_variables());
+		}
+	} else if constexpr(std::is_same_v<SymbolType, GlobalVariable>) {
+		bytes += string_bytes(symbol.mangled_name(), output, state);
+	} else if constexpr(std::is_same_v<SymbolType, SourceFile>) {
+		bytes += string_bytes(symbol.working_dir, output, state);
+		bytes += string_bytes(symbol.command_line_path, output, state);
+		other_bytes += vector_bytes(symbol.functions());
+		other_bytes += vector_bytes(symbol.global_variables());
+		using StabsElement = std::pair<const StabsTypeNumber, DataTypeHandle>;
+		other_bytes += symbol.stabs_type_number_to_handle.size() * (sizeof(StabsElement) + MAP_NODE_OVERHEAD);
+		for(const std::string& version_info : symbol.toolchain_version_info) {
+			other_bytes += sizeof(std::string) + MAP_NODE_OVERHEAD + version_info.capacity() + 1;
+		}
+	}
+	output.other.bytes += other_bytes;
+	
+	return bytes + other_bytes;
+}
+
+static u64 node_bytes(const ast::Node& node, SymbolListStats& output, StatsState& state)
+{
+	u64 bytes = 0;
+	switch(node.descriptor) {
+		case ast::ARRAY: {
+			bytes += sizeof(ast::Array);
+			break;
+		}
+		case ast::BITFIELD: {
+			bytes += sizeof(ast::BitField);
+			break;
+		}
+		case ast::BUILTIN: {
+			bytes += sizeof(ast::BuiltIn);
+			break;
+		}
+		case ast::ENUM: {
+			const ast::Enum& enumeration = node.as<ast::Enum>();
+			bytes += sizeof(ast::Enum);
+			bytes += vector_bytes(enumeration.constants);
+			for(const auto& [value, name] : enumeration.constants) {
+				if(name.capacity() > std::string().capacity()) {
+					bytes += name.capacity() + 1;
+				}
+			}
+			break;
+		}
+		case ast::ERROR_NODE: {
+			const ast::Error& error = node.as<ast::Error>();
+			bytes += sizeof(ast::Error);
+			if(error.message.capacity() > std::string().capacity()) {
+				bytes += error.message.capacity() + 1;
+			}
+			break;
+		}
+		case ast::FUNCTION: {
+			const ast::Function& function = node.as<ast::Function>();
+			bytes += sizeof(ast::Function);
+			if(function.parameters.has_value()) {
+				bytes += vector_bytes(*function.parameters);
+			}
+			break;
+		}
+		case ast::POINTER_OR_REFERENCE: {
+			bytes += sizeof(ast::PointerOrReference);
+			break;
+		}
+		case ast::POINTER_TO_DATA_MEMBER: {
+			bytes += sizeof(ast::PointerToDataMember);
+			break;
+		}
+		case ast::STRUCT_OR_UNION: {
+			const ast::StructOrUnion& struct_or_union = node.as<ast::StructOrUnion>();
+			bytes += sizeof(ast::StructOrUnion);
+			bytes += vector_bytes(struct_or_union.base_classes);
+			bytes += vector_bytes(struct_or_union.fields);
+			bytes += vector_bytes(struct_or_union.member_functions);
+			break;
+		}
+		case ast::TYPE_NAME: {
+			const ast::TypeName& type_name = node.as<ast::TypeName>();
+			bytes += sizeof(ast::TypeName);
+			if(type_name.unresolved_stabs) {
+				bytes += sizeof(ast::TypeName::UnresolvedStabs);
+				if(type_name.unresolved_stabs->type_name.capacity() > std::string().capacity()) {
+					bytes += type_name.unresolved_stabs->type_name.capacity() + 1;
+				}
+			}
+			break;
+		}
+	}
+	
+	output.ast_nodes.add(1, bytes);
+	state.output.ast_nodes[node.descriptor].add(1, bytes);
+	
+	return bytes + string_bytes(node.name, output, state);
+}
+
+static u64 string_bytes(const std::string& string, SymbolListStats& output, StatsState& state)
+{
+	if(string.empty() || !state.seen_strings.emplace(&string).second) {
+		return 0;
+	}
+	
+	u64 bytes = sizeof(std::string) + string.size();
+	output.strings.add(1, bytes);
+	return bytes;
+}
+
+template <typename Element>
+static u64 vector_bytes(const std::vector<Element>& vector)
+{
+	return vector.capacity() * sizeof(Element);
+}
+
+}
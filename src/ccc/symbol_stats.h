@@ -0,0 +1,68 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "ast.h"
+
+namespace ccc {
+
+struct MemoryUsage {
+	u64 count = 0;
+	u64 bytes = 0;
+	
+	void add(u64 extra_count, u64 extra_bytes) { count += extra_count; bytes += extra_bytes; }
+	
+	MemoryUsage& operator+=(const MemoryUsage& rhs) { add(rhs.count, rhs.bytes); return *this; }
+};
+
+// The memory used by a single symbol list. Heap allocations are counted using
+// the number of bytes requested, so allocator overhead isn't included, and map
+// nodes are assumed to be red-black tree nodes with three pointers and a colour.
+struct SymbolListStats {
+	SymbolDescriptor descriptor;
+	const char* name;
+	// The symbol objects themselves, including unused capacity.
+	MemoryUsage records;
+	MemoryUsage address_map;
+	MemoryUsage name_map;
+	MemoryUsage module_map;
+	// Interned strings are shared, so each string is counted against the
+	// first symbol list that references it.
+	MemoryUsage strings;
+	MemoryUsage ast_nodes;
+	// Other heap allocations owned by the symbols, for example line numbers.
+	MemoryUsage other;
+	
+	u64 total_bytes() const;
+};
+
+// The memory used by the symbols from a single symbol source or module.
+struct SymbolOwnerStats {
+	RawSymbolHandle handle = NULL_SYMBOL_HANDLE;
+	std::string name;
+	u64 symbol_count = 0;
+	u64 bytes = 0;
+};
+
+static const constexpr s32 AST_NODE_DESCRIPTOR_COUNT = ast::TYPE_NAME + 1;
+
+struct SymbolDatabaseStats {
+	std::vector<SymbolListStats> symbol_lists;
+	std::array<MemoryUsage, AST_NODE_DESCRIPTOR_COUNT> ast_nodes; // Indexed by NodeDescriptor.
+	std::vector<SymbolOwnerStats> sources;
+	std::vector<SymbolOwnerStats> modules;
+	// The global string pool may also contain strings that aren't referenced
+	// by this symbol database.
+	StringPoolStats string_pool;
+	
+	u64 total_bytes() const;
+};
+
+// Work out how much memory is being used by a symbol database, and what it is
+// being used for. This walks over every symbol and AST node once.
+SymbolDatabaseStats compute_symbol_database_stats(const SymbolDatabase& database);
+
+const char* node_descriptor_to_string(ast::NodeDescriptor descriptor);
+
+}
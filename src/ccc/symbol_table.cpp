@@ -3,10 +3,13 @@
 
 #include "symbol_table.h"
 
+#include <thread>
+
 #include "elf.h"
 #include "elf_symtab.h"
 #include "mdebug_importer.h"
 #include "mdebug_section.h"
+#include "profiler.h"
 #include "sndll.h"
 
 namespace ccc {
@@ -106,11 +109,20 @@ Result<ModuleHandle> import_symbol_tables(
 	DemanglerFunctions demangler,
 	const std::atomic_bool* interrupt)
 {
+	// If anything goes wrong, undo all the changes made to the database.
+	database.begin_transaction();
+	
 	Result<SymbolSourceHandle> module_source = database.get_symbol_source("Symbol Table Importer");
-	CCC_RETURN_IF_ERROR(module_source);
+	if(!module_source.success()) {
+		database.rollback_transaction();
+		return module_source;
+	}
 	
 	Result<Module*> module_symbol = database.modules.create_symbol(std::move(module_name), *module_source, nullptr);
-	CCC_RETURN_IF_ERROR(module_symbol);
+	if(!module_symbol.success()) {
+		database.rollback_transaction();
+		return module_symbol;
+	}
 	
 	ModuleHandle module_handle = (*module_symbol)->handle();
 	
@@ -119,7 +131,7 @@ Result<ModuleHandle> import_symbol_tables(
 		// doesn't already exist.
 		Result<SymbolSourceHandle> source = database.get_symbol_source(symbol_table->name());
 		if(!source.success()) {
-			database.destroy_symbols_from_module(module_handle, false);
+			database.rollback_transaction();
 			return source;
 		}
 		
@@ -128,17 +140,124 @@ Result<ModuleHandle> import_symbol_tables(
 		group.source = *source;
 		group.module_symbol = database.modules.symbol_from_handle(module_handle);
 		
+		ProfileScope profile(ProfilePhase::IMPORT_SYMBOL_TABLE, symbol_table->name());
 		Result<void> result = symbol_table->import(
 			database, group, importer_flags, demangler, interrupt);
 		if(!result.success()) {
-			database.destroy_symbols_from_module(module_handle, false);
+			database.rollback_transaction();
+			return result;
+		}
+	}
+	
+	database.commit_transaction();
+	
+	return module_handle;
+}
+
+Result<ModuleHandle> import_symbol_tables_pipelined(
+	SymbolDatabase& database,
+	std::string module_name,
+	const std::vector<std::unique_ptr<SymbolTable>>& symbol_tables,
+	u32 importer_flags,
+	DemanglerFunctions demangler,
+	const std::atomic_bool* interrupt)
+{
+	// Start parsing all the symbol tables that support staging. This doesn't
+	// touch the database, so it can run alongside the main import.
+	std::vector<std::optional<Result<std::vector<StagedSymbol>>>> staged(symbol_tables.size());
+	std::vector<std::thread> threads(symbol_tables.size());
+	for(size_t i = 0; i < symbol_tables.size(); i++) {
+		if(symbol_tables[i]->supports_staging()) {
+			threads[i] = std::thread([&, i]() {
+				if(interrupt && *interrupt) {
+					staged[i] = CCC_FAILURE("Operation interrupted by user.");
+					return;
+				}
+				
+				ProfileScope profile(ProfilePhase::STAGE_SYMBOLS, symbol_tables[i]->name());
+				staged[i] = symbol_tables[i]->stage(importer_flags, demangler);
+			});
+		}
+	}
+	
+	auto join_all = [&]() {
+		for(std::thread& thread : threads) {
+			if(thread.joinable()) {
+				thread.join();
+			}
+		}
+	};
+	
+	database.begin_transaction();
+	
+	Result<SymbolSourceHandle> module_source = database.get_symbol_source("Symbol Table Importer");
+	if(!module_source.success()) {
+		join_all();
+		database.rollback_transaction();
+		return module_source;
+	}
+	
+	Result<Module*> module_symbol = database.modules.create_symbol(std::move(module_name), *module_source, nullptr);
+	if(!module_symbol.success()) {
+		join_all();
+		database.rollback_transaction();
+		return module_symbol;
+	}
+	
+	ModuleHandle module_handle = (*module_symbol)->handle();
+	
+	// Insert the symbols in priority order, since the deduplication logic
+	// depends on which symbols have already been imported.
+	for(size_t i = 0; i < symbol_tables.size(); i++) {
+		if(interrupt && *interrupt) {
+			join_all();
+			database.rollback_transaction();
+			return CCC_FAILURE("Operation interrupted by user.");
+		}
+		
+		Result<SymbolSourceHandle> source = database.get_symbol_source(symbol_tables[i]->name());
+		if(!source.success()) {
+			join_all();
+			database.rollback_transaction();
+			return source;
+		}
+		
+		SymbolGroup group;
+		group.source = *source;
+		group.module_symbol = database.modules.symbol_from_handle(module_handle);
+		
+		ProfileScope profile(ProfilePhase::IMPORT_SYMBOL_TABLE, symbol_tables[i]->name());
+		Result<void> result;
+		if(threads[i].joinable()) {
+			threads[i].join();
+			CCC_ASSERT(staged[i].has_value());
+			if(staged[i]->success()) {
+				result = insert_staged_symbols(database, group, **staged[i], importer_flags);
+			} else {
+				result = std::move(*staged[i]);
+			}
+			staged[i].reset();
+		} else {
+			result = symbol_tables[i]->import(database, group, importer_flags, demangler, interrupt);
+		}
+		
+		if(!result.success()) {
+			join_all();
+			database.rollback_transaction();
 			return result;
 		}
 	}
 	
+	database.commit_transaction();
+	
 	return module_handle;
 }
 
+Result<std::vector<StagedSymbol>> SymbolTable::stage(u32 importer_flags, DemanglerFunctions demangler) const
+{
+	return CCC_FAILURE("Symbol table '%s' does not support staging.", name());
+}
+
 // *****************************************************************************
 
 MdebugSymbolTable::MdebugSymbolTable(std::span<const u8> image, s32 section_offset)
@@ -205,6 +324,11 @@ Result<void> SymtabSymbolTable::import(
 	return elf::import_symbols(database, group, m_symtab, m_strtab, importer_flags, demangler);
 }
 
+Result<std::vector<StagedSymbol>> SymtabSymbolTable::stage(u32 importer_flags, DemanglerFunctions demangler) const
+{
+	return elf::stage_symbols(m_symtab, m_strtab, importer_flags, demangler);
+}
+
 Result<void> SymtabSymbolTable::print_headers(FILE* out) const
 {
 	return Result<void>();
@@ -238,6 +362,11 @@ Result<void> SNDLLSymbolTable::import(
 	return import_sndll_symbols(database, *m_sndll, group, importer_flags, demangler);
 }
 
+Result<std::vector<StagedSymbol>> SNDLLSymbolTable::stage(u32 importer_flags, DemanglerFunctions demangler) const
+{
+	return stage_sndll_symbols(*m_sndll, importer_flags, demangler);
+}
+
 Result<void> SNDLLSymbolTable::print_headers(FILE* out) const
 {
 	return Result<void>();
@@ -50,6 +50,13 @@ public:
 		DemanglerFunctions demangler,
 		const std::atomic_bool* interrupt) const = 0;
 	
+	// Some symbol tables can be parsed into a list of staged symbols without
+	// accessing the database, which can then be inserted later. This is used
+	// to parse them on a separate thread while other symbol tables are being
+	// imported. Only call stage if supports_staging returns true.
+	virtual bool supports_staging() const { return false; }
+	virtual Result<std::vector<StagedSymbol>> stage(u32 importer_flags, DemanglerFunctions demangler) const;
+	
 	// Print out all the field in the header structure if one exists.
 	virtual Result<void> print_headers(FILE* out) const = 0;
 	
@@ -68,7 +75,8 @@ Result<std::unique_ptr<SymbolTable>> create_elf_symbol_table(
 	const ElfSection& section, const ElfFile& elf, SymbolTableFormat format);
 
 // Utility function to call import_symbol_table on all the passed symbol tables
-// and to generate a module handle.
+// and to generate a module handle. The import is done inside a transaction, so
+// if it fails the database is left as it was.
 Result<ModuleHandle> import_symbol_tables(
 	SymbolDatabase& database,
 	std::string module_name,
@@ -77,6 +85,18 @@ Result<ModuleHandle> import_symbol_tables(
 	DemanglerFunctions demangler,
 	const std::atomic_bool* interrupt);
 
+// Same as above, except the symbol tables that support staging are parsed on
+// worker threads while the others are being imported. The symbols are still
+// inserted in the order the symbol tables were passed in, so the result is
+// identical to that of import_symbol_tables.
+Result<ModuleHandle> import_symbol_tables_pipelined(
+	SymbolDatabase& database,
+	std::string module_name,
+	const std::vector<std::unique_ptr<SymbolTable>>& symbol_tables,
+	u32 importer_flags,
+	DemanglerFunctions demangler,
+	const std::atomic_bool* interrupt);
+
 class MdebugSymbolTable : public SymbolTable {
 public:
 	MdebugSymbolTable(std::span<const u8> image, s32 section_offset);
@@ -111,6 +131,9 @@ public:
 		DemanglerFunctions demangler,
 		const std::atomic_bool* interrupt) const override;
 	
+	bool supports_staging() const override { return true; }
+	Result<std::vector<StagedSymbol>> stage(u32 importer_flags, DemanglerFunctions demangler) const override;
+	
 	Result<void> print_headers(FILE* out) const override;
 	Result<void> print_symbols(FILE* out, u32 flags) const override;
 	
@@ -134,6 +157,9 @@ public:
 		DemanglerFunctions demangler,
 		const std::atomic_bool* interrupt) const override;
 	
+	bool supports_staging() const override { return true; }
+	Result<std::vector<StagedSymbol>> stage(u32 importer_flags, DemanglerFunctions demangler) const override;
+	
 	Result<void> print_headers(FILE* out) const override;
 	Result<void> print_symbols(FILE* out, u32 flags) const override;
 	
@@ -3,6 +3,8 @@
 
 #include "util.h"
 
+#include <thread>
+
 namespace ccc {
 
 static CustomErrorCallback custom_error_callback = nullptr;
@@ -170,4 +172,39 @@ std::string extract_file_name(const std::string& path)
 	}
 }
 
+void parallel_for(s32 count, s32 thread_count, const std::function<void(s32 index, s32 thread)>& callback)
+{
+	// Don't bother spinning up threads for small workloads.
+	thread_count = std::max(std::min(resolve_thread_count(thread_count), count / 64), 1);
+	if(thread_count == 1) {
+		for(s32 i = 0; i < count; i++) {
+			callback(i, 0);
+		}
+		return;
+	}
+	
+	std::vector<std::thread> threads;
+	for(s32 thread = 0; thread < thread_count; thread++) {
+		s32 begin = (s32) ((s64) count * thread / thread_count);
+		s32 end = (s32) ((s64) count * (thread + 1) / thread_count);
+		threads.emplace_back([begin, end, thread, &callback]() {
+			for(s32 i = begin; i < end; i++) {
+				callback(i, thread);
+			}
+		});
+	}
+	
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+s32 resolve_thread_count(s32 thread_count)
+{
+	if(thread_count > 0) {
+		return thread_count;
+	}
+	return std::max((s32) std::thread::hardware_concurrency(), 1);
+}
+
 }
@@ -5,6 +5,7 @@
 
 #include <set>
 #include <span>
+#include <new>
 #include <cstdio>
 #include <vector>
 #include <memory>
@@ -14,6 +15,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <optional>
+#include <functional>
 
 namespace ccc {
 
@@ -283,6 +285,16 @@ std::string normalise_path(const char* input, bool use_backslashes_as_path_separ
 bool guess_is_windows_path(const char* path);
 std::string extract_file_name(const std::string& path);
 
+// Call the callback for every index in the range [0, count), splitting the work
+// into contiguous chunks processed on separate threads. The thread index passed
+// to the callback is less than resolve_thread_count(thread_count) and can be
+// used to select a per-thread output buffer. Chunks are assigned to threads in
+// order, so concatenating the buffers gives a deterministic result.
+void parallel_for(s32 count, s32 thread_count, const std::function<void(s32 index, s32 thread)>& callback);
+
+// If thread_count is less than one, return the number of hardware threads.
+s32 resolve_thread_count(s32 thread_count);
+
 namespace ast { struct Node; }
 
 // These are used to reference STABS types from other types within a single
@@ -308,6 +320,58 @@ enum StorageClass {
 	STORAGE_CLASS_REGISTER = 5
 };
 
+// A stack for walking over trees without recursion. The first few elements
+// are stored inline so that shallow trees can be walked without allocating.
+// Elements are copied around with memcpy, so they must be trivially copyable.
+template <typename Element, size_t inline_capacity = 32>
+class SmallStack {
+	static_assert(std::is_trivially_copyable_v<Element> && std::is_trivially_destructible_v<Element>);
+	
+public:
+	SmallStack() {}
+	SmallStack(const SmallStack& rhs) = delete;
+	SmallStack& operator=(const SmallStack& rhs) = delete;
+	
+	bool empty() const { return m_size == 0; }
+	size_t size() const { return m_size; }
+	
+	Element& back()
+	{
+		CCC_ASSERT(m_size > 0);
+		return m_data[m_size - 1];
+	}
+	
+	void push_back(const Element& element)
+	{
+		if(m_size == m_capacity) {
+			grow();
+		}
+		new (&m_data[m_size++]) Element(element);
+	}
+	
+	void pop_back()
+	{
+		CCC_ASSERT(m_size > 0);
+		m_size--;
+	}
+	
+protected:
+	void grow()
+	{
+		std::unique_ptr<u8[]> heap(new u8[m_capacity * 2 * sizeof(Element)]);
+		memcpy(heap.get(), m_data, m_size * sizeof(Element));
+		m_data = reinterpret_cast<Element*>(heap.get());
+		m_heap = std::move(heap);
+		m_capacity *= 2;
+	}
+	
+	alignas(Element) u8 m_inline[inline_capacity * sizeof(Element)];
+	Element* m_data = reinterpret_cast<Element*>(m_inline);
+	size_t m_size = 0;
+	size_t m_capacity = inline_capacity;
+	std::unique_ptr<u8[]> m_heap;
+};
+
 // Function pointers for the GNU demangler functions, so we can build CCC as a
 // library without linking against the demangler.
 struct DemanglerFunctions {
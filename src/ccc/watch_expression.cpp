@@ -0,0 +1,352 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include "watch_expression.h"
+
+namespace ccc {
+
+struct WatchCompiler {
+	const std::string& source;
+	size_t pos = 0;
+	const SymbolDatabase& database;
+	CompiledWatchExpression expression;
+	// Offset to be added before the next dereference, or at the end.
+	s32 pending_offset = 0;
+	bool has_base = false;
+};
+
+static Result<void> parse_unary(WatchCompiler& compiler, s32 depth);
+static Result<void> parse_postfix(WatchCompiler& compiler, s32 depth);
+static Result<void> parse_primary(WatchCompiler& compiler, s32 depth);
+static Result<void> apply_dereference(WatchCompiler& compiler);
+static Result<void> apply_subscript(WatchCompiler& compiler, s64 index);
+static Result<void> apply_member_access(WatchCompiler& compiler, const std::string& name);
+static const ast::Node* find_member(
+	const ast::StructOrUnion& struct_or_union,
+	const std::string& name,
+	s32& offset,
+	const SymbolDatabase& database,
+	s32 depth);
+static s32 type_size_bytes(const ast::Node& type, const SymbolDatabase& database);
+static void skip_whitespace(WatchCompiler& compiler);
+static bool consume(WatchCompiler& compiler, const char* token);
+static std::string parse_identifier(WatchCompiler& compiler);
+static std::optional<s64> parse_integer(WatchCompiler& compiler);
+
+Result<CompiledWatchExpression> compile_watch_expression(const std::string& source, const SymbolDatabase& database)
+{
+	WatchCompiler compiler{source, 0, database};
+	compiler.expression.source = source;
+	
+	Result<void> result = parse_unary(compiler, 0);
+	CCC_RETURN_IF_ERROR(result);
+	
+	skip_whitespace(compiler);
+	CCC_CHECK(compiler.pos == source.size(), "Unexpected '%c' at position %d.", source[compiler.pos], (s32) compiler.pos);
+	
+	WatchInstruction& instruction = compiler.expression.instructions.emplace_back();
+	instruction.offset = compiler.pending_offset;
+	instruction.dereference = false;
+	
+	compiler.expression.size = std::max(type_size_bytes(*compiler.expression.type, database), 0);
+	
+	return std::move(compiler.expression);
+}
+
+WatchValue evaluate_watch_expression(
+	const CompiledWatchExpression& expression, std::span<const u8> memory, u32 memory_base)
+{
+	WatchValue value;
+	
+	u32 address = expression.base_address;
+	for(const WatchInstruction& instruction : expression.instructions) {
+		address += instruction.offset;
+		if(instruction.dereference) {
+			if(address < memory_base || (u64) address - memory_base + 4 > memory.size()) {
+				return value;
+			}
+			memcpy(&address, &memory[address - memory_base], 4);
+			if(address == 0) {
+				return value;
+			}
+		}
+	}
+	
+	if(address < memory_base || (u64) address - memory_base + expression.size > memory.size()) {
+		return value;
+	}
+	
+	value.valid = true;
+	value.address = address;
+	value.data = memory.subspan(address - memory_base, expression.size);
+	
+	return value;
+}
+
+void evaluate_watch_expressions(
+	std::span<const CompiledWatchExpression> expressions,
+	std::span<const u8> memory,
+	u32 memory_base,
+	std::span<WatchValue> output)
+{
+	CCC_ASSERT(expressions.size() == output.size());
+	for(size_t i = 0; i < expressions.size(); i++) {
+		output[i] = evaluate_watch_expression(expressions[i], memory, memory_base);
+	}
+}
+
+static Result<void> parse_unary(WatchCompiler& compiler, s32 depth)
+{
+	CCC_CHECK(depth < 100, "Expression too deeply nested.");
+	
+	skip_whitespace(compiler);
+	if(consume(compiler, "*")) {
+		Result<void> operand = parse_unary(compiler, depth + 1);
+		CCC_RETURN_IF_ERROR(operand);
+		
+		return apply_dereference(compiler);
+	}
+	
+	return parse_postfix(compiler, depth);
+}
+
+static Result<void> parse_postfix(WatchCompiler& compiler, s32 depth)
+{
+	Result<void> primary = parse_primary(compiler, depth);
+	CCC_RETURN_IF_ERROR(primary);
+	
+	while(true) {
+		skip_whitespace(compiler);
+		if(consume(compiler, ".")) {
+			skip_whitespace(compiler);
+			std::string name = parse_identifier(compiler);
+			CCC_CHECK(!name.empty(), "Expected field name after '.' at position %d.", (s32) compiler.pos);
+			
+			Result<void> member = apply_member_access(compiler, name);
+			CCC_RETURN_IF_ERROR(member);
+		} else if(consume(compiler, "->")) {
+			skip_whitespace(compiler);
+			std::string name = parse_identifier(compiler);
+			CCC_CHECK(!name.empty(), "Expected field name after '->' at position %d.", (s32) compiler.pos);
+			
+			Result<void> dereference = apply_dereference(compiler);
+			CCC_RETURN_IF_ERROR(dereference);
+			
+			Result<void> member = apply_member_access(compiler, name);
+			CCC_RETURN_IF_ERROR(member);
+		} else if(consume(compiler, "[")) {
+			skip_whitespace(compiler);
+			std::optional<s64> index = parse_integer(compiler);
+			CCC_CHECK(index.has_value(), "Expected integer array index at position %d.", (s32) compiler.pos);
+			
+			skip_whitespace(compiler);
+			CCC_CHECK(consume(compiler, "]"), "Expected ']' at position %d.", (s32) compiler.pos);
+			
+			Result<void> subscript = apply_subscript(compiler, *index);
+			CCC_RETURN_IF_ERROR(subscript);
+		} else {
+			break;
+		}
+	}
+	
+	return Result<void>();
+}
+
+static Result<void> parse_primary(WatchCompiler& compiler, s32 depth)
+{
+	skip_whitespace(compiler);
+	if(consume(compiler, "(")) {
+		Result<void> inner = parse_unary(compiler, depth + 1);
+		CCC_RETURN_IF_ERROR(inner);
+		
+		skip_whitespace(compiler);
+		CCC_CHECK(consume(compiler, ")"), "Expected ')' at position %d.", (s32) compiler.pos);
+		
+		return Result<void>();
+	}
+	
+	std::string name = parse_identifier(compiler);
+	CCC_CHECK(!name.empty(), "Expected identifier at position %d.", (s32) compiler.pos);
+	CCC_ASSERT(!compiler.has_base);
+	
+	GlobalVariableHandle handle = compiler.database.global_variables.first_handle_from_name(name);
+	const GlobalVariable* global_variable = compiler.database.global_variables.symbol_from_handle(handle);
+	CCC_CHECK(global_variable, "No global variable named '%s'.", name.c_str());
+	CCC_CHECK(global_variable->address().valid(), "Global variable '%s' has no address.", name.c_str());
+	CCC_CHECK(global_variable->type(), "Global variable '%s' has no type.", name.c_str());
+	
+	compiler.expression.base_address = global_variable->address().value;
+	compiler.expression.type = global_variable->type();
+	compiler.has_base = true;
+	
+	return Result<void>();
+}
+
+static Result<void> apply_dereference(WatchCompiler& compiler)
+{
+	const ast::Node* physical_type = compiler.expression.type->physical_type(compiler.database).first;
+	CCC_CHECK(physical_type->descriptor == ast::POINTER_OR_REFERENCE,
+		"Cannot dereference value of non-pointer type at position %d.", (s32) compiler.pos);
+	
+	WatchInstruction& instruction = compiler.expression.instructions.emplace_back();
+	instruction.offset = compiler.pending_offset;
+	instruction.dereference = true;
+	
+	compiler.pending_offset = 0;
+	compiler.expression.type = physical_type->as<ast::PointerOrReference>().value_type.get();
+	
+	return Result<void>();
+}
+
+static Result<void> apply_subscript(WatchCompiler& compiler, s64 index)
+{
+	const ast::Node* physical_type = compiler.expression.type->physical_type(compiler.database).first;
+	
+	const ast::Node* element_type;
+	if(physical_type->descriptor == ast::ARRAY) {
+		const ast::Array& array = physical_type->as<ast::Array>();
+		CCC_CHECK(index >= 0 && index < array.element_count,
+			"Array index %lld out of bounds at position %d.", (long long) index, (s32) compiler.pos);
+		
+		element_type = array.element_type.get();
+	} else if(physical_type->descriptor == ast::POINTER_OR_REFERENCE) {
+		Result<void> dereference = apply_dereference(compiler);
+		CCC_RETURN_IF_ERROR(dereference);
+		
+		element_type = compiler.expression.type;
+	} else {
+		return CCC_FAILURE("Cannot subscript value of non-array type at position %d.", (s32) compiler.pos);
+	}
+	
+	s32 element_size = type_size_bytes(*element_type, compiler.database);
+	CCC_CHECK(element_size > 0, "Array element type has unknown size at position %d.", (s32) compiler.pos);
+	
+	s64 offset = compiler.pending_offset + index * element_size;
+	CCC_CHECK(offset >= INT32_MIN && offset <= INT32_MAX, "Array index too large at position %d.", (s32) compiler.pos);
+	
+	compiler.pending_offset = (s32) offset;
+	compiler.expression.type = element_type;
+	
+	return Result<void>();
+}
+
+static Result<void> apply_member_access(WatchCompiler& compiler, const std::string& name)
+{
+	const ast::Node* physical_type = compiler.expression.type->physical_type(compiler.database).first;
+	CCC_CHECK(physical_type->descriptor == ast::STRUCT_OR_UNION,
+		"Cannot access field '%s' of value of non-struct type.", name.c_str());
+	
+	s32 offset = 0;
+	const ast::Node* member = find_member(physical_type->as<ast::StructOrUnion>(), name, offset, compiler.database, 0);
+	CCC_CHECK(member, "No field named '%s'.", name.c_str());
+	
+	compiler.pending_offset += offset;
+	compiler.expression.type = member;
+	
+	return Result<void>();
+}
+
+static const ast::Node* find_member(
+	const ast::StructOrUnion& struct_or_union,
+	const std::string& name,
+	s32& offset,
+	const SymbolDatabase& database,
+	s32 depth)
+{
+	if(depth > 100) {
+		return nullptr;
+	}
+	
+	for(const std::unique_ptr<ast::Node>& field : struct_or_union.fields) {
+		if(field->storage_class == STORAGE_CLASS_STATIC) {
+			continue;
+		}
+		
+		if(field->name == name) {
+			offset += field->offset_bytes;
+			return field.get();
+		}
+		
+		// Search the members of anonymous structs and unions.
+		if(field->name.empty() && field->descriptor == ast::STRUCT_OR_UNION) {
+			s32 inner_offset = offset + field->offset_bytes;
+			const ast::Node* member = find_member(field->as<ast::StructOrUnion>(), name, inner_offset, database, depth + 1);
+			if(member) {
+				offset = inner_offset;
+				return member;
+			}
+		}
+	}
+	
+	for(const std::unique_ptr<ast::Node>& base_class : struct_or_union.base_classes) {
+		const ast::Node* base_type = base_class->physical_type(database).first;
+		if(base_type->descriptor != ast::STRUCT_OR_UNION) {
+			continue;
+		}
+		
+		s32 base_offset = offset + base_class->offset_bytes;
+		const ast::Node* member = find_member(base_type->as<ast::StructOrUnion>(), name, base_offset, database, depth + 1);
+		if(member) {
+			offset = base_offset;
+			return member;
+		}
+	}
+	
+	return nullptr;
+}
+
+static s32 type_size_bytes(const ast::Node& type, const SymbolDatabase& database)
+{
+	if(type.size_bytes > 0) {
+		return type.size_bytes;
+	}
+	return type.physical_type(database).first->size_bytes;
+}
+
+static void skip_whitespace(WatchCompiler& compiler)
+{
+	while(compiler.pos < compiler.source.size() && isspace((u8) compiler.source[compiler.pos])) {
+		compiler.pos++;
+	}
+}
+
+static bool consume(WatchCompiler& compiler, const char* token)
+{
+	size_t length = strlen(token);
+	if(compiler.source.compare(compiler.pos, length, token) != 0) {
+		return false;
+	}
+	compiler.pos += length;
+	return true;
+}
+
+static std::string parse_identifier(WatchCompiler& compiler)
+{
+	size_t begin = compiler.pos;
+	while(compiler.pos < compiler.source.size()) {
+		char c = compiler.source[compiler.pos];
+		if(isalpha((u8) c) || c == '_' || (isdigit((u8) c) && compiler.pos > begin)) {
+			compiler.pos++;
+		} else if(c == ':' && compiler.source.compare(compiler.pos, 2, "::") == 0) {
+			// Allow qualified names e.g. Namespace::variable.
+			compiler.pos += 2;
+		} else {
+			break;
+		}
+	}
+	return compiler.source.substr(begin, compiler.pos - begin);
+}
+
+static std::optional<s64> parse_integer(WatchCompiler& compiler)
+{
+	const char* begin = compiler.source.c_str() + compiler.pos;
+	char* end = nullptr;
+	s64 value = strtoll(begin, &end, 0);
+	if(end == begin) {
+		return std::nullopt;
+	}
+	compiler.pos += end - begin;
+	return value;
+}
+
+}
@@ -0,0 +1,56 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "ast.h"
+
+namespace ccc {
+
+// Add the offset to the current address, and then if dereference is set,
+// replace the current address with the pointer stored at that address.
+struct WatchInstruction {
+	s32 offset = 0;
+	bool dereference = false;
+};
+
+// A C-style expression e.g. "gPlayer->inventory.items[3].count" that has been
+// resolved against the symbol database, so that it can be evaluated without
+// any name lookups.
+struct CompiledWatchExpression {
+	std::string source;
+	u32 base_address = 0;
+	std::vector<WatchInstruction> instructions;
+	// The type of the result. Points into the symbol database so is only valid
+	// for as long as the database is unmodified.
+	const ast::Node* type = nullptr;
+	s32 size = 0;
+};
+
+struct WatchValue {
+	bool valid = false;
+	u32 address = 0;
+	std::span<const u8> data;
+};
+
+// Parse an expression and resolve all the global variables, fields and array
+// indices it references. Supported syntax: identifiers naming global
+// variables, member access with "." and "->", array subscripts with integer
+// literals, dereferences with "*", and parentheses.
+Result<CompiledWatchExpression> compile_watch_expression(const std::string& source, const SymbolDatabase& database);
+
+// Evaluate a compiled expression against a memory snapshot starting at the
+// given base address. Returns an invalid value if a null or out of bounds
+// pointer is encountered.
+WatchValue evaluate_watch_expression(
+	const CompiledWatchExpression& expression, std::span<const u8> memory, u32 memory_base = 0);
+
+// Evaluate many expressions against the same snapshot. The output span must be
+// the same size as the expressions span.
+void evaluate_watch_expressions(
+	std::span<const CompiledWatchExpression> expressions,
+	std::span<const u8> memory,
+	u32 memory_base,
+	std::span<WatchValue> output);
+
+}
@@ -0,0 +1,929 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <chrono>
+#include <deque>
+#include <random>
+
+#include "ccc/ccc.h"
+#include "platform/file.h"
+#define HAVE_DECL_BASENAME 1
+#include "demangle.h"
+
+using namespace ccc;
+
+// Benchmarks for the hot paths of the importer and the code that consumes its
+// output. The end-to-end benchmarks run on synthetic symbol tables generated
+// in memory, so no large test data is required.
+
+struct Options {
+	std::string filter;
+	std::vector<u32> scales = {100000, 500000, 2000000};
+	u32 min_samples = 3;
+	u64 min_time_ns = 500000000;
+	u64 max_time_ns = 10000000000;
+	fs::path output_path;
+	fs::path baseline_path;
+	fs::path elf_path;
+	double tolerance_percent = 10.0;
+	bool quick = false;
+};
+
+struct BenchmarkResult {
+	std::string name;
+	u64 items = 0; // Per sample.
+	std::vector<u64> samples_ns;
+	u64 min_ns = 0;
+	u64 median_ns = 0;
+	double mean_ns = 0.0;
+	
+	double ns_per_item() const { return items > 0 ? (double) median_ns / items : (double) median_ns; }
+};
+
+class BenchmarkRunner {
+public:
+	BenchmarkRunner(const Options& options)
+		: m_options(options) {}
+	
+	bool enabled(const std::string& name) const;
+	
+	// Run setup before each sample without timing it, then time callback. The
+	// result of setup is destroyed after the timer has been stopped.
+	template <typename Setup, typename Callback>
+	void run(const std::string& name, u64 items, Setup setup, Callback callback);
+	
+	template <typename Callback>
+	void run(const std::string& name, u64 items, Callback callback)
+	{
+		run(name, items, []() { return 0; }, [&](int) { callback(); });
+	}
+	
+	const std::vector<BenchmarkResult>& results() const { return m_results; }
+	
+protected:
+	void finish(BenchmarkResult& result);
+	
+	const Options& m_options;
+	std::vector<BenchmarkResult> m_results;
+};
+
+// A set of .mdebug files made up of STABS symbols that look like those
+// emitted by ee-g++. Each file includes a common header, so many of the types
+// are duplicated between files like in a real game.
+struct SyntheticSymbolTable {
+	std::deque<std::string> strings;
+	std::vector<mdebug::File> files;
+	std::vector<mdebug::Symbol> external_symbols;
+	mdebug::ProcedureDescriptor procedure_descriptor = {};
+	u64 symbol_count = 0;
+	
+	SyntheticSymbolTable() = default;
+	SyntheticSymbolTable(const SyntheticSymbolTable& rhs) = delete;
+	SyntheticSymbolTable& operator=(const SyntheticSymbolTable& rhs) = delete;
+};
+
+static const s32 SYNTHETIC_TYPES_PER_FILE = 40;
+static const s32 SYNTHETIC_FUNCTIONS_PER_FILE = 8;
+static const s32 SYNTHETIC_GLOBALS_PER_FILE = 20;
+
+static std::unique_ptr<SyntheticSymbolTable> generate_symbol_table(u64 target_symbol_count);
+static void generate_file(SyntheticSymbolTable& table, s32 index);
+static Result<void> import_synthetic_symbol_table(
+	SymbolDatabase& database, const SyntheticSymbolTable& table, u32 importer_flags);
+static void benchmark_mdebug_section(BenchmarkRunner& runner, const SyntheticSymbolTable& table);
+static void benchmark_stabs(BenchmarkRunner& runner, const SyntheticSymbolTable& table);
+static void benchmark_ast(BenchmarkRunner& runner, const SyntheticSymbolTable& table);
+static void benchmark_symbol_list(BenchmarkRunner& runner, u32 count);
+static void benchmark_output(BenchmarkRunner& runner, const SyntheticSymbolTable& table);
+static void benchmark_import(BenchmarkRunner& runner, u32 symbol_count);
+static void print_results(FILE* out, const std::vector<BenchmarkResult>& results);
+static void write_results(const fs::path& path, const std::vector<BenchmarkResult>& results);
+static bool compare_with_baseline(
+	const fs::path& path, const std::vector<BenchmarkResult>& results, double tolerance_percent);
+static u64 now_ns();
+static Options parse_command_line_arguments(int argc, char** argv);
+static void print_help();
+static const char* get_version();
+
+static DemanglerFunctions demangler;
+
+// Written to so that the compiler can't optimise away the work being timed.
+static volatile u64 sink;
+
+int main(int argc, char** argv)
+{
+	Options options = parse_command_line_arguments(argc, argv);
+	
+	demangler.cplus_demangle = cplus_demangle;
+	demangler.cplus_demangle_opname = cplus_demangle_opname;
+	
+	if(!options.elf_path.empty()) {
+		std::unique_ptr<SyntheticSymbolTable> table = generate_symbol_table(options.scales.front());
+		Result<std::vector<u8>> image = mdebug::write_elf_file_with_symbol_table(table->files, table->external_symbols);
+		CCC_EXIT_IF_ERROR(image);
+		
+		FILE* file = fopen(options.elf_path.string().c_str(), "wb");
+		CCC_EXIT_IF_FALSE(file, "Failed to open output file '%s'.", options.elf_path.string().c_str());
+		CCC_EXIT_IF_FALSE(fwrite(image->data(), image->size(), 1, file) == 1, "Failed to write output file.");
+		fclose(file);
+		
+		return 0;
+	}
+	
+	BenchmarkRunner runner(options);
+	
+	std::unique_ptr<SyntheticSymbolTable> small_table = generate_symbol_table(options.quick ? 2000 : 20000);
+	benchmark_mdebug_section(runner, *small_table);
+	benchmark_stabs(runner, *small_table);
+	benchmark_ast(runner, *small_table);
+	benchmark_symbol_list(runner, options.quick ? 1000 : 100000);
+	benchmark_output(runner, *small_table);
+	small_table.reset();
+	
+	for(u32 scale : options.scales) {
+		benchmark_import(runner, scale);
+	}
+	
+	print_results(stdout, runner.results());
+	
+	if(!options.output_path.empty()) {
+		write_results(options.output_path, runner.results());
+	}
+	
+	if(!options.baseline_path.empty()) {
+		if(!compare_with_baseline(options.baseline_path, runner.results(), options.tolerance_percent)) {
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+bool BenchmarkRunner::enabled(const std::string& name) const
+{
+	return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+}
+
+template <typename Setup, typename Callback>
+void BenchmarkRunner::run(const std::string& name, u64 items, Setup setup, Callback callback)
+{
+	if(!enabled(name)) {
+		return;
+	}
+	
+	fprintf(stderr, "Running %s...\n", name.c_str());
+	
+	BenchmarkResult& result = m_results.emplace_back();
+	result.name = name;
+	result.items = items;
+	
+	u64 total_ns = 0;
+	while(result.samples_ns.size() < m_options.min_samples || total_ns < m_options.min_time_ns) {
+		if(!result.samples_ns.empty() && total_ns >= m_options.max_time_ns) {
+			break;
+		}
+		
+		auto state = setup();
+		
+		u64 begin_ns = now_ns();
+		callback(state);
+		u64 duration_ns = now_ns() - begin_ns;
+		
+		result.samples_ns.emplace_back(duration_ns);
+		total_ns += duration_ns;
+	}
+	
+	finish(result);
+}
+
+void BenchmarkRunner::finish(BenchmarkResult& result)
+{
+	std::vector<u64> sorted = result.samples_ns;
+	std::sort(CCC_BEGIN_END(sorted));
+	
+	result.min_ns = sorted.front();
+	result.median_ns = sorted[sorted.size() / 2];
+	
+	u64 total_ns = 0;
+	for(u64 sample : sorted) {
+		total_ns += sample;
+	}
+	result.mean_ns = (double) total_ns / sorted.size();
+}
+
+static std::unique_ptr<SyntheticSymbolTable> generate_symbol_table(u64 target_symbol_count)
+{
+	std::unique_ptr<SyntheticSymbolTable> table = std::make_unique<SyntheticSymbolTable>();
+	
+	table->procedure_descriptor.frame_size = 48;
+	table->procedure_descriptor.saved_register_mask = (s32) 0x80000000;
+	table->procedure_descriptor.saved_register_offset = -16;
+	table->procedure_descriptor.frame_pointer_register = 29;
+	table->procedure_descriptor.return_pc_register = 31;
+	
+	for(s32 i = 0; table->symbol_count < target_symbol_count; i++) {
+		generate_file(*table, i);
+	}
+	
+	return table;
+}
+
+static void generate_file(SyntheticSymbolTable& table, s32 index)
+{
+	mdebug::File& file = table.files.emplace_back();
+	file.address = 0x100000 + index * 0x1000;
+	file.working_dir = "/home/user/game/";
+	file.command_line_path = "src/file" + std::to_string(index) + ".cpp";
+	file.full_path = file.working_dir + file.command_line_path;
+	
+	auto add = [&](u32 value, mdebug::SymbolType type, mdebug::SymbolClass symbol_class, u32 code, std::string string) {
+		mdebug::Symbol& symbol = file.symbols.emplace_back();
+		symbol.value = value;
+		symbol.symbol_type = type;
+		symbol.symbol_class = symbol_class;
+		symbol.index = code;
+		symbol.string = table.strings.emplace_back(std::move(string)).c_str();
+		if(type == mdebug::SymbolType::PROC) {
+			symbol.procedure_descriptor = &table.procedure_descriptor;
+		}
+	};
+	
+	auto stab = [&](u32 value, mdebug::StabsCode code, std::string string) {
+		add(value, mdebug::SymbolType::NIL, mdebug::SymbolClass::NIL, code + 0x8f300, std::move(string));
+	};
+	
+	using mdebug::SymbolType;
+	using mdebug::SymbolClass;
+	
+	add(0, SymbolType::FILE_SYMBOL, SymbolClass::TEXT, 1, file.command_line_path);
+	add(0xffffffff, SymbolType::NIL, SymbolClass::INFO, mdebug::STAB + 0x8f300, "@stabs");
+	add(file.address, SymbolType::LABEL, SymbolClass::TEXT, mdebug::N_SO + 0x8f300, file.working_dir);
+	add(file.address, SymbolType::LABEL, SymbolClass::TEXT, mdebug::N_SO + 0x8f300, file.command_line_path);
+	
+	// Built-in types.
+	stab(0, mdebug::N_LSYM, "int:t(0,1)=r(0,1);-2147483648;2147483647;");
+	stab(0, mdebug::N_LSYM, "char:t(0,2)=r(0,2);0;127;");
+	stab(0, mdebug::N_LSYM, "unsigned int:t(0,4)=r(0,4);0;4294967295;");
+	stab(0, mdebug::N_LSYM, "float:t(0,14)=r(0,1);4;0;");
+	stab(0, mdebug::N_LSYM, "__builtin_va_list:t(0,22)=*(0,23)=(0,23)");
+	stab(0, mdebug::N_LSYM, "bool:t(0,24)=eFalse:0,True:1,;");
+	
+	// Types from a header included by every file.
+	stab(0, mdebug::N_BINCL, "include/common.h");
+	stab(0, mdebug::N_LSYM, "Vec3:T(1,1)=s12x:(0,14),0,32;y:(0,14),32,32;z:(0,14),64,32;;");
+	stab(0, mdebug::N_LSYM, "Vec3:t(1,1)");
+	stab(0, mdebug::N_LSYM, "Colour:T(1,2)=eRED:0,GREEN:1,BLUE:2,;");
+	stab(0, mdebug::N_LSYM,
+		"Entity:Tt(1,3)=s20position:(1,1),0,96;colour:(1,2),96,32;next:(1,4)=*(1,3),128,32;"
+		"update::(1,5)=#(1,3),(0,23),(1,4),(0,23);:_ZN6Entity6updateEv;2A.;"
+		"get_colour::(1,6)=#(1,3),(1,2),(1,4),(0,23);:_ZN6Entity10get_colourEv;2A.;;");
+	stab(0, mdebug::N_LSYM, "Entity:t(1,3)");
+	stab(0, mdebug::N_EINCL, "");
+	
+	// Types that are only defined in this file. Each structure points to the
+	// previous one, so the types form a chain.
+	std::string prefix = "F" + std::to_string(index) + "_";
+	for(s32 i = 0; i < SYNTHETIC_TYPES_PER_FILE; i++) {
+		std::string name = prefix + "Type" + std::to_string(i);
+		std::string number = "(2," + std::to_string(i * 2 + 1) + ")";
+		if(i % 4 == 3) {
+			stab(0, mdebug::N_LSYM, name + ":T" + number + "=e" + name + "_A:0," + name + "_B:1," + name + "_C:2,;");
+		} else {
+			std::string previous = i % 4 == 0 ? "(1,3)" : "(2," + std::to_string(i * 2 - 1) + ")";
+			std::string pointer = "(2," + std::to_string(i * 2 + 2) + ")";
+			stab(0, mdebug::N_LSYM, name + ":T" + number + "=s24"
+				"id:(0,4),0,32;scale:(0,14),32,32;parent:" + pointer + "=*" + previous + ",64,32;"
+				"origin:(1,1),96,96;;");
+			stab(0, mdebug::N_LSYM, name + ":t" + number);
+		}
+	}
+	
+	// Static global variables.
+	for(s32 i = 0; i < SYNTHETIC_GLOBALS_PER_FILE; i++) {
+		std::string type = i % 2 == 0 ? "(2,1)" : "(1,3)";
+		u32 address = 0x800000 + index * 0x1000 + i * 0x20;
+		add(address, SymbolType::STATIC, SymbolClass::BSS, mdebug::N_STSYM + 0x8f300,
+			"s_" + prefix + std::to_string(i) + ":S" + type);
+	}
+	
+	// Functions with parameters, line numbers and nested blocks of local
+	// variables. There are relatively few of them since a .mdebug section can
+	// only reference around 64k procedure descriptors.
+	for(s32 i = 0; i < SYNTHETIC_FUNCTIONS_PER_FILE; i++) {
+		std::string name = prefix + "function" + std::to_string(i);
+		std::string mangled_name = "_Z" + std::to_string(name.size()) + name + "iP6Entityf";
+		u32 address = file.address + i * 0x80;
+		
+		add(address, SymbolType::LABEL, SymbolClass::TEXT, mdebug::N_FUN + 0x8f300, mangled_name + ":F(0,1)");
+		stab(0xffffffd0, mdebug::N_PSYM, "count:p(0,1)");
+		stab(0xffffffd4, mdebug::N_PSYM, "entity:p(1,4)");
+		stab(0xffffffd8, mdebug::N_PSYM, "scale:p(0,14)");
+		add(address, SymbolType::LABEL, SymbolClass::TEXT, 1, "$LM" + std::to_string(i * 4 + 1));
+		
+		mdebug::Symbol external_symbol;
+		external_symbol.value = address;
+		external_symbol.symbol_type = SymbolType::PROC;
+		external_symbol.symbol_class = SymbolClass::TEXT;
+		external_symbol.index = (u32) file.symbols.size();
+		external_symbol.string = table.strings.emplace_back(mangled_name).c_str();
+		table.external_symbols.emplace_back(external_symbol);
+		
+		add(address, SymbolType::PROC, SymbolClass::TEXT, 1, mangled_name);
+		add(address + 0x10, SymbolType::LABEL, SymbolClass::TEXT, 2, "$LM" + std::to_string(i * 4 + 2));
+		add(address + 0x30, SymbolType::LABEL, SymbolClass::TEXT, 3, "$LM" + std::to_string(i * 4 + 3));
+		add(address + 0x60, SymbolType::LABEL, SymbolClass::TEXT, 4, "$LM" + std::to_string(i * 4 + 4));
+		add(0x80, SymbolType::END, SymbolClass::TEXT, 5, mangled_name);
+		stab(0xffffffe0, mdebug::N_LSYM, "result:(0,1)");
+		stab(0xffffffe4, mdebug::N_LSYM, "index:(0,4)");
+		stab(0x8, mdebug::N_LBRAC, "");
+		stab(0xffffffe8, mdebug::N_LSYM, "object:(2,1)");
+		stab(0xffffffec, mdebug::N_LSYM, "position:(1,1)");
+		stab(0x20, mdebug::N_LBRAC, "");
+		stab(0xfffffff8, mdebug::N_LSYM, "colour:(1,2)");
+		stab(0x50, mdebug::N_RBRAC, "");
+		stab(0x70, mdebug::N_RBRAC, "");
+	}
+	
+	add(file.address + 0x1000, SymbolType::LABEL, SymbolClass::TEXT, mdebug::N_SO + 0x8f300, "");
+	
+	table.symbol_count += file.symbols.size() + SYNTHETIC_FUNCTIONS_PER_FILE;
+}
+
+static Result<void> import_synthetic_symbol_table(
+	SymbolDatabase& database, const SyntheticSymbolTable& table, u32 importer_flags)
+{
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Synthetic");
+	CCC_RETURN_IF_ERROR(source);
+	
+	mdebug::AnalysisContext context;
+	context.group.source = *source;
+	context.importer_flags = importer_flags;
+	context.demangler = demangler;
+	
+	for(const mdebug::File& file : table.files) {
+		Result<void> result = mdebug::import_file(database, file, context);
+		CCC_RETURN_IF_ERROR(result);
+	}
+	
+	return mdebug::run_analysis_passes(database, context);
+}
+
+static void benchmark_mdebug_section(BenchmarkRunner& runner, const SyntheticSymbolTable& table)
+{
+	runner.run("mdebug/write_symbol_table", table.symbol_count, [&]() {
+		Result<std::vector<u8>> section = mdebug::write_symbol_table(table.files, table.external_symbols, 0);
+		CCC_EXIT_IF_ERROR(section);
+		sink = section->size();
+	});
+	
+	Result<std::vector<u8>> section = mdebug::write_symbol_table(table.files, table.external_symbols, 0);
+	CCC_EXIT_IF_ERROR(section);
+	
+	mdebug::SymbolTableReader reader;
+	Result<void> reader_result = reader.init(*section, 0);
+	CCC_EXIT_IF_ERROR(reader_result);
+	
+	runner.run("mdebug/parse_file", table.symbol_count, [&]() {
+		u64 count = 0;
+		for(s32 i = 0; i < reader.file_count(); i++) {
+			Result<mdebug::File> file = reader.parse_file(i);
+			CCC_EXIT_IF_ERROR(file);
+			count += file->symbols.size();
+		}
+		
+		Result<std::vector<mdebug::Symbol>> external_symbols = reader.parse_external_symbols();
+		CCC_EXIT_IF_ERROR(external_symbols);
+		count += external_symbols->size();
+		
+		sink = count;
+	});
+}
+
+static void benchmark_stabs(BenchmarkRunner& runner, const SyntheticSymbolTable& table)
+{
+	std::vector<const char*> strings;
+	for(const mdebug::File& file : table.files) {
+		for(const mdebug::Symbol& symbol : file.symbols) {
+			if(symbol.is_stabs() && strchr(symbol.string, ':')) {
+				strings.emplace_back(symbol.string);
+			}
+		}
+	}
+	
+	runner.run("stabs/parse_stabs_symbol", strings.size(), [&]() {
+		u64 count = 0;
+		for(const char* string : strings) {
+			const char* input = string;
+			Result<StabsSymbol> symbol = parse_stabs_symbol(input);
+			CCC_EXIT_IF_ERROR(symbol);
+			count += symbol->name.size();
+		}
+		sink = count;
+	});
+	
+	runner.run("mdebug/parse_symbols", table.symbol_count, [&]() {
+		u64 count = 0;
+		for(const mdebug::File& file : table.files) {
+			u32 importer_flags = NO_IMPORTER_FLAGS;
+			Result<std::vector<mdebug::ParsedSymbol>> symbols = mdebug::parse_symbols(file.symbols, importer_flags);
+			CCC_EXIT_IF_ERROR(symbols);
+			count += symbols->size();
+		}
+		sink = count;
+	});
+}
+
+static void benchmark_ast(BenchmarkRunner& runner, const SyntheticSymbolTable& table)
+{
+	struct ParsedFile {
+		std::vector<mdebug::ParsedSymbol> symbols;
+		std::map<StabsTypeNumber, const StabsType*> stabs_types;
+	};
+	
+	std::vector<ParsedFile> parsed_files;
+	u64 type_count = 0;
+	for(const mdebug::File& file : table.files) {
+		ParsedFile& parsed_file = parsed_files.emplace_back();
+		
+		u32 importer_flags = NO_IMPORTER_FLAGS;
+		Result<std::vector<mdebug::ParsedSymbol>> symbols = mdebug::parse_symbols(file.symbols, importer_flags);
+		CCC_EXIT_IF_ERROR(symbols);
+		parsed_file.symbols = std::move(*symbols);
+		
+		for(const mdebug::ParsedSymbol& symbol : parsed_file.symbols) {
+			if(symbol.type == mdebug::ParsedSymbolType::NAME_COLON_TYPE) {
+				symbol.name_colon_type.type->enumerate_numbered_types(parsed_file.stabs_types);
+				type_count++;
+			}
+		}
+	}
+	
+	runner.run("stabs_to_ast/stabs_type_to_ast", type_count, [&]() {
+		u64 count = 0;
+		for(ParsedFile& parsed_file : parsed_files) {
+			StabsToAstCache cache;
+			
+			StabsToAstState state;
+			state.stabs_types = &parsed_file.stabs_types;
+			state.cache = &cache;
+			state.importer_flags = NO_IMPORTER_FLAGS;
+			state.demangler = demangler;
+			
+			for(const mdebug::ParsedSymbol& symbol : parsed_file.symbols) {
+				if(symbol.type == mdebug::ParsedSymbolType::NAME_COLON_TYPE) {
+					Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(
+						*symbol.name_colon_type.type, nullptr, state, true, false);
+					CCC_EXIT_IF_ERROR(node);
+					count += (*node)->descriptor;
+				}
+			}
+		}
+		sink = count;
+	});
+	
+	// Convert the types again and pair up the ones that are identical between
+	// files, like the deduplication logic would when importing.
+	std::vector<std::unique_ptr<ast::Node>> nodes;
+	std::map<std::string_view, const ast::Node*> first_nodes;
+	std::vector<std::pair<const ast::Node*, const ast::Node*>> pairs;
+	for(ParsedFile& parsed_file : parsed_files) {
+		StabsToAstState state;
+		state.stabs_types = &parsed_file.stabs_types;
+		state.importer_flags = NO_IMPORTER_FLAGS;
+		state.demangler = demangler;
+		
+		for(const mdebug::ParsedSymbol& symbol : parsed_file.symbols) {
+			bool is_type = symbol.type == mdebug::ParsedSymbolType::NAME_COLON_TYPE
+				&& (symbol.name_colon_type.descriptor == StabsSymbolDescriptor::TYPE_NAME
+					|| symbol.name_colon_type.descriptor == StabsSymbolDescriptor::ENUM_STRUCT_OR_TYPE_TAG);
+			if(!is_type) {
+				continue;
+			}
+			
+			Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(
+				*symbol.name_colon_type.type, nullptr, state, false, false);
+			CCC_EXIT_IF_ERROR(node);
+			
+			auto [iterator, inserted] = first_nodes.emplace(symbol.raw->string, node->get());
+			if(!inserted) {
+				pairs.emplace_back(iterator->second, node->get());
+			}
+			
+			nodes.emplace_back(std::move(*node));
+		}
+	}
+	
+	runner.run("ast/compare_nodes", pairs.size(), [&]() {
+		u64 count = 0;
+		for(auto [lhs, rhs] : pairs) {
+			ast::CompareResult result = ast::compare_nodes(*lhs, *rhs, nullptr, true);
+			count += (u64) result.type;
+		}
+		sink = count;
+	});
+	
+	runner.run("ast/for_each_node", nodes.size(), [&]() {
+		u64 count = 0;
+		for(const std::unique_ptr<ast::Node>& node : nodes) {
+			ast::for_each_node(*node, ast::PREORDER_TRAVERSAL, [&](const ast::Node& child) {
+				count++;
+				return ast::EXPLORE_CHILDREN;
+			});
+		}
+		sink = count;
+	});
+}
+
+static void benchmark_symbol_list(BenchmarkRunner& runner, u32 count)
+{
+	std::vector<std::string> names;
+	for(u32 i = 0; i < count; i++) {
+		names.emplace_back("function" + std::to_string(i));
+	}
+	
+	auto create_database = [&]() {
+		std::unique_ptr<SymbolDatabase> database = std::make_unique<SymbolDatabase>();
+		Result<SymbolSourceHandle> source = database->get_symbol_source("Benchmark");
+		CCC_EXIT_IF_ERROR(source);
+		return database;
+	};
+	
+	auto fill_database = [&]() {
+		std::unique_ptr<SymbolDatabase> database = create_database();
+		SymbolSourceHandle source = database->symbol_sources.first_handle_from_name("Benchmark");
+		for(u32 i = 0; i < count; i++) {
+			Result<Function*> function = database->functions.create_symbol(names[i], i * 0x10, source);
+			CCC_EXIT_IF_ERROR(function);
+			(*function)->set_size(0x10);
+		}
+		return database;
+	};
+	
+	std::unique_ptr<SymbolDatabase> database = fill_database();
+	
+	std::vector<FunctionHandle> handles;
+	for(const Function& function : database->functions) {
+		handles.emplace_back(function.handle());
+	}
+	
+	std::mt19937 random(1234);
+	std::vector<u32> indices(count);
+	for(u32& index : indices) {
+		index = random() % count;
+	}
+	
+	runner.run("symbol_list/create_symbol", count, create_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		SymbolSourceHandle source = database->symbol_sources.first_handle_from_name("Benchmark");
+		for(u32 i = 0; i < count; i++) {
+			Result<Function*> function = database->functions.create_symbol(names[i], i * 0x10, source);
+			CCC_EXIT_IF_ERROR(function);
+		}
+	});
+	
+	runner.run("symbol_list/symbol_from_handle", count, [&]() {
+		u64 result = 0;
+		for(u32 index : indices) {
+			result += database->functions.symbol_from_handle(handles[index])->address().value;
+		}
+		sink = result;
+	});
+	
+	runner.run("symbol_list/first_handle_from_name", count, [&]() {
+		u64 result = 0;
+		for(u32 index : indices) {
+			result += database->functions.first_handle_from_name(names[index]).value;
+		}
+		sink = result;
+	});
+	
+	runner.run("symbol_list/first_handle_from_starting_address", count, [&]() {
+		u64 result = 0;
+		for(u32 index : indices) {
+			result += database->functions.first_handle_from_starting_address(index * 0x10).value;
+		}
+		sink = result;
+	});
+	
+	runner.run("symbol_list/symbol_overlapping_address", count, [&]() {
+		u64 result = 0;
+		for(u32 index : indices) {
+			result += database->functions.symbol_overlapping_address(index * 0x10 + 4)->size();
+		}
+		sink = result;
+	});
+	
+	runner.run("symbol_list/move_symbol", count, fill_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		for(u32 i = 0; i < count; i++) {
+			database->functions.move_symbol(handles[indices[i]], 0x10000000 + i * 0x10);
+		}
+	});
+	
+	runner.run("symbol_list/rename_symbol", count, fill_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		for(u32 i = 0; i < count; i++) {
+			database->functions.rename_symbol(handles[indices[i]], names[i]);
+		}
+	});
+	
+	runner.run("symbol_list/destroy_marked_symbols", count / 2, fill_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		for(u32 i = 0; i < count; i += 2) {
+			database->functions.mark_symbol_for_destruction(handles[i], database.get());
+		}
+		database->destroy_marked_symbols();
+	});
+}
+
+static void benchmark_output(BenchmarkRunner& runner, const SyntheticSymbolTable& table)
+{
+	SymbolDatabase database;
+	Result<void> import_result = import_synthetic_symbol_table(database, table, NO_IMPORTER_FLAGS);
+	CCC_EXIT_IF_ERROR(import_result);
+
+#ifdef _WIN32
+	const char* null_device = "NUL";
+#else
+	const char* null_device = "/dev/null";
+#endif
+	
+	runner.run("print_cpp/data_types", database.data_types.size(), [&]() {
+		FILE* out = fopen(null_device, "w");
+		CCC_EXIT_IF_FALSE(out, "Failed to open '%s'.", null_device);
+		CppPrinterConfig config;
+		CppPrinter printer(out, config);
+		for(const DataType& data_type : database.data_types) {
+			printer.data_type(data_type, database);
+		}
+		fclose(out);
+	});
+	
+	runner.run("print_cpp/functions", database.functions.size(), [&]() {
+		FILE* out = fopen(null_device, "w");
+		CCC_EXIT_IF_FALSE(out, "Failed to open '%s'.", null_device);
+		CppPrinterConfig config;
+		CppPrinter printer(out, config);
+		for(const Function& function : database.functions) {
+			printer.function(function, database, nullptr);
+		}
+		fclose(out);
+	});
+	
+	u64 symbol_count = 0;
+	database.for_each_symbol([&](const ccc::Symbol& symbol) {
+		symbol_count++;
+	});
+	
+	runner.run("json/write_json", symbol_count, [&]() {
+		rapidjson::StringBuffer buffer;
+		JsonWriter writer(buffer);
+		write_json(writer, database, "ccc_bench");
+		sink = buffer.GetSize();
+	});
+}
+
+static void benchmark_import(BenchmarkRunner& runner, u32 symbol_count)
+{
+	std::string files_name = "import/synthetic_" + std::to_string(symbol_count);
+	std::string elf_name = "import/synthetic_elf_" + std::to_string(symbol_count);
+	if(!runner.enabled(files_name) && !runner.enabled(elf_name)) {
+		return;
+	}
+	
+	std::unique_ptr<SyntheticSymbolTable> table = generate_symbol_table(symbol_count);
+	
+	auto create_database = []() {
+		return std::make_unique<SymbolDatabase>();
+	};
+	
+	// Import the files directly, skipping the .mdebug section reader.
+	runner.run(files_name, table->symbol_count, create_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		Result<void> result = import_synthetic_symbol_table(*database, *table, NO_IMPORTER_FLAGS);
+		CCC_EXIT_IF_ERROR(result);
+	});
+	
+	if(!runner.enabled(elf_name)) {
+		return;
+	}
+	
+	// Import the symbol table from an ELF file like stdump would.
+	Result<std::vector<u8>> image = mdebug::write_elf_file_with_symbol_table(table->files, table->external_symbols);
+	CCC_EXIT_IF_ERROR(image);
+	u64 table_symbol_count = table->symbol_count;
+	table.reset();
+	
+	Result<ElfFile> elf = ElfFile::parse(std::move(*image));
+	CCC_EXIT_IF_ERROR(elf);
+	
+	const ElfSection* mdebug_section = elf->lookup_section(".mdebug");
+	CCC_EXIT_IF_FALSE(mdebug_section, "No .mdebug section.");
+	
+	runner.run(elf_name, table_symbol_count, create_database, [&](std::unique_ptr<SymbolDatabase>& database) {
+		Result<SymbolSourceHandle> source = database->get_symbol_source("Synthetic");
+		CCC_EXIT_IF_ERROR(source);
+		
+		SymbolGroup group;
+		group.source = *source;
+		
+		Result<void> result = mdebug::import_symbol_table(
+			*database, elf->image, mdebug_section->header.offset, group, NO_IMPORTER_FLAGS, demangler, nullptr);
+		CCC_EXIT_IF_ERROR(result);
+	});
+}
+
+static void print_results(FILE* out, const std::vector<BenchmarkResult>& results)
+{
+	fprintf(out, "%-48s %8s %10s %14s %14s %14s\n",
+		"Benchmark", "Samples", "Items", "Median (ms)", "ns/item", "Items/s");
+	for(const BenchmarkResult& result : results) {
+		fprintf(out, "%-48s %8d %10llu %14.3f %14.2f %14.0f\n",
+			result.name.c_str(),
+			(s32) result.samples_ns.size(),
+			(unsigned long long) result.items,
+			result.median_ns / 1e6,
+			result.ns_per_item(),
+			1e9 / result.ns_per_item());
+	}
+}
+
+static void write_results(const fs::path& path, const std::vector<BenchmarkResult>& results)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	
+	writer.StartObject();
+	writer.Key("version");
+	writer.String(get_version());
+	writer.Key("benchmarks");
+	writer.StartArray();
+	for(const BenchmarkResult& result : results) {
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(result.name.c_str());
+		writer.Key("items");
+		writer.Uint64(result.items);
+		writer.Key("samples");
+		writer.Uint64(result.samples_ns.size());
+		writer.Key("min_ns");
+		writer.Uint64(result.min_ns);
+		writer.Key("median_ns");
+		writer.Uint64(result.median_ns);
+		writer.Key("mean_ns");
+		writer.Double(result.mean_ns);
+		writer.Key("ns_per_item");
+		writer.Double(result.ns_per_item());
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+	
+	FILE* file = fopen(path.string().c_str(), "w");
+	CCC_EXIT_IF_FALSE(file, "Failed to open output file '%s'.", path.string().c_str());
+	fprintf(file, "%s\n", buffer.GetString());
+	fclose(file);
+}
+
+static bool compare_with_baseline(
+	const fs::path& path, const std::vector<BenchmarkResult>& results, double tolerance_percent)
+{
+	std::optional<std::string> text = platform::read_text_file(path);
+	CCC_EXIT_IF_FALSE(text.has_value(), "Failed to read baseline file '%s'.", path.string().c_str());
+	
+	rapidjson::Document baseline;
+	baseline.Parse(text->c_str());
+	CCC_EXIT_IF_FALSE(!baseline.HasParseError() && baseline.IsObject() && baseline.HasMember("benchmarks"),
+		"Baseline file '%s' is not valid.", path.string().c_str());
+	
+	std::map<std::string, double> baseline_ns_per_item;
+	for(const rapidjson::Value& benchmark : baseline["benchmarks"].GetArray()) {
+		if(benchmark.HasMember("name") && benchmark.HasMember("ns_per_item")) {
+			baseline_ns_per_item[benchmark["name"].GetString()] = benchmark["ns_per_item"].GetDouble();
+		}
+	}
+	
+	printf("\n%-48s %14s %14s %10s\n", "Benchmark", "Baseline", "Current", "Change");
+	
+	bool success = true;
+	for(const BenchmarkResult& result : results) {
+		auto iterator = baseline_ns_per_item.find(result.name);
+		if(iterator == baseline_ns_per_item.end() || iterator->second <= 0.0) {
+			continue;
+		}
+		
+		double change_percent = (result.ns_per_item() / iterator->second - 1.0) * 100.0;
+		bool regressed = change_percent > tolerance_percent;
+		printf("%-48s %14.2f %14.2f %+9.1f%%%s\n",
+			result.name.c_str(), iterator->second, result.ns_per_item(), change_percent, regressed ? " REGRESSION" : "");
+		
+		if(regressed) {
+			success = false;
+		}
+	}
+	
+	return success;
+}
+
+static u64 now_ns()
+{
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::now().time_since_epoch();
+	return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+static Options parse_command_line_arguments(int argc, char** argv)
+{
+	Options options;
+	bool custom_scales = false;
+	for(s32 i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		if(strcmp(arg, "--filter") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing filter after --filter.");
+			options.filter = argv[++i];
+		} else if(strcmp(arg, "--scale") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing symbol count after --scale.");
+			if(!custom_scales) {
+				options.scales.clear();
+				custom_scales = true;
+			}
+			options.scales.emplace_back((u32) strtoul(argv[++i], nullptr, 10));
+		} else if(strcmp(arg, "--samples") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing sample count after --samples.");
+			options.min_samples = std::max((u32) strtoul(argv[++i], nullptr, 10), 1u);
+		} else if(strcmp(arg, "--min-time") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing time after --min-time.");
+			options.min_time_ns = (u64) (strtod(argv[++i], nullptr) * 1e9);
+		} else if(strcmp(arg, "--output") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing path after --output.");
+			options.output_path = argv[++i];
+		} else if(strcmp(arg, "--baseline") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing path after --baseline.");
+			options.baseline_path = argv[++i];
+		} else if(strcmp(arg, "--tolerance") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing percentage after --tolerance.");
+			options.tolerance_percent = strtod(argv[++i], nullptr);
+		} else if(strcmp(arg, "--write-elf") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing path after --write-elf.");
+			options.elf_path = argv[++i];
+		} else if(strcmp(arg, "--quick") == 0) {
+			options.quick = true;
+		} else if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+			print_help();
+			exit(0);
+		} else {
+			CCC_EXIT("Unknown option '%s'.", arg);
+		}
+	}
+	
+	if(options.quick) {
+		options.min_samples = 1;
+		options.min_time_ns = 0;
+		if(!custom_scales) {
+			options.scales = {10000};
+		}
+	}
+	
+	return options;
+}
+
+static void print_help()
+{
+	printf("ccc_bench %s -- https://github.com/chaoticgd/ccc\n", get_version());
+	printf("\n");
+	printf("usage: ccc_bench [options]\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  --filter <substring>          Only run benchmarks with names containing the\n");
+	printf("                                given string.\n");
+	printf("\n");
+	printf("  --scale <symbol count>        Run the end-to-end import benchmarks on a\n");
+	printf("                                synthetic symbol table with approximately the\n");
+	printf("                                given number of symbols. Can be passed multiple\n");
+	printf("                                times. Defaults to 100000, 500000 and 2000000.\n");
+	printf("\n");
+	printf("  --samples <count>             The minimum number of times to run each\n");
+	printf("                                benchmark. Defaults to 3.\n");
+	printf("\n");
+	printf("  --min-time <seconds>          The minimum amount of time to spend running\n");
+	printf("                                each benchmark. Defaults to 0.5.\n");
+	printf("\n");
+	printf("  --output <output file>        Write the results out as JSON.\n");
+	printf("\n");
+	printf("  --baseline <baseline file>    Compare the results against a JSON file\n");
+	printf("                                previously written out using --output, and\n");
+	printf("                                exit with a non-zero status code if any of the\n");
+	printf("                                benchmarks got slower.\n");
+	printf("\n");
+	printf("  --tolerance <percent>         How much slower a benchmark can get before it\n");
+	printf("                                is considered to have regressed. Defaults to 10.\n");
+	printf("\n");
+	printf("  --quick                       Run each benchmark once on a small input. This\n");
+	printf("                                is useful for checking that they still work.\n");
+	printf("\n");
+	printf("  --write-elf <output file>     Instead of running the benchmarks, write out an\n");
+	printf("                                ELF file containing a synthetic .mdebug symbol\n");
+	printf("                                table with the number of symbols given by the\n");
+	printf("                                first --scale option.\n");
+}
+
+extern const char* git_tag;
+
+static const char* get_version()
+{
+	return (git_tag && strlen(git_tag) > 0) ? git_tag : "development version";
+}
@@ -16,16 +16,21 @@ enum Flags {
 	FLAG_CALLER_STACK_OFFSETS = 1 << 1,
 	FLAG_LOCAL_SYMBOLS = 1 << 2,
 	FLAG_PROCEDURE_DESCRIPTORS = 1 << 3,
-	FLAG_EXTERNAL_SYMBOLS = 1 << 4
+	FLAG_EXTERNAL_SYMBOLS = 1 << 4,
+	FLAG_JSON = 1 << 5,
+	FLAG_COMPACT = 1 << 6,
+	FLAG_PIPELINED = 1 << 7
 };
 
 struct Options {
 	void (*function)(FILE* out, const Options& options) = nullptr;
 	fs::path input_file;
 	fs::path output_file;
+	fs::path trace_file;
 	u32 flags = NO_FLAGS;
 	u32 importer_flags = NO_IMPORTER_FLAGS;
 	std::vector<SymbolTableLocation> sections;
+	SymbolQuery query;
 };
 
 static void identify_symbol_tables(FILE* out, const Options& options);
@@ -43,6 +48,9 @@ static void print_headers(FILE* out, const Options& options);
 static void print_files(FILE* out, const Options& options);
 static void print_includes(FILE* out, const Options& options);
 static void print_sections(FILE* out, const Options& options);
+static void query_symbols(FILE* out, const Options& options);
+static void print_stats(FILE* out, const Options& options);
+static void print_stats_json(FILE* out, const SymbolDatabaseStats& stats, const CompactionStats* compaction);
 static SymbolDatabase read_symbol_table(std::unique_ptr<SymbolFile>& symbol_file, const Options& options);
 static std::vector<std::unique_ptr<SymbolTable>> select_symbol_tables(
 	SymbolFile& symbol_file, const std::vector<SymbolTableLocation>& sections);
@@ -102,6 +110,49 @@ static const StdumpCommand commands[] = {
 	}},
 	{print_sections, "sections", {
 		"List the names of the source files associated with each ELF section."
+	}},
+	{query_symbols, "query", {
+		"Print the symbols that match all of the filters specified, one per line.",
+		"",
+		"--kind <lists>                Only match symbols from the listed symbol lists",
+		"                              e.g. functions,global_variables.",
+		"",
+		"--name <pattern>              Match names, where * and ? are wildcards.",
+		"",
+		"--regex <regex>               Match names with an ECMAScript regex.",
+		"",
+		"--module <name>               Match symbols from the named module.",
+		"",
+		"--source <name>               Match symbols from the named symbol source.",
+		"",
+		"--file <pattern>              Match symbols from source files with paths",
+		"                              matching the pattern.",
+		"",
+		"--address-range <low> <high>  Match symbols starting in [low, high).",
+		"",
+		"--min-size <size>             Match symbols at least this many bytes in size.",
+		"",
+		"--max-size <size>             Match symbols at most this many bytes in size.",
+		"",
+		"--storage-class <class>       Match functions and globals with the given",
+		"                              storage class e.g. static.",
+		"",
+		"--location <location>         Match global variables in the given location",
+		"                              e.g. bss.",
+		"",
+		"--references <type name>      Match symbols with types that reference the",
+		"                              named data type.",
+		"",
+		"--json                        Print each match as a JSON object."
+	}},
+	{print_stats, "stats", {
+		"Print how much memory the symbol database is using, broken down by symbol",
+		"list, AST node type, symbol source and module.",
+		"",
+		"--compact                     Compact the symbol database first, and print",
+		"                              how many bytes were reclaimed.",
+		"",
+		"--json                        Print the statistics as JSON."
 	}}
 };
 
@@ -115,8 +166,16 @@ int main(int argc, char** argv)
 		CCC_EXIT_IF_FALSE(out, "Failed to open output file '%s'.", options.output_file.string().c_str());
 	}
 	
+	if(!options.trace_file.empty()) {
+		set_profiling_enabled(true);
+	}
+	
 	if(options.function) {
 		options.function(out, options);
+		if(!options.trace_file.empty()) {
+			Result<void> trace_result = finish_profile(stderr, options.trace_file.string());
+			CCC_EXIT_IF_ERROR(trace_result);
+		}
 	} else {
 		print_help(out);
 		return 1;
@@ -480,6 +539,201 @@ static void print_sections(FILE* out, const Options& options)
 	}
 }
 
+static void query_symbols(FILE* out, const Options& options)
+{
+	std::unique_ptr<SymbolFile> symbol_file;
+	SymbolDatabase database = read_symbol_table(symbol_file, options);
+	
+	// Only build the type reference index if it's going to be used.
+	TypeReferenceIndex type_references;
+	if(!options.query.referenced_type_name.empty()) {
+		type_references.build(database);
+	}
+	
+	run_symbol_query(database, options.query, &type_references, [&](const Symbol& symbol, SymbolDescriptor descriptor) {
+		if(options.flags & FLAG_JSON) {
+			rapidjson::StringBuffer buffer;
+			rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+			writer.StartObject();
+			writer.Key("kind");
+			writer.String(symbol_descriptor_to_string(descriptor));
+			writer.Key("handle");
+			writer.Uint(symbol.raw_handle());
+			writer.Key("name");
+			writer.String(symbol.name().c_str());
+			if(symbol.address().valid()) {
+				writer.Key("address");
+				writer.Uint(symbol.address().value);
+			}
+			writer.Key("size");
+			writer.Uint(symbol.size());
+			writer.EndObject();
+			fprintf(out, "%s\n", buffer.GetString());
+		} else {
+			if(symbol.address().valid()) {
+				fprintf(out, "%-18s %08x %8u %s\n",
+					symbol_descriptor_to_string(descriptor), symbol.address().value, symbol.size(), symbol.name().c_str());
+			} else {
+				fprintf(out, "%-18s -------- %8u %s\n",
+					symbol_descriptor_to_string(descriptor), symbol.size(), symbol.name().c_str());
+			}
+		}
+	});
+}
+
+static void print_stats(FILE* out, const Options& options)
+{
+	std::unique_ptr<SymbolFile> symbol_file;
+	SymbolDatabase database = read_symbol_table(symbol_file, options);
+	
+	std::optional<CompactionStats> compaction;
+	if(options.flags & FLAG_COMPACT) {
+		compaction = database.compact();
+	}
+	
+	SymbolDatabaseStats stats = compute_symbol_database_stats(database);
+	
+	if(options.flags & FLAG_JSON) {
+		print_stats_json(out, stats, compaction.has_value() ? &*compaction : nullptr);
+		return;
+	}
+	
+	fprintf(out, "%-20s %10s %12s %12s %12s %12s %12s %12s %12s %12s\n",
+		"Symbol List", "Count", "Records", "Address Map", "Name Map", "Module Map", "Strings", "AST Nodes", "Other", "Total");
+	for(const SymbolListStats& list : stats.symbol_lists) {
+		fprintf(out, "%-20s %10llu %12llu %12llu %12llu %12llu %12llu %12llu %12llu %12llu\n",
+			list.name,
+			(unsigned long long) list.records.count,
+			(unsigned long long) list.records.bytes,
+			(unsigned long long) list.address_map.bytes,
+			(unsigned long long) list.name_map.bytes,
+			(unsigned long long) list.module_map.bytes,
+			(unsigned long long) list.strings.bytes,
+			(unsigned long long) list.ast_nodes.bytes,
+			(unsigned long long) list.other.bytes,
+			(unsigned long long) list.total_bytes());
+	}
+	fprintf(out, "%-20s %10s %12s %12s %12s %12s %12s %12s %12s %12llu\n",
+		"Total", "", "", "", "", "", "", "", "", (unsigned long long) stats.total_bytes());
+	
+	fprintf(out, "\n%-24s %10s %12s\n", "AST Node", "Count", "Bytes");
+	for(s32 i = 0; i < AST_NODE_DESCRIPTOR_COUNT; i++) {
+		fprintf(out, "%-24s %10llu %12llu\n",
+			node_descriptor_to_string((ast::NodeDescriptor) i),
+			(unsigned long long) stats.ast_nodes[i].count,
+			(unsigned long long) stats.ast_nodes[i].bytes);
+	}
+	
+	fprintf(out, "\n%-24s %10s %12s\n", "Symbol Source", "Symbols", "Bytes");
+	for(const SymbolOwnerStats& source : stats.sources) {
+		fprintf(out, "%-24s %10llu %12llu\n",
+			source.name.c_str(), (unsigned long long) source.symbol_count, (unsigned long long) source.bytes);
+	}
+	
+	if(!stats.modules.empty()) {
+		fprintf(out, "\n%-24s %10s %12s\n", "Module", "Symbols", "Bytes");
+		for(const SymbolOwnerStats& module : stats.modules) {
+			fprintf(out, "%-24s %10llu %12llu\n",
+				module.name.c_str(), (unsigned long long) module.symbol_count, (unsigned long long) module.bytes);
+		}
+	}
+	
+	fprintf(out, "\nString pool: %llu strings, %llu bytes of characters.\n",
+		(unsigned long long) stats.string_pool.string_count, (unsigned long long) stats.string_pool.byte_count);
+	
+	if(compaction.has_value()) {
+		fprintf(out, "Compaction: %llu bytes reclaimed, %u nodes relocated.\n",
+			(unsigned long long) compaction->bytes_reclaimed, compaction->nodes_relocated);
+	}
+}
+
+static void print_stats_json(FILE* out, const SymbolDatabaseStats& stats, const CompactionStats* compaction)
+{
+	rapidjson::StringBuffer buffer;
+	JsonWriter writer(buffer);
+	
+	auto write_usage = [&](const char* key, const MemoryUsage& usage) {
+		writer.Key(key);
+		writer.StartObject();
+		writer.Key("count");
+		writer.Uint64(usage.count);
+		writer.Key("bytes");
+		writer.Uint64(usage.bytes);
+		writer.EndObject();
+	};
+	
+	auto write_owners = [&](const char* key, const std::vector<SymbolOwnerStats>& owners) {
+		writer.Key(key);
+		writer.StartArray();
+		for(const SymbolOwnerStats& owner : owners) {
+			writer.StartObject();
+			writer.Key("name");
+			writer.String(owner.name.c_str());
+			writer.Key("symbols");
+			writer.Uint64(owner.symbol_count);
+			writer.Key("bytes");
+			writer.Uint64(owner.bytes);
+			writer.EndObject();
+		}
+		writer.EndArray();
+	};
+	
+	writer.StartObject();
+	
+	writer.Key("symbol_lists");
+	writer.StartObject();
+	for(const SymbolListStats& list : stats.symbol_lists) {
+		writer.Key(symbol_descriptor_to_string(list.descriptor));
+		writer.StartObject();
+		write_usage("records", list.records);
+		write_usage("address_map", list.address_map);
+		write_usage("name_map", list.name_map);
+		write_usage("module_map", list.module_map);
+		write_usage("strings", list.strings);
+		write_usage("ast_nodes", list.ast_nodes);
+		write_usage("other", list.other);
+		writer.Key("total_bytes");
+		writer.Uint64(list.total_bytes());
+		writer.EndObject();
+	}
+	writer.EndObject();
+	
+	writer.Key("ast_nodes");
+	writer.StartObject();
+	for(s32 i = 0; i < AST_NODE_DESCRIPTOR_COUNT; i++) {
+		write_usage(node_descriptor_to_string((ast::NodeDescriptor) i), stats.ast_nodes[i]);
+	}
+	writer.EndObject();
+	
+	write_owners("sources", stats.sources);
+	write_owners("modules", stats.modules);
+	
+	writer.Key("string_pool");
+	writer.StartObject();
+	writer.Key("count");
+	writer.Uint64(stats.string_pool.string_count);
+	writer.Key("bytes");
+	writer.Uint64(stats.string_pool.byte_count);
+	writer.EndObject();
+	
+	if(compaction) {
+		writer.Key("compaction");
+		writer.StartObject();
+		writer.Key("bytes_reclaimed");
+		writer.Uint64(compaction->bytes_reclaimed);
+		writer.Key("nodes_relocated");
+		writer.Uint(compaction->nodes_relocated);
+		writer.EndObject();
+	}
+	
+	writer.Key("total_bytes");
+	writer.Uint64(stats.total_bytes());
+	
+	writer.EndObject();
+	
+	fprintf(out, "%s\n", buffer.GetString());
+}
+
 static SymbolDatabase read_symbol_table(std::unique_ptr<SymbolFile>& symbol_file, const Options& options)
 {
 	Result<std::vector<u8>> image = platform::read_binary_file(options.input_file);
@@ -498,7 +752,8 @@ static SymbolDatabase read_symbol_table(std::unique_ptr<SymbolFile>& symbol_file
 	demangler.cplus_demangle = cplus_demangle;
 	demangler.cplus_demangle_opname = cplus_demangle_opname;
 	
-	Result<ModuleHandle> module_handle = import_symbol_tables(
+	auto import_function = (options.flags & FLAG_PIPELINED) ? import_symbol_tables_pipelined : import_symbol_tables;
+	Result<ModuleHandle> module_handle = import_function(
 		database, symbol_file->name(), symbol_tables, options.importer_flags, demangler, nullptr);
 	CCC_EXIT_IF_ERROR(module_handle);
 	
@@ -545,6 +800,14 @@ static Options parse_command_line_arguments(int argc, char** argv)
 		u32 importer_flag = parse_importer_flag(arg);
 		if(importer_flag != NO_IMPORTER_FLAGS) {
 			options.importer_flags |= importer_flag;
+		} else if(strcmp(arg, "--profile") == 0) {
+			if(i + 1 < argc) {
+				std::optional<u32> profile = parse_importer_profile(argv[++i]);
+				CCC_EXIT_IF_FALSE(profile.has_value(), "Unknown profile '%s'.", argv[i]);
+				options.importer_flags |= *profile;
+			} else {
+				CCC_EXIT("Missing profile name after --profile.");
+			}
 		} else if(strcmp(arg, "--sort-by-address") == 0) {
 			options.flags |= FLAG_SORT_BY_ADDRESS;
 		} else if(strcmp(arg, "--caller-stack-offsets") == 0) {
@@ -561,6 +824,11 @@ static Options parse_command_line_arguments(int argc, char** argv)
 			} else {
 				CCC_EXIT("No output path specified.");
 			}
+		} else if(strcmp(arg, "--trace") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "No trace file path specified.");
+			options.trace_file = argv[++i];
+		} else if(strcmp(arg, "--pipelined") == 0) {
+			options.flags |= FLAG_PIPELINED;
 		} else if(strcmp(arg, "--section") == 0) {
 			if(i + 2 < argc) {
 				SymbolTableLocation& section = options.sections.emplace_back();
@@ -571,6 +839,52 @@ static Options parse_command_line_arguments(int argc, char** argv)
 			} else {
 				CCC_EXIT("Missing section name after --section.");
 			}
+		} else if(strcmp(arg, "--kind") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing symbol lists after --kind.");
+			std::optional<u32> descriptors = parse_symbol_descriptors(argv[++i]);
+			CCC_EXIT_IF_FALSE(descriptors.has_value(), "Invalid symbol lists '%s'.", argv[i]);
+			options.query.descriptors = *descriptors;
+		} else if(strcmp(arg, "--name") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing pattern after --name.");
+			options.query.name_glob = argv[++i];
+		} else if(strcmp(arg, "--regex") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing regex after --regex.");
+			Result<void> regex_result = options.query.set_name_regex(argv[++i]);
+			CCC_EXIT_IF_ERROR(regex_result);
+		} else if(strcmp(arg, "--module") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing module name after --module.");
+			options.query.module_name = argv[++i];
+		} else if(strcmp(arg, "--source") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing symbol source name after --source.");
+			options.query.source_name = argv[++i];
+		} else if(strcmp(arg, "--file") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing pattern after --file.");
+			options.query.source_file_glob = argv[++i];
+		} else if(strcmp(arg, "--address-range") == 0) {
+			CCC_EXIT_IF_FALSE(i + 2 < argc, "Missing addresses after --address-range.");
+			options.query.address_range.low = (u32) strtoul(argv[++i], nullptr, 0);
+			options.query.address_range.high = (u32) strtoul(argv[++i], nullptr, 0);
+		} else if(strcmp(arg, "--min-size") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing size after --min-size.");
+			options.query.min_size = (u32) strtoul(argv[++i], nullptr, 0);
+		} else if(strcmp(arg, "--max-size") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing size after --max-size.");
+			options.query.max_size = (u32) strtoul(argv[++i], nullptr, 0);
+		} else if(strcmp(arg, "--storage-class") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing storage class after --storage-class.");
+			options.query.storage_class = storage_class_from_string(argv[++i]);
+			CCC_EXIT_IF_FALSE(options.query.storage_class.has_value(), "Unknown storage class '%s'.", argv[i]);
+		} else if(strcmp(arg, "--location") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing location after --location.");
+			options.query.storage_location = global_storage_location_from_string(argv[++i]);
+			CCC_EXIT_IF_FALSE(options.query.storage_location.has_value(), "Unknown location '%s'.", argv[i]);
+		} else if(strcmp(arg, "--references") == 0) {
+			CCC_EXIT_IF_FALSE(i + 1 < argc, "Missing type name after --references.");
+			options.query.referenced_type_name = argv[++i];
+		} else if(strcmp(arg, "--json") == 0) {
+			options.flags |= FLAG_JSON;
+		} else if(strcmp(arg, "--compact") == 0) {
+			options.flags |= FLAG_COMPACT;
 		} else if(strncmp(arg, "--", 2) == 0) {
 			CCC_EXIT("Unknown option '%s'.", arg);
 		} else if(input_path_provided) {
@@ -608,6 +922,14 @@ static void print_help(FILE* out)
 	fprintf(out, "  --output | -o <output file>   Write the output to the file specified instead\n");
 	fprintf(out, "                                of to the standard output.\n");
 	fprintf(out, "\n");
+	fprintf(out, "  --trace <trace file>          Time each phase of the import process, print a\n");
+	fprintf(out, "                                summary to the standard error, and write out a\n");
+	fprintf(out, "                                trace that can be loaded into chrome://tracing.\n");
+	fprintf(out, "\n");
+	fprintf(out, "  --pipelined                   Parse the ELF and SNDLL symbol tables on worker\n");
+	fprintf(out, "                                threads while the .mdebug symbol table is being\n");
+	fprintf(out, "                                imported.\n");
+	fprintf(out, "\n");
 	
 	fprintf(out, "  --section <section> <format>  Explicitly specify a symbol table to load. This\n");
 	fprintf(out, "                                option can be used multiple times to specify\n");
@@ -12,6 +12,8 @@
 using namespace ccc;
 
 static int main_test(const fs::path& input_directory);
+static void test_mdebug_round_trip(std::span<const u8> image, s32 section_offset);
+static void check_symbols_equal(const mdebug::Symbol& lhs, const mdebug::Symbol& rhs);
 
 int main(int argc, char** argv)
 {
@@ -86,6 +88,96 @@ static int main_test(const fs::path& input_directory)
 				rapidjson::StringBuffer buffer;
 				JsonWriter writer(buffer);
 				write_json(writer, database, "test");
+				
+				// Test that the pipelined importer produces the same output.
+				SymbolDatabase pipelined_database;
+				Result<ModuleHandle> pipelined_handle = import_symbol_tables_pipelined(
+					pipelined_database, (*symbol_file)->name(), *symbol_tables, importer_flags, demangler, nullptr);
+				CCC_EXIT_IF_ERROR(pipelined_handle);
+				
+				rapidjson::StringBuffer pipelined_buffer;
+				JsonWriter pipelined_writer(pipelined_buffer);
+				write_json(pipelined_writer, pipelined_database, "test");
+				CCC_EXIT_IF_FALSE(strcmp(buffer.GetString(), pipelined_buffer.GetString()) == 0,
+					"Pipelined import produced different output.");
+				
+				// Test that importing the .mdebug section lazily produces the
+				// same symbols as importing it all in one go.
+				Result<ElfFile> elf = ElfFile::parse(*image);
+				const ElfSection* mdebug_section = elf.success() ? elf->lookup_section(".mdebug") : nullptr;
+				if(mdebug_section) {
+					// Test that writing out the .mdebug section again and
+					// reading it back in doesn't change the files and symbols
+					// that are parsed from it.
+					test_mdebug_round_trip(*image, mdebug_section->header.offset);
+					
+					SymbolDatabase eager_database;
+					SymbolDatabase lazy_database;
+					
+					SymbolGroup eager_group;
+					Result<SymbolSourceHandle> eager_source = eager_database.get_symbol_source("Eager");
+					CCC_EXIT_IF_ERROR(eager_source);
+					eager_group.source = *eager_source;
+					
+					SymbolGroup lazy_group;
+					Result<SymbolSourceHandle> lazy_source = lazy_database.get_symbol_source("Lazy");
+					CCC_EXIT_IF_ERROR(lazy_source);
+					lazy_group.source = *lazy_source;
+					
+					Result<void> eager_result = mdebug::import_symbol_table(
+						eager_database, *image, mdebug_section->header.offset, eager_group, importer_flags, demangler, nullptr);
+					CCC_EXIT_IF_ERROR(eager_result);
+					
+					mdebug::LazySymbolTable lazy_symbol_table;
+					Result<void> open_result = lazy_symbol_table.open(
+						*image, mdebug_section->header.offset, lazy_group, importer_flags, demangler);
+					CCC_EXIT_IF_ERROR(open_result);
+					
+					Result<void> lazy_result = lazy_symbol_table.load_all(lazy_database, nullptr);
+					CCC_EXIT_IF_ERROR(lazy_result);
+					
+					CCC_EXIT_IF_FALSE(lazy_database.functions.size() == eager_database.functions.size(),
+						"Lazy import produced a different number of functions.");
+					CCC_EXIT_IF_FALSE(lazy_database.global_variables.size() == eager_database.global_variables.size(),
+						"Lazy import produced a different number of global variables.");
+					CCC_EXIT_IF_FALSE(lazy_database.data_types.size() == eager_database.data_types.size(),
+						"Lazy import produced a different number of data types.");
+					CCC_EXIT_IF_FALSE(lazy_symbol_table.deferred_symbol_count() == 0,
+						"Lazy import left type names unresolved.");
+					
+					// Test that the importer profiles skip the right symbols.
+					for(const ImporterProfileInfo& profile : IMPORTER_PROFILES) {
+						SymbolDatabase profile_database;
+						
+						SymbolGroup profile_group;
+						Result<SymbolSourceHandle> profile_source = profile_database.get_symbol_source(profile.name);
+						CCC_EXIT_IF_ERROR(profile_source);
+						profile_group.source = *profile_source;
+						
+						Result<void> profile_result = mdebug::import_symbol_table(
+							profile_database,
+							*image,
+							mdebug_section->header.offset,
+							profile_group,
+							importer_flags | profile.flags,
+							demangler,
+							nullptr);
+						CCC_EXIT_IF_ERROR(profile_result);
+						
+						bool has_functions = profile_database.functions.size() > 0;
+						bool has_global_variables = profile_database.global_variables.size() > 0;
+						bool has_locals = profile_database.parameter_variables.size() > 0
+							|| profile_database.local_variables.size() > 0;
+						CCC_EXIT_IF_FALSE(!(profile.flags & NO_FUNCTIONS) || !has_functions,
+							"Profile '%s' imported functions.", profile.name);
+						CCC_EXIT_IF_FALSE(!(profile.flags & NO_GLOBAL_VARIABLES) || !has_global_variables,
+							"Profile '%s' imported global variables.", profile.name);
+						CCC_EXIT_IF_FALSE(!(profile.flags & (NO_FUNCTIONS | NO_LOCAL_VARIABLES)) || !has_locals,
+							"Profile '%s' imported parameters or local variables.", profile.name);
+						CCC_EXIT_IF_FALSE(profile_database.data_types.size() > 0 || eager_database.data_types.size() == 0,
+							"Profile '%s' didn't import any data types.", profile.name);
+					}
+				}
 			} else {
 				printf("%s", symbol_file.error().message.c_str());
 			}
@@ -96,3 +188,72 @@ static int main_test(const fs::path& input_directory)
 	
 	return 0;
 }
+
+static void test_mdebug_round_trip(std::span<const u8> image, s32 section_offset)
+{
+	mdebug::SymbolTableReader reader;
+	Result<void> reader_result = reader.init(image, section_offset);
+	CCC_EXIT_IF_ERROR(reader_result);
+	
+	std::vector<mdebug::File> files;
+	for(s32 i = 0; i < reader.file_count(); i++) {
+		Result<mdebug::File> file = reader.parse_file(i);
+		CCC_EXIT_IF_ERROR(file);
+		files.emplace_back(std::move(*file));
+	}
+	
+	Result<std::vector<mdebug::Symbol>> external_symbols = reader.parse_external_symbols();
+	CCC_EXIT_IF_ERROR(external_symbols);
+	
+	Result<std::vector<u8>> written_image = mdebug::write_elf_file_with_symbol_table(files, *external_symbols);
+	CCC_EXIT_IF_ERROR(written_image);
+	
+	Result<ElfFile> written_elf = ElfFile::parse(std::move(*written_image));
+	CCC_EXIT_IF_ERROR(written_elf);
+	
+	const ElfSection* written_section = written_elf->lookup_section(".mdebug");
+	CCC_EXIT_IF_FALSE(written_section, "Written ELF file has no .mdebug section.");
+	
+	mdebug::SymbolTableReader written_reader;
+	Result<void> written_reader_result = written_reader.init(written_elf->image, written_section->header.offset);
+	CCC_EXIT_IF_ERROR(written_reader_result);
+	
+	CCC_EXIT_IF_FALSE(written_reader.file_count() == reader.file_count(),
+		"Round trip through the .mdebug writer changed the number of files.");
+	for(s32 i = 0; i < written_reader.file_count(); i++) {
+		Result<mdebug::File> file = written_reader.parse_file(i);
+		CCC_EXIT_IF_ERROR(file);
+		
+		CCC_EXIT_IF_FALSE(file->address == files[i].address
+				&& file->working_dir == files[i].working_dir
+				&& file->command_line_path == files[i].command_line_path
+				&& file->full_path == files[i].full_path
+				&& file->symbols.size() == files[i].symbols.size(),
+			"Round trip through the .mdebug writer changed file %d.", i);
+		for(size_t j = 0; j < file->symbols.size(); j++) {
+			check_symbols_equal(file->symbols[j], files[i].symbols[j]);
+		}
+	}
+	
+	Result<std::vector<mdebug::Symbol>> written_external_symbols = written_reader.parse_external_symbols();
+	CCC_EXIT_IF_ERROR(written_external_symbols);
+	CCC_EXIT_IF_FALSE(written_external_symbols->size() == external_symbols->size(),
+		"Round trip through the .mdebug writer changed the number of external symbols.");
+	for(size_t i = 0; i < external_symbols->size(); i++) {
+		check_symbols_equal((*written_external_symbols)[i], (*external_symbols)[i]);
+	}
+}
+
+static void check_symbols_equal(const mdebug::Symbol& lhs, const mdebug::Symbol& rhs)
+{
+	bool equal = lhs.value == rhs.value
+		&& lhs.symbol_type == rhs.symbol_type
+		&& lhs.symbol_class == rhs.symbol_class
+		&& lhs.index == rhs.index
+		&& strcmp(lhs.string, rhs.string) == 0
+		&& (lhs.procedure_descriptor != nullptr) == (rhs.procedure_descriptor != nullptr);
+	if(equal && lhs.procedure_descriptor) {
+		equal = memcmp(lhs.procedure_descriptor, rhs.procedure_descriptor, sizeof(mdebug::ProcedureDescriptor)) == 0;
+	}
+	CCC_EXIT_IF_FALSE(equal, "Round trip through the .mdebug writer changed symbol '%s'.", rhs.string);
+}
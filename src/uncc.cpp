@@ -11,7 +11,9 @@ using namespace ccc;
 struct Options {
 	fs::path elf_path;
 	fs::path output_path;
+	fs::path trace_path;
 	u32 importer_flags = NO_IMPORTER_FLAGS;
+	bool pipelined = false;
 };
 
 struct FunctionsFile {
@@ -76,8 +78,13 @@ int main(int argc, char** argv)
 	Result<std::vector<std::unique_ptr<SymbolTable>>> symbol_tables = (*symbol_file)->get_all_symbol_tables();
 	CCC_EXIT_IF_ERROR(symbol_tables);
 	
+	if(!options.trace_path.empty()) {
+		set_profiling_enabled(true);
+	}
+	
 	SymbolDatabase database;
-	Result<ModuleHandle> module_handle = import_symbol_tables(
+	auto import_function = options.pipelined ? import_symbol_tables_pipelined : import_symbol_tables;
+	Result<ModuleHandle> module_handle = import_function(
 		database, (*symbol_file)->name(), *symbol_tables, options.importer_flags, demangler, nullptr);
 	CCC_EXIT_IF_ERROR(module_handle);
 	
@@ -86,6 +93,11 @@ int main(int argc, char** argv)
 	
 	mdebug::fill_in_pointers_to_member_function_definitions(database);
 	
+	if(!options.trace_path.empty()) {
+		Result<void> trace_result = finish_profile(stderr, options.trace_path.string());
+		CCC_EXIT_IF_ERROR(trace_result);
+	}
+	
 	// Group duplicate source file entries, filter out files not referenced in
 	// the SOURCES.txt file.
 	std::map<std::string, std::vector<SourceFileHandle>> path_to_source_file;
@@ -404,6 +416,22 @@ static Options parse_command_line_arguments(int argc, char** argv)
 		u32 importer_flag = parse_importer_flag(argv[i]);
 		if(importer_flag != NO_IMPORTER_FLAGS) {
 			options.importer_flags |= importer_flag;
+		} else if(strcmp(argv[i], "--profile") == 0) {
+			if(i + 1 < argc) {
+				std::optional<u32> profile = parse_importer_profile(argv[++i]);
+				CCC_EXIT_IF_FALSE(profile.has_value(), "Unknown profile '%s'.", argv[i]);
+				options.importer_flags |= *profile;
+			} else {
+				CCC_EXIT("Missing profile name after --profile.");
+			}
+		} else if(strcmp(argv[i], "--trace") == 0) {
+			if(i + 1 < argc) {
+				options.trace_path = argv[++i];
+			} else {
+				CCC_EXIT("Missing path after --trace.");
+			}
+		} else if(strcmp(argv[i], "--pipelined") == 0) {
+			options.pipelined = true;
 		} else if(strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
 			print_help(argc, argv);
 			return Options();
@@ -435,6 +463,15 @@ static void print_help(int argc, char** argv)
 	printf("\n");
 	printf("usage: %s [options] <input elf> <output directory>\n", (argc > 0) ? argv[0] : "uncc");
 	printf( "\n");
+	printf("Options:\n");
+	printf("  --trace <trace file>          Time each phase of the import process, print a\n");
+	printf("                                summary to the standard error, and write out a\n");
+	printf("                                trace that can be loaded into chrome://tracing.\n");
+	printf("\n");
+	printf("  --pipelined                   Parse the ELF and SNDLL symbol tables on worker\n");
+	printf("                                threads while the .mdebug symbol table is being\n");
+	printf("                                imported.\n");
+	printf("\n");
 	printf("Importer Options:\n");
 	print_importer_flags_help(stdout);
 	printf("\n");
@@ -0,0 +1,99 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/ast.h"
+#include "ccc/data_refinement.h"
+
+using namespace ccc;
+
+static std::unique_ptr<ast::BuiltIn> create_builtin(ast::BuiltInClass bclass, const char* name, s32 offset)
+{
+	std::unique_ptr<ast::BuiltIn> builtin = std::make_unique<ast::BuiltIn>();
+	builtin->bclass = bclass;
+	builtin->name = name;
+	builtin->offset_bytes = offset;
+	builtin->size_bytes = builtin_class_size(bclass);
+	return builtin;
+}
+
+TEST(CCCDataRefinement, ArrayOfStructs)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	// struct S { int a; float b[2]; };
+	std::unique_ptr<ast::StructOrUnion> s = std::make_unique<ast::StructOrUnion>();
+	s->size_bytes = 12;
+	s->fields.emplace_back(create_builtin(ast::BuiltInClass::SIGNED_32, "a", 0));
+	std::unique_ptr<ast::Array> b = std::make_unique<ast::Array>();
+	b->name = "b";
+	b->offset_bytes = 4;
+	b->size_bytes = 8;
+	b->element_count = 2;
+	b->element_type = create_builtin(ast::BuiltInClass::FLOAT_32, "", -1);
+	s->fields.emplace_back(std::move(b));
+	
+	Result<DataType*> data_type = database.data_types.create_symbol("S", *source);
+	CCC_GTEST_FAIL_IF_ERROR(data_type);
+	(*data_type)->set_type(std::move(s));
+	
+	// S variable[2];
+	std::unique_ptr<ast::TypeName> type_name = std::make_unique<ast::TypeName>();
+	type_name->data_type_handle = (*data_type)->handle();
+	type_name->size_bytes = 12;
+	ast::Array variable_type;
+	variable_type.element_type = std::move(type_name);
+	variable_type.element_count = 2;
+	variable_type.size_bytes = 24;
+	
+	ElfFile elf;
+	struct { s32 a; float b[2]; } data[2] = {{1, {1.5f, 2.f}}, {-3, {0.1f, 100000.f}}};
+	elf.image.resize(sizeof(data));
+	memcpy(elf.image.data(), data, sizeof(data));
+	ElfProgramHeader& segment = elf.segments.emplace_back();
+	segment.offset = 0;
+	segment.vaddr = 0x100000;
+	segment.filesz = sizeof(data);
+	
+	GlobalStorage storage;
+	storage.location = GlobalStorageLocation::DATA;
+	
+	VariableToRefine variable;
+	variable.address = 0x100000;
+	variable.storage = &storage;
+	variable.type = &variable_type;
+	ASSERT_TRUE(can_refine_variable(variable));
+	
+	DataRefiner refiner(database, elf);
+	Result<PreparedVariable> prepared = refiner.prepare_variable(variable);
+	CCC_GTEST_FAIL_IF_ERROR(prepared);
+	EXPECT_TRUE(prepared->is_list());
+	
+	std::string output;
+	refiner.write_variable(*prepared, 0, output);
+	EXPECT_EQ(output,
+		"{\n"
+		"\t/* [0] = */ {\n"
+		"\t\t/* .a = */ 1,\n"
+		"\t\t/* .b = */ {\n"
+		"\t\t\t/* [0] = */ 1.5f,\n"
+		"\t\t\t/* [1] = */ 2.f\n"
+		"\t\t}\n"
+		"\t},\n"
+		"\t/* [1] = */ {\n"
+		"\t\t/* .a = */ -3,\n"
+		"\t\t/* .b = */ {\n"
+		"\t\t\t/* [0] = */ 0.1f,\n"
+		"\t\t\t/* [1] = */ 100000.f\n"
+		"\t\t}\n"
+		"\t}\n"
+		"}");
+	
+	// Reading past the end of the segment should fail before anything is
+	// printed.
+	variable.address = 0x100004;
+	Result<PreparedVariable> out_of_bounds = refiner.prepare_variable(variable);
+	EXPECT_FALSE(out_of_bounds.success());
+}
@@ -0,0 +1,111 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/field_layout.h"
+
+using namespace ccc;
+
+static std::unique_ptr<ast::Node> create_field(const char* name, s32 offset, s32 size)
+{
+	std::unique_ptr<ast::BuiltIn> field = std::make_unique<ast::BuiltIn>();
+	field->bclass = ast::BuiltInClass::SIGNED_32;
+	field->name = name;
+	field->offset_bytes = offset;
+	field->size_bytes = size;
+	return field;
+}
+
+static std::unique_ptr<ast::Node> create_type_name(const char* name, DataTypeHandle handle, s32 offset, s32 size)
+{
+	std::unique_ptr<ast::TypeName> type_name = std::make_unique<ast::TypeName>();
+	type_name->name = name;
+	type_name->data_type_handle = handle;
+	type_name->offset_bytes = offset;
+	type_name->size_bytes = size;
+	return type_name;
+}
+
+TEST(CCCFieldLayout, FieldAtOffset)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	// struct Base { int base; };
+	std::unique_ptr<ast::StructOrUnion> base = std::make_unique<ast::StructOrUnion>();
+	base->size_bytes = 4;
+	base->fields.emplace_back(create_field("base", 0, 4));
+	Result<DataType*> base_symbol = database.data_types.create_symbol("Base", *source);
+	CCC_GTEST_FAIL_IF_ERROR(base_symbol);
+	(*base_symbol)->set_type(std::move(base));
+	DataTypeHandle base_handle = (*base_symbol)->handle();
+	
+	// struct Inner { int x; int y; };
+	std::unique_ptr<ast::StructOrUnion> inner = std::make_unique<ast::StructOrUnion>();
+	inner->size_bytes = 8;
+	inner->fields.emplace_back(create_field("x", 0, 4));
+	inner->fields.emplace_back(create_field("y", 4, 4));
+	Result<DataType*> inner_symbol = database.data_types.create_symbol("Inner", *source);
+	CCC_GTEST_FAIL_IF_ERROR(inner_symbol);
+	(*inner_symbol)->set_type(std::move(inner));
+	DataTypeHandle inner_handle = (*inner_symbol)->handle();
+	
+	// struct Outer : Base { int a; Inner b[4]; union { int u; int v; }; };
+	std::unique_ptr<ast::StructOrUnion> outer = std::make_unique<ast::StructOrUnion>();
+	outer->size_bytes = 44;
+	outer->base_classes.emplace_back(create_type_name("", base_handle, 0, 4));
+	outer->fields.emplace_back(create_field("a", 4, 4));
+	std::unique_ptr<ast::Array> b = std::make_unique<ast::Array>();
+	b->name = "b";
+	b->offset_bytes = 8;
+	b->size_bytes = 32;
+	b->element_count = 4;
+	b->element_type = create_type_name("", inner_handle, -1, 8);
+	outer->fields.emplace_back(std::move(b));
+	std::unique_ptr<ast::StructOrUnion> anonymous_union = std::make_unique<ast::StructOrUnion>();
+	anonymous_union->is_struct = false;
+	anonymous_union->offset_bytes = 40;
+	anonymous_union->size_bytes = 4;
+	anonymous_union->fields.emplace_back(create_field("u", 0, 4));
+	anonymous_union->fields.emplace_back(create_field("v", 0, 4));
+	outer->fields.emplace_back(std::move(anonymous_union));
+	Result<DataType*> outer_symbol = database.data_types.create_symbol("Outer", *source);
+	CCC_GTEST_FAIL_IF_ERROR(outer_symbol);
+	(*outer_symbol)->set_type(std::move(outer));
+	DataTypeHandle outer_handle = (*outer_symbol)->handle();
+	
+	FieldLayoutCache cache;
+	const DataType* outer_type = database.data_types.symbol_from_handle(outer_handle);
+	
+	std::shared_ptr<const FieldLayout> layout = cache.layout(*outer_type, database);
+	ASSERT_TRUE(layout);
+	EXPECT_EQ(layout->entries.size(), 5);
+	EXPECT_EQ(cache.layout(*outer_type, database), layout);
+	
+	std::optional<FieldLookupResult> base_field = cache.field_at_offset(*outer_type, 2, database);
+	ASSERT_TRUE(base_field.has_value());
+	EXPECT_EQ(base_field->path, "base");
+	EXPECT_EQ(base_field->offset_in_node, 2);
+	
+	std::optional<FieldLookupResult> nested = cache.field_at_offset(*outer_type, 8 + 3 * 8 + 4, database);
+	ASSERT_TRUE(nested.has_value());
+	EXPECT_EQ(nested->path, "b[3].y");
+	EXPECT_EQ(nested->offset_in_node, 0);
+	
+	std::optional<FieldLookupResult> union_member = cache.field_at_offset(*outer_type, 41, database);
+	ASSERT_TRUE(union_member.has_value());
+	EXPECT_EQ(union_member->path, "u");
+	
+	EXPECT_FALSE(cache.field_at_offset(*outer_type, 44, database).has_value());
+	
+	// Changing the type of the base class should invalidate the layout.
+	std::unique_ptr<ast::StructOrUnion> new_base = std::make_unique<ast::StructOrUnion>();
+	new_base->size_bytes = 4;
+	new_base->fields.emplace_back(create_field("renamed", 0, 4));
+	database.data_types.symbol_from_handle(base_handle)->set_type(std::move(new_base));
+	
+	std::optional<FieldLookupResult> renamed = cache.field_at_offset(*outer_type, 0, database);
+	ASSERT_TRUE(renamed.has_value());
+	EXPECT_EQ(renamed->path, "renamed");
+}
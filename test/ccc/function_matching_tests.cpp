@@ -0,0 +1,299 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/ast.h"
+#include "ccc/function_matching.h"
+
+using namespace ccc;
+
+static std::vector<u32> generate_code(u32 seed, s32 instruction_count)
+{
+	std::vector<u32> code;
+	for(s32 i = 0; i < instruction_count; i++) {
+		seed = seed * 1664525 + 1013904223;
+		code.emplace_back(seed);
+	}
+	return code;
+}
+
+static ElfFile create_elf(u32 base_address, const std::vector<std::vector<u32>>& functions)
+{
+	ElfFile elf;
+	for(const std::vector<u32>& function : functions) {
+		const u8* begin = (const u8*) function.data();
+		elf.image.insert(elf.image.end(), begin, begin + function.size() * 4);
+	}
+	ElfProgramHeader& segment = elf.segments.emplace_back();
+	segment.offset = 0;
+	segment.vaddr = base_address;
+	segment.filesz = (u32) elf.image.size();
+	return elf;
+}
+
+static std::vector<FunctionHandle> create_functions(
+	SymbolDatabase& database, u32 base_address, const std::vector<std::vector<u32>>& functions, bool named)
+{
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_ASSERT(source.success());
+	
+	std::vector<FunctionHandle> handles;
+	u32 address = base_address;
+	for(size_t i = 0; i < functions.size(); i++) {
+		std::string name = named ? "function" + std::to_string(i) : "";
+		Result<Function*> function = database.functions.create_symbol(name, address, *source, nullptr);
+		CCC_ASSERT(function.success());
+		(*function)->set_size((u32) functions[i].size() * 4);
+		handles.emplace_back((*function)->handle());
+		address += (u32) functions[i].size() * 4;
+	}
+	return handles;
+}
+
+class RecordingObserver : public SymbolDatabaseObserver {
+public:
+	void on_symbols_changed(const SymbolDatabaseChanges& changes) override
+	{
+		batches.emplace_back(changes);
+	}
+	
+	std::vector<SymbolDatabaseChanges> batches;
+};
+
+TEST(CCCFunctionMatching, ExactAndFuzzyMatches)
+{
+	std::vector<std::vector<u32>> source_code = {
+		generate_code(1, 200),
+		generate_code(2, 200),
+		generate_code(3, 200)
+	};
+	std::vector<std::vector<u32>> target_code = source_code;
+	
+	// Swap the order of the functions, modify the immediate of an instruction
+	// in one (should still be an exact match) and insert an extra instruction
+	// into another (should be a fuzzy match).
+	std::swap(target_code[0], target_code[2]);
+	target_code[1][10] ^= 0xffff;
+	target_code[0].insert(target_code[0].begin() + 100, 0x24020001);
+	
+	SymbolDatabase source_database;
+	std::vector<FunctionHandle> source_handles = create_functions(source_database, 0x100000, source_code, true);
+	ElfFile source_elf = create_elf(0x100000, source_code);
+	
+	SymbolDatabase target_database;
+	std::vector<FunctionHandle> target_handles = create_functions(target_database, 0x200000, target_code, false);
+	ElfFile target_elf = create_elf(0x200000, target_code);
+	
+	FunctionMatchingConfig config;
+	std::vector<FunctionSignature> source_signatures = compute_function_signatures(source_database, source_elf, config);
+	std::vector<FunctionSignature> target_signatures = compute_function_signatures(target_database, target_elf, config);
+	ASSERT_EQ(source_signatures.size(), 3);
+	ASSERT_EQ(target_signatures.size(), 3);
+	
+	std::vector<FunctionMatch> matches = match_functions(source_signatures, target_signatures, config);
+	ASSERT_EQ(matches.size(), 3);
+	
+	EXPECT_EQ(matches[0].source, source_handles[2]);
+	EXPECT_EQ(matches[0].target, target_handles[0]);
+	EXPECT_LT(matches[0].similarity, 1.f);
+	EXPECT_EQ(matches[1].source, source_handles[1]);
+	EXPECT_EQ(matches[1].target, target_handles[1]);
+	EXPECT_EQ(matches[1].similarity, 1.f);
+	EXPECT_EQ(matches[2].source, source_handles[0]);
+	EXPECT_EQ(matches[2].target, target_handles[2]);
+	EXPECT_EQ(matches[2].similarity, 1.f);
+}
+
+TEST(CCCFunctionMatching, TransferSymbols)
+{
+	std::vector<std::vector<u32>> code = {generate_code(1, 100)};
+	
+	SymbolDatabase source_database;
+	FunctionHandle source_handle = create_functions(source_database, 0x100000, code, true).at(0);
+	
+	Result<DataType*> data_type = source_database.data_types.create_symbol("Struct", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(data_type);
+	(*data_type)->set_type(std::make_unique<ast::StructOrUnion>());
+	
+	Result<ParameterVariable*> parameter = source_database.parameter_variables.create_symbol("param", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(parameter);
+	std::unique_ptr<ast::TypeName> type_name = std::make_unique<ast::TypeName>();
+	type_name->data_type_handle = (*data_type)->handle();
+	(*parameter)->set_type(std::move(type_name));
+	
+	Function* source_function = source_database.functions.symbol_from_handle(source_handle);
+	source_function->set_type(std::make_unique<ast::BuiltIn>());
+	source_function->set_parameter_variables(std::vector<ParameterVariableHandle>{(*parameter)->handle()}, source_database);
+	
+	SymbolDatabase target_database;
+	FunctionHandle target_handle = create_functions(target_database, 0x200000, code, false).at(0);
+	
+	Result<SymbolSourceHandle> target_source = target_database.get_symbol_source("Function Matching");
+	CCC_GTEST_FAIL_IF_ERROR(target_source);
+	SymbolGroup group;
+	group.source = *target_source;
+	
+	FunctionMatch match;
+	match.source = source_handle;
+	match.target = target_handle;
+	match.similarity = 1.f;
+	
+	RecordingObserver observer;
+	target_database.add_observer(&observer);
+	
+	Result<s32> functions_updated = transfer_function_symbols(target_database, source_database, std::span(&match, 1), group);
+	CCC_GTEST_FAIL_IF_ERROR(functions_updated);
+	EXPECT_EQ(*functions_updated, 1);
+	
+	const Function* target_function = target_database.functions.symbol_from_handle(target_handle);
+	ASSERT_TRUE(target_function);
+	EXPECT_EQ(target_function->name(), "function0");
+	EXPECT_EQ(target_database.functions.first_handle_from_name("function0"), target_handle);
+	ASSERT_TRUE(target_function->type());
+	EXPECT_EQ(target_function->type()->descriptor, ast::BUILTIN);
+	
+	// Validate that the new return type was reported to the observer.
+	target_database.flush_changes();
+	ASSERT_EQ(observer.batches.size(), 1);
+	bool function_retyped = false;
+	for(const SymbolListChanges& list : observer.batches[0].lists) {
+		if(list.descriptor == FUNCTION) {
+			function_retyped = list.retyped == std::vector<RawSymbolHandle>{target_handle.value};
+		}
+	}
+	EXPECT_TRUE(function_retyped);
+	target_database.remove_observer(&observer);
+	
+	ASSERT_TRUE(target_function->parameter_variables().has_value());
+	ASSERT_EQ(target_function->parameter_variables()->size(), 1);
+	const ParameterVariable* target_parameter = target_database.parameter_variables.symbol_from_handle(
+		target_function->parameter_variables()->at(0));
+	ASSERT_TRUE(target_parameter && target_parameter->type());
+	EXPECT_EQ(target_parameter->name(), "param");
+	
+	const DataType* target_data_type = target_database.data_types.symbol_from_handle(
+		target_parameter->type()->as<ast::TypeName>().data_type_handle);
+	ASSERT_TRUE(target_data_type);
+	EXPECT_EQ(target_data_type->name(), "Struct");
+	EXPECT_EQ(target_data_type->source(), *target_source);
+}
+
+TEST(CCCFunctionMatching, TransferSymbolsRollback)
+{
+	std::vector<std::vector<u32>> code = {generate_code(1, 100)};
+	
+	SymbolDatabase source_database;
+	FunctionHandle source_handle = create_functions(source_database, 0x100000, code, true).at(0);
+	
+	Result<DataType*> data_type = source_database.data_types.create_symbol("Struct", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(data_type);
+	(*data_type)->set_type(std::make_unique<ast::StructOrUnion>());
+	
+	Result<ParameterVariable*> parameter = source_database.parameter_variables.create_symbol("param", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(parameter);
+	
+	Function* source_function = source_database.functions.symbol_from_handle(source_handle);
+	std::unique_ptr<ast::TypeName> return_type = std::make_unique<ast::TypeName>();
+	return_type->data_type_handle = (*data_type)->handle();
+	source_function->set_type(std::move(return_type));
+	source_function->set_parameter_variables(std::vector<ParameterVariableHandle>{(*parameter)->handle()}, source_database);
+	
+	SymbolDatabase target_database;
+	FunctionHandle target_handle = create_functions(target_database, 0x200000, code, false).at(0);
+	
+	Result<SymbolSourceHandle> target_source = target_database.get_symbol_source("Function Matching");
+	CCC_GTEST_FAIL_IF_ERROR(target_source);
+	SymbolGroup group;
+	group.source = *target_source;
+	
+	// Make it so that creating the parameter will fail after the data type
+	// for the return type has been copied.
+	SymbolDatabaseHandleBlocks blocks = target_database.handle_blocks();
+	blocks.parameter_variables.end = blocks.parameter_variables.begin;
+	target_database.set_handle_blocks(blocks);
+	
+	FunctionMatch match;
+	match.source = source_handle;
+	match.target = target_handle;
+	match.similarity = 1.f;
+	
+	Result<s32> functions_updated = transfer_function_symbols(target_database, source_database, std::span(&match, 1), group);
+	EXPECT_FALSE(functions_updated.success());
+	EXPECT_FALSE(target_database.in_transaction());
+	
+	// Validate that the target database was left unchanged.
+	const Function* target_function = target_database.functions.symbol_from_handle(target_handle);
+	ASSERT_TRUE(target_function);
+	EXPECT_EQ(target_function->name(), "");
+	EXPECT_FALSE(target_function->type());
+	EXPECT_FALSE(target_function->parameter_variables().has_value());
+	EXPECT_EQ(target_database.data_types.size(), 0);
+	EXPECT_EQ(target_database.parameter_variables.size(), 0);
+}
+
+TEST(CCCFunctionMatching, TransferSymbolsDeduplicateTypes)
+{
+	std::vector<std::vector<u32>> code = {generate_code(1, 100), generate_code(2, 100)};
+	
+	SymbolDatabase source_database;
+	std::vector<FunctionHandle> source_handles = create_functions(source_database, 0x100000, code, true);
+	
+	// Create a recursive struct, and a different struct with the same name.
+	Result<DataType*> recursive_type = source_database.data_types.create_symbol("Struct", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(recursive_type);
+	DataTypeHandle recursive_handle = (*recursive_type)->handle();
+	std::unique_ptr<ast::StructOrUnion> recursive_struct = std::make_unique<ast::StructOrUnion>();
+	std::unique_ptr<ast::PointerOrReference> pointer = std::make_unique<ast::PointerOrReference>();
+	std::unique_ptr<ast::TypeName> pointer_type_name = std::make_unique<ast::TypeName>();
+	pointer_type_name->data_type_handle = recursive_handle;
+	pointer->value_type = std::move(pointer_type_name);
+	pointer->name = "next";
+	recursive_struct->fields.emplace_back(std::move(pointer));
+	(*recursive_type)->set_type(std::move(recursive_struct));
+	
+	Result<DataType*> other_type = source_database.data_types.create_symbol("Struct", *source_database.get_symbol_source("Source"));
+	CCC_GTEST_FAIL_IF_ERROR(other_type);
+	DataTypeHandle other_handle = (*other_type)->handle();
+	(*other_type)->set_type(std::make_unique<ast::StructOrUnion>());
+	
+	for(size_t i = 0; i < source_handles.size(); i++) {
+		std::unique_ptr<ast::TypeName> return_type = std::make_unique<ast::TypeName>();
+		return_type->data_type_handle = i == 0 ? recursive_handle : other_handle;
+		source_database.functions.symbol_from_handle(source_handles[i])->set_type(std::move(return_type));
+	}
+	
+	SymbolDatabase target_database;
+	std::vector<FunctionHandle> target_handles = create_functions(target_database, 0x200000, code, false);
+	
+	Result<SymbolSourceHandle> target_source = target_database.get_symbol_source("Function Matching");
+	CCC_GTEST_FAIL_IF_ERROR(target_source);
+	SymbolGroup group;
+	group.source = *target_source;
+	
+	// Transfer the symbols twice, so that the second time around all the data
+	// types already exist in the target database.
+	for(s32 pass = 0; pass < 2; pass++) {
+		std::vector<FunctionMatch> matches(source_handles.size());
+		for(size_t i = 0; i < source_handles.size(); i++) {
+			matches[i].source = source_handles[i];
+			matches[i].target = target_handles[i];
+			matches[i].similarity = 1.f;
+		}
+		
+		Result<s32> functions_updated = transfer_function_symbols(target_database, source_database, matches, group);
+		CCC_GTEST_FAIL_IF_ERROR(functions_updated);
+		EXPECT_EQ(*functions_updated, 2);
+		EXPECT_EQ(target_database.data_types.size(), 2);
+	}
+	
+	// Validate that the recursive struct still references itself.
+	const Function* target_function = target_database.functions.symbol_from_handle(target_handles[0]);
+	ASSERT_TRUE(target_function && target_function->type());
+	DataTypeHandle target_handle = target_function->type()->as<ast::TypeName>().data_type_handle;
+	const DataType* target_type = target_database.data_types.symbol_from_handle(target_handle);
+	ASSERT_TRUE(target_type && target_type->type());
+	const ast::StructOrUnion& target_struct = target_type->type()->as<ast::StructOrUnion>();
+	ASSERT_EQ(target_struct.fields.size(), 1);
+	const ast::PointerOrReference& target_pointer = target_struct.fields[0]->as<ast::PointerOrReference>();
+	EXPECT_EQ(target_pointer.value_type->as<ast::TypeName>().data_type_handle, target_handle);
+}
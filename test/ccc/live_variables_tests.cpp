@@ -0,0 +1,80 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/live_variables.h"
+
+using namespace ccc;
+
+static LocalVariableHandle create_local(
+	SymbolDatabase& database, SymbolSourceHandle source, const char* name, u32 low, u32 high, s32 stack_offset)
+{
+	Result<LocalVariable*> local_variable = database.local_variables.create_symbol(name, source);
+	EXPECT_TRUE(local_variable.success());
+	StackStorage storage;
+	storage.stack_pointer_offset = stack_offset;
+	(*local_variable)->storage = storage;
+	(*local_variable)->live_range = AddressRange(low, high);
+	return (*local_variable)->handle();
+}
+
+TEST(CCCLiveVariables, LiveVariablesAtAddress)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	Result<Function*> function = database.functions.create_symbol("func", 0x1000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(function);
+	(*function)->set_size(0x100);
+	(*function)->stack_frame_size = 32;
+	
+	// void func(int a0) { { int outer; { int inner; } } { int other; } static int s; }
+	Result<ParameterVariable*> parameter = database.parameter_variables.create_symbol("a0", *source);
+	CCC_GTEST_FAIL_IF_ERROR(parameter);
+	RegisterStorage register_storage;
+	register_storage.dbx_register_number = 4;
+	register_storage.is_by_reference = false;
+	(*parameter)->storage = register_storage;
+	ParameterVariableHandle parameter_handle = (*parameter)->handle();
+	
+	LocalVariableHandle outer = create_local(database, *source, "outer", 0x1010, 0x1060, -8);
+	LocalVariableHandle inner = create_local(database, *source, "inner", 0x1020, 0x1030, -12);
+	LocalVariableHandle other = create_local(database, *source, "other", 0x1070, 0x1080, -16);
+	
+	Result<LocalVariable*> static_local = database.local_variables.create_symbol("s", 0x5000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(static_local);
+	(*static_local)->storage = GlobalStorage();
+	LocalVariableHandle static_handle = (*static_local)->handle();
+	
+	Function* func = database.functions.symbol_from_handle((*function)->handle());
+	func->set_parameter_variables(std::vector<ParameterVariableHandle>{parameter_handle}, database);
+	func->set_local_variables(std::vector<LocalVariableHandle>{other, inner, static_handle, outer}, database);
+	
+	LiveVariableIndex index;
+	index.build(database);
+	
+	std::vector<LiveVariable> nested = index.live_variables_at(0x1024);
+	ASSERT_EQ(nested.size(), 4);
+	EXPECT_EQ(nested[0].parameter_variable, parameter_handle);
+	EXPECT_EQ(nested[0].storage, LiveVariableStorage::REGISTER);
+	EXPECT_EQ(nested[0].register_class, mips::RegisterClass::GPR);
+	EXPECT_EQ(nested[0].register_index, 4);
+	EXPECT_EQ(nested[1].local_variable, static_handle);
+	EXPECT_EQ(nested[1].global_address.value, 0x5000);
+	EXPECT_EQ(nested[2].local_variable, outer);
+	EXPECT_EQ(nested[2].stack_offset, 24);
+	EXPECT_FALSE(nested[2].stack_offset_relative_to_caller);
+	EXPECT_EQ(nested[3].local_variable, inner);
+	
+	// Live ranges are half open.
+	std::vector<LiveVariable> after = index.live_variables_at(0x1060);
+	EXPECT_EQ(after.size(), 2);
+	
+	std::vector<LiveVariable> last = index.live_variables_at(0x107c);
+	ASSERT_EQ(last.size(), 3);
+	EXPECT_EQ(last[2].local_variable, other);
+	
+	EXPECT_TRUE(index.live_variables_at(0x1100).empty());
+	EXPECT_EQ(index.function_at(0x10ff), (*function)->handle());
+}
@@ -3,6 +3,7 @@
 
 #include <gtest/gtest.h>
 #include "ccc/mdebug_importer.h"
+#include "ccc/stabs_to_ast.h"
 
 using namespace ccc;
 using namespace ccc::mdebug;
@@ -344,3 +345,270 @@ MDEBUG_IMPORTER_TEST(ComplicatedFunctionIOP,
 	EXPECT_EQ(database.local_variables.size(), 4);
 	EXPECT_EQ(database.parameter_variables.size(), 3);
 }
+
+// Synthetic example. An anonymous type referenced by its type number more than
+// once, where one of the references is qualified.
+MDEBUG_IMPORTER_TEST(AnonymousTypeReferencedTwice,
+	({
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "PointerPointer:t(1,2)=*(1,3)=*(1,1)"},
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "ConstPointer:t(1,4)=k(1,3)"},
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "Pointer:t(1,5)=(1,3)"}
+	}), {})
+{
+	DataType* const_pointer = database.data_types.symbol_from_handle(database.data_types.first_handle_from_name("ConstPointer"));
+	ASSERT_TRUE(const_pointer && const_pointer->type());
+	ASSERT_EQ(const_pointer->type()->descriptor, ast::POINTER_OR_REFERENCE);
+	EXPECT_TRUE(const_pointer->type()->is_const);
+	
+	DataType* pointer = database.data_types.symbol_from_handle(database.data_types.first_handle_from_name("Pointer"));
+	ASSERT_TRUE(pointer && pointer->type());
+	ASSERT_EQ(pointer->type()->descriptor, ast::POINTER_OR_REFERENCE);
+	EXPECT_FALSE(pointer->type()->is_const);
+	
+	const ast::Node& value_type = *pointer->type()->as<ast::PointerOrReference>().value_type;
+	ASSERT_EQ(value_type.descriptor, ast::TYPE_NAME);
+	ASSERT_TRUE(value_type.as<ast::TypeName>().unresolved_stabs);
+	EXPECT_EQ(value_type.as<ast::TypeName>().unresolved_stabs->type_name, "int");
+}
+
+static const std::string DEEPLY_NESTED_POINTER = "DeeplyNestedPointer:t(1,2)=" + std::string(1000, '*') + "(1,1)";
+
+MDEBUG_IMPORTER_TEST(DeeplyNestedPointer,
+	({
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), DEEPLY_NESTED_POINTER.c_str()}
+	}), {})
+{
+	DataType* data_type = database.data_types.symbol_from_handle(database.data_types.first_handle_from_name("DeeplyNestedPointer"));
+	ASSERT_TRUE(data_type && data_type->type());
+	
+	const ast::Node* node = data_type->type();
+	for(s32 i = 0; i < 1000; i++) {
+		ASSERT_EQ(node->descriptor, ast::POINTER_OR_REFERENCE);
+		node = node->as<ast::PointerOrReference>().value_type.get();
+	}
+	ASSERT_EQ(node->descriptor, ast::TYPE_NAME);
+}
+
+TEST(CCCMdebugImporter, TypeContainsItself)
+{
+	// This isn't real compiler output, but symbol tables can be corrupted.
+	mdebug::File input = {{
+		{0x00000000, SymbolType::NIL, SymbolClass::NIL, STABS_CODE(N_LSYM), "ContainsItself:t(1,1)=(1,2)=k(1,2)"}
+	}};
+	Result<SymbolDatabase> database = run_importer("TypeContainsItself", input, {});
+	EXPECT_FALSE(database.success());
+}
+
+TEST(CCCMdebugImporter, TypeContainsItselfNotStrict)
+{
+	const char* input = "ContainsItself:t(1,1)=(1,2)=k(1,2)";
+	Result<StabsSymbol> symbol = parse_stabs_symbol(input);
+	CCC_GTEST_FAIL_IF_ERROR(symbol);
+	
+	std::map<StabsTypeNumber, const StabsType*> stabs_types;
+	symbol->type->enumerate_numbered_types(stabs_types);
+	
+	StabsToAstCache cache;
+	
+	StabsToAstState state;
+	state.stabs_types = &stabs_types;
+	state.cache = &cache;
+	state.importer_flags = NO_IMPORTER_FLAGS;
+	
+	// Without STRICT_PARSING the cycle should be replaced with an error node.
+	Result<std::unique_ptr<ast::Node>> node = stabs_type_to_ast(*symbol->type, nullptr, state, false, false);
+	CCC_GTEST_FAIL_IF_ERROR(node);
+	
+	s32 error_count = 0;
+	ast::for_each_node(**node, ast::PREORDER_TRAVERSAL, [&](ast::Node& child) {
+		if(child.descriptor == ast::ERROR_NODE) {
+			EXPECT_NE(child.as<ast::Error>().message.find("contains itself"), std::string::npos);
+			error_count++;
+		}
+		return ast::EXPLORE_CHILDREN;
+	});
+	EXPECT_EQ(error_count, 1);
+	
+	// The type that contains itself was only partially converted, so it
+	// shouldn't have been cached.
+	for(const auto& [key, cached_node] : cache.nodes) {
+		EXPECT_FALSE(key.type_number.file == 1 && key.type_number.type == 2);
+	}
+}
+
+// Synthetic example. The first translation unit defines a struct and the
+// second one references it by name.
+static Result<std::vector<u8>> write_lazy_symbol_table(ProcedureDescriptor& procedure_descriptor)
+{
+	std::vector<mdebug::File> files(2);
+	
+	files[0].address = 0x100000;
+	files[0].command_line_path = "a.cpp";
+	files[0].symbols = {
+		{0x00000000, SymbolType::FILE_SYMBOL, SymbolClass::TEXT, 0,                  "a.cpp"},
+		{0xffffffff, SymbolType::NIL,         SymbolClass::INFO, STABS_CODE(STAB),   "@stabs"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "/game/"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "a.cpp"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_LSYM), "Shared:T(1,2)=s4x:(1,1),0,32;;"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_FUN),  "_Z1av:F(1,1)"},
+		{0x00100000, SymbolType::PROC,        SymbolClass::TEXT, 1,                  "_Z1av"},
+		{0x00000020, SymbolType::END,         SymbolClass::TEXT, 9,                  "_Z1av"}
+	};
+	files[0].symbols[7].procedure_descriptor = &procedure_descriptor;
+	
+	files[1].address = 0x100100;
+	files[1].command_line_path = "b.cpp";
+	files[1].symbols = {
+		{0x00000000, SymbolType::FILE_SYMBOL, SymbolClass::TEXT, 0,                  "b.cpp"},
+		{0xffffffff, SymbolType::NIL,         SymbolClass::INFO, STABS_CODE(STAB),   "@stabs"},
+		{0x00100100, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "/game/"},
+		{0x00100100, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "b.cpp"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_GSYM), "shared:G(1,2)=xsShared:"},
+		{0x00100100, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_FUN),  "_Z1bv:F(1,1)"},
+		{0x00100100, SymbolType::PROC,        SymbolClass::TEXT, 1,                  "_Z1bv"},
+		{0x00000040, SymbolType::END,         SymbolClass::TEXT, 9,                  "_Z1bv"}
+	};
+	files[1].symbols[7].procedure_descriptor = &procedure_descriptor;
+	
+	return write_elf_file_with_symbol_table(files, {});
+}
+
+TEST(CCCMdebugImporter, LazySymbolTableOpen)
+{
+	ProcedureDescriptor procedure_descriptor = {};
+	Result<std::vector<u8>> image = write_lazy_symbol_table(procedure_descriptor);
+	CCC_GTEST_FAIL_IF_ERROR(image);
+	
+	LazySymbolTable symbol_table;
+	Result<void> open_result = symbol_table.open(*image, 0x40, SymbolGroup(), NO_IMPORTER_FLAGS, DemanglerFunctions());
+	CCC_GTEST_FAIL_IF_ERROR(open_result);
+	
+	const std::vector<LazyTranslationUnit>& units = symbol_table.translation_units();
+	ASSERT_EQ(units.size(), 2);
+	
+	EXPECT_EQ(units[0].full_path, "/game/a.cpp");
+	EXPECT_EQ(units[0].address_range.low.value, 0x100000);
+	EXPECT_EQ(units[0].address_range.high.value, 0x100020);
+	ASSERT_EQ(units[0].functions.size(), 1);
+	EXPECT_EQ(units[0].functions[0].first, "_Z1av");
+	EXPECT_EQ(units[0].type_names, (std::vector<std::string>{"Shared", "int"}));
+	EXPECT_FALSE(units[0].loaded);
+	
+	EXPECT_EQ(units[1].full_path, "/game/b.cpp");
+	EXPECT_EQ(units[1].address_range.low.value, 0x100100);
+	EXPECT_EQ(units[1].address_range.high.value, 0x100140);
+	EXPECT_EQ(units[1].type_names, std::vector<std::string>{"int"});
+	
+	EXPECT_EQ(symbol_table.translation_unit_from_address(0x100000), 0);
+	EXPECT_EQ(symbol_table.translation_unit_from_address(0x10001c), 0);
+	EXPECT_EQ(symbol_table.translation_unit_from_address(0x100020), -1);
+	EXPECT_EQ(symbol_table.translation_unit_from_address(0x100120), 1);
+	EXPECT_EQ(symbol_table.translation_unit_from_address(0x100140), -1);
+	EXPECT_EQ(symbol_table.translation_unit_from_function("_Z1bv"), 1);
+	EXPECT_EQ(symbol_table.translation_unit_from_function("_Z1cv"), -1);
+}
+
+TEST(CCCMdebugImporter, LazySymbolTableLoadOnDemand)
+{
+	ProcedureDescriptor procedure_descriptor = {};
+	Result<std::vector<u8>> image = write_lazy_symbol_table(procedure_descriptor);
+	CCC_GTEST_FAIL_IF_ERROR(image);
+	
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Lazy");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	SymbolGroup group;
+	group.source = *source;
+	
+	LazySymbolTable symbol_table;
+	Result<void> open_result = symbol_table.open(*image, 0x40, group, NO_IMPORTER_FLAGS, DemanglerFunctions());
+	CCC_GTEST_FAIL_IF_ERROR(open_result);
+	EXPECT_EQ(database.functions.size(), 0);
+	
+	// Loading the second translation unit by address shouldn't load the first.
+	Result<void> address_result = symbol_table.load_address(database, 0x100120);
+	CCC_GTEST_FAIL_IF_ERROR(address_result);
+	EXPECT_FALSE(symbol_table.translation_units()[0].loaded);
+	EXPECT_TRUE(symbol_table.translation_units()[1].loaded);
+	EXPECT_TRUE(database.functions.first_handle_from_name("_Z1bv").valid());
+	EXPECT_FALSE(database.functions.first_handle_from_name("_Z1av").valid());
+	
+	// The struct is defined in the first translation unit, so the type of the
+	// global variable should be left unresolved until it's loaded.
+	GlobalVariable* global = database.global_variables.symbol_from_handle(
+		database.global_variables.first_handle_from_name("shared"));
+	ASSERT_TRUE(global && global->type());
+	ASSERT_EQ(global->type()->descriptor, ast::TYPE_NAME);
+	EXPECT_TRUE(global->type()->as<ast::TypeName>().unresolved_stabs);
+	EXPECT_EQ(symbol_table.deferred_symbol_count(), 1);
+	
+	Result<void> type_result = symbol_table.load_type(database, "Shared");
+	CCC_GTEST_FAIL_IF_ERROR(type_result);
+	EXPECT_TRUE(symbol_table.translation_units()[0].loaded);
+	EXPECT_EQ(symbol_table.deferred_symbol_count(), 0);
+	
+	global = database.global_variables.symbol_from_handle(
+		database.global_variables.first_handle_from_name("shared"));
+	ASSERT_TRUE(global && global->type());
+	const ast::TypeName& type_name = global->type()->as<ast::TypeName>();
+	EXPECT_FALSE(type_name.unresolved_stabs);
+	EXPECT_EQ(type_name.data_type_handle, database.data_types.first_handle_from_name("Shared").value);
+	
+	// Everything has been loaded already.
+	Result<void> function_result = symbol_table.load_function(database, "_Z1av");
+	CCC_GTEST_FAIL_IF_ERROR(function_result);
+	EXPECT_EQ(database.functions.size(), 2);
+}
+
+TEST(CCCMdebugImporter, LazySymbolTableLoadFailure)
+{
+	ProcedureDescriptor procedure_descriptor = {};
+	
+	// Synthetic example. There's an RBRAC symbol without a matching LBRAC.
+	std::vector<mdebug::File> files(1);
+	files[0].address = 0x100000;
+	files[0].command_line_path = "a.cpp";
+	files[0].symbols = {
+		{0x00000000, SymbolType::FILE_SYMBOL, SymbolClass::TEXT, 0,                  "a.cpp"},
+		{0xffffffff, SymbolType::NIL,         SymbolClass::INFO, STABS_CODE(STAB),   "@stabs"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "/game/"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),   "a.cpp"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_FUN),  "_Z1av:F(1,1)"},
+		{0x00100000, SymbolType::PROC,        SymbolClass::TEXT, 1,                  "_Z1av"},
+		{0x00000020, SymbolType::END,         SymbolClass::TEXT, 9,                  "_Z1av"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_RBRAC), ""}
+	};
+	files[0].symbols[6].procedure_descriptor = &procedure_descriptor;
+	
+	Result<std::vector<u8>> image = write_elf_file_with_symbol_table(files, {});
+	CCC_GTEST_FAIL_IF_ERROR(image);
+	
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Lazy");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	SymbolGroup group;
+	group.source = *source;
+	
+	LazySymbolTable symbol_table;
+	Result<void> open_result = symbol_table.open(*image, 0x40, group, NO_IMPORTER_FLAGS, DemanglerFunctions());
+	CCC_GTEST_FAIL_IF_ERROR(open_result);
+	
+	// Loading the translation unit should fail without leaving any symbols
+	// behind, so trying again doesn't create duplicates.
+	for(s32 attempt = 0; attempt < 2; attempt++) {
+		Result<bool> load_result = symbol_table.load_translation_unit(database, 0);
+		EXPECT_FALSE(load_result.success());
+		EXPECT_FALSE(symbol_table.translation_units()[0].loaded);
+		EXPECT_FALSE(database.in_transaction());
+		EXPECT_EQ(database.source_files.size(), 0);
+		EXPECT_EQ(database.functions.size(), 0);
+		EXPECT_EQ(database.data_types.size(), 0);
+	}
+}
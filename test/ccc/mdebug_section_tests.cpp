@@ -0,0 +1,102 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/mdebug_section.h"
+
+using namespace ccc;
+using namespace ccc::mdebug;
+
+#define STABS_CODE(code) ((code) + 0x8f300)
+
+TEST(CCCMdebugSection, WriteAndReadBack)
+{
+	ProcedureDescriptor procedure_descriptor = {};
+	procedure_descriptor.address = 0x100000;
+	procedure_descriptor.frame_size = 32;
+	procedure_descriptor.return_pc_register = 31;
+	
+	std::vector<File> files(2);
+	
+	files[0].address = 0x100000;
+	files[0].command_line_path = "src/main.cpp";
+	files[0].symbols = {
+		{0x00000000, SymbolType::FILE_SYMBOL, SymbolClass::TEXT, 60,                "src/main.cpp"},
+		{0xffffffff, SymbolType::NIL,         SymbolClass::INFO, STABS_CODE(STAB),  "@stabs"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),  "/home/user/game/"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_SO),  "src/main.cpp"},
+		{0x00000000, SymbolType::NIL,         SymbolClass::NIL,  STABS_CODE(N_LSYM), "int:t1=r1;-2147483648;2147483647;"},
+		{0x00100000, SymbolType::LABEL,       SymbolClass::TEXT, STABS_CODE(N_FUN), "main:F1"},
+		{0x00100000, SymbolType::PROC,        SymbolClass::TEXT, 1,                 "main"},
+		{0x00000020, SymbolType::END,         SymbolClass::TEXT, 9,                 "main"}
+	};
+	files[0].symbols[6].procedure_descriptor = &procedure_descriptor;
+	
+	files[1].address = 0x100020;
+	files[1].command_line_path = "empty.c";
+	
+	std::vector<Symbol> external_symbols = {
+		{0x00100000, SymbolType::PROC,   SymbolClass::TEXT, 6,       "main"},
+		{0x00200000, SymbolType::GLOBAL, SymbolClass::DATA, 0xfffff, "global"}
+	};
+	
+	Result<std::vector<u8>> image = write_elf_file_with_symbol_table(files, external_symbols);
+	CCC_GTEST_FAIL_IF_ERROR(image);
+	
+	// The section is placed right after the ELF file header.
+	SymbolTableReader reader;
+	Result<void> init_result = reader.init(*image, 0x40);
+	CCC_GTEST_FAIL_IF_ERROR(init_result);
+	ASSERT_EQ(reader.file_count(), 2);
+	
+	Result<File> main_file = reader.parse_file(0);
+	CCC_GTEST_FAIL_IF_ERROR(main_file);
+	EXPECT_EQ(main_file->address, 0x100000);
+	EXPECT_EQ(main_file->working_dir, "/home/user/game/");
+	EXPECT_EQ(main_file->command_line_path, "src/main.cpp");
+	EXPECT_EQ(main_file->full_path, "/home/user/game/src/main.cpp");
+	ASSERT_EQ(main_file->symbols.size(), files[0].symbols.size());
+	for(size_t i = 0; i < files[0].symbols.size(); i++) {
+		const Symbol& lhs = main_file->symbols[i];
+		const Symbol& rhs = files[0].symbols[i];
+		EXPECT_EQ(lhs.value, rhs.value);
+		EXPECT_EQ(lhs.symbol_type, rhs.symbol_type);
+		EXPECT_EQ(lhs.symbol_class, rhs.symbol_class);
+		EXPECT_EQ(lhs.index, rhs.index);
+		EXPECT_STREQ(lhs.string, rhs.string);
+		EXPECT_EQ(lhs.procedure_descriptor != nullptr, rhs.procedure_descriptor != nullptr);
+	}
+	
+	const ProcedureDescriptor* read_procedure_descriptor = main_file->symbols[6].procedure_descriptor;
+	ASSERT_TRUE(read_procedure_descriptor);
+	EXPECT_EQ(read_procedure_descriptor->address, 0x100000);
+	EXPECT_EQ(read_procedure_descriptor->symbol_index, 6);
+	EXPECT_EQ(read_procedure_descriptor->frame_size, 32);
+	EXPECT_EQ(read_procedure_descriptor->return_pc_register, 31);
+	
+	Result<File> empty_file = reader.parse_file(1);
+	CCC_GTEST_FAIL_IF_ERROR(empty_file);
+	EXPECT_EQ(empty_file->address, 0x100020);
+	EXPECT_EQ(empty_file->command_line_path, "empty.c");
+	EXPECT_TRUE(empty_file->symbols.empty());
+	
+	Result<std::vector<Symbol>> read_external_symbols = reader.parse_external_symbols();
+	CCC_GTEST_FAIL_IF_ERROR(read_external_symbols);
+	ASSERT_EQ(read_external_symbols->size(), 2);
+	EXPECT_EQ((*read_external_symbols)[1].value, 0x200000);
+	EXPECT_EQ((*read_external_symbols)[1].symbol_type, SymbolType::GLOBAL);
+	EXPECT_EQ((*read_external_symbols)[1].symbol_class, SymbolClass::DATA);
+	EXPECT_EQ((*read_external_symbols)[1].index, 0xfffff);
+	EXPECT_STREQ((*read_external_symbols)[1].string, "global");
+}
+
+TEST(CCCMdebugSection, WriteSymbolIndexOutOfRange)
+{
+	std::vector<File> files(1);
+	files[0].symbols = {
+		{0x00000000, SymbolType::LABEL, SymbolClass::TEXT, 0x100000, "too_big"}
+	};
+	
+	Result<std::vector<u8>> section = write_symbol_table(files, {}, 0);
+	EXPECT_FALSE(section.success());
+}
@@ -0,0 +1,150 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/memory_map.h"
+
+using namespace ccc;
+
+static std::unique_ptr<ast::Node> create_pointer(const char* name, DataTypeHandle handle, s32 offset)
+{
+	std::unique_ptr<ast::TypeName> value_type = std::make_unique<ast::TypeName>();
+	value_type->data_type_handle = handle;
+	value_type->size_bytes = 8;
+	
+	std::unique_ptr<ast::PointerOrReference> pointer = std::make_unique<ast::PointerOrReference>();
+	pointer->name = name;
+	pointer->offset_bytes = offset;
+	pointer->size_bytes = 4;
+	pointer->value_type = std::move(value_type);
+	return pointer;
+}
+
+TEST(CCCMemoryMap, FollowPointers)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	// struct Node { int value; Node* next; };
+	Result<DataType*> node_symbol = database.data_types.create_symbol("Node", *source);
+	CCC_GTEST_FAIL_IF_ERROR(node_symbol);
+	DataTypeHandle node_handle = (*node_symbol)->handle();
+	
+	std::unique_ptr<ast::StructOrUnion> node = std::make_unique<ast::StructOrUnion>();
+	node->size_bytes = 8;
+	std::unique_ptr<ast::BuiltIn> value = std::make_unique<ast::BuiltIn>();
+	value->bclass = ast::BuiltInClass::SIGNED_32;
+	value->name = "value";
+	value->size_bytes = 4;
+	node->fields.emplace_back(std::move(value));
+	node->fields.emplace_back(create_pointer("next", node_handle, 4));
+	(*node_symbol)->set_type(std::move(node));
+	
+	// Node* head;
+	Result<GlobalVariable*> head = database.global_variables.create_symbol("head", 0x1000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(head);
+	(*head)->set_type(create_pointer("", node_handle, 0));
+	
+	// Node tail;
+	Result<GlobalVariable*> tail = database.global_variables.create_symbol("tail", 0x1008, *source);
+	CCC_GTEST_FAIL_IF_ERROR(tail);
+	std::unique_ptr<ast::TypeName> tail_type = std::make_unique<ast::TypeName>();
+	tail_type->data_type_handle = node_handle;
+	tail_type->size_bytes = 8;
+	(*tail)->set_type(std::move(tail_type));
+	
+	// head -> 0x1020 -> 0x1030 -> tail, plus an unreachable node at 0x1040
+	// that points to 0x1030.
+	u32 memory[0x14] = {};
+	memory[0x0] = 0x1020; // head
+	memory[0x8] = 1; // *head
+	memory[0x9] = 0x1030;
+	memory[0xc] = 2; // *head->next
+	memory[0xd] = 0x1008;
+	memory[0x10] = 3;
+	memory[0x11] = 0x1030;
+	std::span<const u8> bytes((const u8*) memory, sizeof(memory));
+	
+	FieldLayoutCache cache;
+	
+	for(s32 thread_count : {1, 4}) {
+		MemoryMap map(database, bytes, 0x1000);
+		MemoryMapConfig config;
+		config.thread_count = thread_count;
+		map.build(config);
+		
+		ASSERT_EQ(map.objects().size(), 4);
+		EXPECT_EQ(map.objects()[2].address, 0x1020);
+		EXPECT_EQ(map.objects()[3].address, 0x1030);
+		EXPECT_EQ(map.objects()[3].depth, 2);
+		EXPECT_EQ(map.object_at_address(0x1040), -1);
+		
+		std::optional<MemoryMapLookupResult> second = map.lookup(0x1036, cache);
+		ASSERT_TRUE(second.has_value());
+		EXPECT_EQ(second->object_name, "*(*(head).next)");
+		EXPECT_EQ(second->field_path, "next");
+		EXPECT_EQ(second->offset_in_node, 2);
+		
+		std::optional<MemoryMapLookupResult> global = map.lookup(0x1009, cache);
+		ASSERT_TRUE(global.has_value());
+		EXPECT_EQ(global->object_name, "tail");
+		EXPECT_EQ(global->field_path, "value");
+	}
+}
+
+TEST(CCCMemoryMap, InteriorPointers)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	// struct Node { int value; Node* next; };
+	Result<DataType*> node_symbol = database.data_types.create_symbol("Node", *source);
+	CCC_GTEST_FAIL_IF_ERROR(node_symbol);
+	DataTypeHandle node_handle = (*node_symbol)->handle();
+	
+	std::unique_ptr<ast::StructOrUnion> node = std::make_unique<ast::StructOrUnion>();
+	node->size_bytes = 8;
+	std::unique_ptr<ast::BuiltIn> value = std::make_unique<ast::BuiltIn>();
+	value->bclass = ast::BuiltInClass::SIGNED_32;
+	value->name = "value";
+	value->size_bytes = 4;
+	node->fields.emplace_back(std::move(value));
+	node->fields.emplace_back(create_pointer("next", node_handle, 4));
+	(*node_symbol)->set_type(std::move(node));
+	
+	// Node* first; Node* second; Node* third;
+	const char* names[] = {"first", "second", "third"};
+	for(u32 i = 0; i < 3; i++) {
+		Result<GlobalVariable*> global = database.global_variables.create_symbol(names[i], 0x1000 + i * 4, *source);
+		CCC_GTEST_FAIL_IF_ERROR(global);
+		(*global)->set_type(create_pointer("", node_handle, 0));
+	}
+	
+	// The second global points into the middle of the node pointed to by the
+	// first one, and that node points into the middle of the node pointed to
+	// by the third one.
+	u32 memory[0xe] = {};
+	memory[0x0] = 0x1020; // first
+	memory[0x1] = 0x1024; // second
+	memory[0x2] = 0x1030; // third
+	memory[0x8] = 1; // *first
+	memory[0x9] = 0x1034;
+	memory[0xc] = 2; // *third
+	std::span<const u8> bytes((const u8*) memory, sizeof(memory));
+	
+	for(s32 thread_count : {1, 4}) {
+		MemoryMap map(database, bytes, 0x1000);
+		MemoryMapConfig config;
+		config.thread_count = thread_count;
+		map.build(config);
+		
+		// Neither of the interior pointers should create a new object.
+		ASSERT_EQ(map.objects().size(), 5);
+		EXPECT_EQ(map.objects()[3].address, 0x1020);
+		EXPECT_EQ(map.objects()[4].address, 0x1030);
+		EXPECT_EQ(map.object_at_address(0x1024), 3);
+		EXPECT_EQ(map.object_at_address(0x1034), 4);
+	}
+}
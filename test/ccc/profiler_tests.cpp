@@ -0,0 +1,85 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/profiler.h"
+
+#include <thread>
+
+using namespace ccc;
+
+static void recursive_scope(s32 depth)
+{
+	ProfileScope profile(ProfilePhase::STABS_TYPE_TO_AST);
+	if(depth > 0) {
+		recursive_scope(depth - 1);
+	}
+}
+
+TEST(CCCProfiler, SummaryAndTrace)
+{
+	reset_profile();
+	
+	// Nothing should be recorded while profiling is disabled.
+	{
+		ProfileScope profile(ProfilePhase::PARSE_FILE);
+		profile_count(ProfileCounter::PARSED_SYMBOLS, 10);
+	}
+	
+	set_profiling_enabled(true, 0);
+	
+	{
+		ProfileScope profile(ProfilePhase::TRANSLATION_UNIT, "main.cpp");
+		recursive_scope(5);
+		profile_count(ProfileCounter::PARSED_SYMBOLS, 3);
+	}
+	
+	std::thread thread([]() {
+		ProfileScope profile(ProfilePhase::TRANSLATION_UNIT, "other.cpp");
+		profile_count(ProfileCounter::PARSED_SYMBOLS, 2);
+	});
+	thread.join();
+	
+	set_profiling_enabled(false);
+	
+	ProfileSummary summary = collect_profile_summary();
+	EXPECT_EQ(summary.phases[(s32) ProfilePhase::PARSE_FILE].calls, 0);
+	EXPECT_EQ(summary.phases[(s32) ProfilePhase::TRANSLATION_UNIT].calls, 2);
+	// Nested scopes for the same phase are only counted once.
+	EXPECT_EQ(summary.phases[(s32) ProfilePhase::STABS_TYPE_TO_AST].calls, 1);
+	EXPECT_EQ(summary.counters[(s32) ProfileCounter::PARSED_SYMBOLS], 5);
+	
+	ASSERT_EQ(summary.translation_units.size(), 2);
+	EXPECT_NE(summary.translation_units[0].thread, summary.translation_units[1].thread);
+	
+	FILE* file = tmpfile();
+	ASSERT_TRUE(file);
+	write_profile_trace(file);
+	long size = ftell(file);
+	std::string trace(size, '\0');
+	rewind(file);
+	EXPECT_EQ(fread(trace.data(), 1, size, file), (size_t) size);
+	fclose(file);
+	EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+	EXPECT_NE(trace.find("\"detail\":\"other.cpp\""), std::string::npos);
+	EXPECT_NE(trace.find("\"name\":\"stabs_type_to_ast\""), std::string::npos);
+	
+	// Resetting the profile should free the buffers for each thread.
+	reset_profile();
+	ProfileSummary empty = collect_profile_summary();
+	EXPECT_EQ(empty.phases[(s32) ProfilePhase::TRANSLATION_UNIT].calls, 0);
+	EXPECT_TRUE(empty.threads.empty());
+	
+	// Threads that recorded before the reset should get a new buffer.
+	set_profiling_enabled(true, 0);
+	{
+		ProfileScope profile(ProfilePhase::PARSE_FILE);
+	}
+	set_profiling_enabled(false);
+	
+	ProfileSummary after_reset = collect_profile_summary();
+	ASSERT_EQ(after_reset.threads.size(), 1);
+	EXPECT_EQ(after_reset.phases[(s32) ProfilePhase::PARSE_FILE].calls, 1);
+	
+	reset_profile();
+}
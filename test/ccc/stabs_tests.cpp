@@ -258,3 +258,20 @@ STABS_IDENTIFIER_TEST(SingleQuoteCharacterLiteralInTypeName, "SingleQuoteCharact
 // template <char c> struct NonPrintableCharacterLiteralInTypeName {};
 // template struct NonPrintableCharacterLiteralInTypeName<'\xff'>;
 STABS_IDENTIFIER_TEST(NonPrintableCharacterLiteralInTypeName, "NonPrintableCharacterLiteralInTypeName<'\xff" "77777777'>");
+
+TEST(CCCStabs, DeeplyNestedPointer)
+{
+	// Make sure the parser doesn't run out of stack space.
+	std::string stab = "pointer:t1=" + std::string(10000, '*') + "2";
+	const char* input = stab.c_str();
+	Result<StabsSymbol> symbol = parse_stabs_symbol(input);
+	CCC_GTEST_FAIL_IF_ERROR(symbol);
+	
+	const StabsType* type = symbol->type.get();
+	for(s32 i = 0; i < 10000; i++) {
+		ASSERT_EQ(type->descriptor, StabsTypeDescriptor::POINTER);
+		type = type->as<StabsPointerType>().value_type.get();
+	}
+	ASSERT_FALSE(type->descriptor.has_value());
+	EXPECT_EQ(type->type_number.type, 2);
+}
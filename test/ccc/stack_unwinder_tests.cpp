@@ -0,0 +1,87 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/stack_unwinder.h"
+
+using namespace ccc;
+
+static FunctionHandle create_function(
+	SymbolDatabase& database,
+	SymbolSourceHandle source,
+	const char* name,
+	u32 address,
+	u32 size,
+	s32 frame_size,
+	u32 saved_register_mask,
+	s32 saved_register_offset)
+{
+	Result<Function*> function = database.functions.create_symbol(name, address, source);
+	EXPECT_TRUE(function.success());
+	(*function)->set_size(size);
+	(*function)->stack_frame_size = frame_size;
+	(*function)->saved_register_mask = saved_register_mask;
+	(*function)->saved_register_offset = saved_register_offset;
+	(*function)->return_pc_register = 31;
+	return (*function)->handle();
+}
+
+static void write_u32(std::vector<u8>& memory, u32 address, u32 value)
+{
+	memcpy(&memory[address], &value, 4);
+}
+
+TEST(CCCStackUnwinder, UnwindSamples)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	FunctionHandle main = create_function(database, *source, "main", 0x1000, 0x100, 32, 0x80000000, -16);
+	FunctionHandle foo = create_function(database, *source, "foo", 0x2000, 0x40, 16, 0x80000000, -8);
+	FunctionHandle leaf = create_function(database, *source, "leaf", 0x3000, 0x10, 0, 0, 0);
+	
+	UnwindTable table = build_unwind_table(database);
+	ASSERT_EQ(table.entries.size(), 3);
+	EXPECT_EQ(table.entries[1].return_address_offset, 8);
+	EXPECT_EQ(table.entry_at_address(0x2040), nullptr);
+	
+	std::vector<u8> memory(0x10000);
+	write_u32(memory, 0x2000, 0x27bdfff0); // addiu sp, sp, -16
+	write_u32(memory, 0x2004, 0xffbf0008); // sd ra, 8(sp)
+	write_u32(memory, 0x8008, 0x1050); // Return address from foo to main.
+	
+	std::vector<StackSample> samples(2);
+	
+	// Stopped inside a leaf function called from foo.
+	samples[0].registers.pc = 0x3004;
+	samples[0].registers.sp = 0x8000;
+	samples[0].registers.ra = 0x2010;
+	samples[0].memory = memory;
+	
+	// Stopped in the middle of the prologue of foo, before the return address
+	// has been saved.
+	samples[1].registers.pc = 0x2004;
+	samples[1].registers.sp = 0x7ff0;
+	samples[1].registers.ra = 0x1050;
+	samples[1].memory = memory;
+	
+	for(s32 thread_count : {1, 4}) {
+		BatchBacktraces backtraces = unwind_stacks(table, samples, thread_count);
+		
+		std::span<const BacktraceFrame> first = backtraces.backtrace(0);
+		ASSERT_EQ(first.size(), 3);
+		EXPECT_EQ(first[0].function, leaf);
+		EXPECT_EQ(first[1].function, foo);
+		EXPECT_EQ(first[1].pc, 0x2010);
+		EXPECT_EQ(first[2].function, main);
+		EXPECT_EQ(first[2].pc, 0x1050);
+		EXPECT_EQ(first[2].sp, 0x8010);
+		
+		std::span<const BacktraceFrame> second = backtraces.backtrace(1);
+		ASSERT_EQ(second.size(), 2);
+		EXPECT_EQ(second[0].function, foo);
+		EXPECT_EQ(second[1].function, main);
+		EXPECT_EQ(second[1].sp, 0x8000);
+	}
+}
@@ -0,0 +1,99 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <thread>
+#include <gtest/gtest.h>
+#include "ccc/string_pool.h"
+
+using namespace ccc;
+
+TEST(CCCStringPool, InternStrings)
+{
+	InternedString first = std::string("string_pool_test");
+	InternedString second = "string_pool_test";
+	InternedString other = std::string_view("string_pool_other");
+	
+	// Equal strings should share the same storage.
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(first.c_str(), second.c_str());
+	EXPECT_NE(first, other);
+	
+	EXPECT_EQ(first, "string_pool_test");
+	EXPECT_EQ(first, std::string("string_pool_test"));
+	EXPECT_EQ(first + "::x", "string_pool_test::x");
+	EXPECT_LT(other, first);
+	
+	InternedString empty;
+	EXPECT_TRUE(empty.empty());
+	EXPECT_EQ(empty, InternedString(""));
+	
+	StringPoolStats before = string_pool_stats();
+	InternedString again = "string_pool_test";
+	StringPoolStats after = string_pool_stats();
+	EXPECT_EQ(again, first);
+	EXPECT_EQ(before.string_count, after.string_count);
+	EXPECT_EQ(before.byte_count, after.byte_count);
+}
+
+TEST(CCCStringPool, ReclaimStrings)
+{
+	StringPoolStats before = string_pool_stats();
+	
+	{
+		InternedString first = "string_pool_reclaim";
+		InternedString copy = first;
+		InternedString moved = std::move(copy);
+		EXPECT_TRUE(copy.empty());
+		EXPECT_EQ(moved, first);
+		
+		StringPoolStats during = string_pool_stats();
+		EXPECT_EQ(during.string_count, before.string_count + 1);
+		EXPECT_EQ(during.byte_count, before.byte_count + strlen("string_pool_reclaim"));
+		
+		first = InternedString();
+		EXPECT_EQ(string_pool_stats().string_count, before.string_count + 1);
+	}
+	
+	// The string should be freed once the last reference is gone.
+	StringPoolStats after = string_pool_stats();
+	EXPECT_EQ(after.string_count, before.string_count);
+	EXPECT_EQ(after.byte_count, before.byte_count);
+}
+
+TEST(CCCStringPool, ConcurrentInterning)
+{
+	std::vector<std::vector<InternedString>> results(4);
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < results.size(); i++) {
+		threads.emplace_back([&results, i]() {
+			for(s32 j = 0; j < 1000; j++) {
+				results[i].emplace_back(InternedString("concurrent_" + std::to_string(j)));
+			}
+		});
+	}
+	
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+	
+	for(size_t i = 1; i < results.size(); i++) {
+		for(s32 j = 0; j < 1000; j++) {
+			EXPECT_EQ(results[i][j].c_str(), results[0][j].c_str());
+		}
+	}
+	
+	// Release the strings from multiple threads at the same time.
+	StringPoolStats before = string_pool_stats();
+	threads.clear();
+	for(size_t i = 0; i < results.size(); i++) {
+		threads.emplace_back([&results, i]() {
+			results[i].clear();
+		});
+	}
+	
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+	
+	EXPECT_EQ(string_pool_stats().string_count, before.string_count - 1000);
+}
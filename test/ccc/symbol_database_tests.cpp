@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include "ccc/ast.h"
 #include "ccc/importer_flags.h"
+#include "ccc/mdebug_importer.h"
 #include "ccc/symbol_database.h"
 
 using namespace ccc;
@@ -234,6 +235,210 @@ TEST(CCCSymbolDatabase, MergeSymbolLists)
 	EXPECT_TRUE(list.symbol_from_handle(other_handle));
 }
 
+TEST(CCCSymbolDatabase, HandlesIndependentOfOtherDatabases)
+{
+	SymbolDatabase first;
+	SymbolDatabase second;
+	
+	Result<SymbolSourceHandle> first_source = first.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(first_source);
+	Result<SymbolSourceHandle> second_source = second.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(second_source);
+	
+	EXPECT_EQ(*first_source, *second_source);
+}
+
+static void create_shard_functions(SymbolDatabase& database, SymbolSourceHandle source, const char* prefix)
+{
+	for(s32 i = 0; i < 3; i++) {
+		std::string name = std::string(prefix) + std::to_string(i);
+		Result<Function*> function = database.functions.create_symbol(name, source);
+		EXPECT_TRUE(function.success());
+	}
+}
+
+TEST(CCCSymbolDatabase, ShardedHandleBlocks)
+{
+	// Create the symbols for two shards in order in a single database.
+	SymbolDatabase sequential;
+	Result<SymbolSourceHandle> sequential_source = sequential.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(sequential_source);
+	
+	Result<SymbolDatabaseHandleBlocks> sequential_a = sequential.reserve_handles(8);
+	CCC_GTEST_FAIL_IF_ERROR(sequential_a);
+	Result<SymbolDatabaseHandleBlocks> sequential_b = sequential.reserve_handles(8);
+	CCC_GTEST_FAIL_IF_ERROR(sequential_b);
+	SymbolDatabaseHandleBlocks sequential_main = sequential.handle_blocks();
+	
+	sequential.set_handle_blocks(*sequential_a);
+	create_shard_functions(sequential, *sequential_source, "a");
+	sequential.set_handle_blocks(*sequential_b);
+	create_shard_functions(sequential, *sequential_source, "b");
+	sequential.set_handle_blocks(sequential_main);
+	
+	// Create the same symbols in separate databases, in the opposite order,
+	// and then merge them into the main database.
+	SymbolDatabase sharded;
+	Result<SymbolSourceHandle> sharded_source = sharded.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(sharded_source);
+	
+	Result<SymbolDatabaseHandleBlocks> sharded_a = sharded.reserve_handles(8);
+	CCC_GTEST_FAIL_IF_ERROR(sharded_a);
+	Result<SymbolDatabaseHandleBlocks> sharded_b = sharded.reserve_handles(8);
+	CCC_GTEST_FAIL_IF_ERROR(sharded_b);
+	
+	SymbolDatabase shard_b;
+	shard_b.set_handle_blocks(*sharded_b);
+	create_shard_functions(shard_b, *sharded_source, "b");
+	
+	SymbolDatabase shard_a;
+	shard_a.set_handle_blocks(*sharded_a);
+	create_shard_functions(shard_a, *sharded_source, "a");
+	
+	Result<void> merge_b = sharded.merge_from(shard_b);
+	CCC_GTEST_FAIL_IF_ERROR(merge_b);
+	Result<void> merge_a = sharded.merge_from(shard_a);
+	CCC_GTEST_FAIL_IF_ERROR(merge_a);
+	
+	ASSERT_EQ(sharded.functions.size(), sequential.functions.size());
+	for(s32 i = 0; i < sequential.functions.size(); i++) {
+		const Function& lhs = sequential.functions.symbol_from_index(i);
+		const Function& rhs = sharded.functions.symbol_from_index(i);
+		EXPECT_EQ(lhs.handle(), rhs.handle());
+		EXPECT_EQ(lhs.name(), rhs.name());
+	}
+	
+	// Symbols created afterwards should get the same handles too.
+	Result<Function*> sequential_after = sequential.functions.create_symbol("after", *sequential_source);
+	CCC_GTEST_FAIL_IF_ERROR(sequential_after);
+	Result<Function*> sharded_after = sharded.functions.create_symbol("after", *sharded_source);
+	CCC_GTEST_FAIL_IF_ERROR(sharded_after);
+	EXPECT_EQ((*sequential_after)->handle(), (*sharded_after)->handle());
+	
+	// Allocating from an earlier block should keep the list sorted.
+	SymbolDatabaseHandleBlocks unused_space = *sequential_a;
+	unused_space.functions.begin += 3;
+	sequential.set_handle_blocks(unused_space);
+	Result<Function*> late = sequential.functions.create_symbol("late", *sequential_source);
+	CCC_GTEST_FAIL_IF_ERROR(late);
+	EXPECT_EQ(sequential.functions.symbol_from_handle((*late)->handle()), *late);
+	EXPECT_EQ(sequential.functions.index_from_handle((*late)->handle()), 3);
+}
+
+#define STABS_CODE(code) ((code) + 0x8f300)
+
+static Result<void> import_test_symbol_table(SymbolDatabase& database, const std::string& prefix, u32 address)
+{
+	std::string struct_name = prefix + "Struct";
+	std::string struct_stab = struct_name + ":T(1,2)=s4x:(1,1),0,32;;";
+	std::string function_stab = prefix + ":F(1,1)";
+	std::string parameter_stab = "p:p(1,3)=*(1,2)";
+	
+	mdebug::ProcedureDescriptor procedure_descriptor = {};
+	procedure_descriptor.address = address;
+	
+	std::vector<mdebug::File> files(1);
+	files[0].address = address;
+	files[0].command_line_path = prefix + ".c";
+	files[0].symbols = {
+		{0x00000000, mdebug::SymbolType::NIL,   mdebug::SymbolClass::NIL,  STABS_CODE(mdebug::N_LSYM), "int:t(1,1)=r(1,1);-2147483648;2147483647;"},
+		{0x00000000, mdebug::SymbolType::NIL,   mdebug::SymbolClass::NIL,  STABS_CODE(mdebug::N_LSYM), struct_stab.c_str()},
+		{address,    mdebug::SymbolType::LABEL, mdebug::SymbolClass::TEXT, STABS_CODE(mdebug::N_FUN),  function_stab.c_str()},
+		{0x00000000, mdebug::SymbolType::NIL,   mdebug::SymbolClass::NIL,  STABS_CODE(mdebug::N_PSYM), parameter_stab.c_str()},
+		{address,    mdebug::SymbolType::PROC,  mdebug::SymbolClass::TEXT, 1,                          prefix.c_str()},
+		{0x00000020, mdebug::SymbolType::END,   mdebug::SymbolClass::TEXT, 6,                          prefix.c_str()},
+		{0xfffffff0, mdebug::SymbolType::NIL,   mdebug::SymbolClass::NIL,  STABS_CODE(mdebug::N_LSYM), "x:(1,1)"}
+	};
+	files[0].symbols[4].procedure_descriptor = &procedure_descriptor;
+	
+	Result<std::vector<u8>> image = mdebug::write_elf_file_with_symbol_table(files, {});
+	CCC_RETURN_IF_ERROR(image);
+	
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Symbol Table");
+	CCC_RETURN_IF_ERROR(source);
+	
+	SymbolGroup group;
+	group.source = *source;
+	
+	// The section is placed right after the ELF file header.
+	return mdebug::import_symbol_table(
+		database, *image, 0x40, group, NO_IMPORTER_FLAGS, DemanglerFunctions(), nullptr);
+}
+
+TEST(CCCSymbolDatabase, MergeSeparatelyImportedDatabases)
+{
+	SymbolDatabase database;
+	Result<void> first_result = import_test_symbol_table(database, "first", 0x100000);
+	CCC_GTEST_FAIL_IF_ERROR(first_result);
+	
+	SymbolDatabase other;
+	Result<void> second_result = import_test_symbol_table(other, "second", 0x200000);
+	CCC_GTEST_FAIL_IF_ERROR(second_result);
+	
+	// Both databases allocated their handles from the same range.
+	ASSERT_EQ(database.functions.size(), 1);
+	ASSERT_EQ(other.functions.size(), 1);
+	EXPECT_EQ(database.functions.symbol_from_index(0).handle(), other.functions.symbol_from_index(0).handle());
+	
+	Result<void> merge_result = database.merge_from(other);
+	CCC_GTEST_FAIL_IF_ERROR(merge_result);
+	EXPECT_EQ(other.functions.size(), 0);
+	ASSERT_EQ(database.functions.size(), 2);
+	ASSERT_EQ(database.symbol_sources.size(), 2);
+	
+	#define CCC_X(SymbolType, symbol_list) \
+		for(s32 i = 1; i < database.symbol_list.size(); i++) { \
+			EXPECT_LT(database.symbol_list.symbol_from_index(i - 1).handle(), database.symbol_list.symbol_from_index(i).handle()); \
+		}
+	CCC_FOR_EACH_SYMBOL_TYPE_DO_X
+	#undef CCC_X
+	
+	// Check that the references between the symbols from each database still
+	// point to the right symbols.
+	for(const char* prefix : {"first", "second"}) {
+		const Function* function = database.functions.symbol_from_handle(database.functions.first_handle_from_name(prefix));
+		ASSERT_TRUE(function);
+		
+		const SymbolSource* source = database.symbol_sources.symbol_from_handle(function->source());
+		ASSERT_TRUE(source);
+		EXPECT_EQ(source->name(), "Symbol Table");
+		
+		const SourceFile* source_file = database.source_files.symbol_from_handle(function->source_file());
+		ASSERT_TRUE(source_file);
+		EXPECT_EQ(source_file->name(), std::string(prefix) + ".c");
+		ASSERT_EQ(source_file->functions().size(), 1);
+		EXPECT_EQ(source_file->functions()[0], function->handle());
+		EXPECT_EQ(source_file->source(), function->source());
+		
+		ASSERT_TRUE(function->parameter_variables().has_value());
+		ASSERT_EQ(function->parameter_variables()->size(), 1);
+		const ParameterVariable* parameter = database.parameter_variables.symbol_from_handle((*function->parameter_variables())[0]);
+		ASSERT_TRUE(parameter && parameter->type());
+		EXPECT_EQ(parameter->function(), function->handle());
+		
+		ASSERT_EQ(parameter->type()->descriptor, ast::POINTER_OR_REFERENCE);
+		const ast::Node& value_type = *parameter->type()->as<ast::PointerOrReference>().value_type;
+		ASSERT_EQ(value_type.descriptor, ast::TYPE_NAME);
+		const DataType* data_type = database.data_types.symbol_from_handle(value_type.as<ast::TypeName>().data_type_handle);
+		ASSERT_TRUE(data_type);
+		EXPECT_EQ(data_type->name(), std::string(prefix) + "Struct");
+		ASSERT_EQ(data_type->files.size(), 1);
+		EXPECT_EQ(data_type->files[0], source_file->handle());
+		
+		ASSERT_TRUE(function->local_variables().has_value());
+		ASSERT_EQ(function->local_variables()->size(), 1);
+		const LocalVariable* local = database.local_variables.symbol_from_handle((*function->local_variables())[0]);
+		ASSERT_TRUE(local);
+		EXPECT_EQ(local->function(), function->handle());
+	}
+	
+	// New symbols shouldn't collide with the merged ones.
+	Result<Function*> after = database.functions.create_symbol("after", database.symbol_sources.symbol_from_index(0).handle());
+	CCC_GTEST_FAIL_IF_ERROR(after);
+	EXPECT_EQ(database.functions.symbol_from_handle((*after)->handle()), *after);
+	EXPECT_EQ(database.functions.size(), 3);
+}
+
 TEST(CCCSymbolDatabase, DestroySymbolsDanglingHandles)
 {
 	SymbolDatabase database;
@@ -339,6 +544,416 @@ TEST(CCCSymbolDatabase, DestroyFunction)
 	EXPECT_FALSE(database.local_variables.symbol_from_handle(local_handle));
 }
 
+TEST(CCCSymbolDatabase, DestroySymbolsFromModule)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	Result<Module*> first_module = database.modules.create_symbol("first.irx", 0x100000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(first_module);
+	ModuleHandle first_handle = (*first_module)->handle();
+	
+	Result<Module*> second_module = database.modules.create_symbol("second.irx", 0x200000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(second_module);
+	ModuleHandle second_handle = (*second_module)->handle();
+	
+	// Interleave the symbols from the two modules.
+	for(u32 i = 0; i < 10; i++) {
+		Module* module_symbol = database.modules.symbol_from_handle(i % 2 == 0 ? first_handle : second_handle);
+		Result<Function*> function = database.functions.create_symbol(
+			"func" + std::to_string(i), i * 0x10, source_handle, module_symbol);
+		CCC_GTEST_FAIL_IF_ERROR(function);
+	}
+	
+	EXPECT_EQ(database.functions.handles_from_module(first_handle).size(), 5);
+	EXPECT_EQ(database.functions.handles_from_module(second_handle).size(), 5);
+	EXPECT_EQ(database.modules.handles_from_module(first_handle).size(), 1);
+	
+	database.destroy_symbols_from_module(first_handle, true);
+	
+	EXPECT_FALSE(database.modules.symbol_from_handle(first_handle));
+	EXPECT_TRUE(database.functions.handles_from_module(first_handle).empty());
+	EXPECT_EQ(database.functions.size(), 5);
+	
+	// Make sure the remaining symbols are still in order and can be found.
+	std::span<const FunctionHandle> remaining = database.functions.handles_from_module(second_handle);
+	ASSERT_EQ(remaining.size(), 5);
+	for(s32 i = 0; i < 5; i++) {
+		const Function& function = database.functions.symbol_from_index(i);
+		EXPECT_EQ(function.handle(), remaining[i]);
+		EXPECT_EQ(function.name(), "func" + std::to_string(i * 2 + 1));
+		EXPECT_EQ(database.functions.first_handle_from_name(function.name()), function.handle());
+		EXPECT_EQ(database.functions.first_handle_from_starting_address(function.address()), function.handle());
+	}
+	
+	EXPECT_FALSE(database.functions.first_handle_from_name("func0").valid());
+}
+
+TEST(CCCSymbolDatabase, RollbackTransaction)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	Result<Function*> existing = database.functions.create_symbol("existing", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(existing);
+	FunctionHandle existing_handle = (*existing)->handle();
+	
+	Result<Function*> doomed = database.functions.create_symbol("doomed", 0x2000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(doomed);
+	FunctionHandle doomed_handle = (*doomed)->handle();
+	
+	Result<DataType*> data_type = database.data_types.create_symbol("Type", source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(data_type);
+	DataTypeHandle data_type_handle = (*data_type)->handle();
+	(*data_type)->set_type(std::make_unique<ast::BuiltIn>());
+	
+	database.begin_transaction();
+	EXPECT_TRUE(database.in_transaction());
+	
+	Result<Function*> created = database.functions.create_symbol("created", 0x3000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(created);
+	FunctionHandle created_handle = (*created)->handle();
+	
+	EXPECT_TRUE(database.functions.move_symbol(existing_handle, 0x4000));
+	EXPECT_TRUE(database.functions.rename_symbol(existing_handle, "renamed"));
+	EXPECT_TRUE(database.data_types.retype_symbol(data_type_handle, std::make_unique<ast::Enum>()));
+	EXPECT_TRUE(database.functions.mark_symbol_for_destruction(doomed_handle, &database));
+	database.destroy_marked_symbols();
+	
+	EXPECT_FALSE(database.functions.symbol_from_handle(doomed_handle));
+	
+	database.rollback_transaction();
+	EXPECT_FALSE(database.in_transaction());
+	
+	// Make sure everything is back the way it was.
+	EXPECT_EQ(database.functions.size(), 2);
+	EXPECT_FALSE(database.functions.symbol_from_handle(created_handle));
+	EXPECT_FALSE(database.functions.first_handle_from_starting_address(0x3000).valid());
+	EXPECT_EQ(database.functions.first_handle_from_starting_address(0x1000), existing_handle);
+	EXPECT_FALSE(database.functions.first_handle_from_starting_address(0x4000).valid());
+	EXPECT_EQ(database.functions.first_handle_from_name("existing"), existing_handle);
+	EXPECT_FALSE(database.functions.first_handle_from_name("renamed").valid());
+	
+	Function* restored = database.functions.symbol_from_handle(doomed_handle);
+	ASSERT_TRUE(restored);
+	EXPECT_FALSE(restored->is_marked_for_destruction());
+	EXPECT_EQ(database.functions.first_handle_from_starting_address(0x2000), doomed_handle);
+	
+	DataType* restored_type = database.data_types.symbol_from_handle(data_type_handle);
+	ASSERT_TRUE(restored_type && restored_type->type());
+	EXPECT_EQ(restored_type->type()->descriptor, ast::BUILTIN);
+	
+	// Handles aren't reused after a rollback.
+	Result<Function*> after = database.functions.create_symbol("after", source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(after);
+	EXPECT_NE((*after)->handle(), created_handle);
+}
+
+TEST(CCCSymbolDatabase, NestedTransactionsAndSavepoints)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	database.begin_transaction();
+	
+	Result<Label*> outer = database.labels.create_symbol("outer", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(outer);
+	LabelHandle outer_handle = (*outer)->handle();
+	
+	UndoSavepoint savepoint = database.savepoint();
+	
+	Result<Label*> discarded = database.labels.create_symbol("discarded", 0x2000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(discarded);
+	
+	database.rollback_to_savepoint(savepoint);
+	EXPECT_TRUE(database.in_transaction());
+	EXPECT_EQ(database.labels.size(), 1);
+	
+	// Commit an inner transaction, then roll back the outer one. This should
+	// undo the changes from both.
+	database.begin_transaction();
+	Result<Label*> inner = database.labels.create_symbol("inner", 0x3000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(inner);
+	database.labels.clear();
+	database.commit_transaction();
+	EXPECT_TRUE(database.in_transaction());
+	EXPECT_EQ(database.labels.size(), 0);
+	
+	database.rollback_transaction();
+	EXPECT_FALSE(database.in_transaction());
+	EXPECT_TRUE(database.labels.empty());
+	EXPECT_FALSE(database.labels.symbol_from_handle(outer_handle));
+	
+	// Committing should keep the changes.
+	database.begin_transaction();
+	Result<Label*> kept = database.labels.create_symbol("kept", 0x4000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(kept);
+	database.commit_transaction();
+	EXPECT_FALSE(database.in_transaction());
+	EXPECT_TRUE(database.labels.first_handle_from_starting_address(0x4000).valid());
+}
+
+TEST(CCCSymbolDatabase, SymbolsChangedSinceSavepoint)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	// Allocate the handles for the symbols created later from an earlier
+	// block, so they end up in the middle of the list.
+	Result<SymbolDatabaseHandleBlocks> blocks = database.reserve_handles(10);
+	CCC_GTEST_FAIL_IF_ERROR(blocks);
+	SymbolDatabaseHandleBlocks main_blocks = database.handle_blocks();
+	
+	Result<Function*> existing = database.functions.create_symbol("existing", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(existing);
+	FunctionHandle existing_handle = (*existing)->handle();
+	
+	Result<Function*> untouched = database.functions.create_symbol("untouched", 0x2000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(untouched);
+	
+	database.begin_transaction();
+	UndoSavepoint savepoint = database.savepoint();
+	
+	database.set_handle_blocks(*blocks);
+	Result<Function*> created = database.functions.create_symbol("created", 0x3000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(created);
+	FunctionHandle created_handle = (*created)->handle();
+	database.set_handle_blocks(main_blocks);
+	EXPECT_LT(created_handle, existing_handle);
+	
+	EXPECT_TRUE(database.functions.rename_symbol(existing_handle, "renamed"));
+	
+	std::vector<MultiSymbolHandle> expected = {
+		MultiSymbolHandle(FUNCTION, created_handle.value),
+		MultiSymbolHandle(FUNCTION, existing_handle.value)
+	};
+	EXPECT_EQ(database.symbols_changed_since(savepoint), expected);
+	
+	database.commit_transaction();
+}
+
+class RecordingObserver : public SymbolDatabaseObserver {
+public:
+	void on_symbols_changed(const SymbolDatabaseChanges& changes) override
+	{
+		batches.emplace_back(changes);
+	}
+	
+	std::vector<SymbolDatabaseChanges> batches;
+};
+
+TEST(CCCSymbolDatabase, ObserveChanges)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	Result<Function*> existing = database.functions.create_symbol("existing", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(existing);
+	FunctionHandle existing_handle = (*existing)->handle();
+	
+	RecordingObserver observer;
+	database.add_observer(&observer);
+	
+	// Nothing has happened yet.
+	database.flush_changes();
+	EXPECT_TRUE(observer.batches.empty());
+	
+	Result<Function*> created = database.functions.create_symbol("created", 0x2000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(created);
+	FunctionHandle created_handle = (*created)->handle();
+	EXPECT_TRUE(database.functions.move_symbol(created_handle, 0x3000));
+	
+	Result<Function*> temporary = database.functions.create_symbol("temporary", 0x4000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(temporary);
+	EXPECT_TRUE(database.functions.mark_symbol_for_destruction((*temporary)->handle(), &database));
+	database.destroy_marked_symbols();
+	
+	EXPECT_TRUE(database.functions.move_symbol(existing_handle, 0x5000));
+	EXPECT_TRUE(database.functions.move_symbol(existing_handle, 0x6000));
+	EXPECT_TRUE(database.functions.rename_symbol(existing_handle, "renamed"));
+	
+	database.flush_changes();
+	ASSERT_EQ(observer.batches.size(), 1);
+	ASSERT_EQ(observer.batches[0].lists.size(), 1);
+	
+	const SymbolListChanges& functions = observer.batches[0].lists[0];
+	EXPECT_EQ(functions.descriptor, FUNCTION);
+	EXPECT_EQ(functions.created, std::vector<RawSymbolHandle>{created_handle.value});
+	EXPECT_TRUE(functions.destroyed.empty());
+	EXPECT_EQ(functions.moved, std::vector<RawSymbolHandle>{existing_handle.value});
+	EXPECT_EQ(functions.renamed, std::vector<RawSymbolHandle>{existing_handle.value});
+	EXPECT_TRUE(functions.retyped.empty());
+	
+	// Changes that are rolled back cancel out, and the batch is delivered when
+	// the transaction ends.
+	database.begin_transaction();
+	Result<Label*> label = database.labels.create_symbol("label", 0x7000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(label);
+	database.rollback_transaction();
+	EXPECT_EQ(observer.batches.size(), 1);
+	
+	database.begin_transaction();
+	EXPECT_TRUE(database.functions.mark_symbol_for_destruction(created_handle, &database));
+	database.destroy_marked_symbols();
+	database.commit_transaction();
+	ASSERT_EQ(observer.batches.size(), 2);
+	ASSERT_EQ(observer.batches[1].lists.size(), 1);
+	EXPECT_EQ(observer.batches[1].lists[0].destroyed, std::vector<RawSymbolHandle>{created_handle.value});
+	
+	// Once the observer is removed it shouldn't be notified anymore.
+	database.remove_observer(&observer);
+	EXPECT_TRUE(database.functions.rename_symbol(existing_handle, "renamed again"));
+	database.flush_changes();
+	EXPECT_EQ(observer.batches.size(), 2);
+}
+
+TEST(CCCSymbolDatabase, NameIndex)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	Result<Function*> update = database.functions.create_symbol("PlayerUpdate", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(update);
+	FunctionHandle update_handle = (*update)->handle();
+	
+	// Symbols that exist before the index is enabled should be included.
+	database.enable_name_index();
+	const SymbolNameIndex* index = database.name_index();
+	ASSERT_TRUE(index);
+	
+	Result<GlobalVariable*> player = database.global_variables.create_symbol("g_player", 0x2000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(player);
+	GlobalVariableHandle player_handle = (*player)->handle();
+	
+	Result<Function*> render = database.functions.create_symbol("PlayerRender", 0x3000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(render);
+	FunctionHandle render_handle = (*render)->handle();
+	
+	// Labels don't have a name map, so they aren't indexed.
+	Result<Label*> label = database.labels.create_symbol("player_label", 0x4000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(label);
+	
+	// The symbol source is also indexed.
+	EXPECT_EQ(index->size(), 4);
+	EXPECT_EQ(index->find_substring("player"), (std::vector<MultiSymbolHandle>{
+		MultiSymbolHandle(FUNCTION, update_handle.value),
+		MultiSymbolHandle(FUNCTION, render_handle.value),
+		MultiSymbolHandle(GLOBAL_VARIABLE, player_handle.value)}));
+	EXPECT_EQ(index->find_substring("Player", FUNCTION, true).size(), 2);
+	EXPECT_EQ(index->find_substring("player", FUNCTION, true).size(), 0);
+	EXPECT_EQ(index->find_substring("g_", GLOBAL_VARIABLE).size(), 1);
+	EXPECT_EQ(index->find_substring("Missing").size(), 0);
+	
+	std::vector<SymbolNameMatch> similar = index->find_similar("PlayerUpdat", 2);
+	ASSERT_EQ(similar.size(), 2);
+	EXPECT_EQ(similar[0].symbol, MultiSymbolHandle(FUNCTION, update_handle.value));
+	
+	std::vector<SymbolNameMatch> misspelled = index->find_similar("PlyerUpdate", 1);
+	ASSERT_EQ(misspelled.size(), 1);
+	EXPECT_EQ(misspelled[0].symbol, MultiSymbolHandle(FUNCTION, update_handle.value));
+	
+	// The index should be kept up to date.
+	EXPECT_TRUE(database.functions.rename_symbol(render_handle, "EnemyRender"));
+	EXPECT_EQ(index->find_substring("render"), std::vector<MultiSymbolHandle>{MultiSymbolHandle(FUNCTION, render_handle.value)});
+	EXPECT_EQ(index->find_substring("player").size(), 2);
+	
+	EXPECT_TRUE(database.functions.mark_symbol_for_destruction(update_handle, &database));
+	database.destroy_marked_symbols();
+	EXPECT_EQ(index->find_substring("player"), std::vector<MultiSymbolHandle>{MultiSymbolHandle(GLOBAL_VARIABLE, player_handle.value)});
+	
+	database.begin_transaction();
+	Result<Function*> temporary = database.functions.create_symbol("TemporaryPlayer", 0x5000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(temporary);
+	EXPECT_EQ(index->find_substring("player").size(), 2);
+	database.rollback_transaction();
+	EXPECT_EQ(index->find_substring("player").size(), 1);
+	
+	database.clear();
+	EXPECT_EQ(index->size(), 0);
+	
+	database.disable_name_index();
+	EXPECT_FALSE(database.name_index());
+}
+
+TEST(CCCSymbolDatabase, Compact)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Source", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	SymbolSourceHandle source_handle = (*source)->handle();
+	
+	Result<SourceFile*> source_file = database.source_files.create_symbol("file.c", source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(source_file);
+	SourceFileHandle source_file_handle = (*source_file)->handle();
+	
+	Result<DataType*> data_type = database.data_types.create_symbol("Entity", source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(data_type);
+	DataTypeHandle data_type_handle = (*data_type)->handle();
+	(*data_type)->files = {source_file_handle};
+	(*source_file)->stabs_type_number_to_handle[StabsTypeNumber{1, 2}] = data_type_handle;
+	
+	std::unique_ptr<ast::StructOrUnion> struct_or_union = std::make_unique<ast::StructOrUnion>();
+	for(s32 i = 0; i < 3; i++) {
+		std::unique_ptr<ast::TypeName> field = std::make_unique<ast::TypeName>();
+		field->name = "field" + std::to_string(i);
+		field->data_type_handle = data_type_handle;
+		field->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>();
+		field->unresolved_stabs->type_name = "Entity";
+		struct_or_union->fields.emplace_back(std::move(field));
+	}
+	struct_or_union->fields.reserve(100);
+	
+	Result<GlobalVariable*> global_variable = database.global_variables.create_symbol("entities", 0x1000, source_handle);
+	CCC_GTEST_FAIL_IF_ERROR(global_variable);
+	(*global_variable)->set_type(std::move(struct_or_union));
+	u32 generation = (*global_variable)->generation();
+	
+	CompactionStats stats = database.compact();
+	EXPECT_GT(stats.bytes_reclaimed, 0);
+	EXPECT_EQ(stats.nodes_relocated, 4);
+	
+	const SourceFile& compacted_file = database.source_files.symbol_from_index(0);
+	EXPECT_TRUE(compacted_file.stabs_type_number_to_handle.empty());
+	EXPECT_TRUE(database.data_types.symbol_from_index(0).files.empty());
+	
+	const GlobalVariable& compacted_variable = database.global_variables.symbol_from_index(0);
+	EXPECT_NE(compacted_variable.generation(), generation);
+	ASSERT_TRUE(compacted_variable.type());
+	const ast::StructOrUnion& compacted_struct = compacted_variable.type()->as<ast::StructOrUnion>();
+	ASSERT_EQ(compacted_struct.fields.size(), 3);
+	EXPECT_EQ(compacted_struct.fields.capacity(), 3);
+	for(s32 i = 0; i < 3; i++) {
+		const ast::TypeName& field = compacted_struct.fields[i]->as<ast::TypeName>();
+		EXPECT_EQ(field.name, "field" + std::to_string(i));
+		EXPECT_EQ(field.data_type_handle, data_type_handle);
+		EXPECT_FALSE(field.unresolved_stabs);
+	}
+	
+	// Compacting again shouldn't change anything.
+	CompactionStats again = database.compact(NO_COMPACTION_FLAGS);
+	EXPECT_EQ(again.bytes_reclaimed, 0);
+	EXPECT_EQ(again.nodes_relocated, 0);
+}
+
 TEST(CCCSymbolDatabase, DeduplicateEqualTypes)
 {
 	SymbolDatabase database;
@@ -436,6 +1051,88 @@ TEST(CCCSymbolDatabase, DeduplicateWobblyTypedefs)
 	EXPECT_EQ(field->stabs_type_number.type, 2);
 }
 
+TEST(CCCSymbolDatabase, RollbackDeduplicatedType)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSource*> source = database.symbol_sources.create_symbol("Symbol Table", SymbolSourceHandle());
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	SymbolGroup group;
+	group.source = *source;
+	
+	Result<SourceFile*> file = database.source_files.create_symbol("File", (*source)->handle());
+	CCC_GTEST_FAIL_IF_ERROR(file);
+	SourceFileHandle file_handle = (*file)->handle();
+	
+	std::unique_ptr<ast::BuiltIn> underlying_type = std::make_unique<ast::BuiltIn>();
+	Result<DataType*> underlying_symbol = database.create_data_type_if_unique(
+		std::move(underlying_type), StabsTypeNumber{1,1}, "Underlying", **file, group);
+	CCC_GTEST_FAIL_IF_ERROR(underlying_symbol);
+	
+	std::unique_ptr<ast::TypeName> typedef_type = std::make_unique<ast::TypeName>();
+	typedef_type->storage_class = STORAGE_CLASS_TYPEDEF;
+	typedef_type->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>();
+	typedef_type->unresolved_stabs->type_name = "Underlying";
+	typedef_type->unresolved_stabs->referenced_file_handle = file_handle.value;
+	typedef_type->unresolved_stabs->stabs_type_number.file = 1;
+	typedef_type->unresolved_stabs->stabs_type_number.type = 1;
+	Result<DataType*> typedef_symbol = database.create_data_type_if_unique(
+		std::move(typedef_type), StabsTypeNumber{1,2}, "Typedef", **file, group);
+	CCC_GTEST_FAIL_IF_ERROR(typedef_symbol);
+	
+	std::unique_ptr<ast::StructOrUnion> struct_underlying_type = std::make_unique<ast::StructOrUnion>();
+	std::unique_ptr<ast::TypeName> member_underlying_type = std::make_unique<ast::TypeName>();
+	member_underlying_type->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>();
+	member_underlying_type->unresolved_stabs->type_name = "Underlying";
+	member_underlying_type->unresolved_stabs->referenced_file_handle = file_handle.value;
+	member_underlying_type->unresolved_stabs->stabs_type_number.file = 1;
+	member_underlying_type->unresolved_stabs->stabs_type_number.type = 1;
+	struct_underlying_type->fields.emplace_back(std::move(member_underlying_type));
+	Result<DataType*> struct_symbol = database.create_data_type_if_unique(
+		std::move(struct_underlying_type), StabsTypeNumber{1,3}, "WobblyStruct", **file, group);
+	CCC_GTEST_FAIL_IF_ERROR(struct_symbol);
+	DataTypeHandle struct_handle = (*struct_symbol)->handle();
+	
+	// Import a better version of the struct from another file, and then roll
+	// it back as if the import had failed.
+	database.begin_transaction();
+	
+	Result<SourceFile*> other_file = database.source_files.create_symbol("Other File", (*source)->handle());
+	CCC_GTEST_FAIL_IF_ERROR(other_file);
+	
+	std::unique_ptr<ast::StructOrUnion> struct_typedef_type = std::make_unique<ast::StructOrUnion>();
+	std::unique_ptr<ast::TypeName> member_typedef_type = std::make_unique<ast::TypeName>();
+	member_typedef_type->unresolved_stabs = std::make_unique<ast::TypeName::UnresolvedStabs>();
+	member_typedef_type->unresolved_stabs->type_name = "Typedef";
+	member_typedef_type->unresolved_stabs->referenced_file_handle = file_handle.value;
+	member_typedef_type->unresolved_stabs->stabs_type_number.file = 1;
+	member_typedef_type->unresolved_stabs->stabs_type_number.type = 2;
+	struct_typedef_type->fields.emplace_back(std::move(member_typedef_type));
+	Result<DataType*> deduplicated_symbol = database.create_data_type_if_unique(
+		std::move(struct_typedef_type), StabsTypeNumber{1,3}, "WobblyStruct", **other_file, group);
+	CCC_GTEST_FAIL_IF_ERROR(deduplicated_symbol);
+	
+	// Validate that the existing type was replaced.
+	DataType* replaced_type = database.data_types.symbol_from_handle(struct_handle);
+	ASSERT_TRUE(replaced_type && replaced_type->type());
+	EXPECT_EQ(replaced_type->files.size(), 2);
+	ast::StructOrUnion& replaced_struct = replaced_type->type()->as<ast::StructOrUnion>();
+	ASSERT_EQ(replaced_struct.fields.size(), 1);
+	EXPECT_EQ(replaced_struct.fields[0]->as<ast::TypeName>().unresolved_stabs->stabs_type_number.type, 2);
+	
+	database.rollback_transaction();
+	
+	// Validate that the original type and list of files were restored.
+	DataType* restored_type = database.data_types.symbol_from_handle(struct_handle);
+	ASSERT_TRUE(restored_type && restored_type->type());
+	ASSERT_EQ(restored_type->files.size(), 1);
+	EXPECT_EQ(restored_type->files[0], file_handle);
+	ast::StructOrUnion& restored_struct = restored_type->type()->as<ast::StructOrUnion>();
+	ASSERT_EQ(restored_struct.fields.size(), 1);
+	EXPECT_EQ(restored_struct.fields[0]->as<ast::TypeName>().unresolved_stabs->stabs_type_number.type, 1);
+}
+
 TEST(CCCSymbolDatabase, NodeHandle)
 {
 	SymbolDatabase database;
@@ -0,0 +1,129 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/symbol_query.h"
+
+using namespace ccc;
+
+static std::vector<std::string> query_names(
+	const SymbolDatabase& database, const SymbolQuery& query, const TypeReferenceIndex* type_references = nullptr)
+{
+	std::vector<std::string> names;
+	run_symbol_query(database, query, type_references, [&](const Symbol& symbol, SymbolDescriptor descriptor) {
+		names.emplace_back(symbol.name());
+	});
+	return names;
+}
+
+TEST(CCCSymbolQuery, FilterSymbols)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	Result<Module*> module_symbol = database.modules.create_symbol("module.irx", *source, nullptr);
+	CCC_GTEST_FAIL_IF_ERROR(module_symbol);
+	
+	Result<SourceFile*> source_file = database.source_files.create_symbol("src/player.c", *source);
+	CCC_GTEST_FAIL_IF_ERROR(source_file);
+	
+	Result<DataType*> entity = database.data_types.create_symbol("Entity", *source);
+	CCC_GTEST_FAIL_IF_ERROR(entity);
+	(*entity)->set_type(std::make_unique<ast::StructOrUnion>());
+	DataTypeHandle entity_handle = (*entity)->handle();
+	
+	Result<Function*> update = database.functions.create_symbol("player_update", 0x1000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(update);
+	(*update)->set_size(0x100);
+	(*update)->storage_class = STORAGE_CLASS_NONE;
+	FunctionHandle update_handle = (*update)->handle();
+	
+	Result<Function*> helper = database.functions.create_symbol("player_helper", 0x1100, *source);
+	CCC_GTEST_FAIL_IF_ERROR(helper);
+	(*helper)->set_size(0x20);
+	(*helper)->storage_class = STORAGE_CLASS_STATIC;
+	FunctionHandle helper_handle = (*helper)->handle();
+	
+	Result<Function*> irx_function = database.functions.create_symbol("_start", 0x2000, *source, *module_symbol);
+	CCC_GTEST_FAIL_IF_ERROR(irx_function);
+	(*irx_function)->set_size(0x40);
+	
+	Result<GlobalVariable*> player = database.global_variables.create_symbol("player", 0x5000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(player);
+	(*player)->set_size(0x30);
+	(*player)->storage.location = BSS;
+	(*player)->storage_class = STORAGE_CLASS_STATIC;
+	std::unique_ptr<ast::PointerOrReference> pointer = std::make_unique<ast::PointerOrReference>();
+	pointer->is_pointer = true;
+	std::unique_ptr<ast::TypeName> type_name = std::make_unique<ast::TypeName>();
+	type_name->data_type_handle = entity_handle;
+	pointer->value_type = std::move(type_name);
+	(*player)->set_type(std::move(pointer));
+	GlobalVariableHandle player_handle = (*player)->handle();
+	
+	(*source_file)->set_functions(std::vector<FunctionHandle>{update_handle, helper_handle}, database);
+	(*source_file)->set_global_variables(std::vector<GlobalVariableHandle>{player_handle}, database);
+	
+	SymbolQuery exact;
+	exact.name_glob = "player";
+	EXPECT_EQ(plan_symbol_query(exact, GLOBAL_VARIABLE, false), SymbolQueryPlan::NAME_MAP);
+	EXPECT_EQ(plan_symbol_query(exact, LABEL, false), SymbolQueryPlan::SCAN);
+	EXPECT_EQ(query_names(database, exact), std::vector<std::string>{"player"});
+	
+	SymbolQuery prefix;
+	prefix.name_glob = "player_*";
+	prefix.descriptors = FUNCTION;
+	EXPECT_EQ(plan_symbol_query(prefix, FUNCTION, false), SymbolQueryPlan::NAME_PREFIX);
+	EXPECT_EQ(query_names(database, prefix), (std::vector<std::string>{"player_update", "player_helper"}));
+	
+	SymbolQuery regex;
+	EXPECT_TRUE(regex.set_name_regex("_(up|help)").success());
+	EXPECT_EQ(query_names(database, regex), (std::vector<std::string>{"player_update", "player_helper"}));
+	EXPECT_FALSE(regex.set_name_regex("(").success());
+	
+	SymbolQuery module;
+	module.module_name = "module.irx";
+	EXPECT_EQ(plan_symbol_query(module, FUNCTION, false), SymbolQueryPlan::MODULE);
+	EXPECT_EQ(query_names(database, module), (std::vector<std::string>{"_start", "module.irx"}));
+	
+	SymbolQuery range;
+	range.address_range = AddressRange(0x1000, 0x2000);
+	range.min_size = 0x40;
+	EXPECT_EQ(plan_symbol_query(range, FUNCTION, false), SymbolQueryPlan::ADDRESS_MAP);
+	EXPECT_EQ(query_names(database, range), std::vector<std::string>{"player_update"});
+	
+	SymbolQuery file;
+	file.source_file_glob = "*/player.?";
+	file.descriptors = FUNCTION | GLOBAL_VARIABLE;
+	EXPECT_EQ(query_names(database, file), (std::vector<std::string>{"player_update", "player_helper", "player"}));
+	
+	SymbolQuery storage;
+	storage.storage_class = STORAGE_CLASS_STATIC;
+	EXPECT_EQ(query_names(database, storage), (std::vector<std::string>{"player_helper", "player"}));
+	storage.storage_location = BSS;
+	EXPECT_EQ(query_names(database, storage), std::vector<std::string>{"player"});
+	
+	SymbolQuery references;
+	references.referenced_type_name = "Entity";
+	EXPECT_EQ(plan_symbol_query(references, GLOBAL_VARIABLE, false), SymbolQueryPlan::SCAN);
+	EXPECT_EQ(query_names(database, references), std::vector<std::string>{"player"});
+	
+	TypeReferenceIndex type_references;
+	type_references.build(database);
+	EXPECT_EQ(type_references.symbols_referencing(entity_handle).size(), 1);
+	EXPECT_EQ(plan_symbol_query(references, GLOBAL_VARIABLE, true), SymbolQueryPlan::TYPE_REFERENCES);
+	EXPECT_EQ(query_names(database, references, &type_references), std::vector<std::string>{"player"});
+}
+
+TEST(CCCSymbolQuery, GlobMatch)
+{
+	EXPECT_TRUE(glob_match("", ""));
+	EXPECT_TRUE(glob_match("*", "anything"));
+	EXPECT_TRUE(glob_match("a*c", "abbbc"));
+	EXPECT_TRUE(glob_match("a?c", "abc"));
+	EXPECT_TRUE(glob_match("*.c", "dir/file.c"));
+	EXPECT_FALSE(glob_match("a?c", "ac"));
+	EXPECT_FALSE(glob_match("*.c", "file.cpp"));
+	EXPECT_FALSE(glob_match("abc", "ab"));
+}
@@ -0,0 +1,127 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <thread>
+#include <gtest/gtest.h>
+#include "ccc/symbol_snapshot.h"
+
+using namespace ccc;
+
+static Result<FunctionHandle> create_module_with_function(
+	SymbolDatabase& database, const char* module_name, const char* function_name, u32 address)
+{
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_RETURN_IF_ERROR(source);
+	
+	Result<Module*> module_symbol = database.modules.create_symbol(module_name, *source, nullptr);
+	CCC_RETURN_IF_ERROR(module_symbol);
+	
+	Result<Function*> function = database.functions.create_symbol(function_name, address, *source, *module_symbol);
+	CCC_RETURN_IF_ERROR(function);
+	(*function)->set_size(0x10);
+	
+	return (*function)->handle();
+}
+
+TEST(CCCSymbolSnapshot, PublishAndUnpublish)
+{
+	SymbolSnapshotPublisher publisher;
+	
+	std::shared_ptr<const SymbolDatabaseSnapshot> empty = publisher.snapshot();
+	EXPECT_EQ(empty->symbol_count(), 0);
+	
+	SymbolDatabase first;
+	publisher.prepare_database(first);
+	Result<FunctionHandle> first_function = create_module_with_function(first, "first.irx", "first", 0x1000);
+	CCC_GTEST_FAIL_IF_ERROR(first_function);
+	
+	Result<std::shared_ptr<const SymbolDatabase>> first_published = publisher.publish(std::move(first));
+	CCC_GTEST_FAIL_IF_ERROR(first_published);
+	
+	SymbolDatabase second;
+	publisher.prepare_database(second);
+	Result<FunctionHandle> second_function = create_module_with_function(second, "second.irx", "second", 0x2000);
+	CCC_GTEST_FAIL_IF_ERROR(second_function);
+	
+	// The handles shouldn't collide with those from the first database.
+	EXPECT_NE(*first_function, *second_function);
+	
+	Result<std::shared_ptr<const SymbolDatabase>> second_published = publisher.publish(std::move(second));
+	CCC_GTEST_FAIL_IF_ERROR(second_published);
+	
+	std::shared_ptr<const SymbolDatabaseSnapshot> both = publisher.snapshot();
+	EXPECT_EQ(both->databases().size(), 2);
+	EXPECT_GT(both->version(), empty->version());
+	
+	const Function* second_symbol = both->symbol_from_handle(*second_function);
+	ASSERT_TRUE(second_symbol);
+	EXPECT_EQ(second_symbol->name(), "second");
+	EXPECT_EQ(both->database_containing(*second_symbol), second_published->get());
+	EXPECT_EQ(both->symbol_overlapping_address(0x1008, FUNCTION), both->symbol_from_handle(*first_function));
+	EXPECT_EQ(both->symbol_with_name("second", FUNCTION), second_symbol);
+	
+	// Both databases should share a single symbol source.
+	const Function* first_symbol = both->symbol_from_handle(*first_function);
+	ASSERT_TRUE(first_symbol);
+	EXPECT_EQ(first_symbol->source(), second_symbol->source());
+	EXPECT_EQ(both->symbol_sources().size(), 1);
+	EXPECT_TRUE((*first_published)->symbol_sources.empty());
+	EXPECT_TRUE((*second_published)->symbol_sources.empty());
+	const SymbolSource* source = both->symbol_from_handle(second_symbol->source());
+	ASSERT_TRUE(source);
+	EXPECT_EQ(source->name(), "Source");
+	EXPECT_EQ(both->symbol_count(), 5);
+	
+	// Old snapshots should be unaffected.
+	EXPECT_EQ(empty->symbol_count(), 0);
+	
+	EXPECT_TRUE(publisher.unpublish(first_published->get()));
+	EXPECT_FALSE(publisher.unpublish(first_published->get()));
+	
+	std::shared_ptr<const SymbolDatabaseSnapshot> unloaded = publisher.snapshot();
+	EXPECT_FALSE(unloaded->symbol_from_handle(*first_function));
+	EXPECT_TRUE(unloaded->symbol_from_handle(*second_function));
+	EXPECT_TRUE(both->symbol_from_handle(*first_function));
+	EXPECT_TRUE(unloaded->symbol_from_handle(second_symbol->source()));
+	
+	// A database that wasn't prepared would reuse handles.
+	SymbolDatabase unprepared;
+	Result<FunctionHandle> unprepared_function = create_module_with_function(unprepared, "bad.irx", "bad", 0x3000);
+	CCC_GTEST_FAIL_IF_ERROR(unprepared_function);
+	EXPECT_FALSE(publisher.publish(std::move(unprepared)).success());
+}
+
+TEST(CCCSymbolSnapshot, ConcurrentReaders)
+{
+	SymbolSnapshotPublisher publisher;
+	
+	std::atomic_bool done = false;
+	std::atomic_bool consistent = true;
+	std::thread reader([&]() {
+		while(!done) {
+			// Every published database contains exactly two symbols, plus the
+			// symbol source which is shared between all of them.
+			std::shared_ptr<const SymbolDatabaseSnapshot> snapshot = publisher.snapshot();
+			s32 database_count = (s32) snapshot->databases().size();
+			if(snapshot->symbol_count() != database_count * 2 + (database_count > 0)) {
+				consistent = false;
+			}
+		}
+	});
+	
+	for(u32 i = 0; i < 100; i++) {
+		SymbolDatabase database;
+		publisher.prepare_database(database);
+		std::string name = "module" + std::to_string(i);
+		Result<FunctionHandle> function = create_module_with_function(database, name.c_str(), "func", i * 0x10);
+		EXPECT_TRUE(function.success());
+		EXPECT_TRUE(publisher.publish(std::move(database)).success());
+	}
+	
+	done = true;
+	reader.join();
+	
+	EXPECT_TRUE(consistent);
+	EXPECT_EQ(publisher.snapshot()->databases().size(), 100);
+	EXPECT_EQ(publisher.snapshot()->symbol_sources().size(), 1);
+}
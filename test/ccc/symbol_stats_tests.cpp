@@ -0,0 +1,74 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/symbol_stats.h"
+
+using namespace ccc;
+
+static const SymbolListStats& list_stats(const SymbolDatabaseStats& stats, SymbolDescriptor descriptor)
+{
+	for(const SymbolListStats& list : stats.symbol_lists) {
+		if(list.descriptor == descriptor) {
+			return list;
+		}
+	}
+	static SymbolListStats empty;
+	return empty;
+}
+
+TEST(CCCSymbolStats, CountSymbolsAndNodes)
+{
+	SymbolDatabase database;
+	
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	Result<Module*> module_symbol = database.modules.create_symbol("module.irx", *source, nullptr);
+	CCC_GTEST_FAIL_IF_ERROR(module_symbol);
+	
+	Result<Function*> function = database.functions.create_symbol("stats_function", 0x1000, *source);
+	CCC_GTEST_FAIL_IF_ERROR(function);
+	(*function)->line_numbers.resize(10);
+	
+	Result<GlobalVariable*> global = database.global_variables.create_symbol("stats_global", 0x2000, *source, *module_symbol);
+	CCC_GTEST_FAIL_IF_ERROR(global);
+	std::unique_ptr<ast::StructOrUnion> struct_or_union = std::make_unique<ast::StructOrUnion>();
+	for(s32 i = 0; i < 2; i++) {
+		std::unique_ptr<ast::BuiltIn> field = std::make_unique<ast::BuiltIn>();
+		// Both fields have the same name, so the string should only be
+		// counted once.
+		field->name = "stats_field";
+		struct_or_union->fields.emplace_back(std::move(field));
+	}
+	(*global)->set_type(std::move(struct_or_union));
+	
+	SymbolDatabaseStats stats = compute_symbol_database_stats(database);
+	
+	const SymbolListStats& functions = list_stats(stats, FUNCTION);
+	EXPECT_EQ(functions.records.count, 1);
+	EXPECT_GE(functions.records.bytes, sizeof(Function));
+	EXPECT_EQ(functions.address_map.count, 1);
+	EXPECT_EQ(functions.name_map.count, 1);
+	EXPECT_GE(functions.other.bytes, 10 * sizeof(Function::LineNumberPair));
+	EXPECT_EQ(functions.strings.count, 1);
+	
+	const SymbolListStats& globals = list_stats(stats, GLOBAL_VARIABLE);
+	EXPECT_EQ(globals.ast_nodes.count, 3);
+	EXPECT_EQ(globals.module_map.count, 1);
+	EXPECT_EQ(globals.strings.count, 2);
+	
+	EXPECT_EQ(stats.ast_nodes[ast::STRUCT_OR_UNION].count, 1);
+	EXPECT_EQ(stats.ast_nodes[ast::BUILTIN].count, 2);
+	EXPECT_EQ(stats.ast_nodes[ast::BUILTIN].bytes, 2 * sizeof(ast::BuiltIn));
+	
+	ASSERT_EQ(stats.sources.size(), 1);
+	EXPECT_EQ(stats.sources[0].name, "Source");
+	EXPECT_EQ(stats.sources[0].symbol_count, 4);
+	
+	ASSERT_EQ(stats.modules.size(), 1);
+	EXPECT_EQ(stats.modules[0].name, "module.irx");
+	EXPECT_EQ(stats.modules[0].symbol_count, 2);
+	
+	EXPECT_GT(stats.total_bytes(), stats.sources[0].bytes);
+}
@@ -0,0 +1,101 @@
+// This file is part of the Chaos Compiler Collection.
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+#include "ccc/watch_expression.h"
+
+using namespace ccc;
+
+static std::unique_ptr<ast::Node> create_field(const char* name, s32 offset)
+{
+	std::unique_ptr<ast::BuiltIn> field = std::make_unique<ast::BuiltIn>();
+	field->bclass = ast::BuiltInClass::SIGNED_32;
+	field->name = name;
+	field->offset_bytes = offset;
+	field->size_bytes = 4;
+	return field;
+}
+
+TEST(CCCWatchExpression, CompileAndEvaluate)
+{
+	SymbolDatabase database;
+	Result<SymbolSourceHandle> source = database.get_symbol_source("Source");
+	CCC_GTEST_FAIL_IF_ERROR(source);
+	
+	// struct Item { int id; int count; };
+	std::unique_ptr<ast::StructOrUnion> item = std::make_unique<ast::StructOrUnion>();
+	item->size_bytes = 8;
+	item->fields.emplace_back(create_field("id", 0));
+	item->fields.emplace_back(create_field("count", 4));
+	Result<DataType*> item_symbol = database.data_types.create_symbol("Item", *source);
+	CCC_GTEST_FAIL_IF_ERROR(item_symbol);
+	(*item_symbol)->set_type(std::move(item));
+	
+	// struct Player { int health; struct { Item items[4]; } inventory; };
+	std::unique_ptr<ast::TypeName> item_name = std::make_unique<ast::TypeName>();
+	item_name->data_type_handle = (*item_symbol)->handle();
+	item_name->size_bytes = 8;
+	std::unique_ptr<ast::Array> items = std::make_unique<ast::Array>();
+	items->name = "items";
+	items->offset_bytes = 0;
+	items->size_bytes = 32;
+	items->element_count = 4;
+	items->element_type = std::move(item_name);
+	std::unique_ptr<ast::StructOrUnion> inventory = std::make_unique<ast::StructOrUnion>();
+	inventory->name = "inventory";
+	inventory->offset_bytes = 4;
+	inventory->size_bytes = 32;
+	inventory->fields.emplace_back(std::move(items));
+	std::unique_ptr<ast::StructOrUnion> player = std::make_unique<ast::StructOrUnion>();
+	player->size_bytes = 36;
+	player->fields.emplace_back(create_field("health", 0));
+	player->fields.emplace_back(std::move(inventory));
+	Result<DataType*> player_symbol = database.data_types.create_symbol("Player", *source);
+	CCC_GTEST_FAIL_IF_ERROR(player_symbol);
+	(*player_symbol)->set_type(std::move(player));
+	
+	// Player* gPlayer;
+	std::unique_ptr<ast::TypeName> player_name = std::make_unique<ast::TypeName>();
+	player_name->data_type_handle = (*player_symbol)->handle();
+	player_name->size_bytes = 36;
+	std::unique_ptr<ast::PointerOrReference> pointer = std::make_unique<ast::PointerOrReference>();
+	pointer->size_bytes = 4;
+	pointer->value_type = std::move(player_name);
+	Result<GlobalVariable*> global = database.global_variables.create_symbol("gPlayer", 0x100, *source);
+	CCC_GTEST_FAIL_IF_ERROR(global);
+	(*global)->set_type(std::move(pointer));
+	
+	Result<CompiledWatchExpression> count = compile_watch_expression("gPlayer->inventory.items[3].count", database);
+	CCC_GTEST_FAIL_IF_ERROR(count);
+	ASSERT_EQ(count->instructions.size(), 2);
+	EXPECT_EQ(count->instructions[1].offset, 4 + 3 * 8 + 4);
+	EXPECT_EQ(count->size, 4);
+	
+	Result<CompiledWatchExpression> health = compile_watch_expression("(*gPlayer).health", database);
+	CCC_GTEST_FAIL_IF_ERROR(health);
+	
+	EXPECT_FALSE(compile_watch_expression("gPlayer.health", database).success());
+	EXPECT_FALSE(compile_watch_expression("gPlayer->inventory.items[4]", database).success());
+	EXPECT_FALSE(compile_watch_expression("gPlayer->mana", database).success());
+	EXPECT_FALSE(compile_watch_expression("gPlayer gPlayer", database).success());
+	
+	u32 memory[0x20] = {};
+	memory[0x0] = 0x110; // gPlayer
+	memory[0x4] = 100; // gPlayer->health
+	memory[0x4 + 1 + 3 * 2 + 1] = 7; // gPlayer->inventory.items[3].count
+	std::span<const u8> bytes((const u8*) memory, sizeof(memory));
+	
+	std::vector<CompiledWatchExpression> expressions = {*count, *health};
+	std::vector<WatchValue> values(expressions.size());
+	evaluate_watch_expressions(expressions, bytes, 0x100, values);
+	
+	ASSERT_TRUE(values[0].valid);
+	EXPECT_EQ(values[0].address, 0x110 + 4 + 3 * 8 + 4);
+	EXPECT_EQ(*(const s32*) values[0].data.data(), 7);
+	ASSERT_TRUE(values[1].valid);
+	EXPECT_EQ(*(const s32*) values[1].data.data(), 100);
+	
+	// Null pointers should produce invalid values.
+	memory[0x0] = 0;
+	EXPECT_FALSE(evaluate_watch_expression(*count, bytes, 0x100).valid);
+}
@@ -102,8 +102,6 @@ enum demangling_styles current_demangling_style = auto_demangling;
 
 static char cplus_markers[] = { CPLUS_MARKER, '.', '$', '\0' };
 
-static char char_str[2] = { '\000', '\000' };
-
 void
 set_cplus_marker_for_demangling (int ch)
 {
@@ -4188,8 +4186,8 @@ do_hpacc_template_const_value (struct work_stuff *work ATTRIBUTE_UNUSED,
      parameters -- so it's OK to look only for digits */
   while (ISDIGIT ((unsigned char)**mangled))
     {
-      char_str[0] = **mangled;
-      string_append (result, char_str);
+      /* CCC: Don't use a global buffer here so that this is thread safe. */
+      string_appendn (result, *mangled, 1);
       (*mangled)++;
     }
 
@@ -4255,8 +4253,8 @@ snarf_numeric_literal (const char **args, string *arg)
 {
   if (**args == '-')
     {
-      char_str[0] = '-';
-      string_append (arg, char_str);
+      /* CCC: Don't use a global buffer here so that this is thread safe. */
+      string_appendn (arg, "-", 1);
       (*args)++;
     }
   else if (**args == '+')
@@ -4267,8 +4265,8 @@ snarf_numeric_literal (const char **args, string *arg)
 
   while (ISDIGIT ((unsigned char)**args))
     {
-      char_str[0] = **args;
-      string_append (arg, char_str);
+      /* CCC: Don't use a global buffer here so that this is thread safe. */
+      string_appendn (arg, *args, 1);
       (*args)++;
     }
 